@@ -0,0 +1,407 @@
+/* defines the untagged entry points; keep the tag macros off */
+#define MCPKG_ALLOC_IMPL
+#include "container/mcpkg_alloc.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "math/mcpkg_math.h"
+
+static void *libc_alloc(void *ctx, size_t size)
+{
+	(void)ctx;
+	return malloc(size ? size : 1);
+}
+
+static void *libc_realloc(void *ctx, void *p, size_t old_size,
+                          size_t new_size)
+{
+	(void)ctx;
+	(void)old_size;
+	return realloc(p, new_size ? new_size : 1);
+}
+
+static void libc_free(void *ctx, void *p, size_t size)
+{
+	(void)ctx;
+	(void)size;
+	free(p);
+}
+
+static const McPkgAllocator g_libc = {
+	.alloc = libc_alloc,
+	.realloc = libc_realloc,
+	.free = libc_free,
+	.ctx = NULL,
+	.flags = 0,
+};
+
+static const McPkgAllocator *g_default = &g_libc;
+
+const McPkgAllocator *mcpkg_allocator_libc(void)
+{
+	return &g_libc;
+}
+
+void mcpkg_allocator_set_default(const McPkgAllocator *a)
+{
+	g_default = a ? a : &g_libc;
+}
+
+const McPkgAllocator *mcpkg_allocator_default(void)
+{
+	return g_default;
+}
+
+#ifndef MCPKG_MEM_STATS
+#define MCPKG_MEM_STATS 0
+#endif
+
+#if MCPKG_MEM_STATS
+#include <stdatomic.h>
+
+/*
+ * Every counted block is prefixed with its size and module so frees
+ * need neither; the union keeps the payload max_align_t aligned.
+ */
+typedef union {
+	max_align_t		align;
+	struct {
+		size_t		size;
+		unsigned	tag;
+	} h;
+} mem_hdr;
+
+struct mem_counters {
+	atomic_ullong		live;
+	atomic_ullong		peak;
+	atomic_ullong		allocs;
+	atomic_ullong		frees;
+};
+
+static struct mem_counters g_stats[MCPKG_MEM_MODULE_COUNT];
+
+static inline int stats_on(const McPkgAllocator *a)
+{
+	return !(a->flags & MCPKG_ALLOCATOR_F_NO_STATS);
+}
+
+static void peak_raise(atomic_ullong *peak, unsigned long long v)
+{
+	unsigned long long cur = atomic_load_explicit(peak,
+	                         memory_order_relaxed);
+
+	while (v > cur && !atomic_compare_exchange_weak_explicit(peak, &cur,
+	                v, memory_order_relaxed, memory_order_relaxed))
+		;
+}
+
+static void stats_add(unsigned tag, size_t size)
+{
+	unsigned idx[2] = { tag, MCPKG_MEM_TOTAL };
+	unsigned long long live;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		struct mem_counters *c = &g_stats[idx[i]];
+
+		atomic_fetch_add_explicit(&c->allocs, 1, memory_order_relaxed);
+		live = atomic_fetch_add_explicit(&c->live, size,
+		                                 memory_order_relaxed) + size;
+		peak_raise(&c->peak, live);
+	}
+}
+
+static void stats_sub(unsigned tag, size_t size)
+{
+	unsigned idx[2] = { tag, MCPKG_MEM_TOTAL };
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		struct mem_counters *c = &g_stats[idx[i]];
+
+		atomic_fetch_add_explicit(&c->frees, 1, memory_order_relaxed);
+		atomic_fetch_sub_explicit(&c->live, size, memory_order_relaxed);
+	}
+}
+
+/* grow/shrink in place of a counted block */
+static void stats_resize(unsigned tag, size_t old_size, size_t new_size)
+{
+	unsigned idx[2] = { tag, MCPKG_MEM_TOTAL };
+	unsigned long long live;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		struct mem_counters *c = &g_stats[idx[i]];
+
+		if (new_size >= old_size) {
+			live = atomic_fetch_add_explicit(&c->live,
+			                new_size - old_size,
+			                memory_order_relaxed);
+			peak_raise(&c->peak, live + new_size - old_size);
+		} else {
+			atomic_fetch_sub_explicit(&c->live,
+			                          old_size - new_size,
+			                          memory_order_relaxed);
+		}
+	}
+}
+#endif /* MCPKG_MEM_STATS */
+
+void *mcpkg_allocator_alloc_tag(const McPkgAllocator *a, size_t size,
+                                MCPKG_MEM_MODULE tag)
+{
+	a = a ? a : g_default;
+#if MCPKG_MEM_STATS
+	if (stats_on(a)) {
+		mem_hdr *h;
+
+		if (size > SIZE_MAX - sizeof(*h))
+			return NULL;
+		h = a->alloc(a->ctx, sizeof(*h) + size);
+		if (!h)
+			return NULL;
+		h->h.size = size;
+		h->h.tag = (unsigned)tag < MCPKG_MEM_TOTAL ? (unsigned)tag
+		           : MCPKG_MEM_OTHER;
+		stats_add(h->h.tag, size);
+		return h + 1;
+	}
+#else
+	(void)tag;
+#endif
+	return a->alloc(a->ctx, size);
+}
+
+void *mcpkg_allocator_calloc_tag(const McPkgAllocator *a, size_t n,
+                                 size_t size, MCPKG_MEM_MODULE tag)
+{
+	size_t bytes;
+	void *p;
+
+	if (mcpkg_math_mul_overflow_size(n, size, &bytes))
+		return NULL;
+
+	p = mcpkg_allocator_alloc_tag(a, bytes, tag);
+	if (p)
+		memset(p, 0, bytes);
+	return p;
+}
+
+void *mcpkg_allocator_realloc_tag(const McPkgAllocator *a, void *p,
+                                  size_t old_size, size_t new_size,
+                                  MCPKG_MEM_MODULE tag)
+{
+	a = a ? a : g_default;
+	if (!p)
+		return mcpkg_allocator_alloc_tag(a, new_size, tag);
+#if MCPKG_MEM_STATS
+	if (stats_on(a)) {
+		mem_hdr *h = (mem_hdr *)p - 1, *n;
+		size_t had = h->h.size;
+
+		(void)old_size;
+		if (new_size > SIZE_MAX - sizeof(*h))
+			return NULL;
+		n = a->realloc(a->ctx, h, sizeof(*h) + had,
+		               sizeof(*h) + new_size);
+		if (!n)
+			return NULL;
+		n->h.size = new_size;
+		stats_resize(n->h.tag, had, new_size);
+		return n + 1;
+	}
+#endif
+	return a->realloc(a->ctx, p, old_size, new_size);
+}
+
+char *mcpkg_allocator_strndup_tag(const McPkgAllocator *a, const char *s,
+                                  size_t len, MCPKG_MEM_MODULE tag)
+{
+	char *p;
+
+	if (!s || len == SIZE_MAX)
+		return NULL;
+
+	p = mcpkg_allocator_alloc_tag(a, len + 1, tag);
+	if (!p)
+		return NULL;
+	memcpy(p, s, len);
+	p[len] = '\0';
+	return p;
+}
+
+char *mcpkg_allocator_strdup_tag(const McPkgAllocator *a, const char *s,
+                                 MCPKG_MEM_MODULE tag)
+{
+	if (!s)
+		return NULL;
+	return mcpkg_allocator_strndup_tag(a, s, strlen(s), tag);
+}
+
+void *mcpkg_allocator_alloc(const McPkgAllocator *a, size_t size)
+{
+	return mcpkg_allocator_alloc_tag(a, size, MCPKG_MEM_OTHER);
+}
+
+void *mcpkg_allocator_calloc(const McPkgAllocator *a, size_t n, size_t size)
+{
+	return mcpkg_allocator_calloc_tag(a, n, size, MCPKG_MEM_OTHER);
+}
+
+void *mcpkg_allocator_realloc(const McPkgAllocator *a, void *p,
+                              size_t old_size, size_t new_size)
+{
+	return mcpkg_allocator_realloc_tag(a, p, old_size, new_size,
+	                                   MCPKG_MEM_OTHER);
+}
+
+void mcpkg_allocator_free(const McPkgAllocator *a, void *p, size_t size)
+{
+	if (!p)
+		return;
+	a = a ? a : g_default;
+#if MCPKG_MEM_STATS
+	if (stats_on(a)) {
+		mem_hdr *h = (mem_hdr *)p - 1;
+
+		(void)size;
+		stats_sub(h->h.tag, h->h.size);
+		a->free(a->ctx, h, sizeof(*h) + h->h.size);
+		return;
+	}
+#endif
+	a->free(a->ctx, p, size);
+}
+
+char *mcpkg_allocator_strndup(const McPkgAllocator *a, const char *s,
+                              size_t len)
+{
+	return mcpkg_allocator_strndup_tag(a, s, len, MCPKG_MEM_OTHER);
+}
+
+char *mcpkg_allocator_strdup(const McPkgAllocator *a, const char *s)
+{
+	return mcpkg_allocator_strdup_tag(a, s, MCPKG_MEM_OTHER);
+}
+
+void *mcpkg_malloc(size_t size)
+{
+	return mcpkg_allocator_alloc(NULL, size);
+}
+
+void *mcpkg_calloc(size_t n, size_t size)
+{
+	return mcpkg_allocator_calloc(NULL, n, size);
+}
+
+void *mcpkg_realloc(void *p, size_t size)
+{
+	return mcpkg_allocator_realloc(NULL, p, 0, size);
+}
+
+void mcpkg_free(void *p)
+{
+	mcpkg_allocator_free(NULL, p, 0);
+}
+
+char *mcpkg_strdup(const char *s)
+{
+	return mcpkg_allocator_strdup(NULL, s);
+}
+
+char *mcpkg_strndup(const char *s, size_t len)
+{
+	return mcpkg_allocator_strndup(NULL, s, len);
+}
+
+/* ---------- stats ---------- */
+
+static const char *const g_module_names[MCPKG_MEM_MODULE_COUNT] = {
+	[MCPKG_MEM_OTHER]     = "other",
+	[MCPKG_MEM_CONTAINER] = "container",
+	[MCPKG_MEM_MP]        = "mp",
+	[MCPKG_MEM_NET]       = "net",
+	[MCPKG_MEM_CRYPTO]    = "crypto",
+	[MCPKG_MEM_FS]        = "fs",
+	[MCPKG_MEM_MC]        = "mc",
+	[MCPKG_MEM_TOTAL]     = "total",
+};
+
+int mcpkg_mem_stats_enabled(void)
+{
+	return MCPKG_MEM_STATS;
+}
+
+void mcpkg_mem_stats_get(MCPKG_MEM_MODULE module, McPkgMemStats *out)
+{
+	if (!out)
+		return;
+	memset(out, 0, sizeof(*out));
+	if ((unsigned)module >= MCPKG_MEM_MODULE_COUNT)
+		return;
+#if MCPKG_MEM_STATS
+	{
+		struct mem_counters *c = &g_stats[module];
+
+		out->live_bytes = atomic_load_explicit(&c->live,
+		                                       memory_order_relaxed);
+		out->peak_bytes = atomic_load_explicit(&c->peak,
+		                                       memory_order_relaxed);
+		out->allocs = atomic_load_explicit(&c->allocs,
+		                                   memory_order_relaxed);
+		out->frees = atomic_load_explicit(&c->frees,
+		                                  memory_order_relaxed);
+	}
+#endif
+}
+
+void mcpkg_mem_stats_reset_peak(void)
+{
+#if MCPKG_MEM_STATS
+	int i;
+
+	for (i = 0; i < MCPKG_MEM_MODULE_COUNT; i++)
+		atomic_store_explicit(&g_stats[i].peak,
+		                      atomic_load_explicit(&g_stats[i].live,
+		                                      memory_order_relaxed),
+		                      memory_order_relaxed);
+#endif
+}
+
+const char *mcpkg_mem_module_name(MCPKG_MEM_MODULE module)
+{
+	if ((unsigned)module >= MCPKG_MEM_MODULE_COUNT)
+		return "unknown";
+	return g_module_names[module];
+}
+
+char *mcpkg_mem_stats_debug_str(void)
+{
+	/* header + one line per module, each well under 96 bytes */
+	size_t cap = 96u * (MCPKG_MEM_MODULE_COUNT + 1), len;
+	McPkgMemStats st;
+	char *out;
+	int i, n;
+
+	out = mcpkg_malloc(cap);
+	if (!out)
+		return NULL;
+
+	n = snprintf(out, cap, "%-10s %14s %14s %12s %12s\n", "module",
+	             "live", "peak", "allocs", "frees");
+	len = n > 0 ? (size_t)n : 0;
+	for (i = 0; i < MCPKG_MEM_MODULE_COUNT && len < cap; i++) {
+		mcpkg_mem_stats_get((MCPKG_MEM_MODULE)i, &st);
+		n = snprintf(out + len, cap - len,
+		             "%-10s %14llu %14llu %12llu %12llu\n",
+		             g_module_names[i], st.live_bytes, st.peak_bytes,
+		             st.allocs, st.frees);
+		if (n > 0)
+			len += (size_t)n;
+	}
+	return out;
+}
@@ -0,0 +1,154 @@
+#ifndef MCPKG_ALLOC_H
+#define MCPKG_ALLOC_H
+
+#include <stddef.h>
+#include "mcpkg_export.h"
+
+MCPKG_BEGIN_DECLS
+
+/*
+ * McPkgAllocator: memory hooks used by libmcpkg instead of libc.
+ * - One process-wide default (libc unless replaced) and optional
+ *   per-object allocators passed to *_new_alloc constructors.
+ * - Objects remember the allocator they were created with, so later
+ *   changes of the default only affect new objects.
+ * - Sizes are the caller's byte counts; old_size/size are 0 when the
+ *   caller does not track them (e.g. strings handed out to users).
+ *   Allocators that need them (the arena) only serve containers.
+ * - alloc/realloc must return memory aligned for max_align_t.
+ * - Hooks must be thread-safe if the objects using them are shared.
+ */
+
+typedef struct McPkgAllocator {
+	void *(*alloc)(void *ctx, size_t size);
+	void *(*realloc)(void *ctx, void *p, size_t old_size,
+	                 size_t new_size);
+	void (*free)(void *ctx, void *p, size_t size);
+	void *ctx;
+	unsigned flags;         /* MCPKG_ALLOCATOR_F_* */
+} McPkgAllocator;
+
+/* Carves from memory already counted elsewhere (arena views). */
+#define MCPKG_ALLOCATOR_F_NO_STATS  0x1u
+
+/*
+ * Accounting modules. MCPKG_MEM_STATS builds charge each allocation to
+ * the module of the calling source file (MCPKG_MEM_TAG, set per
+ * directory by the build); anything else lands in OTHER.
+ */
+typedef enum {
+	MCPKG_MEM_OTHER = 0,
+	MCPKG_MEM_CONTAINER,
+	MCPKG_MEM_MP,
+	MCPKG_MEM_NET,
+	MCPKG_MEM_CRYPTO,
+	MCPKG_MEM_FS,
+	MCPKG_MEM_MC,
+	MCPKG_MEM_TOTAL,        /* stats only: sum over all modules */
+	MCPKG_MEM_MODULE_COUNT
+} MCPKG_MEM_MODULE;
+
+/* malloc/realloc/free. */
+MCPKG_API const McPkgAllocator *mcpkg_allocator_libc(void);
+
+/*
+ * Replace the default (NULL restores libc). a must outlive every object
+ * allocated through it. Not synchronized: call it before other threads
+ * use the library, and free default-allocated objects before switching.
+ */
+MCPKG_API void mcpkg_allocator_set_default(const McPkgAllocator *a);
+MCPKG_API const McPkgAllocator *mcpkg_allocator_default(void);
+
+/* Calls through a; a NULL means the current default. */
+MCPKG_API void *mcpkg_allocator_alloc(const McPkgAllocator *a, size_t size);
+/* Zeroed n * size bytes, overflow-checked. */
+MCPKG_API void *mcpkg_allocator_calloc(const McPkgAllocator *a, size_t n,
+                                       size_t size);
+MCPKG_API void *mcpkg_allocator_realloc(const McPkgAllocator *a, void *p,
+                                        size_t old_size, size_t new_size);
+MCPKG_API void mcpkg_allocator_free(const McPkgAllocator *a, void *p,
+                                    size_t size);
+MCPKG_API char *mcpkg_allocator_strndup(const McPkgAllocator *a,
+                                        const char *s, size_t len);
+MCPKG_API char *mcpkg_allocator_strdup(const McPkgAllocator *a,
+                                       const char *s);
+
+/*
+ * libc-style shorthands on the default allocator. Memory the library
+ * hands out (packed buffers, decoded strings, debug strings) comes from
+ * here; release it with mcpkg_free, never plain free() (stats builds
+ * prefix every block with a header).
+ */
+MCPKG_API void *mcpkg_malloc(size_t size);
+MCPKG_API void *mcpkg_calloc(size_t n, size_t size);
+MCPKG_API void *mcpkg_realloc(void *p, size_t size);
+MCPKG_API void mcpkg_free(void *p);
+MCPKG_API char *mcpkg_strdup(const char *s);
+MCPKG_API char *mcpkg_strndup(const char *s, size_t len);
+
+/* Same as the untagged calls, charged to module tag. */
+MCPKG_API void *mcpkg_allocator_alloc_tag(const McPkgAllocator *a,
+                size_t size, MCPKG_MEM_MODULE tag);
+MCPKG_API void *mcpkg_allocator_calloc_tag(const McPkgAllocator *a,
+                size_t n, size_t size, MCPKG_MEM_MODULE tag);
+MCPKG_API void *mcpkg_allocator_realloc_tag(const McPkgAllocator *a,
+                void *p, size_t old_size, size_t new_size,
+                MCPKG_MEM_MODULE tag);
+MCPKG_API char *mcpkg_allocator_strndup_tag(const McPkgAllocator *a,
+                const char *s, size_t len, MCPKG_MEM_MODULE tag);
+MCPKG_API char *mcpkg_allocator_strdup_tag(const McPkgAllocator *a,
+                const char *s, MCPKG_MEM_MODULE tag);
+
+/*
+ * Library sources built with MCPKG_MEM_STATS get MCPKG_MEM_TAG and
+ * call the tagged variants; user code and untagged sources do not.
+ */
+#if defined(MCPKG_MEM_TAG) && !defined(MCPKG_ALLOC_IMPL)
+#define mcpkg_allocator_alloc(a, size) \
+	mcpkg_allocator_alloc_tag((a), (size), MCPKG_MEM_TAG)
+#define mcpkg_allocator_calloc(a, n, size) \
+	mcpkg_allocator_calloc_tag((a), (n), (size), MCPKG_MEM_TAG)
+#define mcpkg_allocator_realloc(a, p, old_size, new_size) \
+	mcpkg_allocator_realloc_tag((a), (p), (old_size), (new_size), \
+	                            MCPKG_MEM_TAG)
+#define mcpkg_allocator_strndup(a, s, len) \
+	mcpkg_allocator_strndup_tag((a), (s), (len), MCPKG_MEM_TAG)
+#define mcpkg_allocator_strdup(a, s) \
+	mcpkg_allocator_strdup_tag((a), (s), MCPKG_MEM_TAG)
+#define mcpkg_malloc(size) \
+	mcpkg_allocator_alloc_tag(NULL, (size), MCPKG_MEM_TAG)
+#define mcpkg_calloc(n, size) \
+	mcpkg_allocator_calloc_tag(NULL, (n), (size), MCPKG_MEM_TAG)
+#define mcpkg_realloc(p, size) \
+	mcpkg_allocator_realloc_tag(NULL, (p), 0, (size), MCPKG_MEM_TAG)
+#define mcpkg_strndup(s, len) \
+	mcpkg_allocator_strndup_tag(NULL, (s), (len), MCPKG_MEM_TAG)
+#define mcpkg_strdup(s) \
+	mcpkg_allocator_strdup_tag(NULL, (s), MCPKG_MEM_TAG)
+#endif
+
+/* Per-module counters; all zero unless built with MCPKG_MEM_STATS. */
+typedef struct {
+	unsigned long long	live_bytes;
+	unsigned long long	peak_bytes;
+	unsigned long long	allocs;
+	unsigned long long	frees;
+} McPkgMemStats;
+
+/* 1 if this build keeps memory stats. */
+MCPKG_API int mcpkg_mem_stats_enabled(void);
+
+/* Snapshot of one module (MCPKG_MEM_TOTAL for all). */
+MCPKG_API void mcpkg_mem_stats_get(MCPKG_MEM_MODULE module,
+                                   McPkgMemStats *out);
+
+/* Restart peak tracking from the current live bytes (one stage). */
+MCPKG_API void mcpkg_mem_stats_reset_peak(void);
+
+MCPKG_API const char *mcpkg_mem_module_name(MCPKG_MEM_MODULE module);
+
+/* Table of every module's stats; mcpkg_free() it. */
+MCPKG_API char *mcpkg_mem_stats_debug_str(void);
+
+MCPKG_END_DECLS
+#endif /* MCPKG_ALLOC_H */
@@ -0,0 +1,326 @@
+#include "container/mcpkg_arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "math/mcpkg_math.h"
+
+#define ARENA_ALIGN  _Alignof(max_align_t)
+
+struct arena_chunk {
+	struct arena_chunk	*next;     /* older chunk */
+	unsigned long long	seq;       /* creation order, for rewind */
+	size_t			cap;
+	size_t			off;
+	max_align_t		data[];
+};
+
+struct McPkgArena {
+	struct arena_chunk	*head;     /* current chunk (newest) */
+	const McPkgAllocator	*alloc;    /* where chunks come from */
+	McPkgAllocator		self;      /* mcpkg_arena_allocator */
+	size_t			chunk_size;
+	size_t			used;
+	size_t			reserved;
+	unsigned long long	max_bytes;
+	unsigned long long	seq;       /* chunks created so far */
+
+	/* last allocation, for in-place realloc */
+	struct arena_chunk	*last_chunk;
+	unsigned char		*last;
+};
+
+static inline unsigned char *chunk_base(struct arena_chunk *c)
+{
+	return (unsigned char *)c->data;
+}
+
+static struct arena_chunk *chunk_new(McPkgArena *a, size_t cap)
+{
+	struct arena_chunk *c;
+	size_t total;
+
+	if (mcpkg_math_add_overflow_size(sizeof(*c), cap, &total))
+		return NULL;
+	if ((unsigned long long)a->reserved + total > a->max_bytes)
+		return NULL;
+
+	c = mcpkg_allocator_alloc(a->alloc, total);
+	if (!c)
+		return NULL;
+
+	c->next = NULL;
+	c->seq = ++a->seq;
+	c->cap = cap;
+	c->off = 0;
+	a->reserved += total;
+	return c;
+}
+
+static void chunk_free(McPkgArena *a, struct arena_chunk *c)
+{
+	a->reserved -= sizeof(*c) + c->cap;
+	mcpkg_allocator_free(a->alloc, c, sizeof(*c) + c->cap);
+}
+
+/* room for size bytes at align in c, or SIZE_MAX */
+static inline size_t chunk_fit(const struct arena_chunk *c, size_t size,
+                               size_t align)
+{
+	size_t off = (c->off + align - 1) & ~(align - 1);
+
+	if (off > c->cap || c->cap - off < size)
+		return SIZE_MAX;
+	return off;
+}
+
+static void *arena_alloc(McPkgArena *a, size_t size, size_t align)
+{
+	struct arena_chunk *c = a->head;
+	size_t off = SIZE_MAX;
+
+	if (c)
+		off = chunk_fit(c, size, align);
+
+	if (off == SIZE_MAX) {
+		/* big blocks get a private chunk behind head */
+		int big = size > a->chunk_size / 2;
+
+		c = chunk_new(a, big ? size : a->chunk_size);
+		if (!c)
+			return NULL;
+		if (big && a->head) {
+			c->next = a->head->next;
+			a->head->next = c;
+		} else {
+			c->next = a->head;
+			a->head = c;
+		}
+		off = 0;
+	}
+
+	a->used += off - c->off + size;
+	c->off = off + size;
+	a->last_chunk = c;
+	a->last = chunk_base(c) + off;
+	return a->last;
+}
+
+/* McPkgAllocator view: frees are dropped until reset/rewind */
+static void *self_alloc(void *ctx, size_t size)
+{
+	return mcpkg_arena_alloc(ctx, size);
+}
+
+static void *self_realloc(void *ctx, void *p, size_t old_size,
+                          size_t new_size)
+{
+	return mcpkg_arena_realloc(ctx, p, old_size, new_size);
+}
+
+static void self_free(void *ctx, void *p, size_t size)
+{
+	(void)ctx;
+	(void)p;
+	(void)size;
+}
+
+McPkgArena *mcpkg_arena_new_alloc(const McPkgAllocator *alloc,
+                                  size_t chunk_size,
+                                  unsigned long long max_bytes)
+{
+	McPkgArena *a;
+
+	alloc = alloc ? alloc : mcpkg_allocator_default();
+	a = mcpkg_allocator_calloc(alloc, 1, sizeof(*a));
+	if (!a)
+		return NULL;
+
+	a->alloc = alloc;
+	a->self.alloc = self_alloc;
+	a->self.realloc = self_realloc;
+	a->self.free = self_free;
+	a->self.ctx = a;
+	a->self.flags = MCPKG_ALLOCATOR_F_NO_STATS;  /* chunks are counted */
+	a->chunk_size = chunk_size ? chunk_size : MCPKG_ARENA_DEFAULT_CHUNK;
+	a->max_bytes = max_bytes ? max_bytes : MCPKG_CONTAINER_MAX_BYTES;
+	return a;
+}
+
+McPkgArena *mcpkg_arena_new(size_t chunk_size, unsigned long long max_bytes)
+{
+	return mcpkg_arena_new_alloc(NULL, chunk_size, max_bytes);
+}
+
+void mcpkg_arena_free(McPkgArena *a)
+{
+	struct arena_chunk *c, *n;
+
+	if (!a)
+		return;
+
+	for (c = a->head; c; c = n) {
+		n = c->next;
+		chunk_free(a, c);
+	}
+	mcpkg_allocator_free(a->alloc, a, sizeof(*a));
+}
+
+const McPkgAllocator *mcpkg_arena_allocator(McPkgArena *a)
+{
+	return a ? &a->self : NULL;
+}
+
+void *mcpkg_arena_alloc(McPkgArena *a, size_t size)
+{
+	if (!a)
+		return NULL;
+	return arena_alloc(a, size, ARENA_ALIGN);
+}
+
+void *mcpkg_arena_calloc(McPkgArena *a, size_t n, size_t size)
+{
+	size_t bytes;
+	void *p;
+
+	if (!a || mcpkg_math_mul_overflow_size(n, size, &bytes))
+		return NULL;
+
+	p = arena_alloc(a, bytes, ARENA_ALIGN);
+	if (p)
+		memset(p, 0, bytes);
+	return p;
+}
+
+void *mcpkg_arena_realloc(McPkgArena *a, void *p, size_t old_size,
+                          size_t new_size)
+{
+	struct arena_chunk *c;
+	size_t at;
+	void *q;
+
+	if (!a)
+		return NULL;
+	if (!p)
+		return arena_alloc(a, new_size, ARENA_ALIGN);
+
+	c = a->last_chunk;
+	if (p == a->last) {
+		at = (size_t)(a->last - chunk_base(c));
+		if (at + old_size == c->off && c->cap - at >= new_size) {
+			c->off = at + new_size;
+			a->used = a->used - old_size + new_size;
+			return p;
+		}
+	}
+	if (new_size <= old_size)
+		return p;
+
+	q = arena_alloc(a, new_size, ARENA_ALIGN);
+	if (q && old_size)
+		memcpy(q, p, old_size);
+	return q;
+}
+
+char *mcpkg_arena_strndup(McPkgArena *a, const char *s, size_t len)
+{
+	size_t need;
+	char *p;
+
+	if (!a || !s)
+		return NULL;
+	if (mcpkg_math_add_overflow_size(len, 1, &need))
+		return NULL;
+
+	p = arena_alloc(a, need, 1);
+	if (!p)
+		return NULL;
+	memcpy(p, s, len);
+	p[len] = '\0';
+	return p;
+}
+
+char *mcpkg_arena_strdup(McPkgArena *a, const char *s)
+{
+	if (!s)
+		return NULL;
+	return mcpkg_arena_strndup(a, s, strlen(s));
+}
+
+McPkgArenaMark mcpkg_arena_mark(const McPkgArena *a)
+{
+	McPkgArenaMark m;
+
+	memset(&m, 0, sizeof(m));
+	if (!a)
+		return m;
+
+	m.chunk = a->head;
+	m.off = a->head ? a->head->off : 0;
+	m.used = a->used;
+	m.seq = a->seq;
+	return m;
+}
+
+void mcpkg_arena_rewind(McPkgArena *a, const McPkgArenaMark *m)
+{
+	struct arena_chunk *c, *n, **link;
+
+	if (!a || !m)
+		return;
+
+	/* chunks are unlinked in list order; keep the older ones */
+	link = &a->head;
+	for (c = a->head; c; c = n) {
+		n = c->next;
+		if (c->seq > m->seq) {
+			*link = n;
+			chunk_free(a, c);
+			continue;
+		}
+		link = &c->next;
+	}
+
+	if (a->head && a->head == m->chunk)
+		a->head->off = m->off;
+	a->used = m->used;
+	a->last_chunk = NULL;
+	a->last = NULL;
+}
+
+void mcpkg_arena_reset(McPkgArena *a)
+{
+	struct arena_chunk *c, *n, *keep = NULL;
+
+	if (!a)
+		return;
+
+	for (c = a->head; c; c = n) {
+		n = c->next;
+		if (!keep && c->cap == a->chunk_size) {
+			keep = c;
+			continue;
+		}
+		chunk_free(a, c);
+	}
+
+	a->head = keep;
+	a->used = 0;
+	a->last_chunk = NULL;
+	a->last = NULL;
+	if (keep) {
+		keep->next = NULL;
+		keep->off = 0;
+	}
+}
+
+size_t mcpkg_arena_used(const McPkgArena *a)
+{
+	return a ? a->used : 0;
+}
+
+size_t mcpkg_arena_reserved(const McPkgArena *a)
+{
+	return a ? a->reserved : 0;
+}
@@ -0,0 +1,88 @@
+#ifndef MCPKG_ARENA_H
+#define MCPKG_ARENA_H
+
+#include <stddef.h>
+#include "mcpkg_export.h"
+#include "container/mcpkg_container_error.h"
+#include "container/mcpkg_alloc.h"
+
+MCPKG_BEGIN_DECLS
+
+/*
+ * McPkgArena: bump allocator for object graphs that die together, e.g.
+ * one page of decoded packages.
+ * - Allocations come from large chunks; there is no per-object free.
+ *   reset/free release everything at once.
+ * - mark/rewind drop everything allocated after a mark (error paths).
+ * - Returned pointers never move (realloc may return a new pointer).
+ * - Chunks come from a McPkgAllocator (default or given at creation),
+ *   and the arena is itself one (mcpkg_arena_allocator).
+ * - Not thread-safe; callers must synchronize.
+ */
+
+typedef struct McPkgArena McPkgArena;
+
+/* Position to rewind to; taken with mcpkg_arena_mark. */
+typedef struct {
+	void			*chunk;
+	size_t			off;
+	size_t			used;
+	unsigned long long	seq;
+} McPkgArenaMark;
+
+#define MCPKG_ARENA_DEFAULT_CHUNK  (64u * 1024u)
+
+/*
+ * Create an arena. chunk_size 0 = default; max_bytes 0 = default
+ * container cap (bounds the chunks reserved, not just bytes handed out).
+ */
+MCPKG_API McPkgArena *mcpkg_arena_new(size_t chunk_size,
+                                      unsigned long long max_bytes);
+
+/* Same; chunks come from alloc (NULL = default allocator). */
+MCPKG_API McPkgArena *mcpkg_arena_new_alloc(const McPkgAllocator *alloc,
+                size_t chunk_size,
+                unsigned long long max_bytes);
+
+/* Free the arena and everything allocated from it. */
+MCPKG_API void mcpkg_arena_free(McPkgArena *a);
+
+/* size bytes aligned for any type (max_align_t). NULL on OOM/limit. */
+MCPKG_API void *mcpkg_arena_alloc(McPkgArena *a, size_t size);
+
+/* Zeroed n * size bytes, overflow-checked. */
+MCPKG_API void *mcpkg_arena_calloc(McPkgArena *a, size_t n, size_t size);
+
+/*
+ * Grow/shrink an allocation of old_size bytes. The most recent
+ * allocation is resized in place when its chunk has room; otherwise
+ * the bytes are copied and the old block stays dead until reset.
+ * p NULL acts as alloc.
+ */
+MCPKG_API void *mcpkg_arena_realloc(McPkgArena *a, void *p, size_t old_size,
+                                    size_t new_size);
+
+/* String copies (byte aligned). NULL on OOM/limit or s NULL. */
+MCPKG_API char *mcpkg_arena_strdup(McPkgArena *a, const char *s);
+MCPKG_API char *mcpkg_arena_strndup(McPkgArena *a, const char *s,
+                                    size_t len);
+
+/* Current position; rewind frees every chunk allocated after it. */
+MCPKG_API McPkgArenaMark mcpkg_arena_mark(const McPkgArena *a);
+MCPKG_API void mcpkg_arena_rewind(McPkgArena *a, const McPkgArenaMark *m);
+
+/* Drop all allocations; keeps one chunk for reuse. */
+MCPKG_API void mcpkg_arena_reset(McPkgArena *a);
+
+/*
+ * The arena as an allocator for *_new_alloc constructors: frees are
+ * no-ops and realloc needs the exact old size. Valid as long as a.
+ */
+MCPKG_API const McPkgAllocator *mcpkg_arena_allocator(McPkgArena *a);
+
+/* Bytes handed out (incl. alignment) / bytes reserved in chunks. */
+MCPKG_API size_t mcpkg_arena_used(const McPkgArena *a);
+MCPKG_API size_t mcpkg_arena_reserved(const McPkgArena *a);
+
+MCPKG_END_DECLS
+#endif /* MCPKG_ARENA_H */
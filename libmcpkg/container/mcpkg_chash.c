@@ -0,0 +1,357 @@
+#include "container/mcpkg_chash.h"
+#include "container/mcpkg_hash_p.h"
+#include "threads/mcpkg_thread.h"
+
+/*
+ * McPkgCHash: N McPkgHash shards sharing one seed and hash function.
+ * One key hash picks the shard from its top bits and then drives the
+ * probe inside it (H1/H2 use the low bits). Shard pointers never change
+ * after new(), so picking a shard needs no lock.
+ */
+
+struct chash_shard {
+	struct McPkgRwLock *lock;
+	McPkgHash          *h;
+};
+
+struct McPkgCHash {
+	struct chash_shard *shard;
+	unsigned            n;       /* pow2 */
+	unsigned            shift;   /* 64 - log2(n) */
+	size_t              value_size;
+	McPkgHashOps        ops;
+	const McPkgAllocator *alloc; /* default at creation */
+};
+
+static inline uint64_t chash_key_hash(const struct McPkgCHash *ch,
+                                      const char *key, size_t len)
+{
+	/* all shards share k0/k1/hash_fn */
+	return key_hash_n(ch->shard[0].h, key, len);
+}
+
+static inline struct chash_shard *chash_pick(const struct McPkgCHash *ch,
+                uint64_t hv)
+{
+	return ch->n > 1 ? &ch->shard[hv >> ch->shift] : &ch->shard[0];
+}
+
+static void chash_copy_out(const struct McPkgCHash *ch, const McPkgHash *h,
+                           size_t pos, void *out)
+{
+	const unsigned char *v = h->values + pos * h->value_size;
+
+	if (ch->ops.value_copy)
+		ch->ops.value_copy(out, v, ch->ops.ctx);
+	else
+		memcpy(out, v, ch->value_size);
+}
+
+static size_t split_cap(size_t total, unsigned n)
+{
+	if (!total)
+		return 0;
+	return total / n + (total % n != 0);
+}
+
+McPkgCHash *mcpkg_chash_new(size_t value_size,
+                            const McPkgHashOps *ops_or_null,
+                            unsigned shards, size_t max_pairs,
+                            unsigned long long max_bytes)
+{
+	const McPkgAllocator *alloc;
+	struct McPkgCHash *ch;
+	unsigned n = 1, lg = 0, i;
+
+	if (!value_size)
+		return NULL;
+	if (!shards)
+		shards = MCPKG_CHASH_DEFAULT_SHARDS;
+	if (shards > MCPKG_CHASH_MAX_SHARDS)
+		return NULL;
+	while (n < shards) {
+		n <<= 1;
+		lg++;
+	}
+
+	alloc = mcpkg_allocator_default();
+	ch = mcpkg_allocator_calloc(alloc, 1, sizeof(*ch));
+	if (!ch)
+		return NULL;
+	ch->alloc = alloc;
+	ch->shard = mcpkg_allocator_calloc(alloc, n, sizeof(*ch->shard));
+	if (!ch->shard) {
+		mcpkg_allocator_free(alloc, ch, sizeof(*ch));
+		return NULL;
+	}
+	ch->n = n;
+	ch->shift = 64u - lg;
+	ch->value_size = value_size;
+	if (ops_or_null)
+		ch->ops = *ops_or_null;
+
+	for (i = 0; i < n; i++) {
+		struct chash_shard *s = &ch->shard[i];
+
+		s->h = mcpkg_hash_new_alloc(alloc, value_size, ops_or_null,
+		                            split_cap(max_pairs, n),
+		                            max_bytes ? max_bytes / n : 0);
+		s->lock = mcpkg_rwlock_new();
+		if (!s->h || !s->lock) {
+			mcpkg_chash_free(ch);
+			return NULL;
+		}
+		/* one hash serves shard pick and probe */
+		s->h->k0 = ch->shard[0].h->k0;
+		s->h->k1 = ch->shard[0].h->k1;
+	}
+	return ch;
+}
+
+void mcpkg_chash_free(McPkgCHash *ch)
+{
+	unsigned i;
+
+	if (!ch)
+		return;
+	for (i = 0; i < ch->n; i++) {
+		mcpkg_hash_free(ch->shard[i].h);
+		mcpkg_rwlock_free(ch->shard[i].lock);
+	}
+	mcpkg_allocator_free(ch->alloc, ch->shard,
+	                     ch->n * sizeof(*ch->shard));
+	mcpkg_allocator_free(ch->alloc, ch, sizeof(*ch));
+}
+
+size_t mcpkg_chash_size(const McPkgCHash *ch)
+{
+	size_t total = 0;
+	unsigned i;
+
+	if (!ch)
+		return 0;
+	for (i = 0; i < ch->n; i++) {
+		mcpkg_rwlock_rdlock(ch->shard[i].lock);
+		total += mcpkg_hash_size(ch->shard[i].h);
+		mcpkg_rwlock_rdunlock(ch->shard[i].lock);
+	}
+	return total;
+}
+
+unsigned mcpkg_chash_shards(const McPkgCHash *ch)
+{
+	return ch ? ch->n : 0;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_chash_set_hash_fn(McPkgCHash *ch, MCPKG_HASH_FN fn)
+{
+	MCPKG_CONTAINER_ERROR ret;
+	unsigned i;
+
+	if (!ch)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (fn > MCPKG_HASH_FN_WYHASH || mcpkg_chash_size(ch))
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	for (i = 0; i < ch->n; i++) {
+		ret = mcpkg_hash_set_hash_fn(ch->shard[i].h, fn);
+		if (ret != MCPKG_CONTAINER_OK)
+			return ret;
+	}
+	return MCPKG_CONTAINER_OK;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_chash_set_n(McPkgCHash *ch, const char *key,
+                                        size_t len, const void *value)
+{
+	MCPKG_CONTAINER_ERROR ret;
+	struct chash_shard *s;
+	uint64_t hv;
+
+	if (!ch || !key || !value)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (!key_n_valid(key, len))
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	hv = chash_key_hash(ch, key, len);
+	s = chash_pick(ch, hv);
+	mcpkg_rwlock_wrlock(s->lock);
+	ret = mcpkg_hash_set_h(s->h, key, len, hv, value);
+	mcpkg_rwlock_wrunlock(s->lock);
+	return ret;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_chash_set(McPkgCHash *ch, const char *key,
+                                      const void *value)
+{
+	if (!key)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	return mcpkg_chash_set_n(ch, key, strlen(key), value);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_chash_get_n(const McPkgCHash *ch,
+                                        const char *key, size_t len,
+                                        void *out)
+{
+	MCPKG_CONTAINER_ERROR ret = MCPKG_CONTAINER_ERR_NOT_FOUND;
+	struct chash_shard *s;
+	uint64_t hv;
+	size_t pos;
+
+	if (!ch || !key || !out)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (!key_n_valid(key, len))
+		return MCPKG_CONTAINER_ERR_NOT_FOUND;
+
+	hv = chash_key_hash(ch, key, len);
+	s = chash_pick(ch, hv);
+	mcpkg_rwlock_rdlock(s->lock);
+	if (mcpkg_hash_find_h(s->h, key, len, hv, &pos)) {
+		chash_copy_out(ch, s->h, pos, out);
+		ret = MCPKG_CONTAINER_OK;
+	}
+	mcpkg_rwlock_rdunlock(s->lock);
+	return ret;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_chash_get(const McPkgCHash *ch, const char *key,
+                                      void *out)
+{
+	if (!key)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	return mcpkg_chash_get_n(ch, key, strlen(key), out);
+}
+
+int mcpkg_chash_contains_n(const McPkgCHash *ch, const char *key,
+                           size_t len)
+{
+	struct chash_shard *s;
+	uint64_t hv;
+	int r;
+
+	if (!ch || !key || !key_n_valid(key, len))
+		return 0;
+
+	hv = chash_key_hash(ch, key, len);
+	s = chash_pick(ch, hv);
+	mcpkg_rwlock_rdlock(s->lock);
+	r = mcpkg_hash_contains_h(s->h, key, len, hv);
+	mcpkg_rwlock_rdunlock(s->lock);
+	return r;
+}
+
+int mcpkg_chash_contains(const McPkgCHash *ch, const char *key)
+{
+	return key ? mcpkg_chash_contains_n(ch, key, strlen(key)) : 0;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_chash_pop(McPkgCHash *ch, const char *key,
+                                      void *out)
+{
+	MCPKG_CONTAINER_ERROR ret = MCPKG_CONTAINER_ERR_NOT_FOUND;
+	struct chash_shard *s;
+	size_t len, pos;
+	uint64_t hv;
+
+	if (!ch || !key)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	len = strlen(key);
+	hv = chash_key_hash(ch, key, len);
+	s = chash_pick(ch, hv);
+	mcpkg_rwlock_wrlock(s->lock);
+	if (mcpkg_hash_find_h(s->h, key, len, hv, &pos)) {
+		if (out)
+			chash_copy_out(ch, s->h, pos, out);
+		mcpkg_hash_erase_at(s->h, pos);
+		ret = MCPKG_CONTAINER_OK;
+	}
+	mcpkg_rwlock_wrunlock(s->lock);
+	return ret;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_chash_remove(McPkgCHash *ch, const char *key)
+{
+	return mcpkg_chash_pop(ch, key, NULL);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_chash_remove_all(McPkgCHash *ch)
+{
+	MCPKG_CONTAINER_ERROR ret;
+	unsigned i;
+
+	if (!ch)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	for (i = 0; i < ch->n; i++) {
+		mcpkg_rwlock_wrlock(ch->shard[i].lock);
+		ret = mcpkg_hash_remove_all(ch->shard[i].h);
+		mcpkg_rwlock_wrunlock(ch->shard[i].lock);
+		if (ret != MCPKG_CONTAINER_OK)
+			return ret;
+	}
+	return MCPKG_CONTAINER_OK;
+}
+
+/* shards locked; stored hashes are reused, snap has the same seed */
+static MCPKG_CONTAINER_ERROR snapshot_fill(const struct McPkgCHash *ch,
+                McPkgHash *snap)
+{
+	MCPKG_CONTAINER_ERROR ret;
+	const McPkgHash *h;
+	const char *k;
+	unsigned i;
+	size_t p;
+
+	for (i = 0; i < ch->n; i++) {
+		h = ch->shard[i].h;
+		for (p = 0; p < h->cap; p++) {
+			if (!ctrl_is_full(h->ctrl[p]))
+				continue;
+			k = slot_key(h, p);
+			ret = mcpkg_hash_set_h(snap, k, strlen(k), h->hashes[p],
+			                       h->values + p * h->value_size);
+			if (ret != MCPKG_CONTAINER_OK)
+				return ret;
+		}
+	}
+	return MCPKG_CONTAINER_OK;
+}
+
+McPkgHash *mcpkg_chash_snapshot(const McPkgCHash *ch)
+{
+	uint64_t bytes = 0;
+	unsigned long long b;
+	size_t pairs = 0, p;
+	McPkgHash *snap;
+	unsigned i;
+
+	if (!ch)
+		return NULL;
+
+	for (i = 0; i < ch->n; i++) {
+		mcpkg_hash_get_limits(ch->shard[i].h, &p, &b);
+		if (mcpkg_math_add_overflow_size(pairs, p, &pairs))
+			pairs = (size_t)-1;
+		if (mcpkg_math_add_overflow_u64(bytes, b, &bytes))
+			bytes = UINT64_MAX;
+	}
+
+	snap = mcpkg_hash_new(ch->value_size, &ch->ops, pairs, bytes);
+	if (!snap)
+		return NULL;
+	snap->hash_fn = ch->shard[0].h->hash_fn;
+	snap->k0 = ch->shard[0].h->k0;
+	snap->k1 = ch->shard[0].h->k1;
+
+	/* ascending order; writers hold one shard at a time */
+	for (i = 0; i < ch->n; i++)
+		mcpkg_rwlock_rdlock(ch->shard[i].lock);
+	if (snapshot_fill(ch, snap) != MCPKG_CONTAINER_OK) {
+		mcpkg_hash_free(snap);
+		snap = NULL;
+	}
+	for (i = ch->n; i-- > 0;)
+		mcpkg_rwlock_rdunlock(ch->shard[i].lock);
+	return snap;
+}
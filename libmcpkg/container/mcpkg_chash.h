@@ -0,0 +1,101 @@
+#ifndef MCPKG_CHASH_H
+#define MCPKG_CHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mcpkg_export.h"
+#include "container/mcpkg_container_error.h"
+#include "container/mcpkg_hash.h"
+
+MCPKG_BEGIN_DECLS
+
+/*
+ * McPkgCHash: thread-safe string-key → by-value map for shared caches.
+ * - Split into a power-of-two number of McPkgHash shards, each behind its
+ *   own RW lock; a key's seeded hash picks the shard (top bits) and is
+ *   reused for the probe inside it, so each call hashes the key once.
+ * - Readers on different keys rarely contend; readers of one shard run
+ *   in parallel, writers lock a single shard.
+ * - Same McPkgHashOps as McPkgHash. Hooks run under the shard lock and
+ *   may run concurrently for different shards; ctx must tolerate that.
+ * - Explicit max_pairs / max_bytes are split evenly over the shards.
+ */
+
+typedef struct McPkgCHash McPkgCHash;
+
+/* Default shard count (enough for 32 threads with little contention). */
+#define MCPKG_CHASH_DEFAULT_SHARDS  64u
+#define MCPKG_CHASH_MAX_SHARDS      1024u
+
+/* shards: 0 = default, otherwise rounded up to a power of two. */
+MCPKG_API McPkgCHash *mcpkg_chash_new(size_t value_size,
+                                      const McPkgHashOps *ops_or_null,
+                                      unsigned shards,
+                                      size_t max_pairs /*0=default*/,
+                                      unsigned long long max_bytes /*0=def*/);
+
+/* Free the map; no other thread may still be using it. */
+MCPKG_API void mcpkg_chash_free(McPkgCHash *ch);
+
+/* Entries over all shards; only a hint while writers are active. */
+MCPKG_API size_t mcpkg_chash_size(const McPkgCHash *ch);
+
+MCPKG_API unsigned mcpkg_chash_shards(const McPkgCHash *ch);
+
+/*
+ * See mcpkg_hash_set_hash_fn. The hash also picks the shard, so this is
+ * only allowed while the map is empty (ERR_INVALID otherwise) and must
+ * not race with other calls.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_chash_set_hash_fn(McPkgCHash *ch, MCPKG_HASH_FN fn);
+
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_chash_set(McPkgCHash *ch,
+                const char *key,
+                const void *value);
+
+/*
+ * Copy value for key into *out. With ops.value_copy set, out receives a
+ * deep copy (made under the shard lock) and the caller must release it
+ * with value_dtor; a plain byte copy could point at data a concurrent
+ * set/remove is about to free.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_chash_get(const McPkgCHash *ch,
+                const char *key,
+                void *out);
+
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_chash_remove(McPkgCHash *ch,
+                const char *key);
+
+/* If key exists, copy its value to out (nullable, as get) and remove it. */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_chash_pop(McPkgCHash *ch,
+                const char *key,
+                void *out /*nullable*/);
+
+MCPKG_API int mcpkg_chash_contains(const McPkgCHash *ch, const char *key);
+
+/* (key,len) variants; same NUL rules as mcpkg_hash_set_n. */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_chash_set_n(McPkgCHash *ch,
+                const char *key, size_t len,
+                const void *value);
+
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_chash_get_n(const McPkgCHash *ch,
+                const char *key, size_t len,
+                void *out);
+
+MCPKG_API int mcpkg_chash_contains_n(const McPkgCHash *ch, const char *key,
+                                     size_t len);
+
+/* Remove all entries, one shard at a time. */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_chash_remove_all(McPkgCHash *ch);
+
+/*
+ * Snapshot read: copy every entry into a new, private McPkgHash while
+ * all shards are read-locked, so the copy is one consistent state.
+ * Iterate or query it without locks; free with mcpkg_hash_free.
+ * NULL on failure.
+ */
+MCPKG_API McPkgHash *mcpkg_chash_snapshot(const McPkgCHash *ch);
+
+MCPKG_END_DECLS
+#endif /* MCPKG_CHASH_H */
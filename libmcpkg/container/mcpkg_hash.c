@@ -2,80 +2,179 @@
 
 /* ---------- core table ops (non-inline) ---------- */
 
-static MCPKG_CONTAINER_ERROR rehash(struct McPkgHash *h, size_t new_cap)
+/*
+ * First EMPTY/DELETED slot on hv's probe sequence (no key compare),
+ * within the MCPKG_HASH_MAX_PROBE groups find_slot searches.
+ */
+static size_t probe_free(const struct McPkgHash *h, uint64_t hv)
+{
+	size_t gmask = group_count(h) - 1;
+	size_t g = hash_h1(hv) & gmask;
+	size_t step;
+	uint64_t m;
+
+	for (step = 0; step <= gmask && step < MCPKG_HASH_MAX_PROBE; step++) {
+		m = group_match_free(h->ctrl + g * MCPKG_HASH_GROUP_WIDTH);
+		if (m)
+			return g * MCPKG_HASH_GROUP_WIDTH + group_mask_lowest(m);
+		g = (g + step + 1) & gmask;
+	}
+	return (size_t) -1;
+}
+
+/* copy key into slot pos according to the key mode; 0 ok */
+static int store_key(struct McPkgHash *h, size_t pos, const char *key,
+                     size_t len)
+{
+	char *in;
+
+	switch (h->key_mode) {
+	case MCPKG_CONTAINER_KEYS_ARENA:
+		if (len < MCPKG_HASH_INLINE_KEY) {
+			in = h->inl + pos * MCPKG_HASH_INLINE_KEY;
+			memcpy(in, key, len);
+			in[len] = '\0';
+			h->keys[pos] = NULL;
+			return 0;
+		}
+		h->keys[pos] = mcpkg_str_arena_dupn(h->arena, key, len);
+		break;
+	case MCPKG_CONTAINER_KEYS_INTERNED:
+		h->keys[pos] = (char *)mcpkg_str_intern_addn(h->intern, key,
+		               len);
+		break;
+	default:
+		h->keys[pos] = mcpkg_allocator_strndup(h->alloc, key, len);
+		break;
+	}
+	return h->keys[pos] ? 0 : -1;
+}
+
+/* only owned keys are freed one by one */
+static void release_key(struct McPkgHash *h, size_t pos)
+{
+	if (h->key_mode == MCPKG_CONTAINER_KEYS_OWNED)
+		mcpkg_allocator_free(h->alloc, h->keys[pos], 0);
+	h->keys[pos] = NULL;
+}
+
+static void release_keys(struct McPkgHash *h)
+{
+	size_t i;
+
+	if (h->key_mode == MCPKG_CONTAINER_KEYS_OWNED) {
+		for (i = 0; i < h->cap; i++) {
+			if (ctrl_is_full(h->ctrl[i]))
+				mcpkg_allocator_free(h->alloc, h->keys[i], 0);
+		}
+	}
+	memset(h->keys, 0, h->cap * sizeof(*h->keys));
+	if (h->arena)
+		mcpkg_str_arena_reset(h->arena);
+}
+
+/* release one set of table arrays sized for cap slots */
+static void table_free(const struct McPkgHash *h, char **keys, char *inl,
+                       uint64_t *hashes, unsigned char *ctrl,
+                       unsigned char *values, size_t cap)
+{
+	mcpkg_allocator_free(h->alloc, keys, cap * sizeof(*keys));
+	mcpkg_allocator_free(h->alloc, inl, cap * MCPKG_HASH_INLINE_KEY);
+	mcpkg_allocator_free(h->alloc, hashes, cap * sizeof(*hashes));
+	mcpkg_allocator_free(h->alloc, ctrl, cap);
+	mcpkg_allocator_free(h->alloc, values, cap * h->value_size);
+}
+
+static MCPKG_CONTAINER_ERROR rehash_to(struct McPkgHash *h, size_t new_cap)
 {
 	char **old_keys;
+	char *old_inl;
 	uint64_t *old_hashes;
-	unsigned char *old_states;
+	unsigned char *old_ctrl;
 	unsigned char *old_values;
-	size_t old_cap, i;
+	size_t old_cap, old_len, old_tombs, i;
 	size_t bytes;
 	size_t est;
 
 	char **keys = NULL;
+	char *inl = NULL;
 	uint64_t *hashes = NULL;
-	unsigned char *states = NULL;
+	unsigned char *ctrl = NULL;
 	unsigned char *values = NULL;
 
 	if (!h)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
+	if (new_cap < MCPKG_HASH_GROUP_WIDTH)
+		new_cap = MCPKG_HASH_GROUP_WIDTH;
 	new_cap = mcpkg_math_next_pow2_size(new_cap);
 
-	if (table_bytes_est(new_cap, h->value_size, &est))
+	if (table_bytes_est(h, new_cap, &est))
 		return MCPKG_CONTAINER_ERR_OVERFLOW;
 
 	if ((unsigned long long)est > h->max_bytes)
 		return MCPKG_CONTAINER_ERR_LIMIT;
 
-	keys = calloc(new_cap, sizeof(*keys));
-	hashes = calloc(new_cap, sizeof(*hashes));
-	states = calloc(new_cap, sizeof(*states));
-	if (!keys || !hashes || !states)
+	keys = mcpkg_allocator_calloc(h->alloc, new_cap, sizeof(*keys));
+	hashes = mcpkg_allocator_calloc(h->alloc, new_cap, sizeof(*hashes));
+	ctrl = mcpkg_allocator_alloc(h->alloc, new_cap);
+	if (!keys || !hashes || !ctrl)
 		goto oom;
+	if (h->key_mode == MCPKG_CONTAINER_KEYS_ARENA) {
+		inl = mcpkg_allocator_alloc(h->alloc,
+		                            new_cap * MCPKG_HASH_INLINE_KEY);
+		if (!inl)
+			goto oom;
+	}
+	memset(ctrl, HCTRL_EMPTY, new_cap);
 
 	if (mcpkg_math_mul_overflow_size(new_cap,
 	                                 h->value_size, &bytes))
 		goto overflow;
 
-	values = malloc(bytes);
+	values = mcpkg_allocator_calloc(h->alloc, 1, bytes);
 	if (!values)
 		goto oom;
-	memset(values, 0, bytes);
 
 	/* stash old */
 	old_keys = h->keys;
+	old_inl = h->inl;
 	old_hashes = h->hashes;
-	old_states = h->states;
+	old_ctrl = h->ctrl;
 	old_values = h->values;
 	old_cap = h->cap;
+	old_len = h->len;
+	old_tombs = h->tombs;
 
 	/* install new */
 	h->keys = keys;
+	h->inl = inl;
 	h->hashes = hashes;
-	h->states = states;
+	h->ctrl = ctrl;
 	h->values = values;
 	h->cap = new_cap;
 	h->len = 0;
+	h->tombs = 0;
 
 	/* move entries */
 	if (old_cap) {
 		for (i = 0; i < old_cap; i++) {
-			size_t pos, step = 0;
+			size_t pos;
 
-			if (old_states[i] != HST_FULL)
+			if (!ctrl_is_full(old_ctrl[i]))
 				continue;
 
-			pos = (size_t)(old_hashes[i] & (h->cap - 1));
-			while (h->states[pos] == HST_FULL) {
-				pos = (pos + 1) & (h->cap - 1);
-				if (++step > h->cap)
-					goto corrupt;
-			}
+			pos = probe_free(h, old_hashes[i]);
+			if (pos == (size_t) -1)
+				goto crowded;
 
 			h->keys[pos] = old_keys[i];
+			if (inl && !old_keys[i])
+				memcpy(inl + pos * MCPKG_HASH_INLINE_KEY,
+				       old_inl + i * MCPKG_HASH_INLINE_KEY,
+				       MCPKG_HASH_INLINE_KEY);
 			h->hashes[pos] = old_hashes[i];
-			h->states[pos] = HST_FULL;
+			h->ctrl[pos] = old_ctrl[i];
 
 			memcpy(h->values + pos * h->value_size,
 			       old_values + i * h->value_size,
@@ -83,103 +182,145 @@ static MCPKG_CONTAINER_ERROR rehash(struct McPkgHash *h, size_t new_cap)
 			h->len++;
 		}
 
-		free(old_keys);
-		free(old_hashes);
-		free(old_states);
-		free(old_values);
+		table_free(h, old_keys, old_inl, old_hashes, old_ctrl,
+		           old_values, old_cap);
 	}
 
 	return MCPKG_CONTAINER_OK;
 
 overflow:
-	free(keys);
-	free(hashes);
-	free(states);
+	table_free(h, keys, inl, hashes, ctrl, NULL, new_cap);
 	return MCPKG_CONTAINER_ERR_OVERFLOW;
 
 oom:
-	free(keys);
-	free(hashes);
-	free(states);
-	free(values);
+	table_free(h, keys, inl, hashes, ctrl, values, new_cap);
 	return MCPKG_CONTAINER_ERR_NO_MEM;
 
-corrupt:
-	/* should never happen; treat as OTHER */
-	free(keys);
-	free(hashes);
-	free(states);
-	free(values);
-	/* restore old (best effort) */
+crowded:
+	/* a probe chain ran past the bound; the old table is untouched */
+	table_free(h, keys, inl, hashes, ctrl, values, new_cap);
 	h->keys = old_keys;
+	h->inl = old_inl;
 	h->hashes = old_hashes;
-	h->states = old_states;
+	h->ctrl = old_ctrl;
 	h->values = old_values;
 	h->cap = old_cap;
+	h->len = old_len;
+	h->tombs = old_tombs;
 	return MCPKG_CONTAINER_ERR_OTHER;
 }
 
-static MCPKG_CONTAINER_ERROR maybe_grow(struct McPkgHash *h)
+/* rebuild at new_cap; a chain too long for it gets one doubling, as in set */
+static MCPKG_CONTAINER_ERROR rehash(struct McPkgHash *h, size_t new_cap)
 {
-	size_t new_cap;
+	MCPKG_CONTAINER_ERROR ret = rehash_to(h, new_cap);
+
+	if (ret == MCPKG_CONTAINER_ERR_OTHER)
+		ret = rehash_to(h, new_cap << 1);
+	return ret == MCPKG_CONTAINER_ERR_OTHER ? MCPKG_CONTAINER_ERR_LIMIT : ret;
+}
 
+static MCPKG_CONTAINER_ERROR maybe_grow(struct McPkgHash *h)
+{
 	if (!h)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
 	if (!h->cap)
-		return rehash(h, 8);
+		return rehash(h, MCPKG_HASH_GROUP_WIDTH);
 
-	if (!loadfactor_exceeded(h->len + 1, h->cap))
+	if (!loadfactor_exceeded(h->len + h->tombs + 1, h->cap))
 		return MCPKG_CONTAINER_OK;
 
-	new_cap = h->cap << 1;
-	return rehash(h, new_cap);
+	/* mostly tombstones: rebuild in place instead of doubling */
+	if (h->tombs > h->len)
+		return rehash(h, h->cap);
+
+	return rehash(h, h->cap << 1);
 }
 
-/* locate slot for key; on insert path, remember first tombstone */
+/*
+ * Probe group by group (triangular over groups, visits each once).
+ * Returns 1 found (*pos_out = slot), 2 not found (*pos_out = first free
+ * slot on the path), -1 probe bound hit (*pos_out = free slot or -1).
+ */
 static int find_slot(const struct McPkgHash *h, const char *key,
-                     uint64_t hv, size_t *pos_out, size_t *tomb_out)
+                     size_t len, uint64_t hv, size_t *pos_out)
 {
-	size_t pos, step = 0;
-	size_t tomb = (size_t) -1;
+	size_t gmask, g, step, base;
+	size_t free_pos = (size_t) -1;
+	unsigned char tag = hash_h2(hv);
+	const unsigned char *grp;
+	uint64_t m;
 
-	if (!h || !key || !pos_out)
+	if (!h || !key || !pos_out || !h->cap)
 		return 0;
 
-	pos = (size_t)(hv & (h->cap - 1));
-	for (;;) {
-		unsigned char st = h->states[pos];
+	gmask = group_count(h) - 1;
+	g = hash_h1(hv) & gmask;
+	for (step = 0; step <= gmask && step < MCPKG_HASH_MAX_PROBE; step++) {
+		base = g * MCPKG_HASH_GROUP_WIDTH;
+		grp = h->ctrl + base;
+
+		for (m = group_match(grp, tag); m; m &= m - 1) {
+			size_t pos = base + group_mask_lowest(m);
 
-		if (st == HST_EMPTY) {
-			if (tomb_out)
-				*tomb_out = tomb;
-			*pos_out = pos;
-			return 2; /* empty slot, not found */
-		}
-		if (st == HST_TOMB) {
-			if (tomb == (size_t) -1)
-				tomb = pos;
-		} else {
 			if (h->hashes[pos] == hv &&
-			    h->keys[pos] &&
-			    strcmp(h->keys[pos], key) == 0) {
+			    slot_key_eq(h, pos, key, len)) {
 				*pos_out = pos;
-				if (tomb_out)
-					*tomb_out = tomb;
 				return 1; /* found */
 			}
 		}
 
-		pos = (pos + 1) & (h->cap - 1);
-		if (++step > MCPKG_HASH_MAX_PROBE)
-			return -1; /* probe bound hit */
+		if (free_pos == (size_t) -1) {
+			m = group_match_free(grp);
+			if (m)
+				free_pos = base + group_mask_lowest(m);
+		}
+
+		/* an EMPTY slot ends every probe chain through this group */
+		if (group_match_empty(grp)) {
+			*pos_out = free_pos;
+			return 2; /* not found */
+		}
+
+		g = (g + step + 1) & gmask;
+	}
+
+	*pos_out = free_pos;
+	return -1; /* probe bound hit */
+}
+
+/*
+ * Release slot pos. If its group still has an EMPTY no probe chain runs
+ * through it, so the slot can go back to EMPTY instead of a tombstone.
+ */
+static void erase_slot(struct McPkgHash *h, size_t pos)
+{
+	const unsigned char *grp;
+
+	release_key(h, pos);
+	if (h->ops.value_dtor) {
+		void *v = h->values + pos * h->value_size;
+		h->ops.value_dtor(v, h->ops.ctx);
+	}
+
+	grp = h->ctrl + (pos & ~(size_t)(MCPKG_HASH_GROUP_WIDTH - 1));
+	if (group_match_empty(grp)) {
+		h->ctrl[pos] = HCTRL_EMPTY;
+	} else {
+		h->ctrl[pos] = HCTRL_DELETED;
+		h->tombs++;
 	}
+	h->len--;
 }
 
 /* ---------- public API ---------- */
 
-McPkgHash *mcpkg_hash_new(size_t value_size, const McPkgHashOps *ops_or_null,
-                          size_t max_pairs, unsigned long long max_bytes)
+McPkgHash *mcpkg_hash_new_alloc(const McPkgAllocator *alloc,
+                                size_t value_size,
+                                const McPkgHashOps *ops_or_null,
+                                size_t max_pairs,
+                                unsigned long long max_bytes)
 {
 	struct McPkgHash *h;
 	size_t est;
@@ -187,10 +328,12 @@ McPkgHash *mcpkg_hash_new(size_t value_size, const McPkgHashOps *ops_or_null,
 	if (!value_size)
 		return NULL;
 
-	h = calloc(1, sizeof(*h));
+	alloc = alloc ? alloc : mcpkg_allocator_default();
+	h = mcpkg_allocator_calloc(alloc, 1, sizeof(*h));
 	if (!h)
 		return NULL;
 
+	h->alloc = alloc;
 	h->value_size = value_size;
 
 	if (ops_or_null)
@@ -201,10 +344,10 @@ McPkgHash *mcpkg_hash_new(size_t value_size, const McPkgHashOps *ops_or_null,
 	h->max_pairs = max_pairs ? max_pairs : MCPKG_CONTAINER_MAX_ELEMENTS;
 	h->max_bytes = max_bytes ? max_bytes : MCPKG_CONTAINER_MAX_BYTES;
 
-	/* sanity: minimum table of 8 must fit the byte cap */
-	if (table_bytes_est(8, h->value_size, &est) ||
+	/* sanity: minimum table of one group must fit the byte cap */
+	if (table_bytes_est(h, MCPKG_HASH_GROUP_WIDTH, &est) ||
 	    (unsigned long long)est > h->max_bytes) {
-		free(h);
+		mcpkg_allocator_free(alloc, h, sizeof(*h));
 		return NULL;
 	}
 
@@ -212,6 +355,13 @@ McPkgHash *mcpkg_hash_new(size_t value_size, const McPkgHashOps *ops_or_null,
 	return h;
 }
 
+McPkgHash *mcpkg_hash_new(size_t value_size, const McPkgHashOps *ops_or_null,
+                          size_t max_pairs, unsigned long long max_bytes)
+{
+	return mcpkg_hash_new_alloc(NULL, value_size, ops_or_null, max_pairs,
+	                            max_bytes);
+}
+
 void mcpkg_hash_free(McPkgHash *h)
 {
 	size_t i;
@@ -219,29 +369,21 @@ void mcpkg_hash_free(McPkgHash *h)
 	if (!h)
 		return;
 
-	if (h->cap && h->keys && h->states) {
-		for (i = 0; i < h->cap; i++) {
-			if (h->states[i] == HST_FULL && h->keys[i]) {
-				free(h->keys[i]);
-				h->keys[i] = NULL;
-			}
-		}
-	}
+	if (h->cap && h->keys && h->ctrl)
+		release_keys(h);
 
 	if (h->ops.value_dtor && h->values && h->cap) {
 		for (i = 0; i < h->cap; i++) {
-			if (h->states[i] == HST_FULL) {
+			if (ctrl_is_full(h->ctrl[i])) {
 				void *v = h->values + i * h->value_size;
 				h->ops.value_dtor(v, h->ops.ctx);
 			}
 		}
 	}
 
-	free(h->keys);
-	free(h->hashes);
-	free(h->states);
-	free(h->values);
-	free(h);
+	table_free(h, h->keys, h->inl, h->hashes, h->ctrl, h->values, h->cap);
+	mcpkg_str_arena_free(h->arena);
+	mcpkg_allocator_free(h->alloc, h, sizeof(*h));
 }
 
 size_t mcpkg_hash_size(const McPkgHash *h)
@@ -281,13 +423,13 @@ mcpkg_hash_set_limits(McPkgHash *h, size_t max_pairs,
 		return MCPKG_CONTAINER_ERR_LIMIT;
 
 	if (h->cap) {
-		if (table_bytes_est(h->cap, h->value_size, &est))
+		if (table_bytes_est(h, h->cap, &est))
 			return MCPKG_CONTAINER_ERR_OVERFLOW;
 		if ((unsigned long long)est > max_bytes)
 			return MCPKG_CONTAINER_ERR_LIMIT;
 	}
 
-	if (table_bytes_est(8, h->value_size, &est))
+	if (table_bytes_est(h, MCPKG_HASH_GROUP_WIDTH, &est))
 		return MCPKG_CONTAINER_ERR_OVERFLOW;
 	if ((unsigned long long)est > max_bytes)
 		return MCPKG_CONTAINER_ERR_LIMIT;
@@ -307,33 +449,108 @@ MCPKG_CONTAINER_ERROR mcpkg_hash_remove_all(McPkgHash *h)
 	if (h->cap == 0)
 		return MCPKG_CONTAINER_OK;
 
-	if (h->keys) {
-		for (i = 0; i < h->cap; i++) {
-			if (h->states[i] == HST_FULL && h->keys[i]) {
-				free(h->keys[i]);
-				h->keys[i] = NULL;
-			}
-		}
-	}
+	if (h->keys)
+		release_keys(h);
 
 	if (h->ops.value_dtor && h->values) {
 		for (i = 0; i < h->cap; i++) {
-			if (h->states[i] == HST_FULL) {
+			if (ctrl_is_full(h->ctrl[i])) {
 				void *v = h->values + i * h->value_size;
 				h->ops.value_dtor(v, h->ops.ctx);
 			}
 		}
 	}
 
-	memset(h->states, 0, h->cap * sizeof(h->states[0]));
+	memset(h->ctrl, HCTRL_EMPTY, h->cap);
 	h->len = 0;
+	h->tombs = 0;
 	return MCPKG_CONTAINER_OK;
 }
 
+MCPKG_CONTAINER_ERROR
+mcpkg_hash_set_key_mode(McPkgHash *h, MCPKG_CONTAINER_KEYS mode,
+                        McPkgStrIntern *intern_or_null)
+{
+	McPkgStrArena *arena = NULL;
+
+	if (!h)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (mode == MCPKG_CONTAINER_KEYS_INTERNED && !intern_or_null)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (mode > MCPKG_CONTAINER_KEYS_INTERNED)
+		return MCPKG_CONTAINER_ERR_INVALID;
+	if (h->len)
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	if (mode == MCPKG_CONTAINER_KEYS_ARENA) {
+		arena = mcpkg_str_arena_new_alloc(h->alloc, h->max_bytes);
+		if (!arena)
+			return MCPKG_CONTAINER_ERR_NO_MEM;
+	}
+
+	/* empty: drop the table, the next insert sizes it for the mode */
+	table_free(h, h->keys, h->inl, h->hashes, h->ctrl, h->values, h->cap);
+	mcpkg_str_arena_free(h->arena);
+	h->keys = NULL;
+	h->inl = NULL;
+	h->hashes = NULL;
+	h->ctrl = NULL;
+	h->values = NULL;
+	h->cap = 0;
+	h->tombs = 0;
+
+	h->key_mode = mode;
+	h->arena = arena;
+	h->intern = mode == MCPKG_CONTAINER_KEYS_INTERNED ? intern_or_null
+	            : NULL;
+	return MCPKG_CONTAINER_OK;
+}
+
+static void rehash_keys(struct McPkgHash *h)
+{
+	const char *k;
+	size_t i;
+
+	for (i = 0; i < h->cap; i++) {
+		if (!ctrl_is_full(h->ctrl[i]))
+			continue;
+		k = slot_key(h, i);
+		h->hashes[i] = key_hash_n(h, k, strlen(k));
+		h->ctrl[i] = hash_h2(h->hashes[i]);
+	}
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_set_hash_fn(McPkgHash *h, MCPKG_HASH_FN fn)
+{
+	MCPKG_CONTAINER_ERROR ret;
+	MCPKG_HASH_FN old;
+
+	if (!h)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (fn > MCPKG_HASH_FN_WYHASH)
+		return MCPKG_CONTAINER_ERR_INVALID;
+	if (fn == h->hash_fn)
+		return MCPKG_CONTAINER_OK;
+
+	old = h->hash_fn;
+	h->hash_fn = fn;
+	if (!h->len)
+		return MCPKG_CONTAINER_OK;
+
+	/* new hashes/tags, then rebuild the probe sequences */
+	rehash_keys(h);
+	ret = rehash(h, h->cap);
+	if (ret != MCPKG_CONTAINER_OK) {
+		/* slots did not move: old hashes match old positions */
+		h->hash_fn = old;
+		rehash_keys(h);
+	}
+	return ret;
+}
+
 MCPKG_CONTAINER_ERROR mcpkg_hash_remove(McPkgHash *h, const char *key)
 {
-	uint64_t hv;
-	size_t pos;
+	size_t n, pos;
 	int r;
 
 	if (!h || !key)
@@ -341,36 +558,22 @@ MCPKG_CONTAINER_ERROR mcpkg_hash_remove(McPkgHash *h, const char *key)
 	if (!h->cap || h->len == 0)
 		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
-	hv = key_hash(h, key);
-
-	r = find_slot(h, key, hv, &pos, NULL);
+	n = strlen(key);
+	r = find_slot(h, key, n, key_hash_n(h, key, n), &pos);
 	if (r != 1)
 		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
-	if (h->keys[pos]) {
-		free(h->keys[pos]);
-		h->keys[pos] = NULL;
-	}
-	if (h->ops.value_dtor) {
-		void *v = h->values + pos * h->value_size;
-		h->ops.value_dtor(v, h->ops.ctx);
-	}
-	h->states[pos] = HST_TOMB;
-	h->len--;
+	erase_slot(h, pos);
 	return MCPKG_CONTAINER_OK;
 }
 
-MCPKG_CONTAINER_ERROR mcpkg_hash_set(McPkgHash *h, const char *key,
-                                     const void *value)
+static MCPKG_CONTAINER_ERROR set_impl(struct McPkgHash *h, const char *key,
+                                      size_t len, uint64_t hv,
+                                      const void *value)
 {
 	MCPKG_CONTAINER_ERROR ret;
-	uint64_t hv;
-	size_t pos, tomb = (size_t) -1;
+	size_t pos;
 	int r;
-	char *kcopy;
-
-	if (!h || !key || !value)
-		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
 	if (h->len >= h->max_pairs)
 		return MCPKG_CONTAINER_ERR_LIMIT;
@@ -379,16 +582,15 @@ MCPKG_CONTAINER_ERROR mcpkg_hash_set(McPkgHash *h, const char *key,
 	if (ret != MCPKG_CONTAINER_OK)
 		return ret;
 
-	hv = key_hash(h, key);
-	r = find_slot(h, key, hv, &pos, &tomb);
+	r = find_slot(h, key, len, hv, &pos);
 
-	if (r == -1) {
+	if (r == -1 && pos == (size_t) -1) {
 		ret = rehash(h, h->cap << 1);
 		if (ret != MCPKG_CONTAINER_OK)
 			return ret;
 
-		r = find_slot(h, key, hv, &pos, &tomb);
-		if (r == -1)
+		r = find_slot(h, key, len, hv, &pos);
+		if (r == -1 && pos == (size_t) -1)
 			return MCPKG_CONTAINER_ERR_LIMIT;
 	}
 
@@ -403,15 +605,14 @@ MCPKG_CONTAINER_ERROR mcpkg_hash_set(McPkgHash *h, const char *key,
 		return MCPKG_CONTAINER_OK;
 	}
 
-	pos = (tomb != (size_t) -1) ? tomb : pos;
-
-	kcopy = dup_cstr(key);
-	if (!kcopy)
+	if (store_key(h, pos, key, len))
 		return MCPKG_CONTAINER_ERR_NO_MEM;
 
-	h->keys[pos] = kcopy;
+	if (h->ctrl[pos] == HCTRL_DELETED)
+		h->tombs--;
+
 	h->hashes[pos] = hv;
-	h->states[pos] = HST_FULL;
+	h->ctrl[pos] = hash_h2(hv);
 
 	if (h->ops.value_copy) {
 		h->ops.value_copy(h->values + pos * h->value_size, value,
@@ -425,71 +626,169 @@ MCPKG_CONTAINER_ERROR mcpkg_hash_set(McPkgHash *h, const char *key,
 	return MCPKG_CONTAINER_OK;
 }
 
-MCPKG_CONTAINER_ERROR mcpkg_hash_get(const McPkgHash *h, const char *key,
-                                     void *out)
+static MCPKG_CONTAINER_ERROR get_impl(const struct McPkgHash *h,
+                                      const char *key, size_t len,
+                                      uint64_t hv, void *out)
 {
-	uint64_t hv;
 	size_t pos;
-	int r;
 
-	if (!h || !key || !out)
-		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 	if (!h->cap || h->len == 0)
 		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
-	hv = key_hash(h, key);
-	r = find_slot(h, key, hv, &pos, NULL);
-	if (r != 1)
+	if (find_slot(h, key, len, hv, &pos) != 1)
 		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
 	memcpy(out, h->values + pos * h->value_size, h->value_size);
 	return MCPKG_CONTAINER_OK;
 }
 
-MCPKG_CONTAINER_ERROR mcpkg_hash_pop(McPkgHash *h, const char *key, void *out)
+static int contains_impl(const struct McPkgHash *h, const char *key,
+                         size_t len, uint64_t hv)
 {
-	uint64_t hv;
 	size_t pos;
-	int r;
+
+	if (!h->cap || !h->len)
+		return 0;
+
+	return find_slot(h, key, len, hv, &pos) == 1 ? 1 : 0;
+}
+
+uint64_t mcpkg_hash_key_hash(const McPkgHash *h, const char *key,
+                             size_t len)
+{
+	if (!h || (!key && len))
+		return 0;
+	return key_hash_n(h, key ? key : "", len);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_set(McPkgHash *h, const char *key,
+                                     const void *value)
+{
+	size_t n;
+
+	if (!h || !key || !value)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	n = strlen(key);
+	return set_impl(h, key, n, key_hash_n(h, key, n), value);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_set_n(McPkgHash *h, const char *key,
+                                       size_t len, const void *value)
+{
+	if (!h || !key || !value)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (!key_n_valid(key, len))
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	return set_impl(h, key, len, key_hash_n(h, key, len), value);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_set_h(McPkgHash *h, const char *key,
+                                       size_t len, uint64_t hv,
+                                       const void *value)
+{
+	if (!h || !key || !value)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (!key_n_valid(key, len))
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	return set_impl(h, key, len, hv, value);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_get(const McPkgHash *h, const char *key,
+                                     void *out)
+{
+	size_t n;
+
+	if (!h || !key || !out)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	n = strlen(key);
+	return get_impl(h, key, n, key_hash_n(h, key, n), out);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_get_n(const McPkgHash *h, const char *key,
+                                       size_t len, void *out)
+{
+	if (!h || !key || !out)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (!key_n_valid(key, len))
+		return MCPKG_CONTAINER_ERR_NOT_FOUND;
+
+	return get_impl(h, key, len, key_hash_n(h, key, len), out);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_get_h(const McPkgHash *h, const char *key,
+                                       size_t len, uint64_t hv, void *out)
+{
+	if (!h || !key || !out)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (!key_n_valid(key, len))
+		return MCPKG_CONTAINER_ERR_NOT_FOUND;
+
+	return get_impl(h, key, len, hv, out);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_pop(McPkgHash *h, const char *key, void *out)
+{
+	size_t n, pos;
 
 	if (!h || !key)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 	if (!h->cap || h->len == 0)
 		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
-	hv = key_hash(h, key);
-	r = find_slot(h, key, hv, &pos, NULL);
-	if (r != 1)
+	n = strlen(key);
+	if (find_slot(h, key, n, key_hash_n(h, key, n), &pos) != 1)
 		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
 	if (out)
 		memcpy(out, h->values + pos * h->value_size, h->value_size);
 
-	if (h->keys[pos]) {
-		free(h->keys[pos]);
-		h->keys[pos] = NULL;
-	}
-	if (h->ops.value_dtor) {
-		void *v = h->values + pos * h->value_size;
-		h->ops.value_dtor(v, h->ops.ctx);
-	}
-	h->states[pos] = HST_TOMB;
-	h->len--;
+	erase_slot(h, pos);
 	return MCPKG_CONTAINER_OK;
 }
 
 int mcpkg_hash_contains(const McPkgHash *h, const char *key)
 {
-	uint64_t hv;
-	size_t pos;
-	int r;
+	size_t n;
 
-	if (!h || !key || !h->cap || !h->len)
+	if (!h || !key)
+		return 0;
+
+	n = strlen(key);
+	return contains_impl(h, key, n, key_hash_n(h, key, n));
+}
+
+int mcpkg_hash_contains_n(const McPkgHash *h, const char *key, size_t len)
+{
+	if (!h || !key || !key_n_valid(key, len))
 		return 0;
 
-	hv = key_hash(h, key);
-	r = find_slot(h, key, hv, &pos, NULL);
-	return r == 1 ? 1 : 0;
+	return contains_impl(h, key, len, key_hash_n(h, key, len));
+}
+
+int mcpkg_hash_contains_h(const McPkgHash *h, const char *key, size_t len,
+                          uint64_t hv)
+{
+	if (!h || !key || !key_n_valid(key, len))
+		return 0;
+
+	return contains_impl(h, key, len, hv);
+}
+
+int mcpkg_hash_find_h(const McPkgHash *h, const char *key, size_t len,
+                      uint64_t hv, size_t *pos_out)
+{
+	if (!h || !key || !h->len || !key_n_valid(key, len))
+		return 0;
+	return find_slot(h, key, len, hv, pos_out) == 1;
+}
+
+void mcpkg_hash_erase_at(McPkgHash *h, size_t pos)
+{
+	erase_slot(h, pos);
 }
 
 MCPKG_CONTAINER_ERROR mcpkg_hash_iter_begin(const McPkgHash *h, size_t *it)
@@ -509,9 +808,9 @@ int mcpkg_hash_iter_next(const McPkgHash *h, size_t *it,
 		return 0;
 
 	for (i = *it; i < h->cap; i++) {
-		if (h->states[i] == HST_FULL) {
+		if (ctrl_is_full(h->ctrl[i])) {
 			if (key_out)
-				*key_out = h->keys[i];
+				*key_out = slot_key(h, i);
 			if (value_out)
 				memcpy(value_out,
 				       h->values + i * h->value_size,
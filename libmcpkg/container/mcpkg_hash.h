@@ -2,14 +2,18 @@
 #define MCPKG_HASH_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include "mcpkg_export.h"
 #include "container/mcpkg_container_error.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_str_intern.h"
 
 MCPKG_BEGIN_DECLS
 
 /*
  * McPkgHash: string-key → by-value map.
- * - Keys are owned (strdup on insert, free on remove/clear).
+ * - Keys are owned (strdup on insert, free on remove/clear) unless a
+ *   different key mode is selected (arena / interned).
  * - Values are stored by value (fixed value_size).
  * - Optional value hooks let you deep-copy / destroy internals.
  * - Unordered iteration; order is not stable.
@@ -24,12 +28,26 @@ typedef struct {
 	void *ctx;
 } McPkgHashOps;
 
+/* Key hash function; every choice is seeded per instance. */
+typedef enum {
+	MCPKG_HASH_FN_SIPHASH24 = 0,  /* default; safe for untrusted keys */
+	MCPKG_HASH_FN_SIPHASH13,      /* fewer rounds, still keyed */
+	MCPKG_HASH_FN_WYHASH,         /* fastest; trusted keys only */
+} MCPKG_HASH_FN;
+
 /* Create a map; caps default or as provided. Returns NULL on failure. */
 MCPKG_API McPkgHash *mcpkg_hash_new(size_t value_size,
                                     const McPkgHashOps *ops_or_null,
                                     size_t max_pairs /*0=default*/,
                                     unsigned long long max_bytes /*0=def*/);
 
+/* Same; table, keys and key arena come from alloc (NULL = default). */
+MCPKG_API McPkgHash *mcpkg_hash_new_alloc(const McPkgAllocator *alloc,
+                size_t value_size,
+                const McPkgHashOps *ops_or_null,
+                size_t max_pairs /*0=default*/,
+                unsigned long long max_bytes /*0=def*/);
+
 /* Free the map, its keys, and call value_dtor for remaining values. */
 MCPKG_API void mcpkg_hash_free(McPkgHash *h);
 
@@ -45,6 +63,24 @@ MCPKG_API MCPKG_CONTAINER_ERROR
 mcpkg_hash_set_limits(McPkgHash *h, size_t max_pairs,
                       unsigned long long max_bytes);
 
+/*
+ * Select key storage; only allowed while the map is empty.
+ * KEYS_ARENA: keys < 16 bytes inline in the slot, longer in an arena
+ *             (arena space of removed keys returns on remove_all/free).
+ * KEYS_INTERNED: keys come from intern (must outlive the map).
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_hash_set_key_mode(McPkgHash *h, MCPKG_CONTAINER_KEYS mode,
+                        McPkgStrIntern *intern_or_null);
+
+/*
+ * Switch the key hash function. Safe at any time; existing entries are
+ * rehashed in place. Use WYHASH only for keys from trusted sources
+ * (e.g. our own signed caches), never for network input.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_hash_set_hash_fn(McPkgHash *h, MCPKG_HASH_FN fn);
+
 /* Remove all entries (frees keys; calls value_dtor if provided). */
 MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_hash_remove_all(McPkgHash *h);
 
@@ -70,6 +106,42 @@ MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_hash_pop(McPkgHash *h,
 /* Return 1 if key exists, 0 if not. */
 MCPKG_API int mcpkg_hash_contains(const McPkgHash *h, const char *key);
 
+/*
+ * (key,len) variants for borrowed, non-terminated strings (e.g. from
+ * mcpkg_mp_get_str_borrow). key must not contain NUL bytes: set_n
+ * returns ERR_INVALID, lookups report not found.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_hash_set_n(McPkgHash *h,
+                const char *key, size_t len,
+                const void *value);
+
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_hash_get_n(const McPkgHash *h,
+                const char *key, size_t len,
+                void *out);
+
+MCPKG_API int mcpkg_hash_contains_n(const McPkgHash *h, const char *key,
+                                    size_t len);
+
+/*
+ * Prehashed variants: hv must come from mcpkg_hash_key_hash() on the same
+ * instance (hashes are seeded per instance and change with
+ * mcpkg_hash_set_hash_fn). Hash once and reuse across a get-then-set
+ * or repeated lookups of the same key.
+ */
+MCPKG_API uint64_t mcpkg_hash_key_hash(const McPkgHash *h, const char *key,
+                                       size_t len);
+
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_hash_set_h(McPkgHash *h,
+                const char *key, size_t len,
+                uint64_t hv, const void *value);
+
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_hash_get_h(const McPkgHash *h,
+                const char *key, size_t len,
+                uint64_t hv, void *out);
+
+MCPKG_API int mcpkg_hash_contains_h(const McPkgHash *h, const char *key,
+                                    size_t len, uint64_t hv);
+
 
 
 
@@ -80,6 +152,7 @@ MCPKG_API int mcpkg_hash_contains(const McPkgHash *h, const char *key);
  *   size_t it;
  *   mcpkg_hash_iter_begin(h, &it);
  *   while (mcpkg_hash_iter_next(h, &it, &k, buf_or_null)) { ... }
+ * Key pointers stay valid until the next mutation.
  */
 MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_hash_iter_begin(const McPkgHash *h,
                 size_t *it /*start*/);
@@ -0,0 +1,357 @@
+#include "container/mcpkg_hash_frozen.h"
+#include "container/mcpkg_hash_p.h"
+
+/*
+ * Image layout (native endian, every region 8-byte aligned):
+ *   frozen_hdr | slots[nslots] | entry_offs[count] | entries
+ * An entry is the key, its NUL, padding to 8, then the value: a hit
+ * touches one slot and one entry. A slot keeps the high hash bits as a
+ * tag and the entry offset (0 = empty; the entry blob starts with 8
+ * reserved bytes). Linear probing from hash_h1(). entry_offs only
+ * serve iteration. Every offset is checked against the blob before use,
+ * so a corrupt image cannot make a lookup read out of bounds.
+ */
+
+#define FROZEN_MAGIC     "MCPKFRZ1"
+#define FROZEN_VERSION   1u
+#define FROZEN_ENDIAN    0x01020304u
+#define FROZEN_MIN_SLOTS 8u
+
+struct frozen_hdr {
+	char     magic[8];
+	uint32_t version;
+	uint32_t endian;
+	uint32_t hash_fn;
+	uint32_t value_size;
+	uint64_t k0;
+	uint64_t k1;
+	uint64_t count;
+	uint64_t nslots;     /* pow2 */
+	uint64_t off_slots;
+	uint64_t off_entry_offs;
+	uint64_t off_entries;
+	uint64_t entries_len;
+	uint64_t total;
+	uint64_t reserved[4];
+};
+
+struct frozen_slot {
+	uint32_t tag;       /* hv >> 32 */
+	uint32_t eoff;      /* into the entry blob; 0 = empty */
+};
+
+struct McPkgFrozenHash {
+	const struct frozen_slot *slots;
+	const uint32_t           *entry_offs;
+	const char               *entries;
+	size_t                    entries_len;
+	size_t                    count;
+	size_t                    mask;
+	size_t                    value_size;
+	MCPKG_HASH_FN             hash_fn;
+	uint64_t                  k0;
+	uint64_t                  k1;
+};
+
+static inline size_t align8(size_t v)
+{
+	return (v + 7u) & ~(size_t)7u;
+}
+
+/* key (len bytes) + NUL, padded, then the padded value */
+static inline size_t entry_bytes(size_t len, size_t value_size)
+{
+	return align8(len + 1) + align8(value_size);
+}
+
+/* ---------- freeze ---------- */
+
+struct frozen_layout {
+	size_t nslots, entries_len;
+	size_t off_slots, off_entry_offs, off_entries, total;
+};
+
+static MCPKG_CONTAINER_ERROR frozen_plan(const struct McPkgHash *h,
+                struct frozen_layout *lo)
+{
+	size_t i, sz, blob = 8;
+
+	for (i = 0; i < h->cap; i++) {
+		if (!ctrl_is_full(h->ctrl[i]))
+			continue;
+		sz = entry_bytes(strlen(slot_key(h, i)), h->value_size);
+		if (mcpkg_math_add_overflow_size(blob, sz, &blob))
+			return MCPKG_CONTAINER_ERR_OVERFLOW;
+	}
+	/* entry offsets are 32-bit in the image */
+	if (blob > UINT32_MAX)
+		return MCPKG_CONTAINER_ERR_OVERFLOW;
+
+	lo->nslots = mcpkg_math_next_pow2_size(h->len * 2);
+	if (lo->nslots < FROZEN_MIN_SLOTS)
+		lo->nslots = FROZEN_MIN_SLOTS;
+	lo->entries_len = blob;
+
+	lo->off_slots = sizeof(struct frozen_hdr);
+	lo->off_entry_offs = lo->off_slots +
+	                     lo->nslots * sizeof(struct frozen_slot);
+	lo->off_entries = lo->off_entry_offs +
+	                  align8(h->len * sizeof(uint32_t));
+	if (mcpkg_math_add_overflow_size(lo->off_entries, blob, &lo->total))
+		return MCPKG_CONTAINER_ERR_OVERFLOW;
+	return MCPKG_CONTAINER_OK;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_hash_freeze(const McPkgHash *h, void **buf_out,
+                                        size_t *len_out)
+{
+	struct frozen_layout lo;
+	struct frozen_hdr hdr;
+	struct frozen_slot *slots;
+	MCPKG_CONTAINER_ERROR ret;
+	unsigned char *img, *e;
+	uint32_t *entry_offs;
+	size_t i, n = 0, eoff = 8, mask, pos, klen;
+	const char *k;
+
+	if (!h || !buf_out || !len_out)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (h->ops.value_copy || h->ops.value_dtor ||
+	    h->value_size > UINT32_MAX)
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	ret = frozen_plan(h, &lo);
+	if (ret != MCPKG_CONTAINER_OK)
+		return ret;
+
+	img = mcpkg_calloc(1, lo.total);
+	if (!img)
+		return MCPKG_CONTAINER_ERR_NO_MEM;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, FROZEN_MAGIC, sizeof(hdr.magic));
+	hdr.version = FROZEN_VERSION;
+	hdr.endian = FROZEN_ENDIAN;
+	hdr.hash_fn = (uint32_t)h->hash_fn;
+	hdr.value_size = (uint32_t)h->value_size;
+	hdr.k0 = h->k0;
+	hdr.k1 = h->k1;
+	hdr.count = h->len;
+	hdr.nslots = lo.nslots;
+	hdr.off_slots = lo.off_slots;
+	hdr.off_entry_offs = lo.off_entry_offs;
+	hdr.off_entries = lo.off_entries;
+	hdr.entries_len = lo.entries_len;
+	hdr.total = lo.total;
+	memcpy(img, &hdr, sizeof(hdr));
+
+	slots = (struct frozen_slot *)(void *)(img + lo.off_slots);
+	entry_offs = (uint32_t *)(void *)(img + lo.off_entry_offs);
+	mask = lo.nslots - 1;
+
+	/* stored hashes are reused: the image keeps h's fn and seed */
+	for (i = 0; i < h->cap; i++) {
+		if (!ctrl_is_full(h->ctrl[i]))
+			continue;
+		k = slot_key(h, i);
+		klen = strlen(k);
+		e = img + lo.off_entries + eoff;
+		memcpy(e, k, klen + 1);
+		memcpy(e + align8(klen + 1), h->values + i * h->value_size,
+		       h->value_size);
+		entry_offs[n++] = (uint32_t)eoff;
+
+		pos = hash_h1(h->hashes[i]) & mask;
+		while (slots[pos].eoff)
+			pos = (pos + 1) & mask;
+		slots[pos].tag = (uint32_t)(h->hashes[i] >> 32);
+		slots[pos].eoff = (uint32_t)eoff;
+
+		eoff += entry_bytes(klen, h->value_size);
+	}
+
+	*buf_out = img;
+	*len_out = lo.total;
+	return MCPKG_CONTAINER_OK;
+}
+
+/* ---------- view ---------- */
+
+static int region_ok(uint64_t off, uint64_t size, uint64_t total)
+{
+	return off <= total && size <= total - off && !(off & 7u);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_frozen_hash_open(const void *data, size_t len,
+                size_t value_size,
+                McPkgFrozenHash **out)
+{
+	const unsigned char *base = data;
+	struct McPkgFrozenHash *fh;
+	struct frozen_hdr hdr;
+
+	if (!data || !out)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	*out = NULL;
+	if (len < sizeof(hdr) || ((uintptr_t)data & 7u))
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	memcpy(&hdr, data, sizeof(hdr));
+	if (memcmp(hdr.magic, FROZEN_MAGIC, sizeof(hdr.magic)) != 0 ||
+	    hdr.version != FROZEN_VERSION || hdr.endian != FROZEN_ENDIAN ||
+	    hdr.hash_fn > MCPKG_HASH_FN_WYHASH || !value_size ||
+	    hdr.value_size != value_size ||
+	    hdr.total > len || hdr.entries_len > UINT32_MAX ||
+	    hdr.nslots > hdr.total / sizeof(struct frozen_slot) ||
+	    !mcpkg_math_is_pow2_size((size_t)hdr.nslots) ||
+	    hdr.count >= hdr.nslots)
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	/* products cannot overflow: both counts are bounded by total */
+	if (!region_ok(hdr.off_slots, hdr.nslots * sizeof(struct frozen_slot),
+	               hdr.total) ||
+	    !region_ok(hdr.off_entry_offs, hdr.count * sizeof(uint32_t),
+	               hdr.total) ||
+	    !region_ok(hdr.off_entries, hdr.entries_len, hdr.total))
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	fh = mcpkg_calloc(1, sizeof(*fh));
+	if (!fh)
+		return MCPKG_CONTAINER_ERR_NO_MEM;
+
+	fh->slots = (const struct frozen_slot *)(const void *)
+	            (base + hdr.off_slots);
+	fh->entry_offs = (const uint32_t *)(const void *)
+	                 (base + hdr.off_entry_offs);
+	fh->entries = (const char *)base + hdr.off_entries;
+	fh->entries_len = (size_t)hdr.entries_len;
+	fh->count = (size_t)hdr.count;
+	fh->mask = (size_t)hdr.nslots - 1;
+	fh->value_size = hdr.value_size;
+	fh->hash_fn = (MCPKG_HASH_FN)hdr.hash_fn;
+	fh->k0 = hdr.k0;
+	fh->k1 = hdr.k1;
+
+	*out = fh;
+	return MCPKG_CONTAINER_OK;
+}
+
+void mcpkg_frozen_hash_close(McPkgFrozenHash *fh)
+{
+	mcpkg_free(fh);
+}
+
+size_t mcpkg_frozen_hash_size(const McPkgFrozenHash *fh)
+{
+	return fh ? fh->count : 0;
+}
+
+/* value of the entry at eoff if its key is klen bytes and in bounds */
+static const void *entry_value(const struct McPkgFrozenHash *fh,
+                               size_t eoff, size_t klen)
+{
+	size_t voff = eoff + align8(klen + 1);
+
+	if (voff < eoff || voff > fh->entries_len ||
+	    fh->value_size > fh->entries_len - voff)
+		return NULL;
+	return fh->entries + voff;
+}
+
+const void *mcpkg_frozen_hash_get_ptr(const McPkgFrozenHash *fh,
+                                      const char *key, size_t len)
+{
+	const struct frozen_slot *s;
+	const char *k;
+	uint64_t hv;
+	uint32_t tag;
+	size_t pos, step;
+
+	if (!fh || !key || !fh->count || !key_n_valid(key, len))
+		return NULL;
+
+	hv = hash_fn_apply(fh->hash_fn, fh->k0, fh->k1, key, len);
+	tag = (uint32_t)(hv >> 32);
+	pos = hash_h1(hv) & fh->mask;
+	/* bounded: a corrupt image may have no empty slot */
+	for (step = 0; step <= fh->mask; step++) {
+		s = &fh->slots[pos];
+		if (!s->eoff)
+			return NULL;
+		if (s->tag == tag && s->eoff < fh->entries_len &&
+		    len < fh->entries_len - s->eoff) {
+			k = fh->entries + s->eoff;
+			if (strncmp(k, key, len) == 0 && k[len] == '\0')
+				return entry_value(fh, s->eoff, len);
+		}
+		pos = (pos + 1) & fh->mask;
+	}
+	return NULL;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_frozen_hash_get_n(const McPkgFrozenHash *fh,
+                const char *key, size_t len,
+                void *out)
+{
+	const void *v;
+
+	if (!fh || !key || !out)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	v = mcpkg_frozen_hash_get_ptr(fh, key, len);
+	if (!v)
+		return MCPKG_CONTAINER_ERR_NOT_FOUND;
+	memcpy(out, v, fh->value_size);
+	return MCPKG_CONTAINER_OK;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_frozen_hash_get(const McPkgFrozenHash *fh,
+                const char *key, void *out)
+{
+	if (!key)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	return mcpkg_frozen_hash_get_n(fh, key, strlen(key), out);
+}
+
+int mcpkg_frozen_hash_contains_n(const McPkgFrozenHash *fh, const char *key,
+                                 size_t len)
+{
+	return mcpkg_frozen_hash_get_ptr(fh, key, len) != NULL;
+}
+
+int mcpkg_frozen_hash_contains(const McPkgFrozenHash *fh, const char *key)
+{
+	return key ? mcpkg_frozen_hash_contains_n(fh, key, strlen(key)) : 0;
+}
+
+int mcpkg_frozen_hash_iter_next(const McPkgFrozenHash *fh, size_t *it,
+                                const char **key_out, void *value_out)
+{
+	const char *k, *nul;
+	const void *v;
+	size_t i, eoff;
+
+	if (!fh || !it)
+		return 0;
+
+	for (i = *it; i < fh->count; i++) {
+		eoff = fh->entry_offs[i];
+		if (!eoff || eoff >= fh->entries_len)
+			continue;
+		k = fh->entries + eoff;
+		nul = memchr(k, '\0', fh->entries_len - eoff);
+		if (!nul)
+			continue;
+		v = entry_value(fh, eoff, (size_t)(nul - k));
+		if (!v)
+			continue;
+		if (key_out)
+			*key_out = k;
+		if (value_out)
+			memcpy(value_out, v, fh->value_size);
+		*it = i + 1;
+		return 1;
+	}
+	*it = fh->count;
+	return 0;
+}
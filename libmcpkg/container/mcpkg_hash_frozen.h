@@ -0,0 +1,78 @@
+#ifndef MCPKG_HASH_FROZEN_H
+#define MCPKG_HASH_FROZEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mcpkg_export.h"
+#include "container/mcpkg_container_error.h"
+#include "container/mcpkg_hash.h"
+
+MCPKG_BEGIN_DECLS
+
+/*
+ * Frozen McPkgHash: a read-only, position-independent image of a hash
+ * that can be written to disk and mmap'ed back (mcpkg_fs_map_ro).
+ * - Offsets only, no pointers; open-addressed slots at load <= 1/2.
+ * - Keeps the source's hash function and seed, so freezing reuses the
+ *   stored hashes and lookups hash exactly once.
+ * - Opening checks the header and region bounds only (O(1)); lookups
+ *   read the mapping directly and stay in bounds on corrupt images.
+ * - Native byte order; an image from another endianness is rejected.
+ */
+
+typedef struct McPkgFrozenHash McPkgFrozenHash;
+
+/*
+ * Serialise h into an image (*buf_out, *len_out; mcpkg_free() it).
+ * Values are copied as raw bytes: maps with value_copy/value_dtor hooks
+ * own memory behind their values and are rejected (ERR_INVALID).
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_hash_freeze(const McPkgHash *h,
+                void **buf_out,
+                size_t *len_out);
+
+/*
+ * View an image (8-byte aligned, e.g. a mapping). data is not copied
+ * and must outlive the view. ERR_INVALID on a malformed image or one
+ * whose values are not value_size bytes (callers' out buffers).
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_frozen_hash_open(const void *data,
+                size_t len, size_t value_size,
+                McPkgFrozenHash **out);
+
+/* Free the view only; the caller still owns/unmaps data. */
+MCPKG_API void mcpkg_frozen_hash_close(McPkgFrozenHash *fh);
+
+MCPKG_API size_t mcpkg_frozen_hash_size(const McPkgFrozenHash *fh);
+
+/* Copy value for key into *out (value_size bytes). */
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_frozen_hash_get(const McPkgFrozenHash *fh, const char *key, void *out);
+
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_frozen_hash_get_n(const McPkgFrozenHash *fh, const char *key,
+                        size_t len, void *out);
+
+/* Zero-copy: value inside the image (8-byte aligned), or NULL. */
+MCPKG_API const void *mcpkg_frozen_hash_get_ptr(const McPkgFrozenHash *fh,
+                const char *key, size_t len);
+
+MCPKG_API int mcpkg_frozen_hash_contains(const McPkgFrozenHash *fh,
+                const char *key);
+
+MCPKG_API int mcpkg_frozen_hash_contains_n(const McPkgFrozenHash *fh,
+                const char *key, size_t len);
+
+/*
+ * Iteration in freeze order:
+ *   size_t it = 0;
+ *   while (mcpkg_frozen_hash_iter_next(fh, &it, &k, buf_or_null)) { ... }
+ * Keys point into the image.
+ */
+MCPKG_API int mcpkg_frozen_hash_iter_next(const McPkgFrozenHash *fh,
+                size_t *it,
+                const char **key_out,
+                void *value_out /*nullable*/);
+
+MCPKG_END_DECLS
+#endif /* MCPKG_HASH_FROZEN_H */
@@ -6,27 +6,57 @@
 #include <string.h>
 
 #include "container/mcpkg_hash.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_str_arena.h"
 #include "math/mcpkg_math.h"
 #include "crypto/mcpkg_sip_hash.h"
+#include "crypto/mcpkg_wy_hash.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define MCPKG_HASH_SSE2 1
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define MCPKG_HASH_NEON 1
+#  include <arm_neon.h>
+#endif
 
 #define MCPKG_HASH_LOAD_NUM   82
 #define MCPKG_HASH_LOAD_DEN   100
+/* max groups visited by one probe sequence */
 #define MCPKG_HASH_MAX_PROBE  64
 
-#define HST_EMPTY  0u
-#define HST_FULL   1u
-#define HST_TOMB   2u
+/*
+ * Swiss-table layout: one control byte per slot, slots grouped by 16.
+ * FULL slots keep the low 7 bits of the hash (H2) so a whole group is
+ * filtered with one vector compare before any key is touched.
+ */
+#define MCPKG_HASH_GROUP_WIDTH  16u
+
+/* KEYS_ARENA: keys shorter than this live in the slot itself */
+#define MCPKG_HASH_INLINE_KEY   16u
+
+#define HCTRL_EMPTY    0x80u
+#define HCTRL_DELETED  0xFEu
+/* FULL: 0x00..0x7F (H2 tag) */
 
 // INTERNAL STRUCT DEFINITION (private)
 struct McPkgHash {
-	char                  **keys;
+	char                  **keys;    /* NULL when the key is inline */
+	char                  *inl;      /* KEYS_ARENA: cap * INLINE_KEY */
 	uint64_t              *hashes;
-	unsigned char         *states;
+	unsigned char         *ctrl;
 	unsigned char         *values;
-	size_t                 cap;
+	size_t                 cap;     /* slots; pow2, multiple of a group */
 	size_t                 len;
+	size_t                 tombs;   /* DELETED control bytes */
 	size_t                 value_size;
 	McPkgHashOps           ops;
+	MCPKG_CONTAINER_KEYS   key_mode;
+	MCPKG_HASH_FN          hash_fn;
+	McPkgStrArena         *arena;    /* KEYS_ARENA */
+	McPkgStrIntern        *intern;   /* KEYS_INTERNED, not owned */
+	const McPkgAllocator  *alloc;
 	size_t                 max_pairs;
 	unsigned long long     max_bytes;
 	// SipHash key (128-bit)
@@ -34,21 +64,31 @@ struct McPkgHash {
 	uint64_t               k1;
 };
 
-static inline char *dup_cstr(const char *s)
+/* (ptr,len) keys must not hide a NUL; stored keys are C strings */
+static inline int key_n_valid(const char *key, size_t len)
 {
-	size_t n;
-	char *p;
+	return !len || !memchr(key, '\0', len);
+}
 
-	if (!s)
-		return NULL;
+static inline const char *slot_key(const struct McPkgHash *h, size_t pos)
+{
+	if (!h->keys[pos] && h->inl)
+		return h->inl + pos * MCPKG_HASH_INLINE_KEY;
+	return h->keys[pos];
+}
 
-	n = strlen(s);
-	p = malloc(n + 1);
-	if (!p)
-		return NULL;
+/*
+ * key is len bytes without NULs; interned keys usually match by pointer
+ * before any bytes are compared.
+ */
+static inline int slot_key_eq(const struct McPkgHash *h, size_t pos,
+                              const char *key, size_t len)
+{
+	const char *k = slot_key(h, pos);
 
-	memcpy(p, s, n + 1);
-	return p;
+	if (k != key && strncmp(k, key, len) != 0)
+		return 0;
+	return k[len] == '\0';
 }
 
 static inline int loadfactor_exceeded(size_t len, size_t cap)
@@ -57,14 +97,129 @@ static inline int loadfactor_exceeded(size_t len, size_t cap)
 	return (len * MCPKG_HASH_LOAD_DEN) > (cap * MCPKG_HASH_LOAD_NUM);
 }
 
-static inline uint64_t key_hash(const struct McPkgHash *h, const char *key)
+static inline uint64_t hash_fn_apply(MCPKG_HASH_FN fn, uint64_t k0,
+                                     uint64_t k1, const char *key, size_t n)
+{
+	switch (fn) {
+	case MCPKG_HASH_FN_SIPHASH13:
+		return mcpkg_siphash13_k(key, n, k0, k1);
+	case MCPKG_HASH_FN_WYHASH:
+		return mcpkg_wyhash_k(key, n, k0 ^ k1);
+	default:
+		return mcpkg_siphash24_k(key, n, k0, k1);
+	}
+}
+
+static inline uint64_t key_hash_n(const struct McPkgHash *h,
+                                  const char *key, size_t n)
+{
+	return hash_fn_apply(h->hash_fn, h->k0, h->k1, key, n);
+}
+
+/* H1 picks the first group, H2 is the 7-bit tag stored in ctrl */
+static inline size_t hash_h1(uint64_t hv)
+{
+	return (size_t)(hv >> 7);
+}
+
+static inline unsigned char hash_h2(uint64_t hv)
+{
+	return (unsigned char)(hv & 0x7Fu);
+}
+
+static inline int ctrl_is_full(unsigned char c)
+{
+	return (c & 0x80u) == 0;
+}
+
+/*
+ * Group match masks. SSE2 yields one bit per lane; NEON yields one bit
+ * per nibble (bit 3 of each lane's nibble), hence the lane shift.
+ */
+#if defined(MCPKG_HASH_SSE2)
+#define HGROUP_LANE_SHIFT 0
+
+static inline uint64_t group_match(const unsigned char *g, unsigned char tag)
+{
+	__m128i c = _mm_loadu_si128((const __m128i *)(const void *)g);
+
+	return (uint64_t)(unsigned)_mm_movemask_epi8(
+	               _mm_cmpeq_epi8(c, _mm_set1_epi8((char)tag)));
+}
+
+/* EMPTY or DELETED: both have the top bit set */
+static inline uint64_t group_match_free(const unsigned char *g)
+{
+	__m128i c = _mm_loadu_si128((const __m128i *)(const void *)g);
+
+	return (uint64_t)(unsigned)_mm_movemask_epi8(c);
+}
+#elif defined(MCPKG_HASH_NEON)
+#define HGROUP_LANE_SHIFT 2
+
+static inline uint64_t neon_nibble_mask(uint8x16_t eq)
 {
-	return mcpkg_sip_generate(key ? key : "", h->k0, h->k1);
+	uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+
+	return vget_lane_u64(vreinterpret_u64_u8(n), 0) &
+	       0x8888888888888888ULL;
+}
+
+static inline uint64_t group_match(const unsigned char *g, unsigned char tag)
+{
+	return neon_nibble_mask(vceqq_u8(vld1q_u8(g), vdupq_n_u8(tag)));
+}
+
+static inline uint64_t group_match_free(const unsigned char *g)
+{
+	return neon_nibble_mask(vcgeq_u8(vld1q_u8(g), vdupq_n_u8(0x80u)));
+}
+#else
+#define HGROUP_LANE_SHIFT 0
+
+static inline uint64_t group_match(const unsigned char *g, unsigned char tag)
+{
+	uint64_t m = 0;
+	unsigned i;
+
+	for (i = 0; i < MCPKG_HASH_GROUP_WIDTH; i++)
+		if (g[i] == tag)
+			m |= (uint64_t)1u << i;
+	return m;
+}
+
+static inline uint64_t group_match_free(const unsigned char *g)
+{
+	uint64_t m = 0;
+	unsigned i;
+
+	for (i = 0; i < MCPKG_HASH_GROUP_WIDTH; i++)
+		if (g[i] & 0x80u)
+			m |= (uint64_t)1u << i;
+	return m;
 }
+#endif
 
-static inline int table_bytes_est(size_t cap, size_t value_size, size_t *out)
+static inline uint64_t group_match_empty(const unsigned char *g)
 {
-	size_t a, b, c, d, sum;
+	return group_match(g, (unsigned char)HCTRL_EMPTY);
+}
+
+static inline size_t group_mask_lowest(uint64_t m)
+{
+	return (size_t)(mcpkg_math_ctz64(m) >> HGROUP_LANE_SHIFT);
+}
+
+static inline size_t group_count(const struct McPkgHash *h)
+{
+	return h->cap / MCPKG_HASH_GROUP_WIDTH;
+}
+
+static inline int table_bytes_est(const struct McPkgHash *h, size_t cap,
+                                  size_t *out)
+{
+	size_t a, b, c, d, e, sum;
+	size_t value_size = h->value_size;
 
 	if (!out)
 		return 1;
@@ -90,8 +245,25 @@ static inline int table_bytes_est(size_t cap, size_t value_size, size_t *out)
 	if (mcpkg_math_add_overflow_size(sum, d, &sum))
 		return 1;
 
+	e = 0;
+	if (h->key_mode == MCPKG_CONTAINER_KEYS_ARENA &&
+	    mcpkg_math_mul_overflow_size(cap, MCPKG_HASH_INLINE_KEY, &e))
+		return 1;
+
+	if (mcpkg_math_add_overflow_size(sum, e, &sum))
+		return 1;
+
 	*out = sum;
 	return 0;
 }
 
+/* ----- slot access for mcpkg_chash.c ----- */
+
+/* 1 and *pos_out = slot if key (NUL-free) is present, else 0 */
+int mcpkg_hash_find_h(const McPkgHash *h, const char *key, size_t len,
+                      uint64_t hv, size_t *pos_out);
+
+/* release key, run value_dtor and free the slot */
+void mcpkg_hash_erase_at(McPkgHash *h, size_t pos);
+
 #endif // MCPKG_HASH_P_H
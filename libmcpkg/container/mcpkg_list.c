@@ -1,11 +1,22 @@
 #include "mcpkg_list.h"
+#include "mcpkg_list_p.h"
 #include "mcpkg_str_list_p.h"
 
 #include <limits.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 #include "container/mcpkg_container_util.h"
+#include "crypto/mcpkg_sip_hash.h"
+
+/* index slot: element position + 1 (0 = empty) and its key hash */
+struct list_ix_slot {
+	uint64_t        h;
+	size_t          at;
+};
 
 struct McPkgList {
 	unsigned char	*data;              /* cap * elem_size bytes */
@@ -15,8 +26,150 @@ struct McPkgList {
 	McPkgListOps    ops;                /* copy/dtor/equals/ctx */
 	size_t          max_elements;       /* hard cap (count) */
 	unsigned long long	max_bytes;     /* hard cap (bytes) */
+
+	/* set_indexed: open addressing over first occurrences */
+	struct list_ix_slot	*ix;
+	size_t          ix_cap;             /* slots, power of two */
+	uint64_t        ix_k0, ix_k1;
+	unsigned char   indexed;
+	unsigned char   ix_stale;           /* rebuild before next lookup */
+
+	const McPkgAllocator	*alloc;
+	size_t          inl_cap;            /* elements in inl[] */
+
+	max_align_t     inl[];              /* new_inline: first elements */
 };
 
+/* data still points at the buffer allocated with the list */
+static inline int list_is_inline(const McPkgList *lst)
+{
+	return lst->data == (unsigned char *)lst->inl;
+}
+
+
+/* ----- hash index ----- */
+
+static const void *list_key(const McPkgList *lst, const void *e,
+                            size_t *len)
+{
+	if (lst->ops.key)
+		return lst->ops.key(e, len, lst->ops.ctx);
+	*len = lst->elem_size;
+	return e;
+}
+
+static uint64_t ix_hash(const McPkgList *lst, const void *k, size_t len)
+{
+	return mcpkg_siphash13_k(k, len, lst->ix_k0, lst->ix_k1);
+}
+
+/* slot holding key, or the empty slot where it would go */
+static size_t ix_probe(const McPkgList *lst, const void *k, size_t len,
+                       uint64_t h)
+{
+	size_t mask = lst->ix_cap - 1, i = (size_t)h & mask, elen;
+	const struct list_ix_slot *s;
+	const void *ek;
+
+	for (;; i = (i + 1) & mask) {
+		s = &lst->ix[i];
+		if (!s->at)
+			return i;
+		if (s->h != h)
+			continue;
+		ek = list_key(lst, lst->data + (s->at - 1) * lst->elem_size,
+		              &elen);
+		if (elen == len && !memcmp(ek, k, len))
+			return i;
+	}
+}
+
+/* index element i unless an earlier equal one already is */
+static void ix_add(McPkgList *lst, size_t i)
+{
+	const void *k;
+	size_t len, pos;
+	uint64_t h;
+
+	k = list_key(lst, lst->data + i * lst->elem_size, &len);
+	h = ix_hash(lst, k, len);
+	pos = ix_probe(lst, k, len, h);
+	if (!lst->ix[pos].at) {
+		lst->ix[pos].h = h;
+		lst->ix[pos].at = i + 1;
+	}
+}
+
+/* size the table for len (load <= 1/2) and refill it in order */
+static MCPKG_CONTAINER_ERROR ix_rebuild(McPkgList *lst)
+{
+	struct list_ix_slot *t;
+	size_t cap = 8, i;
+
+	while (cap / 2 < lst->len) {
+		if (cap > SIZE_MAX / 2 / sizeof(*t))
+			return MCPKG_CONTAINER_ERR_OVERFLOW;
+		cap <<= 1;
+	}
+
+	if (cap != lst->ix_cap) {
+		t = mcpkg_allocator_calloc(lst->alloc, cap, sizeof(*t));
+		if (!t)
+			return MCPKG_CONTAINER_ERR_NO_MEM;
+		mcpkg_allocator_free(lst->alloc, lst->ix,
+		                     lst->ix_cap * sizeof(*t));
+		lst->ix = t;
+		lst->ix_cap = cap;
+	} else {
+		memset(lst->ix, 0, cap * sizeof(*lst->ix));
+	}
+
+	for (i = 0; i < lst->len; i++)
+		ix_add(lst, i);
+	lst->ix_stale = 0;
+	return MCPKG_CONTAINER_OK;
+}
+
+/* element len - 1 was appended */
+static void ix_note_push(McPkgList *lst)
+{
+	if (!lst->indexed || lst->ix_stale)
+		return;
+	if (lst->len > lst->ix_cap / 2)
+		lst->ix_stale = 1;	/* grow on the next lookup */
+	else
+		ix_add(lst, lst->len - 1);
+}
+
+static inline void ix_note_shift(McPkgList *lst)
+{
+	lst->ix_stale = 1;
+}
+
+/*
+ * Look key up in the index: 1 with *at = position (SIZE_MAX if absent),
+ * 0 if there is no usable index (caller scans).
+ */
+static int ix_find(const McPkgList *lst, const void *k, size_t len,
+                   size_t *at)
+{
+	McPkgList *w = (McPkgList *)lst;	/* the index is a cache */
+	size_t pos;
+
+	if (!lst->indexed)
+		return 0;
+	if (lst->ix_stale && ix_rebuild(w) != MCPKG_CONTAINER_OK)
+		return 0;
+
+	pos = ix_probe(lst, k, len, ix_hash(lst, k, len));
+	*at = lst->ix[pos].at ? lst->ix[pos].at - 1 : SIZE_MAX;
+	return 1;
+}
+
+static inline int ix_ret(size_t at)
+{
+	return (at > (size_t)INT_MAX) ? -1 : (int)at;
+}
 
 static MCPKG_CONTAINER_ERROR grow_to(McPkgList *lst, size_t new_cap)
 {
@@ -47,7 +200,14 @@ static MCPKG_CONTAINER_ERROR grow_to(McPkgList *lst, size_t new_cap)
 	if ((unsigned long long)bytes > lst->max_bytes)
 		return MCPKG_CONTAINER_ERR_LIMIT;
 
-	p = realloc(lst->data, bytes);
+	if (list_is_inline(lst)) {
+		p = mcpkg_allocator_alloc(lst->alloc, bytes);
+		if (p)
+			memcpy(p, lst->data, lst->len * lst->elem_size);
+	} else {
+		p = mcpkg_allocator_realloc(lst->alloc, lst->data,
+		                            lst->cap * lst->elem_size, bytes);
+	}
 	if (!p)
 		return MCPKG_CONTAINER_ERR_NO_MEM;
 
@@ -85,22 +245,27 @@ ensure_cap_for(McPkgList *lst, size_t want_len)
 	return grow_to(lst, new_cap);
 }
 
-// API
-McPkgList *mcpkg_list_new(size_t elem_size,
-                          const McPkgListOps *ops_or_null,
-                          size_t max_elements,
-                          unsigned long long max_bytes)
+static McPkgList *list_alloc(const McPkgAllocator *alloc, size_t elem_size,
+                             const McPkgListOps *ops_or_null,
+                             size_t inline_cap, size_t max_elements,
+                             unsigned long long max_bytes)
 {
 	McPkgList *lst;
-	size_t eff;
+	size_t eff, tail;
 
 	if (!elem_size)
 		return NULL;
+	if (mcpkg_math_mul_overflow_size(inline_cap, elem_size, &tail) ||
+	    tail > SIZE_MAX - sizeof(*lst))
+		return NULL;
 
-	lst = calloc(1, sizeof(*lst));
+	alloc = alloc ? alloc : mcpkg_allocator_default();
+	lst = mcpkg_allocator_calloc(alloc, 1, sizeof(*lst) + tail);
 	if (!lst)
 		return NULL;
 
+	lst->alloc = alloc;
+	lst->inl_cap = inline_cap;
 	lst->elem_size = elem_size;
 
 	if (ops_or_null)
@@ -116,13 +281,69 @@ McPkgList *mcpkg_list_new(size_t elem_size,
 	                                   lst->max_bytes,
 	                                   lst->elem_size);
 	if (!eff) {
-		free(lst);
+		mcpkg_allocator_free(alloc, lst, sizeof(*lst) + tail);
 		return NULL;
 	}
 
+	if (inline_cap) {
+		lst->data = (unsigned char *)lst->inl;
+		lst->cap = inline_cap < eff ? inline_cap : eff;
+	}
 	return lst;
 }
 
+// API
+McPkgList *mcpkg_list_new(size_t elem_size,
+                          const McPkgListOps *ops_or_null,
+                          size_t max_elements,
+                          unsigned long long max_bytes)
+{
+	return list_alloc(NULL, elem_size, ops_or_null, 0, max_elements,
+	                  max_bytes);
+}
+
+McPkgList *mcpkg_list_new_inline(size_t elem_size,
+                                 const McPkgListOps *ops_or_null,
+                                 size_t inline_cap,
+                                 size_t max_elements,
+                                 unsigned long long max_bytes)
+{
+	return list_alloc(NULL, elem_size, ops_or_null, inline_cap,
+	                  max_elements, max_bytes);
+}
+
+McPkgList *mcpkg_list_new_inline_alloc(const McPkgAllocator *alloc,
+                                       size_t elem_size,
+                                       const McPkgListOps *ops_or_null,
+                                       size_t inline_cap,
+                                       size_t max_elements,
+                                       unsigned long long max_bytes)
+{
+	return list_alloc(alloc, elem_size, ops_or_null, inline_cap,
+	                  max_elements, max_bytes);
+}
+
+McPkgList *mcpkg_list_new_alloc(const McPkgAllocator *alloc,
+                                size_t elem_size,
+                                const McPkgListOps *ops_or_null,
+                                size_t max_elements,
+                                unsigned long long max_bytes)
+{
+	return list_alloc(alloc, elem_size, ops_or_null, 0, max_elements,
+	                  max_bytes);
+}
+
+McPkgList *mcpkg_list_new_arena(McPkgArena *arena, size_t elem_size,
+                                const McPkgListOps *ops_or_null,
+                                size_t max_elements,
+                                unsigned long long max_bytes)
+{
+	if (!arena)
+		return NULL;
+	return list_alloc(mcpkg_arena_allocator(arena), elem_size,
+	                  ops_or_null, 0, max_elements, max_bytes);
+}
+
 void mcpkg_list_free(McPkgList *lst)
 {
 	size_t i;
@@ -143,8 +364,13 @@ void mcpkg_list_free(McPkgList *lst)
 		memset(lst->data, 0, bytes);
 	}
 #endif
-	free(lst->data);
-	free(lst);
+	if (!list_is_inline(lst))
+		mcpkg_allocator_free(lst->alloc, lst->data,
+		                     lst->cap * lst->elem_size);
+	mcpkg_allocator_free(lst->alloc, lst->ix,
+	                     lst->ix_cap * sizeof(*lst->ix));
+	mcpkg_allocator_free(lst->alloc, lst,
+	                     sizeof(*lst) + lst->inl_cap * lst->elem_size);
 }
 
 MCPKG_CONTAINER_ERROR mcpkg_list_resize(McPkgList *lst, size_t new_size)
@@ -168,6 +394,7 @@ MCPKG_CONTAINER_ERROR mcpkg_list_resize(McPkgList *lst, size_t new_size)
 			}
 		}
 		lst->len = new_size;
+		ix_note_shift(lst);
 		return MCPKG_CONTAINER_OK;
 	}
 
@@ -184,6 +411,7 @@ MCPKG_CONTAINER_ERROR mcpkg_list_resize(McPkgList *lst, size_t new_size)
 
 	memset(lst->data + old_len * lst->elem_size, 0, bytes);
 	lst->len = new_size;
+	ix_note_shift(lst);
 	return MCPKG_CONTAINER_OK;
 }
 
@@ -223,6 +451,7 @@ MCPKG_CONTAINER_ERROR mcpkg_list_remove_all(McPkgList *lst)
 		}
 	}
 	lst->len = 0;
+	ix_note_shift(lst);
 	return MCPKG_CONTAINER_OK;
 }
 
@@ -251,6 +480,7 @@ MCPKG_CONTAINER_ERROR mcpkg_list_remove_at(McPkgList *lst, size_t index)
 	}
 
 	lst->len--;
+	ix_note_shift(lst);
 	return MCPKG_CONTAINER_OK;
 }
 
@@ -274,6 +504,7 @@ MCPKG_CONTAINER_ERROR mcpkg_list_push(McPkgList *lst, const void *elem)
 	}
 
 	lst->len++;
+	ix_note_push(lst);
 	return MCPKG_CONTAINER_OK;
 }
 
@@ -297,6 +528,7 @@ MCPKG_CONTAINER_ERROR mcpkg_list_pop(McPkgList *lst, void *out)
 		lst->ops.dtor(src, lst->ops.ctx);
 
 	lst->len--;
+	ix_note_shift(lst);
 	return MCPKG_CONTAINER_OK;
 }
 
@@ -334,6 +566,10 @@ MCPKG_CONTAINER_ERROR mcpkg_list_add(McPkgList *lst, size_t index,
 	}
 
 	lst->len++;
+	if (index + 1 == lst->len)
+		ix_note_push(lst);
+	else
+		ix_note_shift(lst);
 	return MCPKG_CONTAINER_OK;
 }
 
@@ -388,13 +624,20 @@ MCPKG_CONTAINER_ERROR mcpkg_list_last(const McPkgList *lst, void *out)
 
 int mcpkg_list_index_of(const McPkgList *lst, const void *needle)
 {
-	size_t i;
+	const void *k;
+	size_t i, len;
 
 	if (!lst || !needle)
 		return -1;
 	if (!lst->len)
 		return -1;
 
+	if (lst->indexed) {
+		k = list_key(lst, needle, &len);
+		if (ix_find(lst, k, len, &i))
+			return ix_ret(i);
+	}
+
 	if (lst->ops.equals) {
 		for (i = 0; i < lst->len; i++) {
 			const void *e = lst->data + i * lst->elem_size;
@@ -412,6 +655,53 @@ int mcpkg_list_index_of(const McPkgList *lst, const void *needle)
 	return -1;
 }
 
+int mcpkg_list_index_of_key(const McPkgList *lst, const void *key,
+                            size_t len)
+{
+	const void *ek;
+	size_t i, elen;
+
+	if (!lst || (!key && len))
+		return -1;
+	if (ix_find(lst, key, len, &i))
+		return ix_ret(i);
+
+	for (i = 0; i < lst->len; i++) {
+		ek = list_key(lst, lst->data + i * lst->elem_size, &elen);
+		if (elen == len && !memcmp(ek, key, len))
+			return ix_ret(i);
+	}
+	return -1;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_list_set_indexed(McPkgList *lst, int on)
+{
+	MCPKG_CONTAINER_ERROR ret;
+
+	if (!lst)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	if (!on) {
+		mcpkg_allocator_free(lst->alloc, lst->ix,
+		                     lst->ix_cap * sizeof(*lst->ix));
+		lst->ix = NULL;
+		lst->ix_cap = 0;
+		lst->indexed = 0;
+		return MCPKG_CONTAINER_OK;
+	}
+
+	if (lst->ops.equals && !lst->ops.key)
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	if (!lst->indexed)
+		mcpkg_sip_seed(&lst->ix_k0, &lst->ix_k1);
+	ret = ix_rebuild(lst);
+	if (ret != MCPKG_CONTAINER_OK)
+		return ret;
+	lst->indexed = 1;
+	return MCPKG_CONTAINER_OK;
+}
+
 void mcpkg_list_get_limits(const McPkgList *lst, size_t *max_elements,
                            unsigned long long *max_bytes)
 {
@@ -4,6 +4,7 @@
 #include <stddef.h>
 #include "mcpkg_export.h"
 #include "container/mcpkg_container_error.h"
+#include "container/mcpkg_alloc.h"
 
 
 MCPKG_BEGIN_DECLS
@@ -14,13 +15,19 @@ MCPKG_BEGIN_DECLS
  */
 
 typedef struct McPkgList McPkgList;
+struct McPkgArena;
 
-/* Optional per-element hooks; pass NULL for memcpy/no-op/memcmp. */
+/*
+ * Optional per-element hooks; pass NULL for memcpy/no-op/memcmp.
+ * key: bytes that identify an element for the hash index (default: the
+ * whole element); must agree with equals.
+ */
 typedef struct {
 	void (*copy)(void *dst, const void *src, void *ctx);
 	void (*dtor)(void *elem, void *ctx);
 	int (*equals)(const void *a, const void *b, void *ctx);
 	void *ctx;
+	const void *(*key)(const void *elem, size_t *len, void *ctx);
 } McPkgListOps;
 
 /* Create a list for elements of elem_size; caps default or as provided. */
@@ -29,6 +36,38 @@ MCPKG_API McPkgList *mcpkg_list_new(size_t elem_size,
                                     size_t max_elements /*0=default*/,
                                     unsigned long long max_bytes /*0=default*/);
 
+/*
+ * Like mcpkg_list_new, but room for inline_cap elements is allocated
+ * with the list itself; the heap is only touched once it outgrows them.
+ * For the many short lists in decoded records.
+ */
+MCPKG_API McPkgList *mcpkg_list_new_inline(size_t elem_size,
+                const McPkgListOps *ops_or_null,
+                size_t inline_cap,
+                size_t max_elements /*0=default*/,
+                unsigned long long max_bytes /*0=default*/);
+
+/*
+ * Like mcpkg_list_new, but the list and its storage come from alloc
+ * (NULL = default allocator), which must outlive the list.
+ */
+MCPKG_API McPkgList *mcpkg_list_new_alloc(const McPkgAllocator *alloc,
+                size_t elem_size,
+                const McPkgListOps *ops_or_null,
+                size_t max_elements /*0=default*/,
+                unsigned long long max_bytes /*0=default*/);
+
+/*
+ * new_alloc with mcpkg_arena_allocator(arena) (NULL if arena is NULL).
+ * mcpkg_list_free still runs dtors but frees nothing; the memory goes
+ * with mcpkg_arena_reset/free, and the list must not be used after that.
+ */
+MCPKG_API McPkgList *mcpkg_list_new_arena(struct McPkgArena *arena,
+                size_t elem_size,
+                const McPkgListOps *ops_or_null,
+                size_t max_elements /*0=default*/,
+                unsigned long long max_bytes /*0=default*/);
+
 /* Free the list; calls dtor on remaining elements if provided. */
 MCPKG_API void mcpkg_list_free(McPkgList *lst);
 
@@ -76,9 +115,22 @@ MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_list_first(const McPkgList *lst,
 MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_list_last(const McPkgList *lst,
                 void *out);
 
-/* Linear search; uses equals if provided, else memcmp; returns index or -1. */
+/*
+ * First index of needle or -1. Linear search using equals if provided,
+ * else memcmp; a hash lookup on indexed lists.
+ */
 MCPKG_API int mcpkg_list_index_of(const McPkgList *lst, const void *needle);
 
+/*
+ * Keep a hash index (first occurrence per key) so index_of is O(1) on
+ * average. Appends update it in place; inserts/removals elsewhere mark
+ * it stale and the next index_of rebuilds it. Writes through at_ptr are
+ * not seen: toggle the index on again after them. ERR_INVALID when
+ * equals is set without key.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_list_set_indexed(McPkgList *lst,
+                int on);
+
 /* Inspect or update per-instance limits (0 leaves a field unchanged). */
 MCPKG_API void mcpkg_list_get_limits(const McPkgList *lst,
                                      size_t *max_elements,
@@ -0,0 +1,25 @@
+#ifndef MCPKG_LIST_P_H
+#define MCPKG_LIST_P_H
+
+#include "container/mcpkg_list.h"
+
+/*
+ * McPkgList internals shared with mcpkg_str_list.c (not installed).
+ */
+
+/*
+ * First index whose key bytes (ops.key) equal key[0, len), or -1.
+ * Uses the hash index when enabled, else scans.
+ */
+int mcpkg_list_index_of_key(const McPkgList *lst, const void *key,
+                            size_t len);
+
+/* mcpkg_list_new_inline with the list coming from alloc (NULL = default). */
+McPkgList *mcpkg_list_new_inline_alloc(const McPkgAllocator *alloc,
+                                       size_t elem_size,
+                                       const McPkgListOps *ops_or_null,
+                                       size_t inline_cap,
+                                       size_t max_elements,
+                                       unsigned long long max_bytes);
+
+#endif /* MCPKG_LIST_P_H */
@@ -3,13 +3,17 @@
 
 /* ----- search helpers (non-inline) ----- */
 
-static struct rb_node *find_node(const McPkgMap *m, const char *key)
+static struct rb_node *find_node_n(const McPkgMap *m, const char *key,
+                                   size_t len)
 {
 	struct rb_node *cur = m->root;
 	int cmp;
 
 	while (cur) {
-		cmp = strcmp(key, cur->key);
+		/* interned keys: equal strings share a pointer */
+		if (key == cur->key && !cur->key[len])
+			return cur;
+		cmp = key_cmp_n(key, len, cur->key);
 		if (cmp == 0)
 			return cur;
 		cur = (cmp < 0) ? cur->left : cur->right;
@@ -34,6 +38,64 @@ static struct rb_node *lower_bound_node(const McPkgMap *m, const char *key)
 	return res;
 }
 
+/* value slot for key in either backend, or NULL */
+static unsigned char *lookup_n(const McPkgMap *m, const char *key,
+                               size_t len)
+{
+	struct rb_node *n;
+
+	if (m->backend == MCPKG_MAP_BTREE)
+		return mcpkg_map_bt_find(m, key, len);
+
+	n = find_node_n(m, key, len);
+	return n ? n->value : NULL;
+}
+
+/* ----- node alloc / free by key mode ----- */
+
+static struct rb_node *node_new(McPkgMap *m, const char *key, size_t klen)
+{
+	struct rb_node *z;
+	size_t tail = 0;
+
+	if (m->key_mode == MCPKG_CONTAINER_KEYS_ARENA &&
+	    klen <= MCPKG_MAP_INLINE_KEY)
+		tail = klen + 1;
+
+	z = mcpkg_allocator_alloc(m->alloc, sizeof(*z) + m->value_size + tail);
+	if (!z)
+		return NULL;
+
+	if (tail) {
+		z->key = node_tail(m, z);
+		memcpy(z->key, key, klen);
+		z->key[klen] = '\0';
+	} else if (m->key_mode == MCPKG_CONTAINER_KEYS_ARENA) {
+		z->key = mcpkg_str_arena_dupn(m->arena, key, klen);
+	} else if (m->key_mode == MCPKG_CONTAINER_KEYS_INTERNED) {
+		z->key = (char *)mcpkg_str_intern_addn(m->intern, key, klen);
+	} else {
+		z->key = mcpkg_allocator_strndup(m->alloc, key, klen);
+	}
+
+	if (!z->key) {
+		mcpkg_allocator_free(m->alloc, z, 0);
+		return NULL;
+	}
+	return z;
+}
+
+static void node_free(McPkgMap *m, struct rb_node *n)
+{
+	size_t bytes = node_bytes(m) + node_key_bytes(m, n);
+
+	if (m->ops.value_dtor)
+		m->ops.value_dtor(n->value, m->ops.ctx);
+	if (m->key_mode == MCPKG_CONTAINER_KEYS_OWNED)
+		mcpkg_allocator_free(m->alloc, n->key, 0);
+	mcpkg_allocator_free(m->alloc, n, bytes);
+}
+
 /* ----- rotations already inline in _p.h ----- */
 
 /* ----- transplant & fixups ----- */
@@ -161,18 +223,22 @@ static void delete_fixup(McPkgMap *m, struct rb_node *x,
 
 /* ----- public API ----- */
 
-McPkgMap *mcpkg_map_new(size_t value_size, const McPkgMapOps *ops_or_null,
-                        size_t max_pairs, unsigned long long max_bytes)
+McPkgMap *mcpkg_map_new_alloc(const McPkgAllocator *alloc, size_t value_size,
+                              const McPkgMapOps *ops_or_null,
+                              size_t max_pairs,
+                              unsigned long long max_bytes)
 {
 	McPkgMap *m;
 
 	if (!value_size)
 		return NULL;
 
-	m = calloc(1, sizeof(*m));
+	alloc = alloc ? alloc : mcpkg_allocator_default();
+	m = mcpkg_allocator_calloc(alloc, 1, sizeof(*m));
 	if (!m)
 		return NULL;
 
+	m->alloc = alloc;
 	m->value_size = value_size;
 	if (ops_or_null)
 		m->ops = *ops_or_null;
@@ -184,13 +250,20 @@ McPkgMap *mcpkg_map_new(size_t value_size, const McPkgMapOps *ops_or_null,
 	m->bytes_used = 0;
 
 	if ((unsigned long long)node_bytes(m) > m->max_bytes) {
-		free(m);
+		mcpkg_allocator_free(alloc, m, sizeof(*m));
 		return NULL;
 	}
 
 	return m;
 }
 
+McPkgMap *mcpkg_map_new(size_t value_size, const McPkgMapOps *ops_or_null,
+                        size_t max_pairs, unsigned long long max_bytes)
+{
+	return mcpkg_map_new_alloc(NULL, value_size, ops_or_null, max_pairs,
+	                           max_bytes);
+}
+
 void mcpkg_map_free(McPkgMap *m)
 {
 	struct rb_node *n;
@@ -198,6 +271,8 @@ void mcpkg_map_free(McPkgMap *m)
 	if (!m)
 		return;
 
+	mcpkg_map_bt_free(m);
+
 	/* prune leaves iteratively; never touch freed memory */
 	n = m->root;
 	while (n) {
@@ -213,10 +288,6 @@ void mcpkg_map_free(McPkgMap *m)
 		/* n is a leaf: detach from parent, then free */
 		struct rb_node *parent = n->parent;
 
-		if (m->ops.value_dtor)
-			m->ops.value_dtor(n->value, m->ops.ctx);
-		if (n->key)
-			free(n->key);
 		/* detach before free so we never deref a dangling child */
 		if (parent) {
 			if (parent->left == n)
@@ -224,12 +295,13 @@ void mcpkg_map_free(McPkgMap *m)
 			else if (parent->right == n)
 				parent->right = NULL;
 		}
-		free(n);
+		node_free(m, n);
 
 		n = parent; /* climb */
 	}
 
-	free(m);
+	mcpkg_str_arena_free(m->arena);
+	mcpkg_allocator_free(m->alloc, m, sizeof(*m));
 }
 
 
@@ -274,18 +346,64 @@ mcpkg_map_set_limits(McPkgMap *m, size_t max_pairs,
 	return MCPKG_CONTAINER_OK;
 }
 
-MCPKG_CONTAINER_ERROR mcpkg_map_set(McPkgMap *m, const char *key,
-                                    const void *value)
+MCPKG_CONTAINER_ERROR
+mcpkg_map_set_key_mode(McPkgMap *m, MCPKG_CONTAINER_KEYS mode,
+                       McPkgStrIntern *intern_or_null)
 {
-	struct rb_node *cur, *parent = NULL, *z;
-	int cmp;
+	McPkgStrArena *arena = NULL;
 
-	if (!m || !key || !value)
+	if (!m)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (mode == MCPKG_CONTAINER_KEYS_INTERNED && !intern_or_null)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (mode > MCPKG_CONTAINER_KEYS_INTERNED)
+		return MCPKG_CONTAINER_ERR_INVALID;
+	if (m->size)
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	if (mode == MCPKG_CONTAINER_KEYS_ARENA) {
+		arena = mcpkg_str_arena_new_alloc(m->alloc, m->max_bytes);
+		if (!arena)
+			return MCPKG_CONTAINER_ERR_NO_MEM;
+	}
+
+	mcpkg_str_arena_free(m->arena);
+	m->key_mode = mode;
+	m->arena = arena;
+	m->intern = mode == MCPKG_CONTAINER_KEYS_INTERNED ? intern_or_null
+	            : NULL;
+	return MCPKG_CONTAINER_OK;
+}
+
+MCPKG_CONTAINER_ERROR
+mcpkg_map_set_backend(McPkgMap *m, MCPKG_MAP_BACKEND backend)
+{
+	if (!m)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (backend > MCPKG_MAP_BTREE)
+		return MCPKG_CONTAINER_ERR_INVALID;
+	if (m->size)
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	mcpkg_map_bt_free(m);
+	m->backend = backend;
+	/* keep in-leaf values aligned like a malloc'd rb_node value */
+	m->bt_stride = (m->value_size + 15u) & ~(size_t)15u;
+	return MCPKG_CONTAINER_OK;
+}
+
+static MCPKG_CONTAINER_ERROR set_impl(McPkgMap *m, const char *key,
+                                      size_t len, const void *value)
+{
+	struct rb_node *cur, *parent = NULL, *z;
+	int cmp = 0;
+
+	if (m->backend == MCPKG_MAP_BTREE)
+		return mcpkg_map_bt_set(m, key, len, value);
 
 	cur = m->root;
 	while (cur) {
-		cmp = strcmp(key, cur->key);
+		cmp = key_cmp_n(key, len, cur->key);
 		if (cmp == 0) {
 			if (m->ops.value_copy)
 				m->ops.value_copy(cur->value, value,
@@ -303,17 +421,12 @@ MCPKG_CONTAINER_ERROR mcpkg_map_set(McPkgMap *m, const char *key,
 	if (!under_byte_cap(m, 1))
 		return MCPKG_CONTAINER_ERR_LIMIT;
 
-	z = malloc(sizeof(*z) + m->value_size);
+	z = node_new(m, key, len);
 	if (!z)
 		return MCPKG_CONTAINER_ERR_NO_MEM;
 
 	z->left = z->right = z->parent = NULL;
 	set_color(z, 1);		/* red */
-	z->key = dup_cstr(key);
-	if (!z->key) {
-		free(z);
-		return MCPKG_CONTAINER_ERR_NO_MEM;
-	}
 
 	if (m->ops.value_copy)
 		m->ops.value_copy(z->value, value, m->ops.ctx);
@@ -323,7 +436,7 @@ MCPKG_CONTAINER_ERROR mcpkg_map_set(McPkgMap *m, const char *key,
 	z->parent = parent;
 	if (!parent) {
 		m->root = z;
-	} else if (strcmp(z->key, parent->key) < 0) {
+	} else if (cmp < 0) {
 		parent->left = z;
 	} else {
 		parent->right = z;
@@ -331,38 +444,77 @@ MCPKG_CONTAINER_ERROR mcpkg_map_set(McPkgMap *m, const char *key,
 	insert_fixup(m, z);
 
 	m->size++;
-	m->bytes_used += node_bytes(m);
+	m->bytes_used += node_bytes(m) + node_key_bytes(m, z);
 	return MCPKG_CONTAINER_OK;
 }
 
-MCPKG_CONTAINER_ERROR mcpkg_map_get(const McPkgMap *m, const char *key,
-                                    void *out)
+MCPKG_CONTAINER_ERROR mcpkg_map_set(McPkgMap *m, const char *key,
+                                    const void *value)
 {
-	struct rb_node *n;
+	if (!m || !key || !value)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	return set_impl(m, key, strlen(key), value);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_map_set_n(McPkgMap *m, const char *key,
+                                      size_t len, const void *value)
+{
+	if (!m || !key || !value)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (!key_n_valid(key, len))
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	return set_impl(m, key, len, value);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_map_get_n(const McPkgMap *m, const char *key,
+                                      size_t len, void *out)
+{
+	const unsigned char *v;
 
 	if (!m || !key || !out)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (!key_n_valid(key, len))
+		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
-	n = find_node(m, key);
-	if (!n)
+	v = lookup_n(m, key, len);
+	if (!v)
 		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
-	memcpy(out, n->value, m->value_size);
+	memcpy(out, v, m->value_size);
 	return MCPKG_CONTAINER_OK;
 }
 
-MCPKG_CONTAINER_ERROR mcpkg_map_remove(McPkgMap *m, const char *key)
+int mcpkg_map_contains_n(const McPkgMap *m, const char *key, size_t len)
 {
-	struct rb_node *z, *y, *x, *x_parent;
-	unsigned char y_color;
+	if (!m || !key || !key_n_valid(key, len))
+		return 0;
+	return lookup_n(m, key, len) ? 1 : 0;
+}
 
-	if (!m || !key)
+MCPKG_CONTAINER_ERROR mcpkg_map_get(const McPkgMap *m, const char *key,
+                                    void *out)
+{
+	const unsigned char *v;
+
+	if (!m || !key || !out)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
-	z = find_node(m, key);
-	if (!z)
+	v = lookup_n(m, key, strlen(key));
+	if (!v)
 		return MCPKG_CONTAINER_ERR_NOT_FOUND;
 
+	memcpy(out, v, m->value_size);
+	return MCPKG_CONTAINER_OK;
+}
+
+/* unlink and free z; other nodes keep their identity (no key swaps) */
+static void rb_erase(McPkgMap *m, struct rb_node *z)
+{
+	struct rb_node *y, *x, *x_parent;
+	unsigned char y_color;
+
 	y = z;
 	y_color = node_color(y);
 
@@ -395,24 +547,183 @@ MCPKG_CONTAINER_ERROR mcpkg_map_remove(McPkgMap *m, const char *key)
 		set_color(y, node_color(z));
 	}
 
-	if (m->ops.value_dtor)
-		m->ops.value_dtor(z->value, m->ops.ctx);
-	if (z->key)
-		free(z->key);
-	free(z);
-
 	m->size--;
-	m->bytes_used -= node_bytes(m);
+	m->bytes_used -= node_bytes(m) + node_key_bytes(m, z);
+	node_free(m, z);
 
 	if (y_color == 0)
 		delete_fixup(m, x, x_parent);
+}
 
+MCPKG_CONTAINER_ERROR mcpkg_map_remove(McPkgMap *m, const char *key)
+{
+	struct rb_node *z;
+
+	if (!m || !key)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	if (m->backend == MCPKG_MAP_BTREE)
+		return mcpkg_map_bt_remove(m, key, strlen(key));
+
+	z = find_node_n(m, key, strlen(key));
+	if (!z)
+		return MCPKG_CONTAINER_ERR_NOT_FOUND;
+
+	rb_erase(m, z);
 	return MCPKG_CONTAINER_OK;
 }
 
 int mcpkg_map_contains(const McPkgMap *m, const char *key)
 {
-	return (m && key && find_node(m, key)) ? 1 : 0;
+	return (m && key && lookup_n(m, key, strlen(key))) ? 1 : 0;
+}
+
+/* ----- bulk operations ----- */
+
+/*
+ * Balanced subtree over nodes[lo, hi). Sibling subtrees differ by at most
+ * one node, so every NULL link sits at depth red or red + 1: colouring
+ * exactly the nodes at depth red = floor(log2(n)) red keeps black heights
+ * equal.
+ */
+static struct rb_node *rb_build(struct rb_node **nodes, size_t lo,
+                                size_t hi, struct rb_node *parent,
+                                unsigned depth, unsigned red)
+{
+	struct rb_node *x;
+	size_t mid;
+
+	if (lo >= hi)
+		return NULL;
+
+	mid = lo + (hi - lo) / 2;
+	x = nodes[mid];
+	x->parent = parent;
+	x->color = depth == red;
+	x->left = rb_build(nodes, lo, mid, x, depth + 1, red);
+	x->right = rb_build(nodes, mid + 1, hi, x, depth + 1, red);
+	return x;
+}
+
+static MCPKG_CONTAINER_ERROR rb_bulk_load(McPkgMap *m,
+                const char *const *keys,
+                const unsigned char *values, size_t n)
+{
+	MCPKG_CONTAINER_ERROR err = MCPKG_CONTAINER_OK;
+	struct rb_node **nodes;
+	unsigned long long used = m->bytes_used;
+	unsigned red = 0;
+	size_t i;
+
+	if (n > SIZE_MAX / sizeof(*nodes))
+		return MCPKG_CONTAINER_ERR_LIMIT;
+	nodes = mcpkg_allocator_alloc(m->alloc, n * sizeof(*nodes));
+	if (!nodes)
+		return MCPKG_CONTAINER_ERR_NO_MEM;
+
+	/* keys first; values are copied only once nothing can fail */
+	for (i = 0; i < n; i++) {
+		nodes[i] = node_new(m, keys[i], strlen(keys[i]));
+		if (!nodes[i]) {
+			err = MCPKG_CONTAINER_ERR_NO_MEM;
+			break;
+		}
+		used += node_bytes(m) + node_key_bytes(m, nodes[i]);
+		if (used > m->max_bytes) {
+			err = MCPKG_CONTAINER_ERR_LIMIT;
+			i++;
+			break;
+		}
+	}
+	if (err) {
+		while (i-- > 0) {
+			if (m->key_mode == MCPKG_CONTAINER_KEYS_OWNED)
+				mcpkg_allocator_free(m->alloc, nodes[i]->key,
+				                     0);
+			mcpkg_allocator_free(m->alloc, nodes[i], 0);
+		}
+		mcpkg_allocator_free(m->alloc, nodes, n * sizeof(*nodes));
+		return err;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (m->ops.value_copy)
+			m->ops.value_copy(nodes[i]->value,
+			                  values + i * m->value_size,
+			                  m->ops.ctx);
+		else
+			memcpy(nodes[i]->value, values + i * m->value_size,
+			       m->value_size);
+	}
+
+	for (i = n; i > 1; i >>= 1)
+		red++;
+	m->root = rb_build(nodes, 0, n, NULL, 0, red);
+	set_color(m->root, 0);
+	m->size = n;
+	m->bytes_used = used;
+	mcpkg_allocator_free(m->alloc, nodes, n * sizeof(*nodes));
+	return MCPKG_CONTAINER_OK;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_map_bulk_load(McPkgMap *m,
+                const char *const *keys,
+                const void *values, size_t n)
+{
+	size_t i;
+
+	if (!m || (n && (!keys || !values)))
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (m->size)
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	for (i = 0; i < n; i++) {
+		if (!keys[i])
+			return MCPKG_CONTAINER_ERR_NULL_PARAM;
+		if (i && strcmp(keys[i - 1], keys[i]) >= 0)
+			return MCPKG_CONTAINER_ERR_INVALID;
+	}
+	if (n > m->max_pairs)
+		return MCPKG_CONTAINER_ERR_LIMIT;
+	if (!n)
+		return MCPKG_CONTAINER_OK;
+
+	if (m->backend == MCPKG_MAP_BTREE)
+		return mcpkg_map_bt_bulk_load(m, keys, values, n);
+	return rb_bulk_load(m, keys, values, n);
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_map_remove_range(McPkgMap *m,
+                const char *lo_or_null,
+                const char *hi_or_null,
+                size_t *removed_out)
+{
+	struct rb_node *n, *next;
+	size_t removed = 0;
+
+	if (removed_out)
+		*removed_out = 0;
+	if (!m)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (lo_or_null && hi_or_null && strcmp(lo_or_null, hi_or_null) >= 0)
+		return MCPKG_CONTAINER_OK;
+
+	if (m->backend == MCPKG_MAP_BTREE) {
+		removed = mcpkg_map_bt_remove_range(m, lo_or_null, hi_or_null);
+	} else {
+		n = lo_or_null ? lower_bound_node(m, lo_or_null)
+		    : tree_min(m->root);
+		while (n && (!hi_or_null || strcmp(n->key, hi_or_null) < 0)) {
+			next = successor(n);
+			rb_erase(m, n);
+			n = next;
+			removed++;
+		}
+	}
+
+	if (removed_out)
+		*removed_out = removed;
+	return MCPKG_CONTAINER_OK;
 }
 
 /* ----- ordered iteration ----- */
@@ -423,6 +734,11 @@ mcpkg_map_iter_begin(const McPkgMap *m, void **iter)
 	if (!m || !iter)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
+	if (m->backend == MCPKG_MAP_BTREE) {
+		*iter = mcpkg_map_bt_iter_first(m);
+		return MCPKG_CONTAINER_OK;
+	}
+
 	*iter = m->root ? (void *)tree_min(m->root) : NULL;
 	return MCPKG_CONTAINER_OK;
 }
@@ -435,6 +751,9 @@ int mcpkg_map_iter_next(const McPkgMap *m, void **iter,
 	if (!m || !iter)
 		return 0;
 
+	if (m->backend == MCPKG_MAP_BTREE)
+		return mcpkg_map_bt_iter_next(m, iter, key_out, value_out);
+
 	n = (struct rb_node *)(*iter);
 	if (!n)
 		return 0;
@@ -454,10 +773,41 @@ mcpkg_map_iter_seek(const McPkgMap *m, void **iter, const char *seek_key)
 	if (!m || !iter || !seek_key)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
-	*iter = (void *)lower_bound_node(m, seek_key);
+	if (m->backend == MCPKG_MAP_BTREE)
+		*iter = mcpkg_map_bt_iter_seek(m, seek_key, strlen(seek_key));
+	else
+		*iter = (void *)lower_bound_node(m, seek_key);
 	return MCPKG_CONTAINER_OK;
 }
 
+MCPKG_CONTAINER_ERROR
+mcpkg_map_iter_prefix(const McPkgMap *m, void **iter, const char *prefix)
+{
+	return mcpkg_map_iter_seek(m, iter, prefix);
+}
+
+int mcpkg_map_iter_next_prefix(const McPkgMap *m, void **iter,
+                               const char *prefix, const char **key_out,
+                               void *value_out)
+{
+	const char *k;
+
+	if (!m || !iter || !prefix || !*iter)
+		return 0;
+
+	if (m->backend == MCPKG_MAP_BTREE)
+		k = mcpkg_map_bt_iter_key(*iter);
+	else
+		k = ((struct rb_node *)(*iter))->key;
+
+	/* keys sharing a prefix are contiguous; the first miss ends it */
+	if (strncmp(k, prefix, strlen(prefix)) != 0) {
+		*iter = NULL;
+		return 0;
+	}
+	return mcpkg_map_iter_next(m, iter, key_out, value_out);
+}
+
 /* ----- first/last ----- */
 
 MCPKG_CONTAINER_ERROR
@@ -467,6 +817,15 @@ mcpkg_map_first(const McPkgMap *m, const char **key_out, void *value_out)
 
 	if (!m || !key_out)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	if (m->backend == MCPKG_MAP_BTREE) {
+		void *it = mcpkg_map_bt_iter_first(m);
+
+		if (!mcpkg_map_bt_iter_next(m, &it, key_out, value_out))
+			return MCPKG_CONTAINER_ERR_RANGE;
+		return MCPKG_CONTAINER_OK;
+	}
+
 	if (!m->root)
 		return MCPKG_CONTAINER_ERR_RANGE;
 
@@ -484,6 +843,11 @@ mcpkg_map_last(const McPkgMap *m, const char **key_out, void *value_out)
 
 	if (!m || !key_out)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+
+	if (m->backend == MCPKG_MAP_BTREE)
+		return mcpkg_map_bt_last(m, key_out, value_out) ?
+		       MCPKG_CONTAINER_OK : MCPKG_CONTAINER_ERR_RANGE;
+
 	if (!m->root)
 		return MCPKG_CONTAINER_ERR_RANGE;
 
@@ -4,12 +4,15 @@
 #include <stddef.h>
 #include "mcpkg_export.h"
 #include "container/mcpkg_container_error.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_str_intern.h"
 
 MCPKG_BEGIN_DECLS
 
 /*
  * McPkgMap: ordered map (string key → by-value value), ascending strcmp().
- * - Keys are owned (strdup on insert, free on remove/clear).
+ * - Keys are owned (strdup on insert, free on remove/clear) unless a
+ *   different key mode is selected (arena / interned).
  * - Values stored by value (fixed value_size).
  * - Optional hooks let you deep-copy / destroy value internals.
  * - !! WARNING funtime police!! Not thread-safe; callers must synchronize.
@@ -17,6 +20,12 @@ MCPKG_BEGIN_DECLS
 
 typedef struct McPkgMap McPkgMap;
 
+/* Storage backend; both keep the same API and strcmp() order. */
+typedef enum {
+	MCPKG_MAP_RBTREE = 0,   /* default; one node per entry */
+	MCPKG_MAP_BTREE,        /* B+-tree; dense leaves, fast scans */
+} MCPKG_MAP_BACKEND;
+
 typedef struct {
 	void (*value_copy)(void *dst, const void *src, void *ctx); /* memcpy */
 	void (*value_dtor)(void *val, void *ctx);                  /* no-op */
@@ -29,6 +38,13 @@ MCPKG_API McPkgMap *mcpkg_map_new(size_t value_size,
                                   size_t max_pairs,
                                   unsigned long long max_bytes);
 
+/* Same; nodes, leaves and keys come from alloc (NULL = default). */
+MCPKG_API McPkgMap *mcpkg_map_new_alloc(const McPkgAllocator *alloc,
+                                        size_t value_size,
+                                        const McPkgMapOps *ops_or_null,
+                                        size_t max_pairs,
+                                        unsigned long long max_bytes);
+
 /* Free the map, its keys, and call value_dtor for remaining values. */
 MCPKG_API void mcpkg_map_free(McPkgMap *m);
 
@@ -44,6 +60,23 @@ MCPKG_API MCPKG_CONTAINER_ERROR
 mcpkg_map_set_limits(McPkgMap *m, size_t max_pairs,
                      unsigned long long max_bytes);
 
+/*
+ * Select key storage; only allowed while the map is empty.
+ * KEYS_ARENA: keys <= 64 bytes share the node allocation, longer keys
+ *             go to an arena (their space returns on free).
+ * KEYS_INTERNED: keys come from intern (must outlive the map).
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_map_set_key_mode(McPkgMap *m, MCPKG_CONTAINER_KEYS mode,
+                       McPkgStrIntern *intern_or_null);
+
+/*
+ * Select the backend; only allowed while the map is empty.
+ * Iterators of either backend are invalidated by set/remove.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_map_set_backend(McPkgMap *m, MCPKG_MAP_BACKEND backend);
+
 /* Insert or replace key with *value (dup key if new; copy value). */
 MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_set(McPkgMap *m,
                 const char *key,
@@ -61,12 +94,46 @@ MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_remove(McPkgMap *m,
 /* Return 1 if key exists, 0 if not. */
 MCPKG_API int mcpkg_map_contains(const McPkgMap *m, const char *key);
 
+/*
+ * (key,len) variants for borrowed, non-terminated strings. key must not
+ * contain NUL bytes: set_n returns ERR_INVALID, lookups not found.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_set_n(McPkgMap *m,
+                const char *key, size_t len,
+                const void *value);
+
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_get_n(const McPkgMap *m,
+                const char *key, size_t len,
+                void *out);
+
+MCPKG_API int mcpkg_map_contains_n(const McPkgMap *m, const char *key,
+                                   size_t len);
+
+/*
+ * Fill an EMPTY map from n entries in strictly ascending strcmp() order
+ * in O(n) (values: n * value_size bytes, copied like set). ERR_INVALID if
+ * the map is not empty or keys are unsorted/duplicated; on any error the
+ * map stays empty.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_bulk_load(McPkgMap *m,
+                const char *const *keys,
+                const void *values, size_t n);
+
+/* Remove every key in [lo, hi); a NULL bound is open. */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_remove_range(McPkgMap *m,
+                const char *lo_or_null,
+                const char *hi_or_null,
+                size_t *removed_out /*nullable*/);
+
 /* ---- ordered iteration ----
  * Usage:
  *   void *it;
  *   mcpkg_map_iter_begin(m, &it);
  *   while (mcpkg_map_iter_next(m, &it, &k, buf_or_null)) { ... }
  *   mcpkg_map_iter_seek(m, &it, "k2"); // lower_bound("k2")
+ *
+ *   mcpkg_map_iter_prefix(m, &it, "fabric:");
+ *   while (mcpkg_map_iter_next_prefix(m, &it, "fabric:", &k, NULL)) { ... }
  */
 
 MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_iter_begin(const McPkgMap *m,
@@ -80,6 +147,17 @@ MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_iter_seek(const McPkgMap *m,
                 void **iter,
                 const char *seek_key);
 
+/* Position iter at the first key starting with prefix (if any). */
+MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_iter_prefix(const McPkgMap *m,
+                void **iter,
+                const char *prefix);
+
+/* Like iter_next, but stops (0) at the first key without prefix. */
+MCPKG_API int mcpkg_map_iter_next_prefix(const McPkgMap *m, void **iter,
+                const char *prefix,
+                const char **key_out,
+                void *value_out /*nullable*/);
+
 /* Convenience: first/last element (ordered). */
 MCPKG_API MCPKG_CONTAINER_ERROR mcpkg_map_first(const McPkgMap *m,
                 const char **key_out,
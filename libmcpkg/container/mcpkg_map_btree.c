@@ -0,0 +1,1061 @@
+#include <stdint.h>
+
+#include "mcpkg_map.h"
+#include "mcpkg_map_p.h"
+
+/*
+ * McPkgMap B+-tree backend.
+ * - Entries live in sorted leaves linked for range scans; inner nodes
+ *   hold the shortest separator between two leaves (suffix truncation).
+ * - Every slot caches the first 8 key bytes big-endian ("head"), so a
+ *   node search compares integers in one contiguous array and only
+ *   dereferences a key string on a head tie.
+ * - Leaves are 64-byte aligned; an iterator is (leaf | slot).
+ */
+
+#define BT_MAX            MCPKG_MAP_BT_FANOUT
+#define BT_LEAF_MIN       (BT_MAX / 2)
+#define BT_INNER_MIN      (BT_MAX / 2 - 1)     /* separators */
+#define BT_MAX_HEIGHT     16
+#define BT_ALIGN          64u
+#define BT_VAL_ALIGN      16u
+
+struct bt_node {
+	unsigned short  n;      /* leaf: entries, inner: separators */
+	unsigned char   leaf;
+	uint64_t        head[BT_MAX];
+	char           *key[BT_MAX];  /* leaf: entry keys, inner: owned seps */
+};
+
+struct bt_leaf {
+	struct bt_node  h;
+	struct bt_leaf *prev;
+	struct bt_leaf *next;
+	/* BT_MAX value slots follow at bt_val() */
+};
+
+struct bt_inner {
+	struct bt_node  h;
+	struct bt_node *child[BT_MAX + 1];
+};
+
+struct bt_path {
+	struct bt_inner *node[BT_MAX_HEIGHT];
+	unsigned         idx[BT_MAX_HEIGHT];
+	unsigned         depth;
+};
+
+/* ----- sizes / slots ----- */
+
+static size_t bt_vals_off(void)
+{
+	return (sizeof(struct bt_leaf) + BT_VAL_ALIGN - 1) &
+	       ~(size_t)(BT_VAL_ALIGN - 1);
+}
+
+static size_t bt_leaf_bytes(const McPkgMap *m)
+{
+	size_t sz = bt_vals_off() + (size_t)BT_MAX * m->bt_stride;
+
+	return (sz + BT_ALIGN - 1) & ~(size_t)(BT_ALIGN - 1);
+}
+
+static unsigned char *bt_val(const McPkgMap *m, const struct bt_leaf *l,
+                             unsigned i)
+{
+	return (unsigned char *)l + bt_vals_off() + (size_t)i * m->bt_stride;
+}
+
+/* ----- key heads & compare ----- */
+
+static uint64_t key_head_n(const char *k, size_t len)
+{
+	uint64_t h = 0;
+	size_t i;
+
+	for (i = 0; i < 8; i++) {
+		h <<= 8;
+		if (i < len)
+			h |= (unsigned char)k[i];
+	}
+	return h;
+}
+
+static uint64_t key_head(const char *k)
+{
+	uint64_t h = 0;
+	size_t i;
+	int end = 0;
+
+	for (i = 0; i < 8; i++) {
+		h <<= 8;
+		if (!end && k[i])
+			h |= (unsigned char)k[i];
+		else
+			end = 1;
+	}
+	return h;
+}
+
+/* strcmp order of (key,len,kh) against slot i of x */
+static int bt_cmp(const struct bt_node *x, unsigned i, const char *key,
+                  size_t len, uint64_t kh)
+{
+	if (kh != x->head[i])
+		return kh < x->head[i] ? -1 : 1;
+	/* equal heads and a short key: the slot key ends at len too */
+	if (len < 8)
+		return 0;
+	return key_cmp_n(key + 8, len - 8, x->key[i] + 8);
+}
+
+/* first slot >= key; *eq set when that slot equals key */
+static unsigned bt_lower(const struct bt_node *x, const char *key,
+                         size_t len, uint64_t kh, int *eq)
+{
+	unsigned lo = 0, hi = x->n, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (bt_cmp(x, mid, key, len, kh) > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	*eq = lo < x->n && bt_cmp(x, lo, key, len, kh) == 0;
+	return lo;
+}
+
+/* inner routing: number of separators <= key */
+static unsigned bt_route(const struct bt_node *x, const char *key,
+                         size_t len, uint64_t kh)
+{
+	unsigned lo = 0, hi = x->n, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (bt_cmp(x, mid, key, len, kh) >= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* shortest s with lo < s <= hi (lo < hi) */
+static char *bt_sep_new(McPkgMap *m, const char *lo, const char *hi)
+{
+	size_t l = 0;
+
+	while (lo[l] && lo[l] == hi[l])
+		l++;
+	return mcpkg_allocator_strndup(m->alloc, hi, l + 1);
+}
+
+/* separators are always owned, whatever the key mode */
+static void bt_sep_free(McPkgMap *m, char *s)
+{
+	mcpkg_allocator_free(m->alloc, s, 0);
+}
+
+/* ----- node alloc / free ----- */
+
+/*
+ * Leaves need BT_ALIGN but allocators only promise max_align_t: take
+ * BT_ALIGN spare bytes and keep the raw pointer just below the leaf.
+ */
+static void *bt_aligned_alloc(McPkgMap *m, size_t sz)
+{
+	unsigned char *raw, *p;
+
+	if (sz > SIZE_MAX - BT_ALIGN)
+		return NULL;
+	raw = mcpkg_allocator_alloc(m->alloc, sz + BT_ALIGN);
+	if (!raw)
+		return NULL;
+	p = raw + BT_ALIGN - ((uintptr_t)raw & (BT_ALIGN - 1));
+	((void **)p)[-1] = raw;
+	return p;
+}
+
+static void bt_aligned_free(McPkgMap *m, void *p, size_t sz)
+{
+	mcpkg_allocator_free(m->alloc, ((void **)p)[-1], sz + BT_ALIGN);
+}
+
+static struct bt_leaf *bt_leaf_new(McPkgMap *m)
+{
+	struct bt_leaf *l;
+	size_t sz = bt_leaf_bytes(m);
+
+	l = bt_aligned_alloc(m, sz);
+	if (!l)
+		return NULL;
+	memset(l, 0, sizeof(*l));
+	l->h.leaf = 1;
+	m->bytes_used += sz;
+	return l;
+}
+
+static struct bt_inner *bt_inner_new(McPkgMap *m)
+{
+	struct bt_inner *x = mcpkg_allocator_calloc(m->alloc, 1, sizeof(*x));
+
+	if (x)
+		m->bytes_used += sizeof(*x);
+	return x;
+}
+
+static void bt_leaf_free(McPkgMap *m, struct bt_leaf *l)
+{
+	m->bytes_used -= bt_leaf_bytes(m);
+	bt_aligned_free(m, l, bt_leaf_bytes(m));
+}
+
+static void bt_inner_free(McPkgMap *m, struct bt_inner *x)
+{
+	m->bytes_used -= sizeof(*x);
+	mcpkg_allocator_free(m->alloc, x, sizeof(*x));
+}
+
+static char *bt_key_store(McPkgMap *m, const char *key, size_t len)
+{
+	switch (m->key_mode) {
+	case MCPKG_CONTAINER_KEYS_ARENA:
+		return mcpkg_str_arena_dupn(m->arena, key, len);
+	case MCPKG_CONTAINER_KEYS_INTERNED:
+		return (char *)mcpkg_str_intern_addn(m->intern, key, len);
+	default:
+		return mcpkg_allocator_strndup(m->alloc, key, len);
+	}
+}
+
+static void bt_key_release(McPkgMap *m, char *key)
+{
+	if (m->key_mode == MCPKG_CONTAINER_KEYS_OWNED)
+		mcpkg_allocator_free(m->alloc, key, 0);
+}
+
+static void bt_free_subtree(McPkgMap *m, struct bt_node *x, unsigned h)
+{
+	unsigned i;
+
+	if (!h) {
+		struct bt_leaf *l = (struct bt_leaf *)x;
+
+		for (i = 0; i < x->n; i++) {
+			if (m->ops.value_dtor)
+				m->ops.value_dtor(bt_val(m, l, i), m->ops.ctx);
+			bt_key_release(m, x->key[i]);
+		}
+		bt_leaf_free(m, l);
+		return;
+	}
+
+	for (i = 0; i <= x->n; i++)
+		bt_free_subtree(m, ((struct bt_inner *)x)->child[i], h - 1);
+	for (i = 0; i < x->n; i++)
+		bt_sep_free(m, x->key[i]);
+	bt_inner_free(m, (struct bt_inner *)x);
+}
+
+void mcpkg_map_bt_free(McPkgMap *m)
+{
+	if (m->bt_root)
+		bt_free_subtree(m, m->bt_root, m->bt_height);
+	m->bt_root = NULL;
+	m->bt_height = 0;
+}
+
+/* ----- descent ----- */
+
+static struct bt_leaf *bt_descend(const McPkgMap *m, const char *key,
+                                  size_t len, uint64_t kh,
+                                  struct bt_path *path)
+{
+	struct bt_node *x = m->bt_root;
+	unsigned d, i;
+
+	if (path)
+		path->depth = m->bt_height;
+	for (d = 0; d < m->bt_height; d++) {
+		i = bt_route(x, key, len, kh);
+		if (path) {
+			path->node[d] = (struct bt_inner *)x;
+			path->idx[d] = i;
+		}
+		x = ((struct bt_inner *)x)->child[i];
+	}
+	return (struct bt_leaf *)x;
+}
+
+static struct bt_leaf *bt_edge_leaf(const McPkgMap *m, int last)
+{
+	struct bt_node *x = m->bt_root;
+	unsigned d;
+
+	if (!x)
+		return NULL;
+	for (d = 0; d < m->bt_height; d++)
+		x = ((struct bt_inner *)x)->child[last ? x->n : 0];
+	return (struct bt_leaf *)x;
+}
+
+unsigned char *mcpkg_map_bt_find(const McPkgMap *m, const char *key,
+                                 size_t len)
+{
+	struct bt_leaf *l;
+	uint64_t kh = key_head_n(key, len);
+	unsigned i;
+	int eq;
+
+	if (!m->bt_root)
+		return NULL;
+
+	l = bt_descend(m, key, len, kh, NULL);
+	i = bt_lower(&l->h, key, len, kh, &eq);
+	return eq ? bt_val(m, l, i) : NULL;
+}
+
+/* ----- insert ----- */
+
+static void bt_slot_shift_right(const McPkgMap *m, struct bt_leaf *l,
+                                unsigned i)
+{
+	unsigned n = l->h.n;
+
+	memmove(&l->h.head[i + 1], &l->h.head[i], (n - i) * sizeof(uint64_t));
+	memmove(&l->h.key[i + 1], &l->h.key[i], (n - i) * sizeof(char *));
+	memmove(bt_val(m, l, i + 1), bt_val(m, l, i),
+	        (size_t)(n - i) * m->bt_stride);
+}
+
+static void bt_slot_put(const McPkgMap *m, struct bt_leaf *l, unsigned i,
+                        char *k, uint64_t kh, const void *value)
+{
+	bt_slot_shift_right(m, l, i);
+	l->h.head[i] = kh;
+	l->h.key[i] = k;
+	if (m->ops.value_copy)
+		m->ops.value_copy(bt_val(m, l, i), value, m->ops.ctx);
+	else
+		memcpy(bt_val(m, l, i), value, m->value_size);
+	l->h.n++;
+}
+
+/* put (sep, right) after child idx of x; x has room */
+static void bt_inner_put(struct bt_inner *x, unsigned idx, char *sep,
+                         struct bt_node *right)
+{
+	unsigned n = x->h.n;
+
+	memmove(&x->h.head[idx + 1], &x->h.head[idx],
+	        (n - idx) * sizeof(uint64_t));
+	memmove(&x->h.key[idx + 1], &x->h.key[idx], (n - idx) * sizeof(char *));
+	memmove(&x->child[idx + 2], &x->child[idx + 1],
+	        (n - idx) * sizeof(struct bt_node *));
+	x->h.head[idx] = key_head(sep);
+	x->h.key[idx] = sep;
+	x->child[idx + 1] = right;
+	x->h.n++;
+}
+
+/* key at position j of the leaf as if the new key were inserted at i */
+static const char *bt_merged_key(const struct bt_leaf *l, unsigned i,
+                                 const char *nk, unsigned j)
+{
+	if (j < i)
+		return l->h.key[j];
+	if (j == i)
+		return nk;
+	return l->h.key[j - 1];
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_map_bt_set(McPkgMap *m, const char *key,
+                                       size_t len, const void *value)
+{
+	struct bt_inner *spare[BT_MAX_HEIGHT + 1];
+	struct bt_path path;
+	struct bt_leaf *l, *r = NULL;
+	struct bt_node *left, *right;
+	uint64_t kh = key_head_n(key, len);
+	unsigned i, d, splits, inners, k;
+	unsigned long long need;
+	char *kcopy, *sep = NULL;
+	int eq;
+
+	if (!m->bt_root) {
+		if ((unsigned long long)bt_leaf_bytes(m) > m->max_bytes)
+			return MCPKG_CONTAINER_ERR_LIMIT;
+		m->bt_root = (struct bt_node *)bt_leaf_new(m);
+		if (!m->bt_root)
+			return MCPKG_CONTAINER_ERR_NO_MEM;
+	}
+
+	l = bt_descend(m, key, len, kh, &path);
+	i = bt_lower(&l->h, key, len, kh, &eq);
+	if (eq) {
+		if (m->ops.value_copy)
+			m->ops.value_copy(bt_val(m, l, i), value, m->ops.ctx);
+		else
+			memcpy(bt_val(m, l, i), value, m->value_size);
+		return MCPKG_CONTAINER_OK;
+	}
+
+	if (m->size >= m->max_pairs)
+		return MCPKG_CONTAINER_ERR_LIMIT;
+
+	/* nodes that split on the way up; splitting the root adds a level */
+	splits = 0;
+	inners = 0;
+	if (l->h.n == BT_MAX) {
+		splits = 1;
+		for (d = path.depth; d > 0 &&
+		     path.node[d - 1]->h.n == BT_MAX - 1; d--)
+			splits++;
+		inners = splits - 1 + (splits > path.depth);
+		if (m->bt_height + 1 >= BT_MAX_HEIGHT)
+			return MCPKG_CONTAINER_ERR_LIMIT;
+	}
+
+	need = m->bytes_used;
+	if (splits)
+		need += bt_leaf_bytes(m) +
+		        (unsigned long long)inners * sizeof(struct bt_inner);
+	if (need > m->max_bytes)
+		return MCPKG_CONTAINER_ERR_LIMIT;
+
+	kcopy = bt_key_store(m, key, len);
+	if (!kcopy)
+		return MCPKG_CONTAINER_ERR_NO_MEM;
+	if (!splits) {
+		bt_slot_put(m, l, i, kcopy, kh, value);
+		m->size++;
+		return MCPKG_CONTAINER_OK;
+	}
+
+	/* allocate everything up front; nothing below can fail */
+	r = bt_leaf_new(m);
+	sep = bt_sep_new(m, bt_merged_key(l, i, kcopy, BT_LEAF_MIN),
+	                 bt_merged_key(l, i, kcopy, BT_LEAF_MIN + 1));
+	for (k = 0; k < inners; k++) {
+		spare[k] = bt_inner_new(m);
+		if (!spare[k])
+			break;
+	}
+	if (!r || !sep || k < inners) {
+		while (k-- > 0)
+			bt_inner_free(m, spare[k]);
+		if (r)
+			bt_leaf_free(m, r);
+		bt_sep_free(m, sep);
+		bt_key_release(m, kcopy);
+		return MCPKG_CONTAINER_ERR_NO_MEM;
+	}
+
+	/* split the leaf: of BT_MAX + 1 entries the left keeps MIN + 1 */
+	{
+		unsigned keep = BT_LEAF_MIN + 1;
+		unsigned from = i < keep ? keep - 1 : keep;
+		unsigned move = BT_MAX - from;
+
+		memcpy(r->h.head, &l->h.head[from], move * sizeof(uint64_t));
+		memcpy(r->h.key, &l->h.key[from], move * sizeof(char *));
+		memcpy(bt_val(m, r, 0), bt_val(m, l, from),
+		       (size_t)move * m->bt_stride);
+		r->h.n = (unsigned short)move;
+		l->h.n = (unsigned short)from;
+
+		if (i < keep)
+			bt_slot_put(m, l, i, kcopy, kh, value);
+		else
+			bt_slot_put(m, r, i - from, kcopy, kh, value);
+	}
+	r->next = l->next;
+	r->prev = l;
+	if (l->next)
+		l->next->prev = r;
+	l->next = r;
+
+	/* push (sep, right) up until a parent has room */
+	left = (struct bt_node *)l;
+	right = (struct bt_node *)r;
+	k = 0;
+	for (d = path.depth;; d--) {
+		struct bt_inner *p, *q;
+		char *keys[BT_MAX];
+		struct bt_node *kids[BT_MAX + 1];
+		unsigned idx, n, j, mid;
+
+		if (d == 0) {
+			q = spare[k++];
+			q->h.key[0] = sep;
+			q->h.head[0] = key_head(sep);
+			q->child[0] = left;
+			q->child[1] = right;
+			q->h.n = 1;
+			m->bt_root = (struct bt_node *)q;
+			m->bt_height++;
+			break;
+		}
+
+		p = path.node[d - 1];
+		idx = path.idx[d - 1];
+		if (p->h.n < BT_MAX - 1) {
+			bt_inner_put(p, idx, sep, right);
+			break;
+		}
+
+		/* split full p; the middle separator moves up */
+		q = spare[k++];
+		n = p->h.n;
+		for (j = 0; j < idx; j++)
+			keys[j] = p->h.key[j];
+		keys[idx] = sep;
+		for (j = idx; j < n; j++)
+			keys[j + 1] = p->h.key[j];
+		for (j = 0; j <= idx; j++)
+			kids[j] = p->child[j];
+		kids[idx + 1] = right;
+		for (j = idx + 1; j <= n; j++)
+			kids[j + 1] = p->child[j];
+
+		mid = (n + 1) / 2;
+		p->h.n = (unsigned short)mid;
+		for (j = 0; j < mid; j++) {
+			p->h.key[j] = keys[j];
+			p->h.head[j] = key_head(keys[j]);
+			p->child[j] = kids[j];
+		}
+		p->child[mid] = kids[mid];
+
+		q->h.n = (unsigned short)(n - mid);
+		for (j = mid + 1; j <= n; j++) {
+			q->h.key[j - mid - 1] = keys[j];
+			q->h.head[j - mid - 1] = key_head(keys[j]);
+			q->child[j - mid - 1] = kids[j];
+		}
+		q->child[n - mid] = kids[n + 1];
+
+		sep = keys[mid];
+		left = (struct bt_node *)p;
+		right = (struct bt_node *)q;
+	}
+
+	m->size++;
+	return MCPKG_CONTAINER_OK;
+}
+
+/* ----- remove ----- */
+
+static void bt_slot_shift_left(const McPkgMap *m, struct bt_leaf *l,
+                               unsigned i)
+{
+	unsigned n = l->h.n;
+
+	memmove(&l->h.head[i], &l->h.head[i + 1],
+	        (n - i - 1) * sizeof(uint64_t));
+	memmove(&l->h.key[i], &l->h.key[i + 1], (n - i - 1) * sizeof(char *));
+	memmove(bt_val(m, l, i), bt_val(m, l, i + 1),
+	        (size_t)(n - i - 1) * m->bt_stride);
+	l->h.n--;
+}
+
+/* drop separator idx and child idx + 1 of x (separator not freed) */
+static void bt_inner_drop(struct bt_inner *x, unsigned idx)
+{
+	unsigned n = x->h.n;
+
+	memmove(&x->h.head[idx], &x->h.head[idx + 1],
+	        (n - idx - 1) * sizeof(uint64_t));
+	memmove(&x->h.key[idx], &x->h.key[idx + 1],
+	        (n - idx - 1) * sizeof(char *));
+	memmove(&x->child[idx + 1], &x->child[idx + 2],
+	        (n - idx - 1) * sizeof(struct bt_node *));
+	x->h.n--;
+}
+
+static void bt_sep_set(McPkgMap *m, struct bt_inner *p, unsigned idx,
+                       char *s)
+{
+	bt_sep_free(m, p->h.key[idx]);
+	p->h.key[idx] = s;
+	p->h.head[idx] = key_head(s);
+}
+
+/* append leaf r to l and unlink r */
+static void bt_leaf_merge(McPkgMap *m, struct bt_leaf *l, struct bt_leaf *r)
+{
+	unsigned n = l->h.n;
+
+	memcpy(&l->h.head[n], r->h.head, r->h.n * sizeof(uint64_t));
+	memcpy(&l->h.key[n], r->h.key, r->h.n * sizeof(char *));
+	memcpy(bt_val(m, l, n), bt_val(m, r, 0),
+	       (size_t)r->h.n * m->bt_stride);
+	l->h.n += r->h.n;
+
+	l->next = r->next;
+	if (r->next)
+		r->next->prev = l;
+	bt_leaf_free(m, r);
+}
+
+/* append (sep, r) to inner l */
+static void bt_inner_merge(McPkgMap *m, struct bt_inner *l, char *sep,
+                           struct bt_inner *r)
+{
+	unsigned n = l->h.n;
+
+	l->h.key[n] = sep;
+	l->h.head[n] = key_head(sep);
+	memcpy(&l->h.key[n + 1], r->h.key, r->h.n * sizeof(char *));
+	memcpy(&l->h.head[n + 1], r->h.head, r->h.n * sizeof(uint64_t));
+	memcpy(&l->child[n + 1], r->child,
+	       (r->h.n + 1) * sizeof(struct bt_node *));
+	l->h.n += r->h.n + 1;
+	bt_inner_free(m, r);
+}
+
+/*
+ * Leaf l (child idx of p) is short: merge with a sibling when both fit,
+ * else borrow one entry (returns 1; l may still be short). A borrow needs
+ * a new separator; if that allocation fails l just stays short (never
+ * empty, so still valid).
+ */
+static int bt_fix_leaf(McPkgMap *m, struct bt_leaf *l, struct bt_inner *p,
+                        unsigned idx)
+{
+	struct bt_leaf *sib;
+	unsigned n;
+	char *s;
+
+	if (idx < p->h.n) {
+		sib = (struct bt_leaf *)p->child[idx + 1];
+		if (l->h.n + sib->h.n <= BT_MAX) {
+			bt_sep_free(m, p->h.key[idx]);
+			bt_inner_drop(p, idx);
+			bt_leaf_merge(m, l, sib);
+			return 0;
+		}
+		s = bt_sep_new(m, sib->h.key[0], sib->h.key[1]);
+		if (!s)
+			return 0;
+		n = l->h.n;
+		l->h.head[n] = sib->h.head[0];
+		l->h.key[n] = sib->h.key[0];
+		memcpy(bt_val(m, l, n), bt_val(m, sib, 0), m->bt_stride);
+		l->h.n++;
+		bt_slot_shift_left(m, sib, 0);
+		bt_sep_set(m, p, idx, s);
+		return 1;
+	}
+
+	sib = (struct bt_leaf *)p->child[idx - 1];
+	if (l->h.n + sib->h.n <= BT_MAX) {
+		bt_sep_free(m, p->h.key[idx - 1]);
+		bt_inner_drop(p, idx - 1);
+		bt_leaf_merge(m, sib, l);
+		return 0;
+	}
+	n = sib->h.n - 1;
+	s = bt_sep_new(m, sib->h.key[n - 1], sib->h.key[n]);
+	if (!s)
+		return 0;
+	bt_slot_shift_right(m, l, 0);
+	l->h.head[0] = sib->h.head[n];
+	l->h.key[0] = sib->h.key[n];
+	memcpy(bt_val(m, l, 0), bt_val(m, sib, n), m->bt_stride);
+	l->h.n++;
+	sib->h.n--;
+	bt_sep_set(m, p, idx - 1, s);
+	return 1;
+}
+
+/* inner x (child idx of p) is short: rotate through p or merge */
+static void bt_fix_inner(McPkgMap *m, struct bt_inner *x, struct bt_inner *p,
+                         unsigned idx)
+{
+	struct bt_inner *sib;
+	unsigned n = x->h.n;
+
+	if (idx < p->h.n) {
+		sib = (struct bt_inner *)p->child[idx + 1];
+		if (n + 1 + sib->h.n <= BT_MAX - 1) {
+			char *sep = p->h.key[idx];
+
+			bt_inner_drop(p, idx);
+			bt_inner_merge(m, x, sep, sib);
+			return;
+		}
+		x->h.key[n] = p->h.key[idx];
+		x->h.head[n] = p->h.head[idx];
+		x->child[n + 1] = sib->child[0];
+		x->h.n++;
+		p->h.key[idx] = sib->h.key[0];
+		p->h.head[idx] = sib->h.head[0];
+		memmove(&sib->child[0], &sib->child[1],
+		        sib->h.n * sizeof(struct bt_node *));
+		memmove(&sib->h.key[0], &sib->h.key[1],
+		        (sib->h.n - 1) * sizeof(char *));
+		memmove(&sib->h.head[0], &sib->h.head[1],
+		        (sib->h.n - 1) * sizeof(uint64_t));
+		sib->h.n--;
+		return;
+	}
+
+	sib = (struct bt_inner *)p->child[idx - 1];
+	if (sib->h.n + 1 + n <= BT_MAX - 1) {
+		char *sep = p->h.key[idx - 1];
+
+		bt_inner_drop(p, idx - 1);
+		bt_inner_merge(m, sib, sep, x);
+		return;
+	}
+	memmove(&x->child[1], &x->child[0], (n + 1) * sizeof(struct bt_node *));
+	memmove(&x->h.key[1], &x->h.key[0], n * sizeof(char *));
+	memmove(&x->h.head[1], &x->h.head[0], n * sizeof(uint64_t));
+	x->h.key[0] = p->h.key[idx - 1];
+	x->h.head[0] = p->h.head[idx - 1];
+	x->child[0] = sib->child[sib->h.n];
+	x->h.n++;
+	p->h.key[idx - 1] = sib->h.key[sib->h.n - 1];
+	p->h.head[idx - 1] = sib->h.head[sib->h.n - 1];
+	sib->h.n--;
+}
+
+/*
+ * Drop slots [i, j) of leaf l reached via path; 1 if nodes were
+ * rebalanced. An emptied leaf always merges.
+ */
+static int bt_erase(McPkgMap *m, struct bt_path *path, struct bt_leaf *l,
+                    unsigned i, unsigned j)
+{
+	unsigned d, k, tail = l->h.n - j;
+
+	for (k = i; k < j; k++) {
+		if (m->ops.value_dtor)
+			m->ops.value_dtor(bt_val(m, l, k), m->ops.ctx);
+		bt_key_release(m, l->h.key[k]);
+	}
+	memmove(&l->h.head[i], &l->h.head[j], tail * sizeof(uint64_t));
+	memmove(&l->h.key[i], &l->h.key[j], tail * sizeof(char *));
+	memmove(bt_val(m, l, i), bt_val(m, l, j), (size_t)tail * m->bt_stride);
+	l->h.n -= j - i;
+	m->size -= j - i;
+
+	d = path->depth;
+	if (!d || l->h.n >= BT_LEAF_MIN)
+		return 0;
+
+	while (bt_fix_leaf(m, l, path->node[d - 1], path->idx[d - 1]) &&
+	       l->h.n < BT_LEAF_MIN)
+		;
+	/* walk up while inner nodes run short */
+	for (d--; d > 0; d--) {
+		struct bt_inner *x = path->node[d];
+
+		if (x->h.n >= BT_INNER_MIN)
+			break;
+		bt_fix_inner(m, x, path->node[d - 1], path->idx[d - 1]);
+	}
+
+	/* collapse a root left with a single child */
+	while (m->bt_height && m->bt_root->n == 0) {
+		struct bt_inner *old = (struct bt_inner *)m->bt_root;
+
+		m->bt_root = old->child[0];
+		m->bt_height--;
+		bt_inner_free(m, old);
+	}
+	return 1;
+}
+
+MCPKG_CONTAINER_ERROR mcpkg_map_bt_remove(McPkgMap *m, const char *key,
+                size_t len)
+{
+	struct bt_path path;
+	struct bt_leaf *l;
+	uint64_t kh = key_head_n(key, len);
+	unsigned i;
+	int eq;
+
+	if (!m->bt_root)
+		return MCPKG_CONTAINER_ERR_NOT_FOUND;
+
+	l = bt_descend(m, key, len, kh, &path);
+	i = bt_lower(&l->h, key, len, kh, &eq);
+	if (!eq)
+		return MCPKG_CONTAINER_ERR_NOT_FOUND;
+
+	bt_erase(m, &path, l, i, i + 1);
+	return MCPKG_CONTAINER_OK;
+}
+
+/*
+ * Erase the in-range run of each leaf at once while walking the chain;
+ * re-descend only when a leaf is left (the path is per leaf) or a
+ * rebalance moved entries. Key pointers survive merges/borrows, so the
+ * first key past the run is a safe anchor.
+ */
+size_t mcpkg_map_bt_remove_range(McPkgMap *m, const char *lo,
+                                 const char *hi)
+{
+	struct bt_path path;
+	struct bt_leaf *l;
+	const char *at = lo, *next;
+	size_t removed = 0, len;
+	uint64_t kh;
+	unsigned i, j;
+	int eq;
+
+	if (!m->bt_root)
+		return 0;
+
+	if (!at) {
+		l = bt_edge_leaf(m, 0);
+		if (!l || !l->h.n)
+			return 0;
+		at = l->h.key[0];
+	}
+
+	while (at) {
+		len = strlen(at);
+		kh = key_head_n(at, len);
+		l = bt_descend(m, at, len, kh, &path);
+		i = bt_lower(&l->h, at, len, kh, &eq);
+		at = NULL;
+
+		for (;;) {
+			if (i >= l->h.n) {
+				if (l->next)
+					at = l->next->h.key[0];
+				break;
+			}
+			for (j = i; j < l->h.n; j++)
+				if (hi && strcmp(l->h.key[j], hi) >= 0)
+					break;
+			if (j == i)
+				break;
+
+			if (j < l->h.n)
+				next = l->h.key[j];
+			else
+				next = l->next ? l->next->h.key[0] : NULL;
+			removed += j - i;
+			if (bt_erase(m, &path, l, i, j)) {
+				at = next;
+				break;
+			}
+		}
+	}
+	return removed;
+}
+
+/* ----- bulk load ----- */
+
+static const char *bt_edge_key(const struct bt_node *x, unsigned h,
+                               int last)
+{
+	for (; h; h--)
+		x = ((const struct bt_inner *)x)->child[last ? x->n : 0];
+	return x->key[last ? x->n - 1 : 0];
+}
+
+/* release lvl[from, to), each a whole subtree of height h */
+static void bt_free_level(McPkgMap *m, struct bt_node **lvl, size_t from,
+                          size_t to, unsigned h)
+{
+	for (; from < to; from++)
+		bt_free_subtree(m, lvl[from], h);
+}
+
+/*
+ * Bottom-up build: c nodes of a level are split into ceil(c / BT_MAX)
+ * groups as evenly as possible, so every non-root node is at least half
+ * full. Parents overwrite lvl[] in place (parent j <= its first child).
+ */
+MCPKG_CONTAINER_ERROR mcpkg_map_bt_bulk_load(McPkgMap *m,
+                const char *const *keys,
+                const unsigned char *values, size_t n)
+{
+	struct bt_node **lvl;
+	struct bt_leaf *l, *prev = NULL;
+	struct bt_inner *x;
+	unsigned long long need;
+	size_t c, g, j, k, pos, take, lvl_bytes;
+	unsigned h = 0;
+	char *kc;
+
+	/* an emptied map may still hold its root leaf */
+	mcpkg_map_bt_free(m);
+
+	g = (n + BT_MAX - 1) / BT_MAX;
+	need = m->bytes_used + (unsigned long long)g * bt_leaf_bytes(m);
+	for (c = g; c > 1;) {
+		c = (c + BT_MAX - 1) / BT_MAX;
+		need += (unsigned long long)c * sizeof(struct bt_inner);
+	}
+	if (need > m->max_bytes)
+		return MCPKG_CONTAINER_ERR_LIMIT;
+
+	lvl_bytes = g * sizeof(*lvl);
+	lvl = mcpkg_allocator_alloc(m->alloc, lvl_bytes);
+	if (!lvl)
+		return MCPKG_CONTAINER_ERR_NO_MEM;
+
+	for (j = 0, pos = 0; j < g; j++) {
+		l = bt_leaf_new(m);
+		if (!l)
+			goto fail_leaves;
+		lvl[j] = &l->h;
+		l->prev = prev;
+		if (prev)
+			prev->next = l;
+		prev = l;
+
+		take = n / g + (j < n % g);
+		for (k = 0; k < take; k++, pos++) {
+			kc = bt_key_store(m, keys[pos], strlen(keys[pos]));
+			if (!kc) {
+				j++;
+				goto fail_leaves;
+			}
+			l->h.key[k] = kc;
+			l->h.head[k] = key_head(kc);
+			if (m->ops.value_copy)
+				m->ops.value_copy(bt_val(m, l, k),
+				                  values + pos * m->value_size,
+				                  m->ops.ctx);
+			else
+				memcpy(bt_val(m, l, k),
+				       values + pos * m->value_size,
+				       m->value_size);
+			l->h.n++;
+		}
+	}
+
+	for (c = g; c > 1; c = g, h++) {
+		g = (c + BT_MAX - 1) / BT_MAX;
+		for (j = 0, pos = 0; j < g; j++) {
+			x = bt_inner_new(m);
+			if (!x) {
+				bt_free_level(m, lvl, 0, j, h + 1);
+				bt_free_level(m, lvl, pos, c, h);
+				mcpkg_allocator_free(m->alloc, lvl, lvl_bytes);
+				return MCPKG_CONTAINER_ERR_NO_MEM;
+			}
+			take = c / g + (j < c % g);
+			memcpy(x->child, &lvl[pos], take * sizeof(*lvl));
+			x->h.n = (unsigned short)(take - 1);
+			pos += take;
+			lvl[j] = &x->h;
+		}
+
+		/* separators once the level owns all children */
+		for (j = 0; j < g; j++) {
+			x = (struct bt_inner *)lvl[j];
+			for (k = 0; k < x->h.n; k++) {
+				kc = bt_sep_new(m,
+				                bt_edge_key(x->child[k], h, 1),
+				                bt_edge_key(x->child[k + 1], h,
+				                            0));
+				if (!kc) {
+					bt_free_level(m, lvl, 0, g, h + 1);
+					mcpkg_allocator_free(m->alloc, lvl,
+					                     lvl_bytes);
+					return MCPKG_CONTAINER_ERR_NO_MEM;
+				}
+				x->h.key[k] = kc;
+				x->h.head[k] = key_head(kc);
+			}
+		}
+	}
+
+	m->bt_root = lvl[0];
+	m->bt_height = h;
+	m->size = n;
+	mcpkg_allocator_free(m->alloc, lvl, lvl_bytes);
+	return MCPKG_CONTAINER_OK;
+
+fail_leaves:
+	bt_free_level(m, lvl, 0, j, 0);
+	mcpkg_allocator_free(m->alloc, lvl, lvl_bytes);
+	return MCPKG_CONTAINER_ERR_NO_MEM;
+}
+
+/* ----- iteration: iter = leaf | slot (leaves are BT_ALIGN aligned) ----- */
+
+static void *bt_iter_make(const struct bt_leaf *l, unsigned i)
+{
+	if (l && i >= l->h.n) {
+		l = l->next;
+		i = 0;
+	}
+	if (!l || !l->h.n)
+		return NULL;
+	return (void *)((uintptr_t)l | i);
+}
+
+static struct bt_leaf *bt_iter_leaf(void *it, unsigned *i)
+{
+	*i = (unsigned)((uintptr_t)it & (BT_ALIGN - 1));
+	return (struct bt_leaf *)((uintptr_t)it & ~(uintptr_t)(BT_ALIGN - 1));
+}
+
+void *mcpkg_map_bt_iter_first(const McPkgMap *m)
+{
+	return bt_iter_make(bt_edge_leaf(m, 0), 0);
+}
+
+const char *mcpkg_map_bt_iter_key(void *iter)
+{
+	struct bt_leaf *l;
+	unsigned i;
+
+	l = bt_iter_leaf(iter, &i);
+	return l->h.key[i];
+}
+
+void *mcpkg_map_bt_iter_seek(const McPkgMap *m, const char *key, size_t len)
+{
+	struct bt_leaf *l;
+	uint64_t kh = key_head_n(key, len);
+	int eq;
+
+	if (!m->bt_root)
+		return NULL;
+	l = bt_descend(m, key, len, kh, NULL);
+	return bt_iter_make(l, bt_lower(&l->h, key, len, kh, &eq));
+}
+
+int mcpkg_map_bt_iter_next(const McPkgMap *m, void **iter,
+                           const char **key_out, void *value_out)
+{
+	struct bt_leaf *l;
+	unsigned i;
+
+	if (!*iter)
+		return 0;
+
+	l = bt_iter_leaf(*iter, &i);
+	if (key_out)
+		*key_out = l->h.key[i];
+	if (value_out)
+		memcpy(value_out, bt_val(m, l, i), m->value_size);
+
+	*iter = bt_iter_make(l, i + 1);
+	return 1;
+}
+
+int mcpkg_map_bt_last(const McPkgMap *m, const char **key_out,
+                      void *value_out)
+{
+	struct bt_leaf *l = bt_edge_leaf(m, 1);
+
+	if (!l || !l->h.n)
+		return 0;
+	*key_out = l->h.key[l->h.n - 1];
+	if (value_out)
+		memcpy(value_out, bt_val(m, l, l->h.n - 1), m->value_size);
+	return 1;
+}
@@ -5,11 +5,13 @@
 #include <string.h>
 
 #include "container/mcpkg_map.h"      /* public API (opaque type) */
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_str_arena.h"
 #include "math/mcpkg_math.h"          /* overflow helpers */
 
 /*
- * McPkgMap internals (RB-tree).
- * - Include ONLY from mcpkg_map.c (not installed).
+ * McPkgMap internals (RB-tree; B+-tree backend in mcpkg_map_btree.c).
+ * - Include ONLY from mcpkg_map*.c (not installed).
  * - Keep helpers tiny & static inline.
  */
 
@@ -20,22 +22,40 @@ struct rb_node {
 	struct rb_node *right;
 	struct rb_node *parent;
 	unsigned char  color;   /* 0=black, 1=red */
-	char          *key;     /* owned C string */
-	unsigned char  value[]; /* flexible array: value_size bytes */
+	char          *key;     /* owned C string (see key_mode) */
+	unsigned char  value[]; /* value_size bytes, then inline key */
 };
 
+/* KEYS_ARENA: keys up to this length sit behind the value */
+#define MCPKG_MAP_INLINE_KEY  64u
+
+/* B+-tree: entries per leaf / children per inner node */
+#define MCPKG_MAP_BT_FANOUT   32u
+
+struct bt_node;
+
 /* full definition of the opaque map */
 struct McPkgMap {
 	struct rb_node        *root;
 	size_t                 size;
 
+	MCPKG_MAP_BACKEND      backend;
+	struct bt_node        *bt_root;
+	unsigned               bt_height;  /* inner levels above leaves */
+	size_t                 bt_stride;  /* value slot size in a leaf */
+
 	size_t                 value_size;
 	McPkgMapOps            ops;
 
+	MCPKG_CONTAINER_KEYS   key_mode;
+	McPkgStrArena         *arena;   /* KEYS_ARENA, long keys */
+	McPkgStrIntern        *intern;  /* KEYS_INTERNED, not owned */
+	const McPkgAllocator  *alloc;   /* nodes, owned keys, key arena */
+
 	size_t                 max_pairs;
 	unsigned long long     max_bytes;
 
-	/* accounting for nodes only (sizeof(node)+value_size per entry) */
+	/* accounting for nodes only (node + value + inline key) */
 	unsigned long long     bytes_used;
 };
 
@@ -68,19 +88,33 @@ static inline int under_byte_cap(const struct McPkgMap *m, size_t add_nodes)
 	return need <= m->max_bytes;
 }
 
-static inline char *dup_cstr(const char *s)
+static inline char *node_tail(const struct McPkgMap *m,
+                              const struct rb_node *n)
+{
+	return (char *)n->value + m->value_size;
+}
+
+/* inline keys are part of the node allocation */
+static inline size_t node_key_bytes(const struct McPkgMap *m,
+                                    const struct rb_node *n)
 {
-	size_t n;
-	char *p;
+	return n->key == node_tail(m, n) ? strlen(n->key) + 1 : 0;
+}
 
-	if (!s)
-		return NULL;
-	n = strlen(s);
-	p = malloc(n + 1);
-	if (!p)
-		return NULL;
-	memcpy(p, s, n + 1);
-	return p;
+/* (ptr,len) keys must not hide a NUL; stored keys are C strings */
+static inline int key_n_valid(const char *key, size_t len)
+{
+	return !len || !memchr(key, '\0', len);
+}
+
+/* strcmp() order for a NUL-free (key,len) against a C string */
+static inline int key_cmp_n(const char *key, size_t len, const char *nk)
+{
+	int c = strncmp(key, nk, len);
+
+	if (c)
+		return c;
+	return nk[len] ? -1 : 0;
 }
 
 static inline struct rb_node *tree_min(struct rb_node *x)
@@ -143,4 +177,36 @@ static inline void rotate_right(struct McPkgMap *m, struct rb_node *x)
 	x->parent = y;
 }
 
+/* ----- B+-tree backend (mcpkg_map_btree.c) ----- */
+
+void mcpkg_map_bt_free(McPkgMap *m);
+
+MCPKG_CONTAINER_ERROR mcpkg_map_bt_set(McPkgMap *m, const char *key,
+                                       size_t len, const void *value);
+
+/* value slot for key, or NULL */
+unsigned char *mcpkg_map_bt_find(const McPkgMap *m, const char *key,
+                                 size_t len);
+
+MCPKG_CONTAINER_ERROR mcpkg_map_bt_remove(McPkgMap *m, const char *key,
+                size_t len);
+
+/* map is empty; keys sorted and validated by the caller */
+MCPKG_CONTAINER_ERROR mcpkg_map_bt_bulk_load(McPkgMap *m,
+                const char *const *keys,
+                const unsigned char *values, size_t n);
+
+/* number of keys removed from [lo, hi) */
+size_t mcpkg_map_bt_remove_range(McPkgMap *m, const char *lo,
+                                 const char *hi);
+
+void *mcpkg_map_bt_iter_first(const McPkgMap *m);
+const char *mcpkg_map_bt_iter_key(void *iter);
+void *mcpkg_map_bt_iter_seek(const McPkgMap *m, const char *key,
+                             size_t len);
+int mcpkg_map_bt_iter_next(const McPkgMap *m, void **iter,
+                           const char **key_out, void *value_out);
+int mcpkg_map_bt_last(const McPkgMap *m, const char **key_out,
+                      void *value_out);
+
 #endif /* MCPKG_MAP_P_H */
@@ -0,0 +1,162 @@
+#include "container/mcpkg_str_arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "math/mcpkg_math.h"
+
+#define STR_ARENA_CHUNK  4096u
+
+struct str_chunk {
+	struct str_chunk	*next;
+	size_t			cap;
+	size_t			off;
+	char			data[];
+};
+
+struct McPkgStrArena {
+	struct str_chunk	*head;     /* current chunk (newest) */
+	const McPkgAllocator	*alloc;
+	size_t			used;
+	size_t			reserved;
+	unsigned long long	max_bytes;
+};
+
+static struct str_chunk *chunk_new(McPkgStrArena *a, size_t need)
+{
+	struct str_chunk *c;
+	size_t cap = need > STR_ARENA_CHUNK ? need : STR_ARENA_CHUNK;
+	size_t total;
+
+	if (mcpkg_math_add_overflow_size(sizeof(*c), cap, &total))
+		return NULL;
+	if ((unsigned long long)a->reserved + total > a->max_bytes)
+		return NULL;
+
+	c = mcpkg_allocator_alloc(a->alloc, total);
+	if (!c)
+		return NULL;
+
+	c->next = NULL;
+	c->cap = cap;
+	c->off = 0;
+	a->reserved += total;
+	return c;
+}
+
+static void chunk_free(McPkgStrArena *a, struct str_chunk *c)
+{
+	mcpkg_allocator_free(a->alloc, c, sizeof(*c) + c->cap);
+}
+
+McPkgStrArena *mcpkg_str_arena_new_alloc(const McPkgAllocator *alloc,
+                unsigned long long max_bytes)
+{
+	McPkgStrArena *a;
+
+	alloc = alloc ? alloc : mcpkg_allocator_default();
+	a = mcpkg_allocator_calloc(alloc, 1, sizeof(*a));
+	if (!a)
+		return NULL;
+
+	a->alloc = alloc;
+	a->max_bytes = max_bytes ? max_bytes : MCPKG_CONTAINER_MAX_BYTES;
+	return a;
+}
+
+McPkgStrArena *mcpkg_str_arena_new(unsigned long long max_bytes)
+{
+	return mcpkg_str_arena_new_alloc(NULL, max_bytes);
+}
+
+void mcpkg_str_arena_free(McPkgStrArena *a)
+{
+	struct str_chunk *c, *n;
+
+	if (!a)
+		return;
+
+	for (c = a->head; c; c = n) {
+		n = c->next;
+		chunk_free(a, c);
+	}
+	mcpkg_allocator_free(a->alloc, a, sizeof(*a));
+}
+
+char *mcpkg_str_arena_dupn(McPkgStrArena *a, const char *s, size_t len)
+{
+	struct str_chunk *c;
+	size_t need;
+	char *p;
+
+	if (!a || (!s && len))
+		return NULL;
+	if (mcpkg_math_add_overflow_size(len, 1, &need))
+		return NULL;
+
+	c = a->head;
+	if (!c || c->cap - c->off < need) {
+		c = chunk_new(a, need);
+		if (!c)
+			return NULL;
+		/* oversized strings get a private chunk behind head */
+		if (a->head && need > STR_ARENA_CHUNK) {
+			c->next = a->head->next;
+			a->head->next = c;
+		} else {
+			c->next = a->head;
+			a->head = c;
+		}
+	}
+
+	p = c->data + c->off;
+	if (len)
+		memcpy(p, s, len);
+	p[len] = '\0';
+	c->off += need;
+	a->used += need;
+	return p;
+}
+
+char *mcpkg_str_arena_dup(McPkgStrArena *a, const char *s)
+{
+	if (!s)
+		return NULL;
+	return mcpkg_str_arena_dupn(a, s, strlen(s));
+}
+
+void mcpkg_str_arena_reset(McPkgStrArena *a)
+{
+	struct str_chunk *c, *n, *keep = NULL;
+
+	if (!a)
+		return;
+
+	for (c = a->head; c; c = n) {
+		n = c->next;
+		if (!keep && c->cap == STR_ARENA_CHUNK) {
+			keep = c;
+			continue;
+		}
+		chunk_free(a, c);
+	}
+
+	a->head = keep;
+	a->used = 0;
+	a->reserved = 0;
+	if (keep) {
+		keep->next = NULL;
+		keep->off = 0;
+		a->reserved = sizeof(*keep) + keep->cap;
+	}
+}
+
+size_t mcpkg_str_arena_used(const McPkgStrArena *a)
+{
+	return a ? a->used : 0;
+}
+
+size_t mcpkg_str_arena_reserved(const McPkgStrArena *a)
+{
+	return a ? a->reserved : 0;
+}
@@ -0,0 +1,46 @@
+#ifndef MCPKG_STR_ARENA_H
+#define MCPKG_STR_ARENA_H
+
+#include <stddef.h>
+#include "mcpkg_export.h"
+#include "container/mcpkg_container_error.h"
+#include "container/mcpkg_alloc.h"
+
+MCPKG_BEGIN_DECLS
+
+/*
+ * McPkgStrArena: append-only string storage in large chunks.
+ * - Strings live until reset/free; there is no per-string free.
+ * - Returned pointers never move.
+ * - Not thread-safe; callers must synchronize.
+ */
+
+typedef struct McPkgStrArena McPkgStrArena;
+
+/* Create an arena; max_bytes 0 = default container cap. */
+MCPKG_API McPkgStrArena *mcpkg_str_arena_new(unsigned long long max_bytes);
+
+/* Same; chunks come from alloc (NULL = default allocator). */
+MCPKG_API McPkgStrArena *mcpkg_str_arena_new_alloc(
+        const McPkgAllocator *alloc,
+        unsigned long long max_bytes);
+
+/* Free the arena and every string in it. */
+MCPKG_API void mcpkg_str_arena_free(McPkgStrArena *a);
+
+/* Copy s (NUL included) into the arena. NULL on OOM/limit. */
+MCPKG_API char *mcpkg_str_arena_dup(McPkgStrArena *a, const char *s);
+
+/* Copy len bytes of s and NUL-terminate. NULL on OOM/limit. */
+MCPKG_API char *mcpkg_str_arena_dupn(McPkgStrArena *a, const char *s,
+                                     size_t len);
+
+/* Drop all strings; keeps the first chunk for reuse. */
+MCPKG_API void mcpkg_str_arena_reset(McPkgStrArena *a);
+
+/* Bytes handed out / bytes reserved in chunks. */
+MCPKG_API size_t mcpkg_str_arena_used(const McPkgStrArena *a);
+MCPKG_API size_t mcpkg_str_arena_reserved(const McPkgStrArena *a);
+
+MCPKG_END_DECLS
+#endif /* MCPKG_STR_ARENA_H */
@@ -0,0 +1,189 @@
+#include "container/mcpkg_str_intern.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_str_arena.h"
+#include "crypto/mcpkg_sip_hash.h"
+#include "math/mcpkg_math.h"
+
+/* open addressing, linear probe; load <= 3/4 */
+struct McPkgStrIntern {
+	const char		**strs;
+	uint64_t		*hashes;
+	size_t			*lens;
+	size_t			cap;
+	size_t			len;
+	size_t			max_strings;
+	McPkgStrArena		*arena;
+	const McPkgAllocator	*alloc;    /* default at creation */
+	uint64_t		k0;
+	uint64_t		k1;
+};
+
+static uint64_t intern_hash(const McPkgStrIntern *in, const char *s,
+                            size_t len)
+{
+	return mcpkg_siphash24_k(s, len, in->k0, in->k1);
+}
+
+static size_t intern_slot(const McPkgStrIntern *in, const char *s,
+                          size_t len, uint64_t hv, int *found)
+{
+	size_t mask = in->cap - 1;
+	size_t pos = (size_t)hv & mask;
+
+	*found = 0;
+	while (in->strs[pos]) {
+		if (in->hashes[pos] == hv && in->lens[pos] == len &&
+		    memcmp(in->strs[pos], s, len) == 0) {
+			*found = 1;
+			break;
+		}
+		pos = (pos + 1) & mask;
+	}
+	return pos;
+}
+
+static void intern_table_free(const McPkgStrIntern *in, const char **strs,
+                              uint64_t *hashes, size_t *lens, size_t cap)
+{
+	mcpkg_allocator_free(in->alloc, (void *)strs, cap * sizeof(*strs));
+	mcpkg_allocator_free(in->alloc, hashes, cap * sizeof(*hashes));
+	mcpkg_allocator_free(in->alloc, lens, cap * sizeof(*lens));
+}
+
+static int intern_grow(McPkgStrIntern *in)
+{
+	const char **strs;
+	uint64_t *hashes;
+	size_t *lens;
+	size_t new_cap, i, pos, mask;
+
+	new_cap = in->cap ? in->cap << 1 : 64;
+	strs = mcpkg_allocator_calloc(in->alloc, new_cap, sizeof(*strs));
+	hashes = mcpkg_allocator_calloc(in->alloc, new_cap, sizeof(*hashes));
+	lens = mcpkg_allocator_calloc(in->alloc, new_cap, sizeof(*lens));
+	if (!strs || !hashes || !lens) {
+		intern_table_free(in, strs, hashes, lens, new_cap);
+		return 1;
+	}
+
+	mask = new_cap - 1;
+	for (i = 0; i < in->cap; i++) {
+		if (!in->strs[i])
+			continue;
+		pos = (size_t)in->hashes[i] & mask;
+		while (strs[pos])
+			pos = (pos + 1) & mask;
+		strs[pos] = in->strs[i];
+		hashes[pos] = in->hashes[i];
+		lens[pos] = in->lens[i];
+	}
+
+	intern_table_free(in, in->strs, in->hashes, in->lens, in->cap);
+	in->strs = strs;
+	in->hashes = hashes;
+	in->lens = lens;
+	in->cap = new_cap;
+	return 0;
+}
+
+McPkgStrIntern *mcpkg_str_intern_new(size_t max_strings,
+                                     unsigned long long max_bytes)
+{
+	const McPkgAllocator *alloc = mcpkg_allocator_default();
+	McPkgStrIntern *in;
+
+	in = mcpkg_allocator_calloc(alloc, 1, sizeof(*in));
+	if (!in)
+		return NULL;
+
+	in->alloc = alloc;
+	in->max_strings = max_strings ? max_strings
+	                  : MCPKG_CONTAINER_MAX_ELEMENTS;
+	in->arena = mcpkg_str_arena_new_alloc(alloc, max_bytes);
+	if (!in->arena || intern_grow(in)) {
+		mcpkg_str_arena_free(in->arena);
+		mcpkg_allocator_free(alloc, in, sizeof(*in));
+		return NULL;
+	}
+
+	mcpkg_sip_seed(&in->k0, &in->k1);
+	return in;
+}
+
+void mcpkg_str_intern_free(McPkgStrIntern *in)
+{
+	if (!in)
+		return;
+
+	mcpkg_str_arena_free(in->arena);
+	intern_table_free(in, in->strs, in->hashes, in->lens, in->cap);
+	mcpkg_allocator_free(in->alloc, in, sizeof(*in));
+}
+
+const char *mcpkg_str_intern_addn(McPkgStrIntern *in, const char *s,
+                                  size_t len)
+{
+	uint64_t hv;
+	size_t pos;
+	int found;
+	char *copy;
+
+	if (!in || (!s && len))
+		return NULL;
+	if (!s)
+		s = "";
+
+	hv = intern_hash(in, s, len);
+	pos = intern_slot(in, s, len, hv, &found);
+	if (found)
+		return in->strs[pos];
+
+	if (in->len >= in->max_strings)
+		return NULL;
+
+	if ((in->len + 1) * 4 > in->cap * 3) {
+		if (intern_grow(in))
+			return NULL;
+		pos = intern_slot(in, s, len, hv, &found);
+	}
+
+	copy = mcpkg_str_arena_dupn(in->arena, s, len);
+	if (!copy)
+		return NULL;
+
+	in->strs[pos] = copy;
+	in->hashes[pos] = hv;
+	in->lens[pos] = len;
+	in->len++;
+	return copy;
+}
+
+const char *mcpkg_str_intern_add(McPkgStrIntern *in, const char *s)
+{
+	if (!s)
+		return NULL;
+	return mcpkg_str_intern_addn(in, s, strlen(s));
+}
+
+const char *mcpkg_str_intern_find(const McPkgStrIntern *in, const char *s)
+{
+	size_t len, pos;
+	int found;
+
+	if (!in || !s)
+		return NULL;
+
+	len = strlen(s);
+	pos = intern_slot(in, s, len, intern_hash(in, s, len), &found);
+	return found ? in->strs[pos] : NULL;
+}
+
+size_t mcpkg_str_intern_size(const McPkgStrIntern *in)
+{
+	return in ? in->len : 0;
+}
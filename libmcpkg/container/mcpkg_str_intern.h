@@ -0,0 +1,49 @@
+#ifndef MCPKG_STR_INTERN_H
+#define MCPKG_STR_INTERN_H
+
+#include <stddef.h>
+#include "mcpkg_export.h"
+#include "container/mcpkg_container_error.h"
+
+MCPKG_BEGIN_DECLS
+
+/*
+ * McPkgStrIntern: set of canonical strings shared across containers.
+ * - Each distinct string is stored once; equal strings share a pointer.
+ * - Strings live until the table is freed (no removal).
+ * - Not thread-safe; callers must synchronize.
+ */
+
+typedef struct McPkgStrIntern McPkgStrIntern;
+
+/* How McPkgHash / McPkgMap store their keys. */
+typedef enum {
+	MCPKG_CONTAINER_KEYS_OWNED = 0,   /* one malloc per key (default) */
+	MCPKG_CONTAINER_KEYS_ARENA,       /* per-container arena, small inline */
+	MCPKG_CONTAINER_KEYS_INTERNED,    /* shared McPkgStrIntern, not owned */
+} MCPKG_CONTAINER_KEYS;
+
+/* Create a table; 0 caps = defaults. NULL on failure. */
+MCPKG_API McPkgStrIntern *mcpkg_str_intern_new(size_t max_strings,
+                unsigned long long max_bytes);
+
+/* Free the table and all canonical strings. */
+MCPKG_API void mcpkg_str_intern_free(McPkgStrIntern *in);
+
+/* Canonical copy of s, added on first use. NULL on OOM/limit. */
+MCPKG_API const char *mcpkg_str_intern_add(McPkgStrIntern *in,
+                const char *s);
+
+/* Same for a (ptr,len) string that need not be NUL-terminated. */
+MCPKG_API const char *mcpkg_str_intern_addn(McPkgStrIntern *in,
+                const char *s, size_t len);
+
+/* Canonical pointer if s is interned, else NULL (never inserts). */
+MCPKG_API const char *mcpkg_str_intern_find(const McPkgStrIntern *in,
+                const char *s);
+
+/* Number of distinct strings. */
+MCPKG_API size_t mcpkg_str_intern_size(const McPkgStrIntern *in);
+
+MCPKG_END_DECLS
+#endif /* MCPKG_STR_INTERN_H */
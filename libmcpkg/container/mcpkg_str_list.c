@@ -1,34 +1,200 @@
 #include "mcpkg_str_list.h"
 #include "mcpkg_str_list_p.h"
 #include <limits.h>
+#include <stdint.h>
+
+/* ----- packed storage ----- */
+
+/* room for add more text bytes; bounded by the list's max_bytes */
+static MCPKG_CONTAINER_ERROR text_reserve(McPkgStringList *sl, size_t add)
+{
+	unsigned long long max_bytes;
+	size_t need, cap;
+	char *p;
+
+	if (add > SIZE_MAX - sl->text_len)
+		return MCPKG_CONTAINER_ERR_OVERFLOW;
+	need = sl->text_len + add;
+	if (need <= sl->text_cap)
+		return MCPKG_CONTAINER_OK;
+
+	mcpkg_list_get_limits(sl->lst, NULL, &max_bytes);
+	if ((unsigned long long)need > max_bytes)
+		return MCPKG_CONTAINER_ERR_LIMIT;
+
+	cap = sl->text_cap <= SIZE_MAX / 2 ? sl->text_cap * 2 : SIZE_MAX;
+	if (cap < need)
+		cap = need;
+	if ((unsigned long long)cap > max_bytes)
+		cap = (size_t)max_bytes;
+
+	if (sl->text == sl->inl) {
+		p = mcpkg_allocator_alloc(sl->alloc, cap);
+		if (p)
+			memcpy(p, sl->text, sl->text_len);
+	} else {
+		p = mcpkg_allocator_realloc(sl->alloc, sl->text, sl->text_cap,
+		                            cap);
+	}
+	if (!p)
+		return MCPKG_CONTAINER_ERR_NO_MEM;
+
+	sl->text = p;
+	sl->text_cap = cap;
+	return MCPKG_CONTAINER_OK;
+}
+
+/* drop the string at index and close its gap in the text */
+static void packed_erase(McPkgStringList *sl, size_t index)
+{
+	size_t *offs = mcpkg_list_at_ptr(sl->lst, 0);
+	size_t n = mcpkg_list_size(sl->lst);
+	size_t off = offs[index], dead, i;
+
+	dead = strlen(sl->text + off) + 1;
+	memmove(sl->text + off, sl->text + off + dead,
+	        sl->text_len - off - dead);
+	sl->text_len -= dead;
+	for (i = 0; i < n; i++)
+		if (offs[i] > off)
+			offs[i] -= dead;
+	(void)mcpkg_list_remove_at(sl->lst, index);
+}
+
+/* insert a copy of s[0, len) at index in either storage mode */
+static MCPKG_CONTAINER_ERROR insert_n(McPkgStringList *sl, size_t index,
+                                      const char *s, size_t len)
+{
+	MCPKG_CONTAINER_ERROR ret;
+	size_t off;
+	char *dup;
+
+	if (index > mcpkg_list_size(sl->lst))
+		return MCPKG_CONTAINER_ERR_RANGE;
+	if (len == SIZE_MAX)
+		return MCPKG_CONTAINER_ERR_OVERFLOW;
+
+	if (sl->packed) {
+		ret = text_reserve(sl, len + 1);
+		if (ret != MCPKG_CONTAINER_OK)
+			return ret;
+
+		/* text_len moves only once the offset is in */
+		off = sl->text_len;
+		memcpy(sl->text + off, s, len);
+		sl->text[off + len] = '\0';
+		ret = mcpkg_list_add(sl->lst, index, &off);
+		if (ret != MCPKG_CONTAINER_OK)
+			return ret;
+		sl->text_len += len + 1;
+		return MCPKG_CONTAINER_OK;
+	}
+
+	dup = mcpkg_allocator_strndup(sl->alloc, s, len);
+	if (!dup)
+		return MCPKG_CONTAINER_ERR_NO_MEM;
+
+	ret = mcpkg_list_add(sl->lst, index, &dup);
+	if (ret != MCPKG_CONTAINER_OK) {
+		mcpkg_allocator_free(sl->alloc, dup, 0);
+		return ret;
+	}
+	return MCPKG_CONTAINER_OK;
+}
+
+McPkgStringList *mcpkg_stringlist_new_alloc(const McPkgAllocator *alloc,
+                size_t max_elements,
+                unsigned long long max_bytes)
+{
+	McPkgStringList *sl;
+
+	alloc = alloc ? alloc : mcpkg_allocator_default();
+	sl = mcpkg_allocator_calloc(alloc, 1, sizeof(*sl));
+	if (!sl)
+		return NULL;
+
+	sl->alloc = alloc;
+	sl->lst = strlist_make_base(alloc, max_elements, max_bytes);
+	if (!sl->lst) {
+		mcpkg_allocator_free(alloc, sl, sizeof(*sl));
+		return NULL;
+	}
+
+	return sl;
+}
 
 McPkgStringList *mcpkg_stringlist_new(size_t max_elements,
                                       unsigned long long max_bytes)
+{
+	return mcpkg_stringlist_new_alloc(NULL, max_elements, max_bytes);
+}
+
+McPkgStringList *mcpkg_stringlist_new_packed_alloc(
+        const McPkgAllocator *alloc,
+        size_t max_elements,
+        unsigned long long max_bytes)
 {
 	McPkgStringList *sl;
+	McPkgListOps ops;
 
-	sl = calloc(1, sizeof(*sl));
+	alloc = alloc ? alloc : mcpkg_allocator_default();
+	sl = mcpkg_allocator_calloc(alloc, 1,
+	                            sizeof(*sl) + MCPKG_STRLIST_INLINE_TEXT);
 	if (!sl)
 		return NULL;
 
-	sl->lst = strlist_make_base(max_elements, max_bytes);
+	sl->alloc = alloc;
+	memset(&ops, 0, sizeof(ops));
+	ops.key = strlist_packed_key;
+	ops.ctx = sl;
+	sl->lst = mcpkg_list_new_inline_alloc(alloc, sizeof(size_t), &ops,
+	                                      MCPKG_STRLIST_INLINE_ELEMS,
+	                                      max_elements, max_bytes);
 	if (!sl->lst) {
-		free(sl);
+		mcpkg_allocator_free(alloc, sl,
+		                     sizeof(*sl) + MCPKG_STRLIST_INLINE_TEXT);
 		return NULL;
 	}
 
+	sl->packed = 1;
+	sl->text = sl->inl;
+	sl->text_cap = MCPKG_STRLIST_INLINE_TEXT;
 	return sl;
 }
 
+McPkgStringList *mcpkg_stringlist_new_packed(size_t max_elements,
+                unsigned long long max_bytes)
+{
+	return mcpkg_stringlist_new_packed_alloc(NULL, max_elements,
+	                max_bytes);
+}
+
+McPkgStringList *mcpkg_stringlist_new_arena(McPkgArena *arena,
+                size_t max_elements,
+                unsigned long long max_bytes)
+{
+	if (!arena)
+		return NULL;
+	return mcpkg_stringlist_new_packed_alloc(mcpkg_arena_allocator(arena),
+	                max_elements, max_bytes);
+}
+
 void mcpkg_stringlist_free(McPkgStringList *sl)
 {
+	size_t bytes = sizeof(*sl);
+
 	if (!sl)
 		return;
 
 	if (sl->lst)
 		mcpkg_list_free(sl->lst);
+	if (sl->packed) {
+		if (sl->text != sl->inl)
+			mcpkg_allocator_free(sl->alloc, sl->text, sl->text_cap);
+		bytes += MCPKG_STRLIST_INLINE_TEXT;
+	}
 
-	free(sl);
+	mcpkg_allocator_free(sl->alloc, sl, bytes);
 }
 
 MCPKG_CONTAINER_ERROR
@@ -41,6 +207,20 @@ mcpkg_stringlist_resize(McPkgStringList *sl, size_t new_size)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
 	old_len = mcpkg_list_size(sl->lst);
+	if (sl->packed) {
+		for (i = old_len; i > new_size; i--)
+			packed_erase(sl, i - 1);
+		for (i = old_len; i < new_size; i++) {
+			ret = insert_n(sl, i, "", 0);
+			if (ret != MCPKG_CONTAINER_OK) {
+				while (i-- > old_len)
+					packed_erase(sl, i);
+				return ret;
+			}
+		}
+		return MCPKG_CONTAINER_OK;
+	}
+
 	if (new_size <= old_len)
 		return mcpkg_list_resize(sl->lst, new_size);
 
@@ -55,7 +235,7 @@ mcpkg_stringlist_resize(McPkgStringList *sl, size_t new_size)
 		if (!cell)
 			goto fail_shrink;
 
-		dup = strdup("");
+		dup = mcpkg_allocator_strdup(sl->alloc, "");
 		if (!dup)
 			goto fail_shrink;
 
@@ -79,6 +259,7 @@ mcpkg_stringlist_remove_all(McPkgStringList *sl)
 {
 	if (!sl)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	sl->text_len = 0;
 	return mcpkg_list_remove_all(sl->lst);
 }
 
@@ -87,28 +268,34 @@ mcpkg_stringlist_remove_at(McPkgStringList *sl, size_t index)
 {
 	if (!sl)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (sl->packed) {
+		if (index >= mcpkg_list_size(sl->lst))
+			return MCPKG_CONTAINER_ERR_RANGE;
+		packed_erase(sl, index);
+		return MCPKG_CONTAINER_OK;
+	}
 	return mcpkg_list_remove_at(sl->lst, index);
 }
 
 MCPKG_CONTAINER_ERROR
 mcpkg_stringlist_push(McPkgStringList *sl, const char *s)
 {
-	char *dup;
-	MCPKG_CONTAINER_ERROR ret;
-
 	if (!sl)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
-	dup = strdup(s ? s : "");
-	if (!dup)
-		return MCPKG_CONTAINER_ERR_NO_MEM;
+	s = s ? s : "";
+	return insert_n(sl, mcpkg_list_size(sl->lst), s, strlen(s));
+}
 
-	ret = mcpkg_list_push(sl->lst, &dup);
-	if (ret != MCPKG_CONTAINER_OK) {
-		free(dup);
-		return ret;
-	}
-	return MCPKG_CONTAINER_OK;
+MCPKG_CONTAINER_ERROR
+mcpkg_stringlist_push_n(McPkgStringList *sl, const char *s, size_t len)
+{
+	if (!sl || (!s && len))
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	if (len && memchr(s, '\0', len))
+		return MCPKG_CONTAINER_ERR_INVALID;
+
+	return insert_n(sl, mcpkg_list_size(sl->lst), s ? s : "", len);
 }
 
 MCPKG_CONTAINER_ERROR
@@ -125,6 +312,18 @@ mcpkg_stringlist_pop(McPkgStringList *sl, char **out)
 		return MCPKG_CONTAINER_ERR_RANGE;
 
 	idx = n - 1;
+	if (sl->packed) {
+		/* the text is shared; hand out a copy */
+		if (out) {
+			*out = mcpkg_allocator_strdup(sl->alloc,
+			                              sl_at_borrow(sl, idx));
+			if (!*out)
+				return MCPKG_CONTAINER_ERR_NO_MEM;
+		}
+		packed_erase(sl, idx);
+		return MCPKG_CONTAINER_OK;
+	}
+
 	cell = (char **)mcpkg_list_at_ptr(sl->lst, idx);
 	if (!cell)
 		return MCPKG_CONTAINER_ERR_RANGE;
@@ -140,22 +339,11 @@ mcpkg_stringlist_pop(McPkgStringList *sl, char **out)
 MCPKG_CONTAINER_ERROR
 mcpkg_stringlist_add(McPkgStringList *sl, size_t index, const char *s)
 {
-	char *dup;
-	MCPKG_CONTAINER_ERROR ret;
-
 	if (!sl)
 		return MCPKG_CONTAINER_ERR_NULL_PARAM;
 
-	dup = strdup(s ? s : "");
-	if (!dup)
-		return MCPKG_CONTAINER_ERR_NO_MEM;
-
-	ret = mcpkg_list_add(sl->lst, index, &dup);
-	if (ret != MCPKG_CONTAINER_OK) {
-		free(dup);
-		return ret;
-	}
-	return MCPKG_CONTAINER_OK;
+	s = s ? s : "";
+	return insert_n(sl, index, s, strlen(s));
 }
 
 const char *mcpkg_stringlist_at(const McPkgStringList *sl, size_t index)
@@ -185,22 +373,21 @@ const char *mcpkg_stringlist_last(const McPkgStringList *sl)
 
 int mcpkg_stringlist_index_of(const McPkgStringList *sl, const char *s)
 {
-	size_t i, n;
 	const char *needle = s ? s : "";
 
 	if (!sl)
 		return -1;
 
-	n = mcpkg_stringlist_size(sl);
-	for (i = 0; i < n; i++) {
-		const char *v = sl_at_borrow(sl, i);
+	/* NULL cells key as "" */
+	return mcpkg_list_index_of_key(sl->lst, needle, strlen(needle));
+}
 
-		if (v && strcmp(v, needle) == 0)
-			return (i > (size_t)INT_MAX) ? -1 : (int)i;
-		if (!v && *needle == '\0')
-			return (i > (size_t)INT_MAX) ? -1 : (int)i;
-	}
-	return -1;
+MCPKG_CONTAINER_ERROR
+mcpkg_stringlist_set_indexed(McPkgStringList *sl, int on)
+{
+	if (!sl)
+		return MCPKG_CONTAINER_ERR_NULL_PARAM;
+	return mcpkg_list_set_indexed(sl->lst, on);
 }
 
 void mcpkg_stringlist_get_limits(const McPkgStringList *sl,
@@ -4,22 +4,55 @@
 #include <stddef.h>
 #include "mcpkg_export.h"
 #include "container/mcpkg_container_error.h"
+#include "container/mcpkg_alloc.h"
 
 MCPKG_BEGIN_DECLS
 
 /*
  * McPkgStringList: owned list of char*.
  * push/add strdup the input; remove/clear/free release strings.
+ * Packed lists keep all strings back to back in one buffer plus offsets
+ * (short lists need no heap beyond the list itself); any mutation may
+ * move them, and pop hands out a copy.
  * Not thread-safe; callers must synchronize.
  */
 
 typedef struct McPkgStringList McPkgStringList;
+struct McPkgArena;
 
 /* Create an empty list; caps default or as provided. */
 MCPKG_API McPkgStringList *mcpkg_stringlist_new(size_t max_elements /*0=def*/,
                 unsigned long long max_bytes
                 /*0=def*/);
 
+/* Same, packed storage; best for build-once lists (decoded records). */
+MCPKG_API McPkgStringList *mcpkg_stringlist_new_packed(
+        size_t max_elements /*0=def*/,
+        unsigned long long max_bytes /*0=def*/);
+
+/*
+ * Both, with the list and its strings from alloc (NULL = default).
+ * Strings handed out by pop come from alloc as well.
+ */
+MCPKG_API McPkgStringList *mcpkg_stringlist_new_alloc(
+        const McPkgAllocator *alloc,
+        size_t max_elements /*0=def*/,
+        unsigned long long max_bytes /*0=def*/);
+MCPKG_API McPkgStringList *mcpkg_stringlist_new_packed_alloc(
+        const McPkgAllocator *alloc,
+        size_t max_elements /*0=def*/,
+        unsigned long long max_bytes /*0=def*/);
+
+/*
+ * Packed list whose offsets and text live in arena (NULL if arena is
+ * NULL); all memory goes with the arena and free is a no-op. Popped
+ * strings are arena copies too.
+ */
+MCPKG_API McPkgStringList *mcpkg_stringlist_new_arena(
+        struct McPkgArena *arena,
+        size_t max_elements /*0=def*/,
+        unsigned long long max_bytes /*0=def*/);
+
 /* Free the list and all owned strings. */
 MCPKG_API void mcpkg_stringlist_free(McPkgStringList *sl);
 
@@ -42,7 +75,11 @@ mcpkg_stringlist_remove_at(McPkgStringList *sl, size_t index);
 MCPKG_API MCPKG_CONTAINER_ERROR
 mcpkg_stringlist_push(McPkgStringList *sl, const char *s);
 
-/* Pop last; if out!=NULL, transfer ownership of the string, else free it. */
+/* Append a copy of s[0, len) (not NUL-terminated; no NUL inside). */
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_stringlist_push_n(McPkgStringList *sl, const char *s, size_t len);
+
+/* Pop last; if out!=NULL, transfer ownership (mcpkg_free), else free it. */
 MCPKG_API MCPKG_CONTAINER_ERROR
 mcpkg_stringlist_pop(McPkgStringList *sl, char **out /*nullable*/);
 
@@ -58,10 +95,17 @@ MCPKG_API const char *mcpkg_stringlist_at(const McPkgStringList *sl,
 MCPKG_API const char *mcpkg_stringlist_first(const McPkgStringList *sl);
 MCPKG_API const char *mcpkg_stringlist_last(const McPkgStringList *sl);
 
-/* Linear search using strcmp; returns index or -1. */
+/* First index of s or -1; linear unless the list is indexed. */
 MCPKG_API int mcpkg_stringlist_index_of(const McPkgStringList *sl,
                                         const char *s);
 
+/*
+ * Keep a hash index so index_of is O(1) on average (see
+ * mcpkg_list_set_indexed); cheap for push-only use such as dedup loops.
+ */
+MCPKG_API MCPKG_CONTAINER_ERROR
+mcpkg_stringlist_set_indexed(McPkgStringList *sl, int on);
+
 /* Inspect or update per-instance limits (0 leaves a field unchanged). */
 MCPKG_API void mcpkg_stringlist_get_limits(const McPkgStringList *sl,
                 size_t *max_elements,
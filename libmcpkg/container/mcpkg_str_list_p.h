@@ -5,31 +5,67 @@
 #include <string.h>
 
 #include "container/mcpkg_str_list.h"     /* public API decls */
+#include "container/mcpkg_alloc.h"        /* per-list allocator */
+#include "container/mcpkg_arena.h"        /* arena-backed lists */
 #include "container/mcpkg_list.h"         /* base list impl */
+#include "container/mcpkg_list_p.h"       /* index_of_key, new_inline_alloc */
 
 /*
  * McPkgStringList internals.
  * Included only by mcpkg_str_list.c (not installed).
  */
 
+/* packed lists: inline text bytes / offsets before touching the heap */
+#define MCPKG_STRLIST_INLINE_TEXT   64u
+#define MCPKG_STRLIST_INLINE_ELEMS  4u
+
 struct McPkgStringList {
-	McPkgList		*lst;		/* list of (char *) */
+	McPkgList		*lst;		/* (char *), packed: (size_t) */
+	unsigned char		packed;
+	char			*text;		/* packed: "a\0bb\0..." */
+	size_t			text_len;
+	size_t			text_cap;
+	const McPkgAllocator	*alloc;		/* list, strings and text */
+	char			inl[];		/* packed: first text bytes */
 };
 
-/* dtor for McPkgList elements (char *). */
+/* dtor for McPkgList elements (char *); ctx is the allocator */
 static inline void strlist_elem_dtor(void *elem, void *ctx)
 {
 	char **p = (char **)elem;
 
-	(void)ctx;
 	if (p && *p) {
-		free(*p);
+		mcpkg_allocator_free((const McPkgAllocator *)ctx, *p, 0);
 		*p = NULL;
 	}
 }
 
+/* index/search key of a (char *) element: the string bytes */
+static inline const void *strlist_elem_key(const void *elem, size_t *len,
+                void *ctx)
+{
+	const char *s = *(const char *const *)elem;
+
+	(void)ctx;
+	s = s ? s : "";
+	*len = strlen(s);
+	return s;
+}
+
+/* packed: elem is an offset into ctx's text */
+static inline const void *strlist_packed_key(const void *elem, size_t *len,
+                void *ctx)
+{
+	const McPkgStringList *sl = (const McPkgStringList *)ctx;
+	const char *s = sl->text + *(const size_t *)elem;
+
+	*len = strlen(s);
+	return s;
+}
+
 /* build the underlying McPkgList configured for (char *) elements */
-static inline McPkgList *strlist_make_base(size_t max_elements,
+static inline McPkgList *strlist_make_base(const McPkgAllocator *alloc,
+                size_t max_elements,
                 unsigned long long max_bytes)
 {
 	McPkgListOps ops;
@@ -38,9 +74,11 @@ static inline McPkgList *strlist_make_base(size_t max_elements,
 	ops.copy = NULL;			/* caller handles strdup */
 	ops.dtor = strlist_elem_dtor;		/* free(char*) on remove */
 	ops.equals = NULL;			/* memcmp fallback is fine */
-	ops.ctx = NULL;
+	ops.ctx = (void *)alloc;
+	ops.key = strlist_elem_key;		/* index_of by string */
 
-	return mcpkg_list_new(sizeof(char *), &ops, max_elements, max_bytes);
+	return mcpkg_list_new_alloc(alloc, sizeof(char *), &ops,
+	                            max_elements, max_bytes);
 }
 
 /* borrowed pointer helper; invalid after reallocation/mutation */
@@ -51,6 +89,11 @@ static inline const char *sl_at_borrow(const McPkgStringList *sl, size_t i)
 	if (!sl)
 		return NULL;
 
+	if (sl->packed) {
+		const size_t *off = mcpkg_list_at_cptr(sl->lst, i);
+
+		return off ? sl->text + *off : NULL;
+	}
 	pp = (const char *const *)mcpkg_list_at_cptr(sl->lst, i);
 	return pp ? *pp : NULL;
 }
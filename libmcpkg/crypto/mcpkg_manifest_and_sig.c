@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "container/mcpkg_alloc.h"
+
 /* ---------------- small helpers ---------------- */
 
 static void pack_u64_le(uint8_t out[8], uint64_t v)
@@ -66,8 +68,8 @@ static int fill_attestation(const char *pkg_id,
 	if (!att)
 		return MCPKG_MANIFEST_ERR_NO_MEMORY;
 
-	att->pkg_id  = strdup(pkg_id);
-	att->version = strdup(version);
+	att->pkg_id  = mcpkg_strdup(pkg_id);
+	att->version = mcpkg_strdup(version);
 	if (!att->pkg_id || !att->version) {
 		mcpkg_mp_ledger_attestation_free(att);
 		return MCPKG_MANIFEST_ERR_NO_MEMORY;
@@ -126,14 +128,14 @@ mcpkg_manifest_attest_from_meta(const struct McPkgCache *meta,
 
 	rc = mcpkg_manifest_hash_b2b32(buf, len, h);
 	if (rc != MCPKG_MANIFEST_NO_ERROR) {
-		free(buf);
+		mcpkg_free(buf);
 		return rc;
 	}
 
 	rc = mcpkg_manifest_attest_b2b32(meta->id, meta->version, h, ts_ms,
 	                                 signer, signer_ctx, out_att);
 
-	free(buf);
+	mcpkg_free(buf);
 	return rc;
 }
 
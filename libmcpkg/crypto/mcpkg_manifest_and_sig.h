@@ -29,7 +29,7 @@ typedef int (*mcpkg_signer_cb)(const void *msg, size_t msg_len,
                                uint8_t out_pub32[32], uint8_t out_sig64[64],
                                void *ctx);
 
-/* --- pack meta via mpgen --- */
+/* --- pack meta via mpgen (*out_buf: mcpkg_free() it) --- */
 MCPKG_API int
 mcpkg_manifest_pack(const struct McPkgCache *meta,
                     void **out_buf, size_t *out_len);
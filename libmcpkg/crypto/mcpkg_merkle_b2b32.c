@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "container/mcpkg_alloc.h"
+
 #include "mcpkg_crypto_hash.h"
 
 #include "mp/mcpkg_mp_ledger_sth.h"
@@ -23,7 +25,7 @@ static int grow(struct McPkgMerkleB2B32 *t, size_t need_cap)
 	newcap = t->cap ? t->cap : 8;
 	while (newcap < need_cap) newcap *= 2;
 
-	p = (uint8_t *)realloc(t->leaves, newcap * NODE_SZ);
+	p = (uint8_t *)mcpkg_realloc(t->leaves, newcap * NODE_SZ);
 	if (!p) return MCPKG_MERKLE_ERR_NO_MEMORY;
 
 	t->leaves = p;
@@ -49,7 +51,7 @@ struct level_buf {
 static void free_levels(struct level_buf *lv, size_t n)
 {
 	size_t i;
-	for (i = 0; i < n; i++) free(lv[i].data);
+	for (i = 0; i < n; i++) mcpkg_free(lv[i].data);
 }
 
 static int build_levels(const uint8_t *leaves, size_t n_leaves,
@@ -64,15 +66,15 @@ static int build_levels(const uint8_t *leaves, size_t n_leaves,
 		return MCPKG_MERKLE_ERR_INVALID;
 
 	/* level 0 */
-	cur = (uint8_t *)malloc(n_leaves * NODE_SZ);
+	cur = (uint8_t *)mcpkg_malloc(n_leaves * NODE_SZ);
 	if (!cur) return MCPKG_MERKLE_ERR_NO_MEMORY;
 	memcpy(cur, leaves, n_leaves * NODE_SZ);
 	cur_n = n_leaves;
 
 	lv_cap = 8;
-	lv = (struct level_buf *)malloc(lv_cap * sizeof(*lv));
+	lv = (struct level_buf *)mcpkg_malloc(lv_cap * sizeof(*lv));
 	if (!lv) {
-		free(cur);
+		mcpkg_free(cur);
 		return MCPKG_MERKLE_ERR_NO_MEMORY;
 	}
 
@@ -83,12 +85,12 @@ static int build_levels(const uint8_t *leaves, size_t n_leaves,
 
 	while (cur_n > 1) {
 		size_t next_n = (cur_n + 1) / 2;
-		uint8_t *next = (uint8_t *)malloc(next_n * NODE_SZ);
+		uint8_t *next = (uint8_t *)mcpkg_malloc(next_n * NODE_SZ);
 		size_t i, j = 0;
 
 		if (!next) {
 			free_levels(lv, lv_cnt);
-			free(lv);
+			mcpkg_free(lv);
 			return MCPKG_MERKLE_ERR_NO_MEMORY;
 		}
 
@@ -104,11 +106,11 @@ static int build_levels(const uint8_t *leaves, size_t n_leaves,
 
 		if (lv_cnt == lv_cap) {
 			size_t nc = lv_cap * 2;
-			void *np = realloc(lv, nc * sizeof(*lv));
+			void *np = mcpkg_realloc(lv, nc * sizeof(*lv));
 			if (!np) {
-				free(next);
+				mcpkg_free(next);
 				free_levels(lv, lv_cnt);
-				free(lv);
+				mcpkg_free(lv);
 				return MCPKG_MERKLE_ERR_NO_MEMORY;
 			}
 			lv = (struct level_buf *)np;
@@ -134,12 +136,12 @@ mcpkg_merkle_b2b32_new(size_t cap_hint)
 {
 	struct McPkgMerkleB2B32 *t;
 
-	t = (struct McPkgMerkleB2B32 *)calloc(1, sizeof(*t));
+	t = (struct McPkgMerkleB2B32 *)mcpkg_calloc(1, sizeof(*t));
 	if (!t) return NULL;
 	if (cap_hint) {
-		t->leaves = (uint8_t *)malloc(cap_hint * NODE_SZ);
+		t->leaves = (uint8_t *)mcpkg_malloc(cap_hint * NODE_SZ);
 		if (!t->leaves) {
-			free(t);
+			mcpkg_free(t);
 			return NULL;
 		}
 		t->cap = cap_hint;
@@ -151,8 +153,8 @@ MCPKG_API void
 mcpkg_merkle_b2b32_free(struct McPkgMerkleB2B32 *t)
 {
 	if (!t) return;
-	free(t->leaves);
-	free(t);
+	mcpkg_free(t->leaves);
+	mcpkg_free(t);
 }
 
 MCPKG_API int
@@ -203,7 +205,7 @@ mcpkg_merkle_b2b32_root(const struct McPkgMerkleB2B32 *t,
 
 	memcpy(out_root32, lv[lv_cnt - 1].data, NODE_SZ);
 	free_levels(lv, lv_cnt);
-	free(lv);
+	mcpkg_free(lv);
 	return MCPKG_MERKLE_NO_ERROR;
 }
 
@@ -257,7 +259,7 @@ mcpkg_merkle_b2b32_audit_path(const struct McPkgMerkleB2B32 *t,
 	ap = mcpkg_mp_ledger_audit_path_new();
 	if (!ap) {
 		free_levels(lv, lv_cnt);
-		free(lv);
+		mcpkg_free(lv);
 		return MCPKG_MERKLE_ERR_NO_MEMORY;
 	}
 
@@ -265,7 +267,7 @@ mcpkg_merkle_b2b32_audit_path(const struct McPkgMerkleB2B32 *t,
 	if (!ap->nodes) {
 		mcpkg_mp_ledger_audit_path_free(ap);
 		free_levels(lv, lv_cnt);
-		free(lv);
+		mcpkg_free(lv);
 		return MCPKG_MERKLE_ERR_NO_MEMORY;
 	}
 
@@ -288,7 +290,7 @@ mcpkg_merkle_b2b32_audit_path(const struct McPkgMerkleB2B32 *t,
 			if (!an) {
 				mcpkg_mp_ledger_audit_path_free(ap);
 				free_levels(lv, lv_cnt);
-				free(lv);
+				mcpkg_free(lv);
 				return MCPKG_MERKLE_ERR_NO_MEMORY;
 			}
 			memcpy(an->sibling, lv[level].data + (sib_i * NODE_SZ), NODE_SZ);
@@ -298,7 +300,7 @@ mcpkg_merkle_b2b32_audit_path(const struct McPkgMerkleB2B32 *t,
 				mcpkg_mp_ledger_audit_node_free(an);
 				mcpkg_mp_ledger_audit_path_free(ap);
 				free_levels(lv, lv_cnt);
-				free(lv);
+				mcpkg_free(lv);
 				return MCPKG_MERKLE_ERR_NO_MEMORY;
 			}
 		}
@@ -307,7 +309,7 @@ mcpkg_merkle_b2b32_audit_path(const struct McPkgMerkleB2B32 *t,
 	}
 
 	free_levels(lv, lv_cnt);
-	free(lv);
+	mcpkg_free(lv);
 
 	*out_path = ap;
 	return MCPKG_MERKLE_NO_ERROR;
@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "container/mcpkg_alloc.h"
+
 #include "crypto/mcpkg_merkle_b2b32.h"
 #include "mcpkg_crypto_hash.h"
 
@@ -23,7 +25,7 @@ struct level_buf {
 static void free_levels(struct level_buf *lv, size_t n)
 {
 	size_t i;
-	for (i = 0; i < n; i++) free(lv[i].data);
+	for (i = 0; i < n; i++) mcpkg_free(lv[i].data);
 }
 
 static void hpair(const uint8_t *l, const uint8_t *r, uint8_t out[NODE_SZ])
@@ -48,15 +50,15 @@ static int build_levels_from_tree(const struct McPkgMerkleB2B32 *t,
 		return MCPKG_MCONS_ERR_INVALID;
 
 	/* level 0 */
-	cur = (uint8_t *)malloc(t->size * NODE_SZ);
+	cur = (uint8_t *)mcpkg_malloc(t->size * NODE_SZ);
 	if (!cur) return MCPKG_MCONS_ERR_NO_MEMORY;
 	memcpy(cur, t->leaves, t->size * NODE_SZ);
 	cur_n = t->size;
 
 	lv_cap = 8;
-	lv = (struct level_buf *)malloc(lv_cap * sizeof(*lv));
+	lv = (struct level_buf *)mcpkg_malloc(lv_cap * sizeof(*lv));
 	if (!lv) {
-		free(cur);
+		mcpkg_free(cur);
 		return MCPKG_MCONS_ERR_NO_MEMORY;
 	}
 
@@ -66,12 +68,12 @@ static int build_levels_from_tree(const struct McPkgMerkleB2B32 *t,
 
 	while (cur_n > 1) {
 		size_t next_n = (cur_n + 1) / 2;
-		uint8_t *next = (uint8_t *)malloc(next_n * NODE_SZ);
+		uint8_t *next = (uint8_t *)mcpkg_malloc(next_n * NODE_SZ);
 		size_t i, j = 0;
 
 		if (!next) {
 			free_levels(lv, lv_cnt);
-			free(lv);
+			mcpkg_free(lv);
 			return MCPKG_MCONS_ERR_NO_MEMORY;
 		}
 
@@ -87,11 +89,11 @@ static int build_levels_from_tree(const struct McPkgMerkleB2B32 *t,
 
 		if (lv_cnt == lv_cap) {
 			size_t nc = lv_cap * 2;
-			void *np = realloc(lv, nc * sizeof(*lv));
+			void *np = mcpkg_realloc(lv, nc * sizeof(*lv));
 			if (!np) {
-				free(next);
+				mcpkg_free(next);
 				free_levels(lv, lv_cnt);
-				free(lv);
+				mcpkg_free(lv);
 				return MCPKG_MCONS_ERR_NO_MEMORY;
 			}
 			lv = (struct level_buf *)np;
@@ -232,7 +234,7 @@ mcpkg_merkle_b2b32_consistency(const struct McPkgMerkleB2B32 *t,
 	cp->nodes = mcpkg_list_new(NODE_SZ, NULL, 0, 0);
 	if (!cp->nodes) {
 		free_levels(lv, lv_cnt);
-		free(lv);
+		mcpkg_free(lv);
 		mcpkg_mp_ledger_consistency_free(cp);
 		return MCPKG_MCONS_ERR_NO_MEMORY;
 	}
@@ -241,14 +243,14 @@ mcpkg_merkle_b2b32_consistency(const struct McPkgMerkleB2B32 *t,
 		rc = append_cover_nodes(lv, lv_cnt, m, n, cp);
 		if (rc != MCPKG_MCONS_NO_ERROR) {
 			free_levels(lv, lv_cnt);
-			free(lv);
+			mcpkg_free(lv);
 			mcpkg_mp_ledger_consistency_free(cp);
 			return rc;
 		}
 	}
 
 	free_levels(lv, lv_cnt);
-	free(lv);
+	mcpkg_free(lv);
 
 	*out_proof = cp;
 	return MCPKG_MCONS_NO_ERROR;
@@ -31,6 +31,7 @@ struct McPkgRepoPage {
 	void                            *att_ctx;
 	mcpkg_signer_cb                 mint_signer;
 	void                            *mint_ctx;
+	struct McPkgMpWriter            wr;             /* reused per manifest */
 };
 
 /* ---- helpers ---- */
@@ -131,6 +132,11 @@ mcpkg_repo_page_begin(struct McPkgMerkleB2B32 *tree,
 	pg->mint_signer = mint_signer;
 	pg->mint_ctx    = mint_ctx;
 
+	if (mcpkg_mp_writer_init(&pg->wr) != MCPKG_MP_NO_ERROR) {
+		free(pg);
+		return MCPKG_RPAGE_ERR_NO_MEMORY;
+	}
+
 	*out_pg = pg;
 	return MCPKG_RPAGE_NO_ERROR;
 }
@@ -141,7 +147,7 @@ mcpkg_repo_page_add(struct McPkgRepoPage *pg,
                     struct McPkgAttestation **out_att,
                     uint64_t *out_leaf_index)
 {
-	void *packed = NULL;
+	const void *packed;
 	size_t packed_len = 0;
 	uint8_t manifest_b2b32[32];
 	uint64_t idx0 = 0;
@@ -151,15 +157,15 @@ mcpkg_repo_page_add(struct McPkgRepoPage *pg,
 	if (!pg || !pg->tree || !meta || !meta->id || !meta->version)
 		return MCPKG_RPAGE_ERR_INVALID;
 
-	rc = mcpkg_mp_pkg_meta_pack(meta, &packed, &packed_len);
+	/* same bytes as mcpkg_manifest_pack, without a buffer per manifest */
+	mcpkg_mp_writer_reset(&pg->wr);
+	rc = mcpkg_mp_pkg_meta_pack_append(meta, &pg->wr);
 	if (rc != MCPKG_MP_NO_ERROR)
 		return MCPKG_RPAGE_ERR_MP;
+	packed = mcpkg_mp_writer_data(&pg->wr, &packed_len);
 
-	if (mcpkg_crypto_blake2b32_buf(packed, packed_len, manifest_b2b32) != 0) {
-		free(packed);
+	if (mcpkg_crypto_blake2b32_buf(packed, packed_len, manifest_b2b32) != 0)
 		return MCPKG_RPAGE_ERR_CRYPTO;
-	}
-	free(packed);
 
 	if (mcpkg_merkle_b2b32_append(pg->tree, manifest_b2b32, &idx0) != 0)
 		return MCPKG_RPAGE_ERR_STATE;
@@ -301,5 +307,6 @@ mcpkg_repo_page_free(struct McPkgRepoPage *pg)
 {
 	if (!pg)
 		return;
+	mcpkg_mp_writer_destroy(&pg->wr);
 	free(pg);
 }
@@ -13,12 +13,11 @@ typedef struct {
 	uint64_t	k1;
 } mcpkg_siphash_key;
 
-/* ---- SipHash-2-4 (inline) ---- */
-
-
+/* ---- SipHash-c-d core (inline; constant rounds fold away) ---- */
 
 static inline uint64_t
-mcpkg_siphash24_k(const void *data, size_t len, uint64_t k0, uint64_t k1)
+mcpkg_siphash_cd_k(const void *data, size_t len, uint64_t k0, uint64_t k1,
+                   int crounds, int drounds)
 {
 	const uint8_t *in = (const uint8_t *)data;
 	uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
@@ -27,6 +26,7 @@ mcpkg_siphash24_k(const void *data, size_t len, uint64_t k0, uint64_t k1)
 	uint64_t v3 = 0x7465646279746573ULL ^ k1;
 	uint64_t m, b;
 	size_t i = 0;
+	int r;
 
 #define SIPROUND() \
     do { \
@@ -47,8 +47,8 @@ mcpkg_siphash24_k(const void *data, size_t len, uint64_t k0, uint64_t k1)
 	for (; i + 8 <= len; i += 8) {
 		m = mcpkg_math_load64_le(in + i);
 		v3 ^= m;
-		SIPROUND() ;
-		SIPROUND() ;
+		for (r = 0; r < crounds; r++)
+			SIPROUND() ;
 		v0 ^= m;
 	}
 
@@ -73,20 +73,34 @@ mcpkg_siphash24_k(const void *data, size_t len, uint64_t k0, uint64_t k1)
 	}
 
 	v3 ^= m;
-	SIPROUND() ;
-	SIPROUND() ;
+	for (r = 0; r < crounds; r++)
+		SIPROUND() ;
 	v0 ^= m;
 
 	v2 ^= 0xff;
-	SIPROUND() ;
-	SIPROUND() ;
-	SIPROUND() ;
-	SIPROUND() ;
+	for (r = 0; r < drounds; r++)
+		SIPROUND() ;
 
 #undef SIPROUND
 	return v0 ^ v1 ^ v2 ^ v3;
 }
 
+/* ---- SipHash-2-4 (inline) ---- */
+
+static inline uint64_t
+mcpkg_siphash24_k(const void *data, size_t len, uint64_t k0, uint64_t k1)
+{
+	return mcpkg_siphash_cd_k(data, len, k0, k1, 2, 4);
+}
+
+/* ---- SipHash-1-3: same keying, fewer rounds (hash tables only) ---- */
+
+static inline uint64_t
+mcpkg_siphash13_k(const void *data, size_t len, uint64_t k0, uint64_t k1)
+{
+	return mcpkg_siphash_cd_k(data, len, k0, k1, 1, 3);
+}
+
 static inline uint64_t
 mcpkg_siphash24(const void *data, size_t len, mcpkg_siphash_key key)
 {
@@ -0,0 +1,87 @@
+#ifndef MCPKG_WY_HASH_H
+#define MCPKG_WY_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "mcpkg_export.h"
+#include "math/mcpkg_math.h"
+MCPKG_BEGIN_DECLS
+
+/*
+ * wyhash (final4 layout): fast seeded 64-bit hash for trusted keys.
+ * NOT collision resistant against chosen input; use SipHash for keys
+ * an attacker controls.
+ */
+
+static inline uint64_t mcpkg_wy_mix(uint64_t a, uint64_t b)
+{
+	uint64_t lo, hi;
+
+	mcpkg_math_mul128_u64(a, b, &lo, &hi);
+	return lo ^ hi;
+}
+
+static inline uint64_t mcpkg_wy_read3(const uint8_t *p, size_t k)
+{
+	return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+static inline uint64_t
+mcpkg_wyhash_k(const void *data, size_t len, uint64_t seed)
+{
+	static const uint64_t s[4] = {
+		0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+		0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+	};
+	const uint8_t *p = (const uint8_t *)data;
+	uint64_t a, b, lo, hi;
+	size_t i;
+
+	seed ^= mcpkg_wy_mix(seed ^ s[0], s[1]);
+	if (len <= 16) {
+		if (len >= 4) {
+			size_t o = (len >> 3) << 2;
+
+			a = ((uint64_t)mcpkg_math_load32_le(p) << 32) |
+			    mcpkg_math_load32_le(p + o);
+			b = ((uint64_t)mcpkg_math_load32_le(p + len - 4) << 32) |
+			    mcpkg_math_load32_le(p + len - 4 - o);
+		} else if (len > 0) {
+			a = mcpkg_wy_read3(p, len);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		i = len;
+		if (i >= 48) {
+			uint64_t see1 = seed, see2 = seed;
+
+			do {
+				seed = mcpkg_wy_mix(mcpkg_math_load64_le(p) ^ s[1],
+				                    mcpkg_math_load64_le(p + 8) ^ seed);
+				see1 = mcpkg_wy_mix(mcpkg_math_load64_le(p + 16) ^ s[2],
+				                    mcpkg_math_load64_le(p + 24) ^ see1);
+				see2 = mcpkg_wy_mix(mcpkg_math_load64_le(p + 32) ^ s[3],
+				                    mcpkg_math_load64_le(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i >= 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = mcpkg_wy_mix(mcpkg_math_load64_le(p) ^ s[1],
+			                    mcpkg_math_load64_le(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = mcpkg_math_load64_le(p + i - 16);
+		b = mcpkg_math_load64_le(p + i - 8);
+	}
+
+	mcpkg_math_mul128_u64(a ^ s[1], b ^ seed, &lo, &hi);
+	return mcpkg_wy_mix(lo ^ s[0] ^ (uint64_t)len, hi ^ s[1]);
+}
+
+MCPKG_END_DECLS
+#endif /* MCPKG_WY_HASH_H */
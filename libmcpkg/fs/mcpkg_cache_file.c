@@ -0,0 +1,1121 @@
+/* libmcpkg/fs/mcpkg_cache_file.c */
+
+#include "fs/mcpkg_cache_file.h"
+#include "fs/mcpkg_fs_file.h"
+#include "fs/mcpkg_fs_zstd.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
+#include "math/mcpkg_math.h"
+#include "mp/mcpkg_mp_util.h"
+#include "mp/mcpkg_mp_pkg_meta.h"
+#include "threads/mcpkg_thread_pool.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#  include <windows.h>
+#endif
+
+#include <zstd.h>
+
+/*
+ * File layout (native endian, footer regions 8-byte aligned):
+ *   cache_hdr | frames | pad | blocks[nblocks] | ids[n_id] |
+ *   slugs[n_slug] | keys | pad | dict
+ * A frame is one zstd-compressed block: its packed records back to
+ * back, against dict when the header names one (version 2; version 1
+ * files have no dict and zeros in its header fields). ids/slugs are
+ * index entries sorted by key bytes (a prefix sorts first, ties in
+ * file order); keys is the string blob they point into.
+ * The header goes in last, so a file with a valid magic is complete.
+ * Every offset is checked before use: a corrupt file fails with
+ * ERR_FORMAT instead of reading out of bounds.
+ */
+
+#define CACHE_MAGIC    "MCPKCAC1"
+#define CACHE_VERSION  2u
+#define CACHE_ENDIAN   0x01020304u
+
+struct cache_hdr {
+	char     magic[8];
+	uint32_t version;
+	uint32_t endian;
+	uint32_t flags;
+	uint32_t pad;
+	uint64_t nrecords;
+	uint64_t nblocks;
+	uint64_t n_id;
+	uint64_t n_slug;
+	uint64_t off_blocks;
+	uint64_t off_ids;
+	uint64_t off_slugs;
+	uint64_t off_keys;
+	uint64_t keys_len;
+	uint64_t total;
+	uint32_t dict_id;    /* 0: plain frames */
+	uint32_t pad2;
+	uint64_t off_dict;
+	uint64_t dict_len;
+	uint64_t reserved[1];
+};
+
+struct cache_block {
+	uint64_t off;        /* frame start */
+	uint32_t clen;
+	uint32_t ulen;
+	uint32_t first;      /* file order of its first record */
+	uint32_t count;
+};
+
+struct cache_ent {
+	uint32_t key_off;    /* into keys */
+	uint32_t key_len;
+	uint32_t block;
+	uint32_t off;        /* record bytes inside the block */
+	uint32_t len;
+	uint32_t rec;        /* file order */
+};
+
+struct McPkgCacheWriter {
+	FILE               *fp;
+	char               *path;
+	char               *tmp;
+	ZSTD_CCtx          *cctx;
+	const McPkgZstdDict *dict;      /* borrowed; embedded on finish */
+	MCPKG_FS_ERROR      err;        /* first failure; sticks */
+	int                 done;
+	size_t              block_records;
+	size_t              nrecords;
+	uint64_t            pos;        /* file offset of the next write */
+
+	unsigned char      *blk;        /* open block, packed records */
+	size_t              blk_len;
+	size_t              blk_cap;
+	size_t              blk_count;
+	unsigned char      *cbuf;       /* frame being written */
+	size_t              cbuf_cap;
+
+	struct cache_block *blocks;
+	size_t              nblocks;
+	size_t              blocks_cap;
+	struct cache_ent   *ids;
+	size_t              n_id;
+	size_t              id_cap;
+	struct cache_ent   *slugs;
+	size_t              n_slug;
+	size_t              slug_cap;
+	char               *keys;
+	size_t              keys_len;
+	size_t              keys_cap;
+};
+
+struct McPkgCacheFile {
+	McPkgFsMap                map;      /* empty when opened on memory */
+	const unsigned char      *base;
+	const struct cache_block *blocks;
+	const struct cache_ent   *ids;
+	const struct cache_ent   *slugs;
+	const char               *keys;
+	size_t                    keys_len;
+	ZSTD_DDict               *ddict;    /* NULL: plain frames */
+	unsigned                  dict_id;
+	size_t                    nblocks;
+	size_t                    n_id;
+	size_t                    n_slug;
+	size_t                    nrecords;
+	size_t                    frames_end;
+};
+
+static inline int key_cmp(const char *a, size_t alen, const char *b,
+                          size_t blen)
+{
+	size_t n = alen < blen ? alen : blen;
+	int c = n ? memcmp(a, b, n) : 0;
+
+	if (c)
+		return c;
+	return (alen > blen) - (alen < blen);
+}
+
+/* ---------- writer ---------- */
+
+/* p with room for need elements of esz bytes (doubling), or NULL */
+static void *grow(void *p, size_t *cap, size_t need, size_t esz)
+{
+	size_t ncap = *cap ? *cap : 16, bytes;
+
+	if (need <= *cap)
+		return p;
+	while (ncap < need) {
+		if (mcpkg_math_mul_overflow_size(ncap, 2, &ncap))
+			return NULL;
+	}
+	if (mcpkg_math_mul_overflow_size(ncap, esz, &bytes))
+		return NULL;
+	p = mcpkg_realloc(p, bytes);
+	if (p)
+		*cap = ncap;
+	return p;
+}
+
+static MCPKG_FS_ERROR put(McPkgCacheWriter *w, const void *p, size_t n)
+{
+	if (n && fwrite(p, 1, n, w->fp) != n)
+		return MCPKG_FS_ERR_IO;
+	w->pos += n;
+	return MCPKG_FS_OK;
+}
+
+static MCPKG_FS_ERROR put_pad8(McPkgCacheWriter *w)
+{
+	static const unsigned char zero[8];
+
+	return put(w, zero, (size_t)(-w->pos & 7u));
+}
+
+MCPKG_FS_ERROR mcpkg_cache_writer_open(const char *path,
+                                       size_t block_records, int level,
+                                       McPkgCacheWriter **out)
+{
+	struct cache_hdr hdr;
+	McPkgCacheWriter *w;
+	size_t plen;
+
+	if (!path || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*out = NULL;
+	if (block_records > UINT32_MAX)
+		return MCPKG_FS_ERR_RANGE;
+
+	w = mcpkg_calloc(1, sizeof(*w));
+	if (!w)
+		return MCPKG_FS_ERR_OOM;
+
+	plen = strlen(path);
+	w->path = mcpkg_strdup(path);
+	w->tmp = mcpkg_malloc(plen + sizeof(".tmp"));
+	w->cctx = ZSTD_createCCtx();
+	if (!w->path || !w->tmp || !w->cctx) {
+		mcpkg_cache_writer_free(w);
+		return MCPKG_FS_ERR_OOM;
+	}
+	memcpy(w->tmp, path, plen);
+	memcpy(w->tmp + plen, ".tmp", sizeof(".tmp"));
+
+	if (level && ZSTD_isError(ZSTD_CCtx_setParameter(w->cctx,
+	                          ZSTD_c_compressionLevel, level))) {
+		mcpkg_cache_writer_free(w);
+		return MCPKG_FS_ERR_RANGE;
+	}
+
+	w->fp = fopen(w->tmp, "wb");
+	if (!w->fp) {
+		mcpkg_cache_writer_free(w);
+		return MCPKG_FS_ERR_IO;
+	}
+
+	/* placeholder; finish rewrites it */
+	memset(&hdr, 0, sizeof(hdr));
+	if (put(w, &hdr, sizeof(hdr)) != MCPKG_FS_OK) {
+		mcpkg_cache_writer_free(w);
+		return MCPKG_FS_ERR_IO;
+	}
+
+	w->block_records = block_records ? block_records
+	                   : MCPKG_CACHE_FILE_BLOCK_RECORDS;
+	*out = w;
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_cache_writer_set_dict(McPkgCacheWriter *w,
+                const McPkgZstdDict *d)
+{
+	if (!w || !d)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	if (w->err)
+		return w->err;
+	if (w->nrecords)
+		return MCPKG_FS_ERR_RANGE;      /* blocks already compressed */
+
+	/* the CDict's level wins over the writer's */
+	if (ZSTD_isError(ZSTD_CCtx_refCDict(w->cctx,
+	                                    mcpkg_fs_zstd_dict_cdict(d))))
+		return MCPKG_FS_ERR_OTHER;
+	w->dict = d;
+	return MCPKG_FS_OK;
+}
+
+static MCPKG_FS_ERROR block_flush(McPkgCacheWriter *w)
+{
+	struct cache_block *bl;
+	size_t bound, clen;
+	void *p;
+
+	if (!w->blk_count)
+		return MCPKG_FS_OK;
+
+	bound = ZSTD_compressBound(w->blk_len);
+	p = grow(w->cbuf, &w->cbuf_cap, bound, 1);
+	if (!p)
+		return MCPKG_FS_ERR_OOM;
+	w->cbuf = p;
+	bl = grow(w->blocks, &w->blocks_cap, w->nblocks + 1, sizeof(*bl));
+	if (!bl)
+		return MCPKG_FS_ERR_OOM;
+	w->blocks = bl;
+
+	clen = ZSTD_compress2(w->cctx, w->cbuf, bound, w->blk, w->blk_len);
+	if (ZSTD_isError(clen) || clen > UINT32_MAX)
+		return MCPKG_FS_ERR_IO;
+
+	bl += w->nblocks;
+	bl->off = w->pos;
+	bl->clen = (uint32_t)clen;
+	bl->ulen = (uint32_t)w->blk_len;
+	bl->first = (uint32_t)(w->nrecords - w->blk_count);
+	bl->count = (uint32_t)w->blk_count;
+	if (put(w, w->cbuf, clen) != MCPKG_FS_OK)
+		return MCPKG_FS_ERR_IO;
+
+	w->nblocks++;
+	w->blk_len = 0;
+	w->blk_count = 0;
+	return MCPKG_FS_OK;
+}
+
+/* room for a len-byte record at the end of the open block */
+static MCPKG_FS_ERROR blk_reserve(McPkgCacheWriter *w, size_t len)
+{
+	void *p;
+
+	if (w->err)
+		return w->err;
+	if (!w->fp)
+		return MCPKG_FS_ERR_IO;
+	if (len > UINT32_MAX - w->blk_len || w->nrecords >= UINT32_MAX)
+		return MCPKG_FS_ERR_OVERFLOW;
+
+	p = grow(w->blk, &w->blk_cap, w->blk_len + len, 1);
+	if (!p)
+		return MCPKG_FS_ERR_OOM;
+	w->blk = p;
+	return MCPKG_FS_OK;
+}
+
+static MCPKG_FS_ERROR index_add(McPkgCacheWriter *w, struct cache_ent **arr,
+                                size_t *n, size_t *cap, const char *key,
+                                size_t klen, const struct cache_ent *loc)
+{
+	struct cache_ent *e;
+	char *k;
+
+	if (klen > UINT32_MAX || w->keys_len > UINT32_MAX - klen)
+		return MCPKG_FS_ERR_OVERFLOW;
+
+	k = grow(w->keys, &w->keys_cap, w->keys_len + klen, 1);
+	if (!k)
+		return MCPKG_FS_ERR_OOM;
+	w->keys = k;
+	e = grow(*arr, cap, *n + 1, sizeof(*e));
+	if (!e)
+		return MCPKG_FS_ERR_OOM;
+	*arr = e;
+
+	if (klen)
+		memcpy(k + w->keys_len, key, klen);
+	e += *n;
+	*e = *loc;
+	e->key_off = (uint32_t)w->keys_len;
+	e->key_len = (uint32_t)klen;
+	w->keys_len += klen;
+	(*n)++;
+	return MCPKG_FS_OK;
+}
+
+/* the len bytes just placed at blk + blk_len become the next record */
+static MCPKG_FS_ERROR record_commit(McPkgCacheWriter *w, size_t len,
+                                    const char *id, size_t id_len,
+                                    const char *slug, size_t slug_len)
+{
+	struct cache_ent loc;
+	MCPKG_FS_ERROR ret = MCPKG_FS_OK;
+
+	memset(&loc, 0, sizeof(loc));
+	loc.block = (uint32_t)w->nblocks;
+	loc.off = (uint32_t)w->blk_len;
+	loc.len = (uint32_t)len;
+	loc.rec = (uint32_t)w->nrecords;
+
+	if (id)
+		ret = index_add(w, &w->ids, &w->n_id, &w->id_cap, id, id_len,
+		                &loc);
+	if (!ret && slug)
+		ret = index_add(w, &w->slugs, &w->n_slug, &w->slug_cap, slug,
+		                slug_len, &loc);
+	if (!ret) {
+		w->blk_len += len;
+		w->blk_count++;
+		w->nrecords++;
+		if (w->blk_count >= w->block_records)
+			ret = block_flush(w);
+	}
+	/* a half-indexed record cannot be undone */
+	if (ret)
+		w->err = ret;
+	return ret;
+}
+
+MCPKG_FS_ERROR mcpkg_cache_writer_add(McPkgCacheWriter *w,
+                                      const struct McPkgCache *p)
+{
+	MCPKG_FS_ERROR ret;
+	size_t len;
+
+	if (!w || !p)
+		return MCPKG_FS_ERR_NULL_PARAM;
+
+	len = mcpkg_mp_pkg_meta_packed_size(p);
+	ret = blk_reserve(w, len);
+	if (ret)
+		return ret;
+	if (mcpkg_mp_pkg_meta_pack_into(p, w->blk + w->blk_len, len, &len))
+		return MCPKG_FS_ERR_FORMAT;
+
+	return record_commit(w, len, p->id, p->id ? strlen(p->id) : 0,
+	                     p->slug, p->slug ? strlen(p->slug) : 0);
+}
+
+MCPKG_FS_ERROR mcpkg_cache_writer_add_packed(McPkgCacheWriter *w,
+                const void *rec, size_t len)
+{
+	struct McPkgCacheView v;
+	MCPKG_FS_ERROR ret;
+
+	if (!w || !rec)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	if (mcpkg_mp_pkg_meta_view(rec, len, &v))
+		return MCPKG_FS_ERR_FORMAT;
+
+	ret = blk_reserve(w, len);
+	if (ret)
+		return ret;
+	memcpy(w->blk + w->blk_len, rec, len);
+
+	return record_commit(w, len, v.id.p, v.id.len, v.slug.p, v.slug.len);
+}
+
+struct sort_ent {
+	const char       *k;
+	struct cache_ent  e;
+};
+
+static int sort_ent_cmp(const void *a, const void *b)
+{
+	const struct sort_ent *x = a, *y = b;
+	int c = key_cmp(x->k, x->e.key_len, y->k, y->e.key_len);
+
+	if (c)
+		return c;
+	return (x->e.rec > y->e.rec) - (x->e.rec < y->e.rec);
+}
+
+/* sort n entries by key and write them */
+static MCPKG_FS_ERROR index_put(McPkgCacheWriter *w, struct cache_ent *arr,
+                                size_t n)
+{
+	struct sort_ent *s;
+	size_t i;
+
+	if (!n)
+		return MCPKG_FS_OK;
+	s = mcpkg_calloc(n, sizeof(*s));
+	if (!s)
+		return MCPKG_FS_ERR_OOM;
+
+	for (i = 0; i < n; i++) {
+		s[i].k = w->keys + arr[i].key_off;
+		s[i].e = arr[i];
+	}
+	qsort(s, n, sizeof(*s), sort_ent_cmp);
+	for (i = 0; i < n; i++)
+		arr[i] = s[i].e;
+	mcpkg_free(s);
+
+	return put(w, arr, n * sizeof(*arr));
+}
+
+static MCPKG_FS_ERROR file_replace(const char *from, const char *to)
+{
+#ifdef _WIN32
+	if (!MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING))
+		return MCPKG_FS_ERR_IO;
+#else
+	if (rename(from, to) != 0)
+		return MCPKG_FS_ERR_IO;
+#endif
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_cache_writer_finish(McPkgCacheWriter *w)
+{
+	struct cache_hdr hdr;
+	MCPKG_FS_ERROR ret;
+	size_t len;
+	FILE *fp;
+
+	if (!w)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	if (w->err)
+		return w->err;
+	if (!w->fp)
+		return MCPKG_FS_ERR_IO;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic));
+	hdr.version = CACHE_VERSION;
+	hdr.endian = CACHE_ENDIAN;
+
+	ret = block_flush(w);
+	if (!ret)
+		ret = put_pad8(w);
+	if (ret)
+		goto fail;
+
+	hdr.off_blocks = w->pos;
+	ret = put(w, w->blocks, w->nblocks * sizeof(*w->blocks));
+	hdr.off_ids = w->pos;
+	if (!ret)
+		ret = index_put(w, w->ids, w->n_id);
+	hdr.off_slugs = w->pos;
+	if (!ret)
+		ret = index_put(w, w->slugs, w->n_slug);
+	hdr.off_keys = w->pos;
+	if (!ret)
+		ret = put(w, w->keys, w->keys_len);
+	if (!ret)
+		ret = put_pad8(w);
+	if (!ret && w->dict) {
+		const void *dict = mcpkg_fs_zstd_dict_data(w->dict, &len);
+
+		hdr.dict_id = mcpkg_fs_zstd_dict_id(w->dict);
+		hdr.off_dict = w->pos;
+		hdr.dict_len = len;
+		ret = put(w, dict, len);
+		if (!ret)
+			ret = put_pad8(w);
+	}
+	if (ret)
+		goto fail;
+
+	hdr.nrecords = w->nrecords;
+	hdr.nblocks = w->nblocks;
+	hdr.n_id = w->n_id;
+	hdr.n_slug = w->n_slug;
+	hdr.keys_len = w->keys_len;
+	hdr.total = w->pos;
+
+	if (fseek(w->fp, 0, SEEK_SET) != 0 ||
+	    fwrite(&hdr, 1, sizeof(hdr), w->fp) != sizeof(hdr)) {
+		ret = MCPKG_FS_ERR_IO;
+		goto fail;
+	}
+
+	fp = w->fp;
+	w->fp = NULL;
+	if (fclose(fp) != 0) {
+		ret = MCPKG_FS_ERR_IO;
+		goto fail;
+	}
+	ret = file_replace(w->tmp, w->path);
+	if (ret)
+		goto fail;
+	w->done = 1;
+	return MCPKG_FS_OK;
+
+fail:
+	w->err = ret;
+	return ret;
+}
+
+void mcpkg_cache_writer_free(McPkgCacheWriter *w)
+{
+	if (!w)
+		return;
+	if (w->fp)
+		fclose(w->fp);
+	if (!w->done && w->tmp)
+		remove(w->tmp);
+
+	ZSTD_freeCCtx(w->cctx);
+	mcpkg_free(w->path);
+	mcpkg_free(w->tmp);
+	mcpkg_free(w->blk);
+	mcpkg_free(w->cbuf);
+	mcpkg_free(w->blocks);
+	mcpkg_free(w->ids);
+	mcpkg_free(w->slugs);
+	mcpkg_free(w->keys);
+	mcpkg_free(w);
+}
+
+/* ---------- reader ---------- */
+
+static int region_ok(uint64_t off, uint64_t size, uint64_t total)
+{
+	return off <= total && size <= total - off && !(off & 7u);
+}
+
+static MCPKG_FS_ERROR cache_open(const void *data, size_t len,
+                                 const McPkgFsMap *map,
+                                 McPkgCacheFile **out)
+{
+	const unsigned char *base = data;
+	struct McPkgCacheFile *cf;
+	struct cache_hdr hdr;
+
+	if (!data || len < sizeof(hdr) || ((uintptr_t)data & 7u))
+		return MCPKG_FS_ERR_FORMAT;
+
+	memcpy(&hdr, data, sizeof(hdr));
+	if (memcmp(hdr.magic, CACHE_MAGIC, sizeof(hdr.magic)) != 0 ||
+	    !hdr.version || hdr.version > CACHE_VERSION ||
+	    hdr.endian != CACHE_ENDIAN ||
+	    hdr.total > len || hdr.nrecords > UINT32_MAX ||
+	    hdr.nblocks > hdr.nrecords || hdr.n_id > hdr.nrecords ||
+	    hdr.n_slug > hdr.nrecords || hdr.keys_len > UINT32_MAX ||
+	    hdr.off_blocks < sizeof(hdr))
+		return MCPKG_FS_ERR_FORMAT;
+
+	/* counts are below 2^32, so the products cannot overflow */
+	if (!region_ok(hdr.off_blocks,
+	               hdr.nblocks * sizeof(struct cache_block), hdr.total) ||
+	    !region_ok(hdr.off_ids, hdr.n_id * sizeof(struct cache_ent),
+	               hdr.total) ||
+	    !region_ok(hdr.off_slugs, hdr.n_slug * sizeof(struct cache_ent),
+	               hdr.total) ||
+	    !region_ok(hdr.off_keys, hdr.keys_len, hdr.total) ||
+	    !region_ok(hdr.off_dict, hdr.dict_len, hdr.total) ||
+	    !hdr.dict_id != !hdr.dict_len)
+		return MCPKG_FS_ERR_FORMAT;
+	/* the embedded dict must be the one the frames were made with */
+	if (hdr.dict_id &&
+	    ZSTD_getDictID_fromDict(base + hdr.off_dict, (size_t)hdr.dict_len)
+	    != hdr.dict_id)
+		return MCPKG_FS_ERR_FORMAT;
+
+	cf = mcpkg_calloc(1, sizeof(*cf));
+	if (!cf)
+		return MCPKG_FS_ERR_OOM;
+
+	if (hdr.dict_id) {
+		cf->ddict = ZSTD_createDDict(base + hdr.off_dict,
+		                             (size_t)hdr.dict_len);
+		if (!cf->ddict) {
+			mcpkg_free(cf);
+			return MCPKG_FS_ERR_OOM;
+		}
+		cf->dict_id = hdr.dict_id;
+	}
+	if (map)
+		cf->map = *map;
+	cf->base = base;
+	cf->blocks = (const struct cache_block *)(const void *)
+	             (base + hdr.off_blocks);
+	cf->ids = (const struct cache_ent *)(const void *)(base + hdr.off_ids);
+	cf->slugs = (const struct cache_ent *)(const void *)
+	            (base + hdr.off_slugs);
+	cf->keys = (const char *)base + hdr.off_keys;
+	cf->keys_len = (size_t)hdr.keys_len;
+	cf->nblocks = (size_t)hdr.nblocks;
+	cf->n_id = (size_t)hdr.n_id;
+	cf->n_slug = (size_t)hdr.n_slug;
+	cf->nrecords = (size_t)hdr.nrecords;
+	cf->frames_end = (size_t)hdr.off_blocks;
+
+	*out = cf;
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_cache_file_open_mem(const void *data, size_t len,
+                McPkgCacheFile **out)
+{
+	if (!data || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*out = NULL;
+	return cache_open(data, len, NULL, out);
+}
+
+MCPKG_FS_ERROR mcpkg_cache_file_open(const char *path, McPkgCacheFile **out)
+{
+	MCPKG_FS_ERROR ret;
+	McPkgFsMap map;
+
+	if (!path || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*out = NULL;
+
+	ret = mcpkg_fs_map_ro(path, &map);
+	if (ret)
+		return ret;
+	ret = cache_open(map.data, map.size, &map, out);
+	if (ret)
+		mcpkg_fs_unmap(&map);
+	return ret;
+}
+
+void mcpkg_cache_file_close(McPkgCacheFile *cf)
+{
+	if (!cf)
+		return;
+	ZSTD_freeDDict(cf->ddict);
+	mcpkg_fs_unmap(&cf->map);
+	mcpkg_free(cf);
+}
+
+size_t mcpkg_cache_file_records(const McPkgCacheFile *cf)
+{
+	return cf ? cf->nrecords : 0;
+}
+
+size_t mcpkg_cache_file_blocks(const McPkgCacheFile *cf)
+{
+	return cf ? cf->nblocks : 0;
+}
+
+unsigned mcpkg_cache_file_dict_id(const McPkgCacheFile *cf)
+{
+	return cf ? cf->dict_id : 0;
+}
+
+/* entry key vs key; an out-of-bounds entry compares as "" */
+static int ent_cmp(const McPkgCacheFile *cf, const struct cache_ent *e,
+                   const char *key, size_t len)
+{
+	if (e->key_off > cf->keys_len ||
+	    e->key_len > cf->keys_len - e->key_off)
+		return key_cmp("", 0, key, len);
+	return key_cmp(cf->keys + e->key_off, e->key_len, key, len);
+}
+
+MCPKG_FS_ERROR mcpkg_cache_file_find(const McPkgCacheFile *cf,
+                                     MCPKG_CACHE_KEY kind, const char *key,
+                                     size_t len, McPkgCacheLoc *out)
+{
+	const struct cache_ent *ents, *e;
+	size_t n, lo = 0, hi, mid;
+
+	if (!cf || !key || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	if (kind == MCPKG_CACHE_KEY_ID) {
+		ents = cf->ids;
+		n = cf->n_id;
+	} else if (kind == MCPKG_CACHE_KEY_SLUG) {
+		ents = cf->slugs;
+		n = cf->n_slug;
+	} else {
+		return MCPKG_FS_ERR_RANGE;
+	}
+
+	/* first entry >= key */
+	hi = n;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (ent_cmp(cf, &ents[mid], key, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == n || ent_cmp(cf, &ents[lo], key, len) != 0)
+		return MCPKG_FS_ERR_NOT_FOUND;
+
+	e = &ents[lo];
+	if (e->block >= cf->nblocks)
+		return MCPKG_FS_ERR_FORMAT;
+	out->block = e->block;
+	out->off = e->off;
+	out->len = e->len;
+	out->rec = e->rec;
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_cache_file_read_block(const McPkgCacheFile *cf,
+                size_t i, McPkgCacheBlock *b)
+{
+	const struct cache_block *bl;
+	ZSTD_DCtx *dc;
+	size_t dec;
+
+	if (!cf || !b)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	if (i >= cf->nblocks)
+		return MCPKG_FS_ERR_RANGE;
+	if (b->owner == cf && b->index == i)
+		return MCPKG_FS_OK;
+
+	bl = &cf->blocks[i];
+	if (bl->off < sizeof(struct cache_hdr) || bl->off > cf->frames_end ||
+	    bl->clen > cf->frames_end - bl->off ||
+	    bl->first > cf->nrecords || bl->count > cf->nrecords - bl->first)
+		return MCPKG_FS_ERR_FORMAT;
+
+	b->owner = NULL;
+	if (b->cap < bl->ulen) {
+		/* nothing to keep: replace rather than realloc */
+		mcpkg_free(b->data);
+		b->data = mcpkg_malloc(bl->ulen);
+		b->cap = b->data ? bl->ulen : 0;
+		if (!b->data)
+			return MCPKG_FS_ERR_OOM;
+	}
+
+	/* scan jobs run on different threads, so each has its own */
+	dc = mcpkg_fs_zstd_dctx();
+	if (!dc)
+		return MCPKG_FS_ERR_OOM;
+	if (cf->ddict)
+		dec = ZSTD_decompress_usingDDict(dc, b->data, bl->ulen,
+		                                 cf->base + bl->off, bl->clen,
+		                                 cf->ddict);
+	else
+		dec = ZSTD_decompressDCtx(dc, b->data, bl->ulen,
+		                          cf->base + bl->off, bl->clen);
+	if (ZSTD_isError(dec) || dec != bl->ulen)
+		return MCPKG_FS_ERR_FORMAT;
+
+	b->len = bl->ulen;
+	b->first = bl->first;
+	b->count = bl->count;
+	b->index = i;
+	b->owner = cf;
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_cache_file_get(const McPkgCacheFile *cf,
+                                    MCPKG_CACHE_KEY kind, const char *key,
+                                    size_t len, McPkgCacheBlock *b,
+                                    const void **rec, size_t *rec_len)
+{
+	McPkgCacheLoc loc;
+	MCPKG_FS_ERROR ret;
+
+	if (!b || !rec || !rec_len)
+		return MCPKG_FS_ERR_NULL_PARAM;
+
+	ret = mcpkg_cache_file_find(cf, kind, key, len, &loc);
+	if (!ret)
+		ret = mcpkg_cache_file_read_block(cf, loc.block, b);
+	if (ret)
+		return ret;
+	if (loc.off > b->len || loc.len > b->len - loc.off)
+		return MCPKG_FS_ERR_FORMAT;
+
+	*rec = b->data + loc.off;
+	*rec_len = loc.len;
+	return MCPKG_FS_OK;
+}
+
+int mcpkg_cache_block_next(const McPkgCacheBlock *b, size_t *pos,
+                           const void **rec, size_t *len)
+{
+	struct McPkgMpCur c;
+	size_t n;
+
+	if (!b || !pos || !b->owner || *pos >= b->len)
+		return 0;
+
+	mcpkg_mp_cur_init(&c, b->data + *pos, b->len - *pos);
+	if (mcpkg_mp_cur_skip(&c))
+		return 0;
+	n = (size_t)(c.p - (b->data + *pos));
+	if (rec)
+		*rec = b->data + *pos;
+	if (len)
+		*len = n;
+	*pos += n;
+	return 1;
+}
+
+void mcpkg_cache_block_free(McPkgCacheBlock *b)
+{
+	if (!b)
+		return;
+	mcpkg_free(b->data);
+	memset(b, 0, sizeof(*b));
+}
+
+/* ---------- whole-file passes ---------- */
+
+struct scan_state {
+	const McPkgCacheFile   *cf;
+	mcpkg_cache_record_fn   fn;
+	void                   *ctx;
+	struct McPkgMutex      *lock;     /* NULL when running inline */
+	struct McPkgCond       *done;
+	size_t                  next;     /* first unclaimed block */
+	unsigned                running;  /* pool jobs not finished */
+	MCPKG_FS_ERROR          err;      /* first failure; stops all */
+};
+
+struct scan_job {
+	struct scan_state *s;
+	unsigned           job;
+};
+
+/* next block to decode, or SIZE_MAX when done or failed */
+static size_t scan_claim(struct scan_state *s, MCPKG_FS_ERROR err)
+{
+	size_t i = SIZE_MAX;
+
+	if (s->lock)
+		mcpkg_mutex_lock(s->lock);
+	if (err && !s->err)
+		s->err = err;
+	if (!s->err && s->next < s->cf->nblocks)
+		i = s->next++;
+	if (s->lock)
+		mcpkg_mutex_unlock(s->lock);
+	return i;
+}
+
+static void scan_run(struct scan_state *s, unsigned job)
+{
+	MCPKG_FS_ERROR ret = MCPKG_FS_OK;
+	McPkgCacheBlock b;
+	const void *rec;
+	size_t i, k, pos, len;
+
+	memset(&b, 0, sizeof(b));
+	while ((i = scan_claim(s, ret)) != SIZE_MAX) {
+		ret = mcpkg_cache_file_read_block(s->cf, i, &b);
+		pos = 0;
+		for (k = 0; !ret && mcpkg_cache_block_next(&b, &pos, &rec,
+		                &len); k++)
+			ret = s->fn(s->ctx, job, b.first + k, rec, len);
+		if (!ret && (pos != b.len || k != b.count))
+			ret = MCPKG_FS_ERR_FORMAT;
+	}
+	mcpkg_cache_block_free(&b);
+}
+
+static int scan_task(void *arg)
+{
+	struct scan_job *j = arg;
+	struct scan_state *s = j->s;
+
+	scan_run(s, j->job);
+
+	mcpkg_mutex_lock(s->lock);
+	if (--s->running == 0)
+		mcpkg_cond_broadcast(s->done);
+	mcpkg_mutex_unlock(s->lock);
+	return 0;
+}
+
+MCPKG_FS_ERROR mcpkg_cache_file_scan(const McPkgCacheFile *cf,
+                                     struct McPkgThreadPool *pool,
+                                     unsigned jobs,
+                                     mcpkg_cache_record_fn fn, void *ctx)
+{
+	struct scan_job *jv = NULL;
+	struct scan_state s;
+	unsigned j;
+
+	if (!cf || !fn)
+		return MCPKG_FS_ERR_NULL_PARAM;
+
+	memset(&s, 0, sizeof(s));
+	s.cf = cf;
+	s.fn = fn;
+	s.ctx = ctx;
+	if (!pool || !jobs)
+		jobs = 1;
+	if (jobs > cf->nblocks && cf->nblocks)
+		jobs = (unsigned)cf->nblocks;
+
+	if (jobs > 1) {
+		jv = mcpkg_calloc(jobs, sizeof(*jv));
+		s.lock = mcpkg_mutex_new();
+		s.done = mcpkg_cond_new();
+		if (!jv || !s.lock || !s.done) {
+			/* fall back to one inline job */
+			jobs = 1;
+			mcpkg_free(jv);
+			jv = NULL;
+			if (s.lock)
+				mcpkg_mutex_free(s.lock);
+			if (s.done)
+				mcpkg_cond_free(s.done);
+			s.lock = NULL;
+			s.done = NULL;
+		}
+	}
+
+	/* jobs 1.. on the pool; a refused submit just means fewer jobs */
+	for (j = 1; j < jobs; j++) {
+		jv[j].s = &s;
+		jv[j].job = j;
+		mcpkg_mutex_lock(s.lock);
+		s.running++;
+		mcpkg_mutex_unlock(s.lock);
+		if (mcpkg_thread_pool_submit(pool, scan_task, &jv[j]) !=
+		    MCPKG_THREAD_NO_ERROR) {
+			mcpkg_mutex_lock(s.lock);
+			s.running--;
+			mcpkg_mutex_unlock(s.lock);
+			break;
+		}
+	}
+
+	scan_run(&s, 0);
+
+	if (s.lock) {
+		mcpkg_mutex_lock(s.lock);
+		while (s.running)
+			mcpkg_cond_wait(s.done, s.lock);
+		mcpkg_mutex_unlock(s.lock);
+		mcpkg_cond_free(s.done);
+		mcpkg_mutex_free(s.lock);
+	}
+	mcpkg_free(jv);
+	return s.err;
+}
+
+static MCPKG_FS_ERROR load_rec(void *ctx, unsigned job, size_t rec,
+                               const void *buf, size_t len)
+{
+	McPkgCacheLoad *ld = ctx;
+	int ret;
+
+	if (rec >= ld->n || job >= ld->narenas)
+		return MCPKG_FS_ERR_FORMAT;
+	ret = mcpkg_mp_pkg_meta_unpack_arena(buf, len, ld->arenas[job],
+	                                     &ld->recs[rec]);
+	if (ret == MCPKG_MP_ERR_NO_MEMORY)
+		return MCPKG_FS_ERR_OOM;
+	return ret ? MCPKG_FS_ERR_FORMAT : MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_cache_file_load(const McPkgCacheFile *cf,
+                                     struct McPkgThreadPool *pool,
+                                     unsigned jobs, McPkgCacheLoad *out)
+{
+	MCPKG_FS_ERROR ret;
+	size_t i;
+
+	if (!out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	memset(out, 0, sizeof(*out));
+	if (!cf)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	if (!pool || !jobs)
+		jobs = 1;
+	if (jobs > cf->nblocks && cf->nblocks)
+		jobs = (unsigned)cf->nblocks;
+
+	out->n = cf->nrecords;
+	out->recs = mcpkg_calloc(out->n ? out->n : 1, sizeof(*out->recs));
+	out->arenas = mcpkg_calloc(jobs, sizeof(*out->arenas));
+	if (!out->recs || !out->arenas) {
+		mcpkg_cache_load_free(out);
+		return MCPKG_FS_ERR_OOM;
+	}
+	out->narenas = jobs;
+	for (i = 0; i < jobs; i++) {
+		out->arenas[i] = mcpkg_arena_new(0, 0);
+		if (!out->arenas[i]) {
+			mcpkg_cache_load_free(out);
+			return MCPKG_FS_ERR_OOM;
+		}
+	}
+
+	ret = mcpkg_cache_file_scan(cf, pool, jobs, load_rec, out);
+	/* block counts that disagree with the header leave holes */
+	for (i = 0; !ret && i < out->n; i++) {
+		if (!out->recs[i])
+			ret = MCPKG_FS_ERR_FORMAT;
+	}
+	if (ret)
+		mcpkg_cache_load_free(out);
+	return ret;
+}
+
+void mcpkg_cache_load_free(McPkgCacheLoad *ld)
+{
+	size_t i;
+
+	if (!ld)
+		return;
+	for (i = 0; ld->arenas && i < ld->narenas; i++)
+		mcpkg_arena_free(ld->arenas[i]);
+	mcpkg_free(ld->arenas);
+	mcpkg_free(ld->recs);
+	memset(ld, 0, sizeof(*ld));
+}
+
+/* ---------- dictionary ---------- */
+
+/* zstd's rule of thumb: ~100x the dictionary size in samples */
+#define CACHE_DICT_SAMPLE_X  100u
+
+MCPKG_FS_ERROR mcpkg_cache_file_train_dict(const McPkgCacheFile *cf,
+                size_t dict_cap, int level, McPkgZstdDict **out)
+{
+	unsigned char *smp = NULL;
+	size_t *sizes = NULL, n = 0, sizes_cap = 0, smp_len = 0, smp_cap = 0;
+	size_t i, total = 0, budget, stride, pos, len, dlen;
+	McPkgCacheBlock b;
+	MCPKG_FS_ERROR ret = MCPKG_FS_OK;
+	const void *rec;
+	void *dict = NULL, *p;
+
+	if (!cf || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*out = NULL;
+	if (!dict_cap)
+		dict_cap = MCPKG_FS_ZSTD_DICT_CAP;
+	if (mcpkg_math_mul_overflow_size(dict_cap, CACHE_DICT_SAMPLE_X,
+	                                 &budget))
+		budget = SIZE_MAX;
+
+	/* whole blocks spread evenly over the file, up to the budget */
+	for (i = 0; i < cf->nblocks; i++)
+		total += cf->blocks[i].ulen;
+	stride = total > budget ? (total + budget - 1) / budget : 1;
+
+	memset(&b, 0, sizeof(b));
+	for (i = 0; !ret && i < cf->nblocks && smp_len < budget; i += stride) {
+		ret = mcpkg_cache_file_read_block(cf, i, &b);
+		pos = 0;
+		while (!ret && mcpkg_cache_block_next(&b, &pos, &rec, &len)) {
+			p = grow(smp, &smp_cap, smp_len + len, 1);
+			if (p)
+				smp = p;
+			p = p ? grow(sizes, &sizes_cap, n + 1, sizeof(*sizes))
+			    : NULL;
+			if (!p) {
+				ret = MCPKG_FS_ERR_OOM;
+				break;
+			}
+			sizes = p;
+			memcpy(smp + smp_len, rec, len);
+			smp_len += len;
+			sizes[n++] = len;
+		}
+	}
+	mcpkg_cache_block_free(&b);
+
+	if (!ret)
+		ret = n ? mcpkg_fs_zstd_dict_train(smp, sizes, n, dict_cap,
+		                                   &dict, &dlen)
+		      : MCPKG_FS_ERR_RANGE;
+	if (!ret)
+		ret = mcpkg_fs_zstd_dict_new(dict, dlen, level, out);
+
+	mcpkg_free(dict);
+	mcpkg_free(sizes);
+	mcpkg_free(smp);
+	return ret;
+}
@@ -0,0 +1,189 @@
+#ifndef MCPKG_CACHE_FILE_H
+#define MCPKG_CACHE_FILE_H
+
+#include <stddef.h>
+#include "mcpkg_export.h"
+#include "fs/mcpkg_fs_error.h"
+#include "fs/mcpkg_fs_file.h"
+
+MCPKG_BEGIN_DECLS
+
+/*
+ * Indexed package cache: pkg.meta records in zstd blocks with a sorted
+ * id/slug index, opened straight from a read-only mapping.
+ * - A lookup binary-searches the index and decompresses one block.
+ * - Blocks are independent frames, so a full scan can split them
+ *   between threads (each with its own McPkgCacheBlock).
+ * - The writer builds "<path>.tmp" and renames it over path on finish,
+ *   so readers never see a half-written file or lose their mapping.
+ * - Native byte order (as frozen hashes); foreign images are rejected.
+ * - With a trained zstd dictionary, blocks of a few records (down to
+ *   one) keep a good ratio; the dictionary travels inside the file.
+ */
+
+typedef struct McPkgCacheWriter McPkgCacheWriter;
+typedef struct McPkgCacheFile McPkgCacheFile;
+
+struct McPkgCache;
+struct McPkgArena;
+struct McPkgThreadPool;
+
+/* records per block when the writer is given 0 */
+#define MCPKG_CACHE_FILE_BLOCK_RECORDS  128u
+
+typedef enum {
+	MCPKG_CACHE_KEY_ID = 0,
+	MCPKG_CACHE_KEY_SLUG,
+} MCPKG_CACHE_KEY;
+
+/* Where a record lives: block, byte range inside it, file order. */
+typedef struct {
+	size_t block;
+	size_t off;
+	size_t len;
+	size_t rec;
+} McPkgCacheLoc;
+
+/*
+ * One decompressed block. Zero it before first use; the buffer is
+ * reused by later reads and released by mcpkg_cache_block_free. Free
+ * (or re-zero) it before reading from a file opened after its owner
+ * was closed.
+ */
+typedef struct {
+	unsigned char        *data;
+	size_t                len;
+	size_t                cap;
+	size_t                first;  /* file order of its first record */
+	size_t                count;
+	size_t                index;  /* block number */
+	const McPkgCacheFile *owner;  /* NULL until a read succeeds */
+} McPkgCacheBlock;
+
+/* ---------- writer ---------- */
+
+/*
+ * Start a cache at path. block_records 0 = default; level is the zstd
+ * level (0 = zstd default).
+ */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_writer_open(const char *path,
+                size_t block_records, int level,
+                McPkgCacheWriter **out);
+
+/*
+ * Compress every block against d; call before the first add. The
+ * dictionary is embedded in the file and its id put in the header, so
+ * readers need nothing else. d's level replaces the writer's, and d
+ * must stay alive until finish.
+ */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_writer_set_dict(McPkgCacheWriter *w,
+                const McPkgZstdDict *d);
+
+/* Append one record (file order = call order). */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_writer_add(McPkgCacheWriter *w,
+                const struct McPkgCache *p);
+
+/* Same for a record already packed by mcpkg_mp_pkg_meta_pack*. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_writer_add_packed(McPkgCacheWriter *w,
+                const void *rec, size_t len);
+
+/* Flush, write the index and move the file into place. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_writer_finish(McPkgCacheWriter *w);
+
+/* Free the writer; without a successful finish the file is discarded. */
+MCPKG_API void mcpkg_cache_writer_free(McPkgCacheWriter *w);
+
+/* ---------- reader ---------- */
+
+/* Map path read-only; checks the header and region bounds only. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_file_open(const char *path,
+                McPkgCacheFile **out);
+
+/* Same over caller memory (8-byte aligned), which must outlive cf. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_file_open_mem(const void *data,
+                size_t len, McPkgCacheFile **out);
+
+MCPKG_API void mcpkg_cache_file_close(McPkgCacheFile *cf);
+
+MCPKG_API size_t mcpkg_cache_file_records(const McPkgCacheFile *cf);
+MCPKG_API size_t mcpkg_cache_file_blocks(const McPkgCacheFile *cf);
+
+/* Id of the embedded dictionary, 0 if the blocks are plain frames. */
+MCPKG_API unsigned mcpkg_cache_file_dict_id(const McPkgCacheFile *cf);
+
+/*
+ * Train a dictionary on records sampled evenly from cf (about 100x
+ * dict_cap bytes; 0 = MCPKG_FS_ZSTD_DICT_CAP), ready for the next
+ * writer. ERR_RANGE if cf is too small to train on.
+ */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_file_train_dict(const McPkgCacheFile *cf,
+                size_t dict_cap, int level, McPkgZstdDict **out);
+
+/* Index lookup only; ERR_NOT_FOUND if no record has that key. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_file_find(const McPkgCacheFile *cf,
+                MCPKG_CACHE_KEY kind, const char *key, size_t len,
+                McPkgCacheLoc *out);
+
+/* Decompress block i into b (kept as is if b already holds it). */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_file_read_block(const McPkgCacheFile *cf,
+                size_t i, McPkgCacheBlock *b);
+
+/*
+ * find + read_block: *rec points into b (valid until b is reused) and
+ * decodes with mcpkg_mp_pkg_meta_view/unpack.
+ */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_file_get(const McPkgCacheFile *cf,
+                MCPKG_CACHE_KEY kind, const char *key, size_t len,
+                McPkgCacheBlock *b, const void **rec, size_t *rec_len);
+
+/*
+ * Records of a block in file order:
+ *   size_t pos = 0;
+ *   while (mcpkg_cache_block_next(b, &pos, &rec, &len)) { ... }
+ * Stops early (0) on a malformed record.
+ */
+MCPKG_API int mcpkg_cache_block_next(const McPkgCacheBlock *b, size_t *pos,
+                                     const void **rec, size_t *len);
+
+MCPKG_API void mcpkg_cache_block_free(McPkgCacheBlock *b);
+
+/* ---------- whole-file passes ---------- */
+
+/*
+ * Scan callback: rec is the record's file order, job the task running
+ * it (0 .. jobs-1). Calls for one block come in order from one job;
+ * different blocks run concurrently. Anything but OK stops the scan.
+ */
+typedef MCPKG_FS_ERROR (*mcpkg_cache_record_fn)(void *ctx, unsigned job,
+                size_t rec, const void *buf, size_t len);
+
+/*
+ * Visit every record with up to jobs tasks: jobs-1 go to pool, the
+ * caller runs one itself (pool NULL or jobs <= 1: all inline). Tasks
+ * claim whole blocks until none are left. Returns the first error.
+ */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_file_scan(const McPkgCacheFile *cf,
+                struct McPkgThreadPool *pool, unsigned jobs,
+                mcpkg_cache_record_fn fn, void *ctx);
+
+/*
+ * Every record decoded, recs[i] being record i in file order whatever
+ * the job count. Records live in one arena per job (jobs never share
+ * an allocator); mcpkg_cache_load_free releases all of it.
+ */
+typedef struct {
+	struct McPkgCache  **recs;
+	size_t               n;
+	struct McPkgArena  **arenas;
+	size_t               narenas;
+} McPkgCacheLoad;
+
+/* Decode everything via mcpkg_cache_file_scan; nothing kept on error. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_cache_file_load(const McPkgCacheFile *cf,
+                struct McPkgThreadPool *pool, unsigned jobs,
+                McPkgCacheLoad *out);
+
+MCPKG_API void mcpkg_cache_load_free(McPkgCacheLoad *ld);
+
+MCPKG_END_DECLS
+#endif /* MCPKG_CACHE_FILE_H */
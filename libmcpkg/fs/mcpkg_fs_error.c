@@ -27,6 +27,8 @@ const char *mcpkg_fs_strerror(MCPKG_FS_ERROR e)
 			return "unsupported";
 		case MCPKG_FS_ERR_OTHER:
 			return "other";
+		case MCPKG_FS_ERR_FORMAT:
+			return "malformed file";
 	}
 	return "unknown";
 }
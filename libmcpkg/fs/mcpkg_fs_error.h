@@ -17,7 +17,8 @@ typedef enum {
 	MCPKG_FS_ERR_OVERFLOW,
 	MCPKG_FS_ERR_OOM,
 	MCPKG_FS_ERR_UNSUPPORTED,
-	MCPKG_FS_ERR_OTHER
+	MCPKG_FS_ERR_OTHER,
+	MCPKG_FS_ERR_FORMAT
 } MCPKG_FS_ERROR;
 
 /* optional helper */
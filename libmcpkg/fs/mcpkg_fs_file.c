@@ -2,8 +2,11 @@
 
 #include "fs/mcpkg_fs_file.h"
 #include "fs/mcpkg_fs_util.h"
+#include "fs/mcpkg_fs_zstd.h"
+#include "container/mcpkg_alloc.h"
 
 #include <stdint.h>
+#include <limits.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,9 +23,11 @@
 #  include <stdio.h>
 #  include <sys/stat.h>
 #  include <sys/types.h>
+#  include <sys/mman.h>
 #endif
 
 #include <zstd.h>
+#include <zdict.h>
 
 /* ---------- touch ---------- */
 
@@ -314,11 +319,110 @@ MCPKG_FS_ERROR mcpkg_fs_write_all(const char *path,
 #endif
 }
 
+/* ---------- read-only mapping ---------- */
+
+MCPKG_FS_ERROR mcpkg_fs_map_ro(const char *path, McPkgFsMap *out)
+{
+#ifdef _WIN32
+	LARGE_INTEGER sz;
+	HANDLE f, fm;
+	void *p;
+
+	if (!path || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	out->data = NULL;
+	out->size = 0;
+
+	f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+	                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (f == INVALID_HANDLE_VALUE)
+		return (GetLastError() == ERROR_FILE_NOT_FOUND)
+		       ? MCPKG_FS_ERR_NOT_FOUND : MCPKG_FS_ERR_IO;
+	if (!GetFileSizeEx(f, &sz)) {
+		CloseHandle(f);
+		return MCPKG_FS_ERR_IO;
+	}
+	if ((unsigned long long)sz.QuadPart > (unsigned long long)SIZE_MAX) {
+		CloseHandle(f);
+		return MCPKG_FS_ERR_OVERFLOW;
+	}
+	if (sz.QuadPart == 0) {
+		CloseHandle(f);
+		return MCPKG_FS_OK;
+	}
+
+	/* the view keeps the section alive; both handles can go */
+	fm = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(f);
+	if (!fm)
+		return MCPKG_FS_ERR_IO;
+	p = MapViewOfFile(fm, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(fm);
+	if (!p)
+		return MCPKG_FS_ERR_IO;
+
+	out->data = p;
+	out->size = (size_t)sz.QuadPart;
+	return MCPKG_FS_OK;
+#else
+	struct stat st;
+	void *p;
+	int fd;
+
+	if (!path || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	out->data = NULL;
+	out->size = 0;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return (errno == ENOENT) ? MCPKG_FS_ERR_NOT_FOUND
+		       : MCPKG_FS_ERR_IO;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return MCPKG_FS_ERR_IO;
+	}
+	if ((unsigned long long)st.st_size > (unsigned long long)SIZE_MAX) {
+		close(fd);
+		return MCPKG_FS_ERR_OVERFLOW;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return MCPKG_FS_OK;
+	}
+
+	p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return MCPKG_FS_ERR_IO;
+
+	out->data = p;
+	out->size = (size_t)st.st_size;
+	return MCPKG_FS_OK;
+#endif
+}
+
+void mcpkg_fs_unmap(McPkgFsMap *map)
+{
+	if (!map || !map->data)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(map->data);
+#else
+	munmap((void *)map->data, map->size);
+#endif
+	map->data = NULL;
+	map->size = 0;
+}
+
 /* ---------- write zstd ---------- */
 
-MCPKG_FS_ERROR mcpkg_fs_write_zstd(const char *path, const void *data,
-                                   size_t size, int level)
+/* cd NULL: plain frame at level */
+static MCPKG_FS_ERROR zstd_write(const char *path, const void *data,
+                                 size_t size, int level,
+                                 const ZSTD_CDict *cd)
 {
+	ZSTD_CCtx *cc;
 	FILE *fp;
 	size_t bound, wr;
 	void *cbuf;
@@ -326,27 +430,33 @@ MCPKG_FS_ERROR mcpkg_fs_write_zstd(const char *path, const void *data,
 
 	if (!path || (!data && size))
 		return MCPKG_FS_ERR_NULL_PARAM;
+	cc = mcpkg_fs_zstd_cctx();
+	if (!cc)
+		return MCPKG_FS_ERR_OOM;
 
 	fp = fopen(path, "wb");
 	if (!fp)
 		return MCPKG_FS_ERR_IO;
 
 	bound = ZSTD_compressBound(size);
-	cbuf = malloc(bound);
+	cbuf = mcpkg_malloc(bound);
 	if (!cbuf) {
 		fclose(fp);
 		return MCPKG_FS_ERR_OOM;
 	}
 
-	clen = ZSTD_compress(cbuf, bound, data, size, level);
+	if (cd)
+		clen = ZSTD_compress_usingCDict(cc, cbuf, bound, data, size, cd);
+	else
+		clen = ZSTD_compressCCtx(cc, cbuf, bound, data, size, level);
 	if (ZSTD_isError(clen)) {
-		free(cbuf);
+		mcpkg_free(cbuf);
 		fclose(fp);
 		return MCPKG_FS_ERR_IO;
 	}
 
 	wr = fwrite(cbuf, 1, clen, fp);
-	free(cbuf);
+	mcpkg_free(cbuf);
 	if (wr != clen) {
 		fclose(fp);
 		return MCPKG_FS_ERR_IO;
@@ -358,6 +468,12 @@ MCPKG_FS_ERROR mcpkg_fs_write_zstd(const char *path, const void *data,
 	return MCPKG_FS_OK;
 }
 
+MCPKG_FS_ERROR mcpkg_fs_write_zstd(const char *path, const void *data,
+                                   size_t size, int level)
+{
+	return zstd_write(path, data, size, level, NULL);
+}
+
 /* ---------- read zstd ---------- */
 
 static MCPKG_FS_ERROR read_entire_file(const char *path,
@@ -367,8 +483,9 @@ static MCPKG_FS_ERROR read_entire_file(const char *path,
 	return mcpkg_fs_read_all(path, buf_out, size_out);
 }
 
-MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
-                                  unsigned char **buf_out, size_t *size_out)
+/* dd NULL: frames without a dictionary only */
+static MCPKG_FS_ERROR zstd_read(const char *path, const ZSTD_DDict *dd,
+                                unsigned char **buf_out, size_t *size_out)
 {
 	unsigned char *cbuf = NULL;
 	size_t csize = 0;
@@ -376,6 +493,7 @@ MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
 	unsigned char *obuf = NULL;
 	size_t osize;
 	size_t dec;
+	ZSTD_DCtx *dc;
 	MCPKG_FS_ERROR er;
 
 	if (!path || !buf_out || !size_out)
@@ -388,6 +506,13 @@ MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
 	if (er != MCPKG_FS_OK)
 		return er;
 
+	/* this thread's context, already reset; nothing to free */
+	dc = mcpkg_fs_zstd_dctx();
+	if (!dc) {
+		free(cbuf);
+		return MCPKG_FS_ERR_OOM;
+	}
+
 	fsize = ZSTD_getFrameContentSize(cbuf, csize);
 	if (fsize == ZSTD_CONTENTSIZE_ERROR) {
 		free(cbuf);
@@ -405,7 +530,11 @@ MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
 			free(cbuf);
 			return MCPKG_FS_ERR_OOM;
 		}
-		dec = ZSTD_decompress(obuf, osize, cbuf, csize);
+		if (dd)
+			dec = ZSTD_decompress_usingDDict(dc, obuf, osize, cbuf,
+			                                 csize, dd);
+		else
+			dec = ZSTD_decompressDCtx(dc, obuf, osize, cbuf, csize);
 		free(cbuf);
 		if (ZSTD_isError(dec) || dec != osize) {
 			free(obuf);
@@ -418,26 +547,20 @@ MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
 
 	/* unknown output size: stream + grow */
 	{
-		ZSTD_DStream *ds = ZSTD_createDStream();
 		ZSTD_inBuffer inb;
 		ZSTD_outBuffer outb;
 		size_t cap = 64 * 1024;
-		size_t ret;
+		size_t ret = 0;
 
-		if (!ds) {
-			free(cbuf);
-			return MCPKG_FS_ERR_OOM;
-		}
-		ret = ZSTD_initDStream(ds);
+		if (dd)
+			ret = ZSTD_DCtx_refDDict(dc, dd);
 		if (ZSTD_isError(ret)) {
-			ZSTD_freeDStream(ds);
 			free(cbuf);
 			return MCPKG_FS_ERR_IO;
 		}
 
 		obuf = (unsigned char *)malloc(cap);
 		if (!obuf) {
-			ZSTD_freeDStream(ds);
 			free(cbuf);
 			return MCPKG_FS_ERR_OOM;
 		}
@@ -449,10 +572,9 @@ MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
 		outb.pos = 0;
 
 		while (inb.pos < inb.size) {
-			ret = ZSTD_decompressStream(ds, &outb, &inb);
+			ret = ZSTD_decompressStream(dc, &outb, &inb);
 			if (ZSTD_isError(ret)) {
 				free(obuf);
-				ZSTD_freeDStream(ds);
 				free(cbuf);
 				return MCPKG_FS_ERR_IO;
 			}
@@ -462,7 +584,6 @@ MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
 				        (unsigned char *)realloc(obuf, new_cap);
 				if (!nb) {
 					free(obuf);
-					ZSTD_freeDStream(ds);
 					free(cbuf);
 					return MCPKG_FS_ERR_OOM;
 				}
@@ -474,7 +595,6 @@ MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
 			}
 		}
 
-		ZSTD_freeDStream(ds);
 		free(cbuf);
 
 		*buf_out = obuf;
@@ -483,6 +603,139 @@ MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
 	}
 }
 
+MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
+                                  unsigned char **buf_out, size_t *size_out)
+{
+	return zstd_read(path, NULL, buf_out, size_out);
+}
+
+/* ---------- zstd dictionaries ---------- */
+
+struct McPkgZstdDict {
+	void       *buf;
+	size_t      len;
+	unsigned    id;
+	ZSTD_CDict *cdict;
+	ZSTD_DDict *ddict;
+};
+
+MCPKG_FS_ERROR mcpkg_fs_zstd_dict_train(const void *samples,
+                                        const size_t *sizes, size_t n,
+                                        size_t dict_cap, void **dict_out,
+                                        size_t *dict_len)
+{
+	void *buf;
+	size_t len;
+
+	if (!samples || !sizes || !dict_out || !dict_len)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*dict_out = NULL;
+	*dict_len = 0;
+	if (!dict_cap)
+		dict_cap = MCPKG_FS_ZSTD_DICT_CAP;
+	if (!n || n > UINT_MAX)
+		return MCPKG_FS_ERR_RANGE;
+
+	buf = mcpkg_malloc(dict_cap);
+	if (!buf)
+		return MCPKG_FS_ERR_OOM;
+	len = ZDICT_trainFromBuffer(buf, dict_cap, samples, sizes,
+	                            (unsigned)n);
+	if (ZDICT_isError(len)) {
+		mcpkg_free(buf);
+		return MCPKG_FS_ERR_RANGE;
+	}
+
+	*dict_out = buf;
+	*dict_len = len;
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_fs_zstd_dict_new(const void *buf, size_t len, int level,
+                                      McPkgZstdDict **out)
+{
+	McPkgZstdDict *d;
+	unsigned id;
+
+	if (!buf || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*out = NULL;
+	id = ZSTD_getDictID_fromDict(buf, len);
+	if (!id)
+		return MCPKG_FS_ERR_FORMAT;
+
+	d = mcpkg_calloc(1, sizeof(*d));
+	if (!d)
+		return MCPKG_FS_ERR_OOM;
+	d->buf = mcpkg_malloc(len);
+	if (!d->buf) {
+		mcpkg_free(d);
+		return MCPKG_FS_ERR_OOM;
+	}
+	memcpy(d->buf, buf, len);
+	d->len = len;
+	d->id = id;
+	d->cdict = ZSTD_createCDict(d->buf, len, level);
+	d->ddict = ZSTD_createDDict(d->buf, len);
+	if (!d->cdict || !d->ddict) {
+		mcpkg_fs_zstd_dict_free(d);
+		return MCPKG_FS_ERR_FORMAT;
+	}
+
+	*out = d;
+	return MCPKG_FS_OK;
+}
+
+void mcpkg_fs_zstd_dict_free(McPkgZstdDict *d)
+{
+	if (!d)
+		return;
+	ZSTD_freeCDict(d->cdict);
+	ZSTD_freeDDict(d->ddict);
+	mcpkg_free(d->buf);
+	mcpkg_free(d);
+}
+
+unsigned mcpkg_fs_zstd_dict_id(const McPkgZstdDict *d)
+{
+	return d ? d->id : 0;
+}
+
+const void *mcpkg_fs_zstd_dict_data(const McPkgZstdDict *d, size_t *len)
+{
+	if (len)
+		*len = d ? d->len : 0;
+	return d ? d->buf : NULL;
+}
+
+const ZSTD_CDict *mcpkg_fs_zstd_dict_cdict(const McPkgZstdDict *d)
+{
+	return d ? d->cdict : NULL;
+}
+
+const ZSTD_DDict *mcpkg_fs_zstd_dict_ddict(const McPkgZstdDict *d)
+{
+	return d ? d->ddict : NULL;
+}
+
+MCPKG_FS_ERROR mcpkg_fs_write_zstd_dict(const char *path, const void *data,
+                                        size_t size, const McPkgZstdDict *d)
+{
+	if (!d)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	return zstd_write(path, data, size, 0, d->cdict);
+}
+
+MCPKG_FS_ERROR mcpkg_fs_read_zstd_dict(const char *path,
+                                       const McPkgZstdDict *d,
+                                       unsigned char **buf_out,
+                                       size_t *size_out)
+{
+	if (!d)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	return zstd_read(path, d->ddict, buf_out, size_out);
+}
+
 /* ---------- read link target ---------- */
 
 MCPKG_FS_ERROR mcpkg_fs_link_target(const char *link_path,
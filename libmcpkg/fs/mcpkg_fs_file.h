@@ -28,6 +28,19 @@ MCPKG_API MCPKG_FS_ERROR mcpkg_fs_write_all(const char *path,
                 const void *data, size_t size,
                 int overwrite);
 
+/*
+ * Map a whole file read-only (mmap / MapViewOfFile). data stays valid
+ * until mcpkg_fs_unmap; an empty file maps to data=NULL, size=0.
+ */
+typedef struct {
+	const void *data;
+	size_t      size;
+} McPkgFsMap;
+
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_map_ro(const char *path, McPkgFsMap *out);
+
+MCPKG_API void mcpkg_fs_unmap(McPkgFsMap *map);
+
 /* Zstd: compress buffer → file (level typically 1..22). */
 MCPKG_API MCPKG_FS_ERROR mcpkg_fs_write_zstd(const char *path,
                 const void *data, size_t size,
@@ -38,6 +51,60 @@ MCPKG_API MCPKG_FS_ERROR mcpkg_fs_read_zstd(const char *path,
                 unsigned char **buf_out,
                 size_t *size_out);
 
+/*
+ * Zstd dictionaries: small, repetitive inputs (a pkg.meta record, a
+ * block of a few) compress well only against a trained dictionary.
+ * A McPkgZstdDict holds the raw bytes plus prepared CDict/DDict and is
+ * read-only after creation, so threads may share one.
+ */
+typedef struct McPkgZstdDict McPkgZstdDict;
+
+/* dict_cap 0 for mcpkg_fs_zstd_dict_train */
+#define MCPKG_FS_ZSTD_DICT_CAP  (32u * 1024u)
+
+/*
+ * Train from n samples stored back to back in samples (sizes[i] bytes
+ * each). *dict_out is mcpkg_malloc'd. ERR_RANGE when the sample is too
+ * small to train on (zstd wants ~100x dict_cap, a few hundred samples).
+ */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_zstd_dict_train(const void *samples,
+                const size_t *sizes, size_t n, size_t dict_cap,
+                void **dict_out, size_t *dict_len);
+
+/*
+ * Wrap trained dictionary bytes (copied) for compression at level.
+ * ERR_FORMAT if buf is not a zstd dictionary (raw content has id 0).
+ */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_zstd_dict_new(const void *buf, size_t len,
+                int level, McPkgZstdDict **out);
+
+MCPKG_API void mcpkg_fs_zstd_dict_free(McPkgZstdDict *d);
+
+/* Dictionary id as stored in frame headers (never 0). */
+MCPKG_API unsigned mcpkg_fs_zstd_dict_id(const McPkgZstdDict *d);
+
+/* The raw dictionary bytes, e.g. to persist them. */
+MCPKG_API const void *mcpkg_fs_zstd_dict_data(const McPkgZstdDict *d,
+                size_t *len);
+
+/* write_zstd/read_zstd against d (level comes from d). */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_write_zstd_dict(const char *path,
+                const void *data, size_t size,
+                const McPkgZstdDict *d);
+
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_read_zstd_dict(const char *path,
+                const McPkgZstdDict *d,
+                unsigned char **buf_out,
+                size_t *size_out);
+
+/* library-internal: prepared dictionaries for other zstd users in fs */
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+MCPKG_LOCAL const struct ZSTD_CDict_s *mcpkg_fs_zstd_dict_cdict(
+        const McPkgZstdDict *d);
+MCPKG_LOCAL const struct ZSTD_DDict_s *mcpkg_fs_zstd_dict_ddict(
+        const McPkgZstdDict *d);
+
 /* Create/replace symlink (POSIX). On Windows returns UNSUPPORTED. */
 MCPKG_API MCPKG_FS_ERROR mcpkg_fs_ln_sf(const char *target,
                                         const char *link_path,
@@ -0,0 +1,393 @@
+/* libmcpkg/fs/mcpkg_fs_zstd.c */
+
+#include "fs/mcpkg_fs_zstd.h"
+#include "container/mcpkg_alloc.h"
+#include "threads/mcpkg_thread.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <zstd.h>
+
+struct McPkgFsZstdWriter {
+	FILE           *fp;
+	char           *path;
+	ZSTD_CCtx      *cc;
+	unsigned char  *obuf;
+	size_t          ocap;
+	MCPKG_FS_ERROR  err;        /* first failure; sticks */
+	int             created;    /* path is ours to remove */
+	int             done;
+};
+
+struct McPkgFsZstdReader {
+	FILE           *fp;
+	ZSTD_DCtx      *dc;
+	unsigned char  *ibuf;
+	ZSTD_inBuffer   in;
+	size_t          last;       /* decompressStream hint; 0 = frame end */
+	int             eof;
+	int             flush;      /* output filled up: zstd may hold more */
+};
+
+/* ---------- per-thread contexts ---------- */
+
+/*
+ * A ZSTD_CCtx is a few hundred KB of tables and a DCtx ~100 KB; the
+ * one-shot APIs build and drop one per call. Each thread keeps one of
+ * each instead, created on first use.
+ */
+struct zstd_tls {
+	ZSTD_CCtx *cc;
+	ZSTD_DCtx *dc;
+};
+
+static _Atomic(struct McPkgTls *) g_zstd_key;
+
+static void zstd_tls_free(void *p)
+{
+	struct zstd_tls *t = p;
+
+	ZSTD_freeCCtx(t->cc);
+	ZSTD_freeDCtx(t->dc);
+	mcpkg_free(t);
+}
+
+static struct zstd_tls *zstd_tls(void)
+{
+	struct McPkgTls *key, *mine;
+	struct zstd_tls *t;
+
+	key = atomic_load_explicit(&g_zstd_key, memory_order_acquire);
+	if (!key) {
+		/* first use races: one key wins, the others go away */
+		mine = mcpkg_tls_new(zstd_tls_free);
+		if (!mine)
+			return NULL;
+		if (atomic_compare_exchange_strong_explicit(&g_zstd_key, &key,
+		                mine, memory_order_acq_rel,
+		                memory_order_acquire)) {
+			key = mine;
+		} else {
+			mcpkg_tls_free(mine);
+		}
+	}
+
+	t = mcpkg_tls_get(key);
+	if (t)
+		return t;
+	t = mcpkg_calloc(1, sizeof(*t));
+	if (t && mcpkg_tls_set(key, t) != 0) {
+		mcpkg_free(t);
+		t = NULL;
+	}
+	return t;
+}
+
+ZSTD_CCtx *mcpkg_fs_zstd_cctx(void)
+{
+	struct zstd_tls *t = zstd_tls();
+
+	if (!t)
+		return NULL;
+	if (!t->cc)
+		t->cc = ZSTD_createCCtx();
+	else
+		ZSTD_CCtx_reset(t->cc, ZSTD_reset_session_and_parameters);
+	return t->cc;
+}
+
+ZSTD_DCtx *mcpkg_fs_zstd_dctx(void)
+{
+	struct zstd_tls *t = zstd_tls();
+
+	if (!t)
+		return NULL;
+	if (!t->dc)
+		t->dc = ZSTD_createDCtx();
+	else
+		ZSTD_DCtx_reset(t->dc, ZSTD_reset_session_and_parameters);
+	return t->dc;
+}
+
+/* ---------- write ---------- */
+
+MCPKG_FS_ERROR mcpkg_fs_zstd_writer_open(const char *path,
+                const McPkgFsZstdOpts *opts, McPkgFsZstdWriter **out)
+{
+	McPkgFsZstdWriter *w;
+	size_t ret = 0;
+
+	if (!path || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*out = NULL;
+
+	w = mcpkg_calloc(1, sizeof(*w));
+	if (!w)
+		return MCPKG_FS_ERR_OOM;
+	w->ocap = ZSTD_CStreamOutSize();
+	w->obuf = mcpkg_malloc(w->ocap);
+	w->path = mcpkg_strdup(path);
+	w->cc = ZSTD_createCCtx();
+	if (!w->obuf || !w->path || !w->cc) {
+		mcpkg_fs_zstd_writer_free(w);
+		return MCPKG_FS_ERR_OOM;
+	}
+
+	if (opts && opts->level)
+		ret = ZSTD_CCtx_setParameter(w->cc, ZSTD_c_compressionLevel,
+		                             opts->level);
+	if (!ZSTD_isError(ret) && opts && opts->dict)
+		ret = ZSTD_CCtx_refCDict(w->cc,
+		                         mcpkg_fs_zstd_dict_cdict(opts->dict));
+	if (ZSTD_isError(ret)) {
+		mcpkg_fs_zstd_writer_free(w);
+		return MCPKG_FS_ERR_RANGE;
+	}
+	/* single-threaded libzstd rejects this; stay on the caller then */
+	if (opts && opts->workers)
+		(void)ZSTD_CCtx_setParameter(w->cc, ZSTD_c_nbWorkers,
+		                             (int)opts->workers);
+
+	w->fp = fopen(path, "wb");
+	if (!w->fp) {
+		MCPKG_FS_ERROR e = (errno == ENOSPC) ? MCPKG_FS_ERR_NOSPC
+		                   : MCPKG_FS_ERR_IO;
+
+		mcpkg_fs_zstd_writer_free(w);
+		return e;
+	}
+	w->created = 1;
+	*out = w;
+	return MCPKG_FS_OK;
+}
+
+/* one compressStream2 round; output goes straight to the file */
+static MCPKG_FS_ERROR zw_step(McPkgFsZstdWriter *w, ZSTD_inBuffer *in,
+                              ZSTD_EndDirective mode, size_t *left)
+{
+	ZSTD_outBuffer o = { w->obuf, w->ocap, 0 };
+	size_t ret;
+
+	ret = ZSTD_compressStream2(w->cc, &o, in, mode);
+	if (ZSTD_isError(ret))
+		return MCPKG_FS_ERR_IO;
+	if (o.pos && fwrite(w->obuf, 1, o.pos, w->fp) != o.pos)
+		return MCPKG_FS_ERR_IO;
+	*left = ret;
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_fs_zstd_writer_write(McPkgFsZstdWriter *w,
+                const void *data, size_t len)
+{
+	ZSTD_inBuffer in = { data, len, 0 };
+	size_t left;
+
+	if (!w || (!data && len))
+		return MCPKG_FS_ERR_NULL_PARAM;
+	if (w->err)
+		return w->err;
+	if (!w->fp)
+		return MCPKG_FS_ERR_IO;
+
+	while (in.pos < in.size) {
+		w->err = zw_step(w, &in, ZSTD_e_continue, &left);
+		if (w->err)
+			return w->err;
+	}
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_fs_zstd_writer_finish(McPkgFsZstdWriter *w)
+{
+	ZSTD_inBuffer in = { NULL, 0, 0 };
+	size_t left = 1;
+	FILE *fp;
+
+	if (!w)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	if (w->err)
+		return w->err;
+	if (!w->fp)
+		return MCPKG_FS_ERR_IO;
+
+	/* with workers this also waits for the jobs still in flight */
+	while (left) {
+		w->err = zw_step(w, &in, ZSTD_e_end, &left);
+		if (w->err)
+			return w->err;
+	}
+
+	fp = w->fp;
+	w->fp = NULL;
+	if (fclose(fp) != 0) {
+		w->err = MCPKG_FS_ERR_IO;
+		return w->err;
+	}
+	w->done = 1;
+	return MCPKG_FS_OK;
+}
+
+void mcpkg_fs_zstd_writer_free(McPkgFsZstdWriter *w)
+{
+	if (!w)
+		return;
+	if (w->fp)
+		fclose(w->fp);
+	if (w->created && !w->done)
+		remove(w->path);
+	ZSTD_freeCCtx(w->cc);
+	mcpkg_free(w->obuf);
+	mcpkg_free(w->path);
+	mcpkg_free(w);
+}
+
+MCPKG_FS_ERROR mcpkg_fs_write_zstd_cb(const char *path,
+                                      const McPkgFsZstdOpts *opts,
+                                      mcpkg_fs_zstd_src_fn src, void *ctx)
+{
+	McPkgFsZstdWriter *w;
+	MCPKG_FS_ERROR ret;
+	unsigned char *buf;
+	size_t cap = ZSTD_CStreamInSize(), got;
+
+	if (!path || !src)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	buf = mcpkg_malloc(cap);
+	if (!buf)
+		return MCPKG_FS_ERR_OOM;
+
+	ret = mcpkg_fs_zstd_writer_open(path, opts, &w);
+	while (!ret) {
+		got = 0;
+		ret = src(ctx, buf, cap, &got);
+		if (ret || !got)
+			break;
+		if (got > cap)
+			ret = MCPKG_FS_ERR_RANGE;
+		else
+			ret = mcpkg_fs_zstd_writer_write(w, buf, got);
+	}
+	if (!ret)
+		ret = mcpkg_fs_zstd_writer_finish(w);
+
+	mcpkg_fs_zstd_writer_free(w);
+	mcpkg_free(buf);
+	return ret;
+}
+
+/* ---------- read ---------- */
+
+MCPKG_FS_ERROR mcpkg_fs_zstd_reader_open(const char *path,
+                const McPkgZstdDict *d, McPkgFsZstdReader **out)
+{
+	McPkgFsZstdReader *r;
+
+	if (!path || !out)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*out = NULL;
+
+	r = mcpkg_calloc(1, sizeof(*r));
+	if (!r)
+		return MCPKG_FS_ERR_OOM;
+	r->ibuf = mcpkg_malloc(ZSTD_DStreamInSize());
+	r->dc = ZSTD_createDCtx();
+	if (!r->ibuf || !r->dc) {
+		mcpkg_fs_zstd_reader_free(r);
+		return MCPKG_FS_ERR_OOM;
+	}
+	if (d && ZSTD_isError(ZSTD_DCtx_refDDict(r->dc,
+	                      mcpkg_fs_zstd_dict_ddict(d)))) {
+		mcpkg_fs_zstd_reader_free(r);
+		return MCPKG_FS_ERR_RANGE;
+	}
+
+	r->fp = fopen(path, "rb");
+	if (!r->fp) {
+		MCPKG_FS_ERROR e = (errno == ENOENT) ? MCPKG_FS_ERR_NOT_FOUND
+		                   : MCPKG_FS_ERR_IO;
+
+		mcpkg_fs_zstd_reader_free(r);
+		return e;
+	}
+	r->in.src = r->ibuf;
+	*out = r;
+	return MCPKG_FS_OK;
+}
+
+MCPKG_FS_ERROR mcpkg_fs_zstd_reader_read(McPkgFsZstdReader *r, void *buf,
+                size_t cap, size_t *got)
+{
+	ZSTD_outBuffer o = { buf, cap, 0 };
+	size_t n, ret;
+
+	if (!r || !got || (!buf && cap))
+		return MCPKG_FS_ERR_NULL_PARAM;
+	*got = 0;
+
+	while (o.pos < o.size) {
+		if (r->in.pos == r->in.size && !r->eof) {
+			n = fread(r->ibuf, 1, ZSTD_DStreamInSize(), r->fp);
+			if (!n && ferror(r->fp))
+				return MCPKG_FS_ERR_IO;
+			r->eof = !n;
+			r->in.size = n;
+			r->in.pos = 0;
+		}
+		if (r->eof && r->in.pos == r->in.size && !r->flush)
+			break;
+
+		ret = ZSTD_decompressStream(r->dc, &o, &r->in);
+		if (ZSTD_isError(ret))
+			return MCPKG_FS_ERR_IO;
+		r->last = ret;
+		r->flush = o.pos == o.size;
+	}
+
+	/* input gone in the middle of a frame */
+	if (!o.pos && cap && r->last)
+		return MCPKG_FS_ERR_IO;
+	*got = o.pos;
+	return MCPKG_FS_OK;
+}
+
+void mcpkg_fs_zstd_reader_free(McPkgFsZstdReader *r)
+{
+	if (!r)
+		return;
+	if (r->fp)
+		fclose(r->fp);
+	ZSTD_freeDCtx(r->dc);
+	mcpkg_free(r->ibuf);
+	mcpkg_free(r);
+}
+
+MCPKG_FS_ERROR mcpkg_fs_read_zstd_cb(const char *path, const McPkgZstdDict *d,
+                                     mcpkg_fs_zstd_sink_fn sink, void *ctx)
+{
+	McPkgFsZstdReader *r;
+	MCPKG_FS_ERROR ret;
+	unsigned char *buf;
+	size_t cap = ZSTD_DStreamOutSize(), got;
+
+	if (!path || !sink)
+		return MCPKG_FS_ERR_NULL_PARAM;
+	buf = mcpkg_malloc(cap);
+	if (!buf)
+		return MCPKG_FS_ERR_OOM;
+
+	ret = mcpkg_fs_zstd_reader_open(path, d, &r);
+	while (!ret) {
+		ret = mcpkg_fs_zstd_reader_read(r, buf, cap, &got);
+		if (ret || !got)
+			break;
+		ret = sink(ctx, buf, got);
+	}
+
+	mcpkg_fs_zstd_reader_free(r);
+	mcpkg_free(buf);
+	return ret;
+}
@@ -0,0 +1,98 @@
+#ifndef MCPKG_FS_ZSTD_H
+#define MCPKG_FS_ZSTD_H
+
+#include <stddef.h>
+#include "mcpkg_export.h"
+#include "fs/mcpkg_fs_error.h"
+#include "fs/mcpkg_fs_file.h"
+
+MCPKG_BEGIN_DECLS
+
+/*
+ * Streaming zstd files: fixed-size buffers (zstd's recommended stream
+ * sizes, ~128 KiB each way), so memory no longer grows with the file
+ * as in mcpkg_fs_write_zstd/read_zstd. Output is a normal zstd file;
+ * either side may be one-shot.
+ * - With workers > 0 zstd compresses on its own threads while the
+ *   caller keeps feeding and writing, overlapping I/O with compression
+ *   (falls back to one thread if libzstd lacks multithreading).
+ * - A writer or reader belongs to one thread at a time.
+ */
+
+typedef struct McPkgFsZstdWriter McPkgFsZstdWriter;
+typedef struct McPkgFsZstdReader McPkgFsZstdReader;
+
+typedef struct {
+	int                  level;    /* 0 = zstd default */
+	unsigned             workers;  /* 0 = compress on the caller */
+	const McPkgZstdDict *dict;     /* NULL = none; its level wins */
+} McPkgFsZstdOpts;
+
+/* ---------- write ---------- */
+
+/* Create/truncate path; opts NULL = defaults. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_zstd_writer_open(const char *path,
+                const McPkgFsZstdOpts *opts, McPkgFsZstdWriter **out);
+
+/* Compress len bytes; data may be reused on return. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_zstd_writer_write(McPkgFsZstdWriter *w,
+                const void *data, size_t len);
+
+/* End the frame and close the file. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_zstd_writer_finish(McPkgFsZstdWriter *w);
+
+/* Free; without a successful finish the partial file is removed. */
+MCPKG_API void mcpkg_fs_zstd_writer_free(McPkgFsZstdWriter *w);
+
+/*
+ * Pull source for mcpkg_fs_write_zstd_cb: fill up to cap bytes of buf,
+ * *got = 0 at the end. Anything but OK aborts the write.
+ */
+typedef MCPKG_FS_ERROR (*mcpkg_fs_zstd_src_fn)(void *ctx, void *buf,
+                size_t cap, size_t *got);
+
+/* Whole write driven by src (open + write loop + finish). */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_write_zstd_cb(const char *path,
+                const McPkgFsZstdOpts *opts,
+                mcpkg_fs_zstd_src_fn src, void *ctx);
+
+/* ---------- read ---------- */
+
+/* d must match the dictionary the file was written with (or NULL). */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_zstd_reader_open(const char *path,
+                const McPkgZstdDict *d, McPkgFsZstdReader **out);
+
+/*
+ * Decompress up to cap bytes into buf; *got = 0 at the end of the
+ * file. A truncated or corrupt file fails with ERR_IO.
+ */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_zstd_reader_read(McPkgFsZstdReader *r,
+                void *buf, size_t cap, size_t *got);
+
+MCPKG_API void mcpkg_fs_zstd_reader_free(McPkgFsZstdReader *r);
+
+/*
+ * Push sink for mcpkg_fs_read_zstd_cb: one decompressed chunk, valid
+ * for the call only. Anything but OK stops the read and is returned.
+ */
+typedef MCPKG_FS_ERROR (*mcpkg_fs_zstd_sink_fn)(void *ctx, const void *buf,
+                size_t len);
+
+/* Whole file through sink, one internal buffer at a time. */
+MCPKG_API MCPKG_FS_ERROR mcpkg_fs_read_zstd_cb(const char *path,
+                const McPkgZstdDict *d,
+                mcpkg_fs_zstd_sink_fn sink, void *ctx);
+
+/*
+ * library-internal: this thread's reusable contexts for one-shot zstd
+ * calls in fs, reset to defaults (no dictionary) on every fetch, so a
+ * context is only valid until the next fetch on the same thread. The
+ * thread-exit destructor frees them; NULL only when out of memory.
+ */
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+MCPKG_LOCAL struct ZSTD_CCtx_s *mcpkg_fs_zstd_cctx(void);
+MCPKG_LOCAL struct ZSTD_DCtx_s *mcpkg_fs_zstd_dctx(void);
+
+MCPKG_END_DECLS
+#endif /* MCPKG_FS_ZSTD_H */
@@ -24,6 +24,36 @@ static inline uint64_t mcpkg_math_load64_le(const void *p)
 	return v;
 }
 
+static inline uint32_t mcpkg_math_load32_le(const void *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap32(v);
+#endif
+	return v;
+}
+
+/* full 64x64 -> 128 product as (lo, hi) */
+static inline void mcpkg_math_mul128_u64(uint64_t a, uint64_t b,
+                uint64_t *lo, uint64_t *hi)
+{
+#if defined(__SIZEOF_INT128__)
+	__uint128_t p = ((__uint128_t)a) * ((__uint128_t)b);
+	*lo = (uint64_t)p;
+	*hi = (uint64_t)(p >> 64);
+#else
+	uint64_t al = a & 0xFFFFFFFFu, ah = a >> 32;
+	uint64_t bl = b & 0xFFFFFFFFu, bh = b >> 32;
+	uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+	uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+
+	*lo = (mid << 32) | (ll & 0xFFFFFFFFu);
+	*hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
 static inline size_t mcpkg_math_min_size(size_t a, size_t b)
 {
 	return a < b ? a : b;
@@ -176,6 +206,22 @@ static inline uint64_t mcpkg_math_rotl64(uint64_t x, int r)
 	return (x << r) | (x >> (64 - r));
 }
 
+/* index of the lowest set bit; x must be non-zero */
+static inline unsigned mcpkg_math_ctz64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned)__builtin_ctzll(x);
+#else
+	unsigned n = 0;
+
+	while (!(x & 1u)) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
 static inline uint32_t mcpkg_math_rotr32(uint32_t x, int r)
 {
 	return (x >> r) | (x << (32 - r));
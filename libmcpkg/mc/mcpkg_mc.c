@@ -3,6 +3,7 @@
 
 #include "mc/mcpkg_mc.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
 
 static int mc_list_push_ptr(McPkgList **lstp, void *ptr)
 {
@@ -70,7 +71,7 @@ int mcpkg_mc_new(struct McPkgMc **out)
 	if (!out)
 		return MCPKG_MC_ERR_INVALID_ARG;
 
-	mc = (struct McPkgMc *)calloc(1, sizeof(*mc));
+	mc = (struct McPkgMc *)mcpkg_calloc(1, sizeof(*mc));
 	if (!mc)
 		return MCPKG_MC_ERR_NO_MEMORY;
 
@@ -101,7 +102,7 @@ void mcpkg_mc_free(struct McPkgMc *mc)
 	mc_clear_list_of_ptrs(mc->loaders, (void (*)(void *))mc_free_loader);
 	mc_clear_list_of_ptrs(mc->versions, (void (*)(void *))mc_free_version_family);
 
-	free(mc);
+	mcpkg_free(mc);
 }
 
 // ---- Optional singleton -----------------------------------------------------
@@ -511,7 +512,7 @@ mcpkg_mc_codename_from_version_in(struct McPkgMc *mc, const char *mc_version)
 		return MCPKG_MC_CODE_NAME_UNKNOWN;
 
 	arr = (const struct McPkgMCVersion **)
-	      calloc(n, sizeof(*arr));
+	      mcpkg_calloc(n, sizeof(*arr));
 	if (!arr)
 		return MCPKG_MC_CODE_NAME_UNKNOWN;
 
@@ -522,7 +523,7 @@ mcpkg_mc_codename_from_version_in(struct McPkgMc *mc, const char *mc_version)
 	}
 
 	code = mcpkg_mc_codename_from_version(arr, n, mc_version);
-	free(arr);
+	mcpkg_free(arr);
 	return code;
 }
 
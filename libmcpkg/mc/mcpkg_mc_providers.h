@@ -100,7 +100,7 @@ mcpkg_mc_provider_set_ops(struct McPkgMcProvider *p,
                           const struct McPkgMcProviderOps *ops);
 
 // Serialize to a newly allocated buffer (MessagePack only; caller compresses if desired).
-// On success: *out_buf points to malloc'd bytes, *out_len set. Return MCPKG_MC_NO_ERROR.
+// On success: *out_buf points to bytes to mcpkg_free(), *out_len set. Return MCPKG_MC_NO_ERROR.
 MCPKG_API int
 mcpkg_mc_provider_pack(const struct McPkgMcProvider *p,
                        void **out_buf, size_t *out_len);
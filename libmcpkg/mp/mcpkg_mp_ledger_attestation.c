@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 
@@ -24,21 +26,29 @@ MCPKG_API struct McPkgAttestation *mcpkg_mp_ledger_attestation_new(void)
 {
 	struct McPkgAttestation *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgAttestation *mcpkg_mp_ledger_attestation_new_arena(struct
+                McPkgArena *a)
+{
+	if (!a)
+		return mcpkg_mp_ledger_attestation_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgAttestation));
+}
+
 MCPKG_API void mcpkg_mp_ledger_attestation_free(struct McPkgAttestation *p)
 {
 	if (!p)
 		return;
 
 	/* free pkg_id */
-	free(p->pkg_id);
+	mcpkg_free(p->pkg_id);
 	p->pkg_id = NULL;
 
 	/* free version */
-	free(p->version);
+	mcpkg_free(p->version);
 	p->version = NULL;
 
 	/* free manifest_sha256 */
@@ -46,7 +56,7 @@ MCPKG_API void mcpkg_mp_ledger_attestation_free(struct McPkgAttestation *p)
 	/* free signature */
 	/* free ts_ms */
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_ledger_attestation_debug_str(const struct
@@ -131,234 +141,374 @@ MCPKG_API char *mcpkg_mp_ledger_attestation_debug_str(const struct
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_ledger_attestation_pack(const struct McPkgAttestation *p,
-                void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_ledger_attestation_pack_map(const struct McPkgAttestation *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
-
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 8);
+	mpret = mcpkg_mp_map_begin(w, 6 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
-	mpret = mcpkg_mp_write_header(&w, "ledger.attestation", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "ledger.attestation", 1);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* pkg_id */
 	if (p->pkg_id)
-		mpret = mcpkg_mp_kv_str(&w, 2, p->pkg_id);
+		mpret = mcpkg_mp_kv_str(w, 2, p->pkg_id);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 2);
+		mpret = mcpkg_mp_kv_nil(w, 2);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* version */
 	if (p->version)
-		mpret = mcpkg_mp_kv_str(&w, 3, p->version);
+		mpret = mcpkg_mp_kv_str(w, 3, p->version);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 3);
+		mpret = mcpkg_mp_kv_nil(w, 3);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* manifest_sha256 */
-	mpret = mcpkg_mp_kv_bin(&w, 4, p->manifest_sha256, 32);
+	mpret = mcpkg_mp_kv_bin(w, 4, p->manifest_sha256, 32);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* signer_pub */
-	mpret = mcpkg_mp_kv_bin(&w, 5, p->signer_pub, 32);
+	mpret = mcpkg_mp_kv_bin(w, 5, p->signer_pub, 32);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* signature */
-	mpret = mcpkg_mp_kv_bin(&w, 6, p->signature, 64);
+	mpret = mcpkg_mp_kv_bin(w, 6, p->signature, 64);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* ts_ms */
-	mpret = mcpkg_mp_kv_i64(&w, 7, p->ts_ms);
+	mpret = mcpkg_mp_kv_i64(w, 7, p->ts_ms);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
-
-MCPKG_API int mcpkg_mp_ledger_attestation_unpack(const void *buf, size_t len,
-                struct McPkgAttestation **out_p)
+MCPKG_API int mcpkg_mp_ledger_attestation_pack_w(const struct McPkgAttestation *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgAttestation *p = NULL;
-	int mpret, ver = 0;
-
-	if (!buf || !len || !out_p)
+	if (!p || !w)
 		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_attestation_pack_map(p, w, 0);
+}
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
+MCPKG_API int mcpkg_mp_ledger_attestation_pack_append(const struct McPkgAttestation *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_attestation_pack_map(p, w, 1);
+}
 
-	mpret = mcpkg_mp_expect_tag(&r, "ledger.attestation", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_ledger_attestation_size_map(const struct McPkgAttestation *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(6 + (top ? 2 : 0));
 
-	p = mcpkg_mp_ledger_attestation_new();
-	if (!p) {
-		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
-	}
+	if (top)
+		n += mcpkg_mp_size_header("ledger.attestation", 1);
 
 	/* pkg_id */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_str(p->pkg_id);
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 2, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* version */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_str(p->version);
 
-		if (found_ && ptr_) {
-			p->pkg_id = malloc(pl_ + 1);
-			if (!p->pkg_id) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->pkg_id, ptr_, pl_);
-			p->pkg_id[pl_] = '\0';
-		}
-		if (!found_ || !p->pkg_id) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* manifest_sha256 */
+	n += mcpkg_mp_size_int(4);
+	n += mcpkg_mp_size_bin(32);
 
-	/* version */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* signer_pub */
+	n += mcpkg_mp_size_int(5);
+	n += mcpkg_mp_size_bin(32);
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 3, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* signature */
+	n += mcpkg_mp_size_int(6);
+	n += mcpkg_mp_size_bin(64);
 
-		if (found_ && ptr_) {
-			p->version = malloc(pl_ + 1);
-			if (!p->version) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->version, ptr_, pl_);
-			p->version[pl_] = '\0';
-		}
-		if (!found_ || !p->version) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* ts_ms */
+	n += mcpkg_mp_size_int(7);
+	n += mcpkg_mp_size_int(p->ts_ms);
 
-	/* manifest_sha256 */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	return n;
+}
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 4, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API size_t mcpkg_mp_ledger_attestation_packed_size(const struct McPkgAttestation *p)
+{
+	return p ? mcpkg_mp_ledger_attestation_size_map(p, 1) : 0;
+}
 
-		if (!found_ || pl_ != 32) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+MCPKG_API size_t mcpkg_mp_ledger_attestation_packed_size_w(const struct McPkgAttestation *p)
+{
+	return p ? mcpkg_mp_ledger_attestation_size_map(p, 0) : 0;
+}
 
-		if (found_ && ptr_ && pl_ == 32)
-			memcpy(p->manifest_sha256, ptr_, 32);
-	}
+MCPKG_API int mcpkg_mp_ledger_attestation_pack_into(const struct McPkgAttestation *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
 
-	/* signer_pub */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	if (!p || !out_len || (!buf && cap))
+		return MCPKG_MP_ERR_INVALID_ARG;
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 5, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		if (!found_ || pl_ != 32) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+	mpret = mcpkg_mp_ledger_attestation_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
+		mpret = MCPKG_MP_ERR_NO_MEMORY;
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
 
-		if (found_ && ptr_ && pl_ == 32)
-			memcpy(p->signer_pub, ptr_, 32);
+MCPKG_API int mcpkg_mp_ledger_attestation_pack(const struct McPkgAttestation *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
+
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_ledger_attestation_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_attestation_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
 	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-	/* signature */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 6, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_ledger_attestation_unpack(const void *buf, size_t len,
+                      struct McPkgAttestation **out_p)
+{
+	return mcpkg_mp_ledger_attestation_unpack_arena(buf, len, NULL, out_p);
+}
 
-		if (!found_ || pl_ != 64) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_ledger_attestation_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgAttestation *p, int top)
+{
+	unsigned char seen_[8] = { 0 };
+	const char *sp_;
+	const void *bp_;
+	size_t n_, i_, pl_;
+	int mpret, key_;
+
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 7 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
 		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "ledger.attestation");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* pkg_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->pkg_id = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->pkg_id)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 3: /* version */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->version = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->version)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
 
-		if (found_ && ptr_ && pl_ == 64)
-			memcpy(p->signature, ptr_, 64);
-	}
+		case 4: /* manifest_sha256 */
+			if (mcpkg_mp_cur_nil(c_)) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 32) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->manifest_sha256, bp_, 32);
+			break;
 
-	/* ts_ms */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
+		case 5: /* signer_pub */
+			if (mcpkg_mp_cur_nil(c_)) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 32) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->signer_pub, bp_, 32);
+			break;
 
-		mpret = mcpkg_mp_get_u64(&r, 7, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+		case 6: /* signature */
+			if (mcpkg_mp_cur_nil(c_)) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 64) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->signature, bp_, 64);
+			break;
+
+		case 7: /* ts_ms */
+			mpret = mcpkg_mp_cur_i64(c_, &p->ts_ms);
+			break;
 
-		if (found_)
-			p->ts_ms = (int64_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->pkg_id)
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->version)
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[4])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[5])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[6])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[7])
+		return MCPKG_MP_ERR_PARSE;
+
+	return MCPKG_MP_NO_ERROR;
+}
+
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_ledger_attestation_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgAttestation **out_p, int top)
+{
+	struct McPkgAttestation *p;
+	McPkgArenaMark mark_;
+	int mpret;
+
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_ledger_attestation_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_attestation_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_ledger_attestation_free(p);
+		return mpret;
+	}
 
 	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_ledger_attestation_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_ledger_attestation_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgAttestation **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_attestation_decode_new(c, a, out_p, 0);
+}
+
+MCPKG_API int mcpkg_mp_ledger_attestation_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgAttestation **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_ledger_attestation_decode_new(&c, a, out_p, 1);
 }
@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 #include "mp/mcpkg_mp_ledger_audit_node.h"
@@ -25,10 +27,18 @@ MCPKG_API struct McPkgAuditPath *mcpkg_mp_ledger_audit_path_new(void)
 {
 	struct McPkgAuditPath *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgAuditPath *mcpkg_mp_ledger_audit_path_new_arena(struct
+                McPkgArena *a)
+{
+	if (!a)
+		return mcpkg_mp_ledger_audit_path_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgAuditPath));
+}
+
 MCPKG_API void mcpkg_mp_ledger_audit_path_free(struct McPkgAuditPath *p)
 {
 	if (!p)
@@ -48,7 +58,7 @@ MCPKG_API void mcpkg_mp_ledger_audit_path_free(struct McPkgAuditPath *p)
 	}
 
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_ledger_audit_path_debug_str(const struct McPkgAuditPath
@@ -76,149 +86,309 @@ MCPKG_API char *mcpkg_mp_ledger_audit_path_debug_str(const struct McPkgAuditPath
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_ledger_audit_path_pack(const struct McPkgAuditPath *p,
-                void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_ledger_audit_path_pack_map(const struct McPkgAuditPath *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
+	mpret = mcpkg_mp_map_begin(w, 1 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
+		goto out;
 
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 3);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
-
-	mpret = mcpkg_mp_write_header(&w, "ledger.audit_path", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "ledger.audit_path", 2);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* nodes */
 	{
 		size_t i_, n_ = p->nodes ? mcpkg_list_size(p->nodes) : 0;
 
-		mpret = mcpkg_mp_kv_array_begin(&w, 2, (uint32_t)n_);
+		mpret = mcpkg_mp_kv_array_begin(w, 2, (uint32_t)n_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 
 		for (i_ = 0; i_ < n_; i_++) {
 			struct McPkgAuditNode *elt_ = NULL;
-			void *b_ = NULL;
-			size_t bl_ = 0;
 
 			if (mcpkg_list_at(p->nodes, i_, &elt_) != MCPKG_CONTAINER_OK || !elt_) {
 				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_w;
-			}
-			if (mcpkg_mp_ledger_audit_node_pack(elt_, &b_, &bl_) != MCPKG_MP_NO_ERROR) {
-				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_w;
+				goto out;
 			}
-			mpret = mcpkg_mp_write_bin(&w, b_, (uint32_t)bl_);
-			free(b_);
+			mpret = mcpkg_mp_ledger_audit_node_pack_w(elt_, w);
 			if (mpret != MCPKG_MP_NO_ERROR)
-				goto out_w;
+				goto out;
 		}
 	}
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
+MCPKG_API int mcpkg_mp_ledger_audit_path_pack_w(const struct McPkgAuditPath *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_audit_path_pack_map(p, w, 0);
+}
+
+MCPKG_API int mcpkg_mp_ledger_audit_path_pack_append(const struct McPkgAuditPath *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_audit_path_pack_map(p, w, 1);
+}
 
-MCPKG_API int mcpkg_mp_ledger_audit_path_unpack(const void *buf, size_t len,
-                struct McPkgAuditPath **out_p)
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_ledger_audit_path_size_map(const struct McPkgAuditPath *p, int top)
 {
-	struct McPkgMpReader r;
-	struct McPkgAuditPath *p = NULL;
-	int mpret, ver = 0;
+	size_t n = mcpkg_mp_size_container(1 + (top ? 2 : 0));
 
-	if (!buf || !len || !out_p)
+	if (top)
+		n += mcpkg_mp_size_header("ledger.audit_path", 2);
+
+	/* nodes */
+	n += mcpkg_mp_size_int(2);
+	{
+		size_t i_, n_ = p->nodes ? mcpkg_list_size(p->nodes) : 0;
+
+		n += mcpkg_mp_size_container(n_);
+		for (i_ = 0; i_ < n_; i_++) {
+			struct McPkgAuditNode *elt_ = NULL;
+
+			if (mcpkg_list_at(p->nodes, i_, &elt_) == MCPKG_CONTAINER_OK && elt_)
+				n += mcpkg_mp_ledger_audit_node_packed_size_w(elt_);
+		}
+	}
+
+	return n;
+}
+
+MCPKG_API size_t mcpkg_mp_ledger_audit_path_packed_size(const struct McPkgAuditPath *p)
+{
+	return p ? mcpkg_mp_ledger_audit_path_size_map(p, 1) : 0;
+}
+
+MCPKG_API size_t mcpkg_mp_ledger_audit_path_packed_size_w(const struct McPkgAuditPath *p)
+{
+	return p ? mcpkg_mp_ledger_audit_path_size_map(p, 0) : 0;
+}
+
+MCPKG_API int mcpkg_mp_ledger_audit_path_pack_into(const struct McPkgAuditPath *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
+
+	if (!p || !out_len || (!buf && cap))
 		return MCPKG_MP_ERR_INVALID_ARG;
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
 	if (mpret != MCPKG_MP_NO_ERROR)
 		return mpret;
 
-	mpret = mcpkg_mp_expect_tag(&r, "ledger.audit_path", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
-
-	p = mcpkg_mp_ledger_audit_path_new();
-	if (!p) {
+	mpret = mcpkg_mp_ledger_audit_path_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
 		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
+
+MCPKG_API int mcpkg_mp_ledger_audit_path_pack(const struct McPkgAuditPath *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
+
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_ledger_audit_path_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_audit_path_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
 	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-	/* nodes */
-	{
-		struct McPkgMpArrayCur *cur_ = NULL;
-		size_t n_ = 0;
-		size_t i_;
-		int found_ = 0;
 
-		mpret = mcpkg_mp_get_array_cur(&r, 2, &cur_, &n_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_ledger_audit_path_unpack(const void *buf, size_t len,
+                      struct McPkgAuditPath **out_p)
+{
+	return mcpkg_mp_ledger_audit_path_unpack_arena(buf, len, NULL, out_p);
+}
+
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_ledger_audit_path_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgAuditPath *p, int top)
+{
+	unsigned char seen_[3] = { 0 };
+	const void *bp_;
+	size_t n_, i_, pl_, ln_, j_;
+	int mpret, key_;
 
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		if (found_ && n_ > 0) {
-			/// yikes
-			p->nodes = mcpkg_list_new(sizeof(struct McPkgAuditNode *), NULL, 0, 0);
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 2 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
+		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "ledger.audit_path");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* nodes */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_array(c_, &ln_);
+			if (mpret != MCPKG_MP_NO_ERROR || ln_ == 0)
+				break;
+			if (a)
+				p->nodes = mcpkg_list_new_arena(a,
+				                  sizeof(struct McPkgAuditNode *), NULL, 0, 0);
+			else
+				p->nodes = mcpkg_list_new(
+				                  sizeof(struct McPkgAuditNode *), NULL, 0, 0);
 			if (!p->nodes) {
 				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				mcpkg_mp_array_cur_destroy(cur_);
-				goto out_err;
+				break;
 			}
-			for (i_ = 0; i_ < n_; i_++) {
-				const void *ptr_ = NULL;
-				size_t pl_ = 0;
+			for (j_ = 0; j_ < ln_; j_++) {
 				struct McPkgAuditNode *elt_ = NULL;
 
-				if (mcpkg_mp_array_get_bin_borrow(cur_, i_, &ptr_, &pl_) != MCPKG_MP_NO_ERROR) {
-					mcpkg_mp_array_cur_destroy(cur_);
-					goto out_err;
-				}
-				if (mcpkg_mp_ledger_audit_node_unpack(ptr_, pl_, &elt_) != MCPKG_MP_NO_ERROR) {
-					mcpkg_mp_array_cur_destroy(cur_);
-					mpret = MCPKG_MP_ERR_PARSE;
-					goto out_err;
+				if (!mcpkg_mp_cur_is_bin(c_)) {
+					mpret = mcpkg_mp_ledger_audit_node_unpack_cur(c_, a, &elt_);
+					if (mpret != MCPKG_MP_NO_ERROR)
+						break;
+				} else {
+					/* version 1: records embedded as bin */
+					mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+					if (mpret != MCPKG_MP_NO_ERROR)
+						break;
+					if (mcpkg_mp_ledger_audit_node_unpack_arena(bp_, pl_, a,
+					        &elt_) != MCPKG_MP_NO_ERROR) {
+						mpret = MCPKG_MP_ERR_PARSE;
+						break;
+					}
 				}
-				if (mcpkg_list_push(p->nodes, &elt_) != MCPKG_CONTAINER_OK) {
-					mcpkg_mp_ledger_audit_node_free(elt_);
-					mcpkg_mp_array_cur_destroy(cur_);
+				if (mcpkg_list_push(p->nodes, &elt_) !=
+				    MCPKG_CONTAINER_OK) {
+					if (!a)
+						mcpkg_mp_ledger_audit_node_free(elt_);
 					mpret = MCPKG_MP_ERR_NO_MEMORY;
-					goto out_err;
+					break;
 				}
 			}
-		}
+			break;
 
-		if (cur_)
-			mcpkg_mp_array_cur_destroy(cur_);
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+
+	return MCPKG_MP_NO_ERROR;
+}
+
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_ledger_audit_path_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgAuditPath **out_p, int top)
+{
+	struct McPkgAuditPath *p;
+	McPkgArenaMark mark_;
+	int mpret;
+
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_ledger_audit_path_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_audit_path_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_ledger_audit_path_free(p);
+		return mpret;
+	}
 
 	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_ledger_audit_path_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_ledger_audit_path_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgAuditPath **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_audit_path_decode_new(c, a, out_p, 0);
+}
+
+MCPKG_API int mcpkg_mp_ledger_audit_path_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgAuditPath **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_ledger_audit_path_decode_new(&c, a, out_p, 1);
 }
@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 #include "mp/mcpkg_mp_ledger_sth.h"
@@ -25,10 +27,18 @@ MCPKG_API struct McPkgBlock *mcpkg_mp_ledger_block_new(void)
 {
 	struct McPkgBlock *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgBlock *mcpkg_mp_ledger_block_new_arena(struct McPkgArena
+                *a)
+{
+	if (!a)
+		return mcpkg_mp_ledger_block_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgBlock));
+}
+
 MCPKG_API void mcpkg_mp_ledger_block_free(struct McPkgBlock *p)
 {
 	if (!p)
@@ -45,7 +55,7 @@ MCPKG_API void mcpkg_mp_ledger_block_free(struct McPkgBlock *p)
 	/* free mint_pub */
 	/* free sig */
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_ledger_block_debug_str(const struct McPkgBlock *p)
@@ -122,211 +132,361 @@ MCPKG_API char *mcpkg_mp_ledger_block_debug_str(const struct McPkgBlock *p)
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_ledger_block_pack(const struct McPkgBlock *p,
-                void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_ledger_block_pack_map(const struct McPkgBlock *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
-
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 7);
+	mpret = mcpkg_mp_map_begin(w, 5 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
-	mpret = mcpkg_mp_write_header(&w, "ledger.block", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "ledger.block", 2);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* height */
 	/* encode u64 as i64 (non-negative) via util */
-	mpret = mcpkg_mp_kv_i64(&w, 2, (int64_t)p->height);
+	mpret = mcpkg_mp_kv_i64(w, 2, (int64_t)p->height);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* prev */
-	mpret = mcpkg_mp_kv_bin(&w, 3, p->prev, 32);
+	mpret = mcpkg_mp_kv_bin(w, 3, p->prev, 32);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* sth */
 	if (p->sth) {
-		void *b_ = NULL;
-		size_t bl_ = 0;
-
-		if (mcpkg_mp_ledger_sth_pack(p->sth, &b_, &bl_) != MCPKG_MP_NO_ERROR) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_w;
-		}
-		mpret = mcpkg_mp_kv_bin(&w, 4, b_, (uint32_t)bl_);
-		free(b_);
+		mpret = mcpkg_mp_write_key(w, 4);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+		mpret = mcpkg_mp_ledger_sth_pack_w(p->sth, w);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 	} else {
-		mpret = mcpkg_mp_kv_nil(&w, 4);
+		mpret = mcpkg_mp_kv_nil(w, 4);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 	}
 
 	/* mint_pub */
-	mpret = mcpkg_mp_kv_bin(&w, 5, p->mint_pub, 32);
+	mpret = mcpkg_mp_kv_bin(w, 5, p->mint_pub, 32);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* sig */
-	mpret = mcpkg_mp_kv_bin(&w, 6, p->sig, 64);
+	mpret = mcpkg_mp_kv_bin(w, 6, p->sig, 64);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
+MCPKG_API int mcpkg_mp_ledger_block_pack_w(const struct McPkgBlock *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_block_pack_map(p, w, 0);
+}
 
-MCPKG_API int mcpkg_mp_ledger_block_unpack(const void *buf, size_t len,
-                struct McPkgBlock **out_p)
+MCPKG_API int mcpkg_mp_ledger_block_pack_append(const struct McPkgBlock *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgBlock *p = NULL;
-	int mpret, ver = 0;
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_block_pack_map(p, w, 1);
+}
 
-	if (!buf || !len || !out_p)
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_ledger_block_size_map(const struct McPkgBlock *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(5 + (top ? 2 : 0));
+
+	if (top)
+		n += mcpkg_mp_size_header("ledger.block", 2);
+
+	/* height */
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_int((int64_t)p->height);
+
+	/* prev */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_bin(32);
+
+	/* sth */
+	n += mcpkg_mp_size_int(4);
+	n += p->sth ? mcpkg_mp_ledger_sth_packed_size_w(p->sth) : 1;
+
+	/* mint_pub */
+	n += mcpkg_mp_size_int(5);
+	n += mcpkg_mp_size_bin(32);
+
+	/* sig */
+	n += mcpkg_mp_size_int(6);
+	n += mcpkg_mp_size_bin(64);
+
+	return n;
+}
+
+MCPKG_API size_t mcpkg_mp_ledger_block_packed_size(const struct McPkgBlock *p)
+{
+	return p ? mcpkg_mp_ledger_block_size_map(p, 1) : 0;
+}
+
+MCPKG_API size_t mcpkg_mp_ledger_block_packed_size_w(const struct McPkgBlock *p)
+{
+	return p ? mcpkg_mp_ledger_block_size_map(p, 0) : 0;
+}
+
+MCPKG_API int mcpkg_mp_ledger_block_pack_into(const struct McPkgBlock *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
+
+	if (!p || !out_len || (!buf && cap))
 		return MCPKG_MP_ERR_INVALID_ARG;
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
 	if (mpret != MCPKG_MP_NO_ERROR)
 		return mpret;
 
-	mpret = mcpkg_mp_expect_tag(&r, "ledger.block", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
-
-	p = mcpkg_mp_ledger_block_new();
-	if (!p) {
+	mpret = mcpkg_mp_ledger_block_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
 		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
-	}
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
 
-	/* height */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
+MCPKG_API int mcpkg_mp_ledger_block_pack(const struct McPkgBlock *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
 
-		mpret = mcpkg_mp_get_u64(&r, 2, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
 
-		if (found_)
-			p->height = (int64_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_ledger_block_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
 
-	/* prev */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	mpret = mcpkg_mp_ledger_block_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
+	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 3, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
 
-		if (!found_ || pl_ != 32) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+MCPKG_API int mcpkg_mp_ledger_block_unpack(const void *buf, size_t len,
+                      struct McPkgBlock **out_p)
+{
+	return mcpkg_mp_ledger_block_unpack_arena(buf, len, NULL, out_p);
+}
 
-		if (found_ && ptr_ && pl_ == 32)
-			memcpy(p->prev, ptr_, 32);
-	}
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_ledger_block_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgBlock *p, int top)
+{
+	unsigned char seen_[7] = { 0 };
+	const void *bp_;
+	size_t n_, i_, pl_;
+	int mpret, key_;
 
-	/* sth */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 4, &ptr_, &pl_, &found_);
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
-
-		if (!found_ || !ptr_ || pl_ == 0) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 6 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
 		}
+		seen_[key_] = 1;
 
-		if (found_ && ptr_ && pl_ > 0) {
-			if (mcpkg_mp_ledger_sth_unpack(ptr_, pl_, &p->sth) != MCPKG_MP_NO_ERROR) {
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "ledger.block");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* height */
+			mpret = mcpkg_mp_cur_u64(c_, &p->height);
+			break;
+
+		case 3: /* prev */
+			if (mcpkg_mp_cur_nil(c_)) {
 				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_err;
+				break;
 			}
-		}
-	}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 32) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->prev, bp_, 32);
+			break;
+
+		case 4: /* sth */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			if (!mcpkg_mp_cur_is_bin(c_)) {
+				mpret = mcpkg_mp_ledger_sth_unpack_cur(c_, a,
+				        &p->sth);
+				break;
+			}
+			/* version 1: a whole record embedded as bin */
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR || pl_ == 0)
+				break;
+			if (mcpkg_mp_ledger_sth_unpack_arena(bp_, pl_, a,
+			        &p->sth) != MCPKG_MP_NO_ERROR)
+				mpret = MCPKG_MP_ERR_PARSE;
+			break;
 
-	/* mint_pub */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+		case 5: /* mint_pub */
+			if (mcpkg_mp_cur_nil(c_)) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 32) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->mint_pub, bp_, 32);
+			break;
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 5, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+		case 6: /* sig */
+			if (mcpkg_mp_cur_nil(c_)) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 64) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->sig, bp_, 64);
+			break;
 
-		if (!found_ || pl_ != 32) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
-
-		if (found_ && ptr_ && pl_ == 32)
-			memcpy(p->mint_pub, ptr_, 32);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
-	/* sig */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[2])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[3])
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->sth)
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[5])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[6])
+		return MCPKG_MP_ERR_PARSE;
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 6, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	return MCPKG_MP_NO_ERROR;
+}
 
-		if (!found_ || pl_ != 64) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_ledger_block_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgBlock **out_p, int top)
+{
+	struct McPkgBlock *p;
+	McPkgArenaMark mark_;
+	int mpret;
 
-		if (found_ && ptr_ && pl_ == 64)
-			memcpy(p->sig, ptr_, 64);
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_ledger_block_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_block_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_ledger_block_free(p);
+		return mpret;
 	}
 
-
 	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_ledger_block_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_ledger_block_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgBlock **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_block_decode_new(c, a, out_p, 0);
+}
+
+MCPKG_API int mcpkg_mp_ledger_block_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgBlock **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_ledger_block_decode_new(&c, a, out_p, 1);
 }
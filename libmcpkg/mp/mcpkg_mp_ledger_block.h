@@ -16,7 +16,7 @@
 MCPKG_BEGIN_DECLS
 
 #define MCPKG_MP_MP_LEDGER_BLOCK_TAG "ledger.block"
-#define MCPKG_MP_MP_LEDGER_BLOCK_VER 1
+#define MCPKG_MP_MP_LEDGER_BLOCK_VER 2
 
 struct McPkgSTH;
 
@@ -31,12 +31,54 @@ struct McPkgBlock {
 MCPKG_API struct McPkgBlock *mcpkg_mp_ledger_block_new(void);
 MCPKG_API void mcpkg_mp_ledger_block_free(struct McPkgBlock *p);
 
+/*
+ * Arena variants: with a non-NULL arena every allocation of the result
+ * (strings, lists, nested structs) comes from it; release it with
+ * mcpkg_arena_reset/free, never _free. A NULL arena means the heap.
+ */
+struct McPkgArena;
+MCPKG_API struct McPkgBlock *mcpkg_mp_ledger_block_new_arena(struct McPkgArena
+                *a);
+
 MCPKG_API int mcpkg_mp_ledger_block_pack(const struct McPkgBlock *p,
                 void **out_buf, size_t *out_len);
 
+/* Exact bytes _pack produces, computed without encoding (0 if p NULL). */
+MCPKG_API size_t mcpkg_mp_ledger_block_packed_size(const struct McPkgBlock *p);
+
+/*
+ * Write the record into buf[0, cap) without allocating. *out_len is its
+ * size; when that exceeds cap the result is MCPKG_MP_ERR_NO_MEMORY and
+ * buf holds nothing usable.
+ */
+MCPKG_API int mcpkg_mp_ledger_block_pack_into(const struct McPkgBlock *p,
+                void *buf, size_t cap, size_t *out_len);
+
+/* Same record appended to w, e.g. many records into one buffer. */
+struct McPkgMpWriter;
+MCPKG_API int mcpkg_mp_ledger_block_pack_append(const struct McPkgBlock *p,
+                struct McPkgMpWriter *w);
+
 MCPKG_API int mcpkg_mp_ledger_block_unpack(const void *buf, size_t len,
                 struct McPkgBlock **out_p);
 
+/* On error nothing is left allocated in a. */
+MCPKG_API int mcpkg_mp_ledger_block_unpack_arena(const void *buf,
+                size_t len, struct McPkgArena *a,
+                struct McPkgBlock **out_p);
+
+/*
+ * Nested form used inside other records: p as a headerless map written
+ * into / read from a stream already in progress.
+ */
+struct McPkgMpCur;
+MCPKG_API int mcpkg_mp_ledger_block_pack_w(const struct McPkgBlock *p,
+                struct McPkgMpWriter *w);
+MCPKG_API size_t mcpkg_mp_ledger_block_packed_size_w(const struct McPkgBlock *p);
+MCPKG_API int mcpkg_mp_ledger_block_unpack_cur(struct McPkgMpCur *c,
+                struct McPkgArena *a,
+                struct McPkgBlock **out_p);
+
 MCPKG_API char *mcpkg_mp_ledger_block_debug_str(const struct McPkgBlock *p);
 
 MCPKG_END_DECLS
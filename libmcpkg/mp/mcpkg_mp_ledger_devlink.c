@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 #include "mp/mcpkg_mp_ledger_devproof.h"
@@ -25,21 +27,29 @@ MCPKG_API struct McPkgDevLink *mcpkg_mp_ledger_devlink_new(void)
 {
 	struct McPkgDevLink *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgDevLink *mcpkg_mp_ledger_devlink_new_arena(struct
+                McPkgArena *a)
+{
+	if (!a)
+		return mcpkg_mp_ledger_devlink_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgDevLink));
+}
+
 MCPKG_API void mcpkg_mp_ledger_devlink_free(struct McPkgDevLink *p)
 {
 	if (!p)
 		return;
 
 	/* free provider */
-	free(p->provider);
+	mcpkg_free(p->provider);
 	p->provider = NULL;
 
 	/* free project_id */
-	free(p->project_id);
+	mcpkg_free(p->project_id);
 	p->project_id = NULL;
 
 	/* free dev_pub */
@@ -51,7 +61,7 @@ MCPKG_API void mcpkg_mp_ledger_devlink_free(struct McPkgDevLink *p)
 
 	/* free ts_ms */
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_ledger_devlink_debug_str(const struct McPkgDevLink *p)
@@ -110,225 +120,357 @@ MCPKG_API char *mcpkg_mp_ledger_devlink_debug_str(const struct McPkgDevLink *p)
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_ledger_devlink_pack(const struct McPkgDevLink *p,
-                void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_ledger_devlink_pack_map(const struct McPkgDevLink *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
-
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 7);
+	mpret = mcpkg_mp_map_begin(w, 5 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
-	mpret = mcpkg_mp_write_header(&w, "ledger.devlink", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "ledger.devlink", 2);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* provider */
 	if (p->provider)
-		mpret = mcpkg_mp_kv_str(&w, 2, p->provider);
+		mpret = mcpkg_mp_kv_str(w, 2, p->provider);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 2);
+		mpret = mcpkg_mp_kv_nil(w, 2);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* project_id */
 	if (p->project_id)
-		mpret = mcpkg_mp_kv_str(&w, 3, p->project_id);
+		mpret = mcpkg_mp_kv_str(w, 3, p->project_id);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 3);
+		mpret = mcpkg_mp_kv_nil(w, 3);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* dev_pub */
-	mpret = mcpkg_mp_kv_bin(&w, 4, p->dev_pub, 32);
+	mpret = mcpkg_mp_kv_bin(w, 4, p->dev_pub, 32);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* proof */
 	if (p->proof) {
-		void *b_ = NULL;
-		size_t bl_ = 0;
-
-		if (mcpkg_mp_ledger_devproof_pack(p->proof, &b_, &bl_) != MCPKG_MP_NO_ERROR) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_w;
-		}
-		mpret = mcpkg_mp_kv_bin(&w, 5, b_, (uint32_t)bl_);
-		free(b_);
+		mpret = mcpkg_mp_write_key(w, 5);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+		mpret = mcpkg_mp_ledger_devproof_pack_w(p->proof, w);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 	} else {
-		mpret = mcpkg_mp_kv_nil(&w, 5);
+		mpret = mcpkg_mp_kv_nil(w, 5);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 	}
 
 	/* ts_ms */
-	mpret = mcpkg_mp_kv_i64(&w, 6, p->ts_ms);
+	mpret = mcpkg_mp_kv_i64(w, 6, p->ts_ms);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
-
-MCPKG_API int mcpkg_mp_ledger_devlink_unpack(const void *buf, size_t len,
-                struct McPkgDevLink **out_p)
+MCPKG_API int mcpkg_mp_ledger_devlink_pack_w(const struct McPkgDevLink *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgDevLink *p = NULL;
-	int mpret, ver = 0;
-
-	if (!buf || !len || !out_p)
+	if (!p || !w)
 		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_devlink_pack_map(p, w, 0);
+}
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
+MCPKG_API int mcpkg_mp_ledger_devlink_pack_append(const struct McPkgDevLink *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_devlink_pack_map(p, w, 1);
+}
 
-	mpret = mcpkg_mp_expect_tag(&r, "ledger.devlink", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_ledger_devlink_size_map(const struct McPkgDevLink *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(5 + (top ? 2 : 0));
 
-	p = mcpkg_mp_ledger_devlink_new();
-	if (!p) {
-		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
-	}
+	if (top)
+		n += mcpkg_mp_size_header("ledger.devlink", 2);
 
 	/* provider */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_str(p->provider);
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 2, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* project_id */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_str(p->project_id);
 
-		if (found_ && ptr_) {
-			p->provider = malloc(pl_ + 1);
-			if (!p->provider) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->provider, ptr_, pl_);
-			p->provider[pl_] = '\0';
-		}
-		if (!found_ || !p->provider) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* dev_pub */
+	n += mcpkg_mp_size_int(4);
+	n += mcpkg_mp_size_bin(32);
 
-	/* project_id */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* proof */
+	n += mcpkg_mp_size_int(5);
+	n += p->proof ? mcpkg_mp_ledger_devproof_packed_size_w(p->proof) : 1;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 3, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* ts_ms */
+	n += mcpkg_mp_size_int(6);
+	n += mcpkg_mp_size_int(p->ts_ms);
 
-		if (found_ && ptr_) {
-			p->project_id = malloc(pl_ + 1);
-			if (!p->project_id) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->project_id, ptr_, pl_);
-			p->project_id[pl_] = '\0';
-		}
-		if (!found_ || !p->project_id) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	return n;
+}
 
-	/* dev_pub */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+MCPKG_API size_t mcpkg_mp_ledger_devlink_packed_size(const struct McPkgDevLink *p)
+{
+	return p ? mcpkg_mp_ledger_devlink_size_map(p, 1) : 0;
+}
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 4, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API size_t mcpkg_mp_ledger_devlink_packed_size_w(const struct McPkgDevLink *p)
+{
+	return p ? mcpkg_mp_ledger_devlink_size_map(p, 0) : 0;
+}
 
-		if (!found_ || pl_ != 32) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+MCPKG_API int mcpkg_mp_ledger_devlink_pack_into(const struct McPkgDevLink *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
+
+	if (!p || !out_len || (!buf && cap))
+		return MCPKG_MP_ERR_INVALID_ARG;
 
-		if (found_ && ptr_ && pl_ == 32)
-			memcpy(p->dev_pub, ptr_, 32);
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	mpret = mcpkg_mp_ledger_devlink_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
+		mpret = MCPKG_MP_ERR_NO_MEMORY;
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
+
+MCPKG_API int mcpkg_mp_ledger_devlink_pack(const struct McPkgDevLink *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
+
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_ledger_devlink_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_devlink_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
 	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-	/* proof */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 5, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_ledger_devlink_unpack(const void *buf, size_t len,
+                      struct McPkgDevLink **out_p)
+{
+	return mcpkg_mp_ledger_devlink_unpack_arena(buf, len, NULL, out_p);
+}
 
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_ledger_devlink_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgDevLink *p, int top)
+{
+	unsigned char seen_[7] = { 0 };
+	const char *sp_;
+	const void *bp_;
+	size_t n_, i_, pl_;
+	int mpret, key_;
+
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		if (found_ && ptr_ && pl_ > 0) {
-			if (mcpkg_mp_ledger_devproof_unpack(ptr_, pl_,
-			                                    &p->proof) != MCPKG_MP_NO_ERROR) {
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 6 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
+		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "ledger.devlink");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* provider */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->provider = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->provider)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 3: /* project_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->project_id = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->project_id)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 4: /* dev_pub */
+			if (mcpkg_mp_cur_nil(c_)) {
 				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_err;
+				break;
+			}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 32) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->dev_pub, bp_, 32);
+			break;
+
+		case 5: /* proof */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			if (!mcpkg_mp_cur_is_bin(c_)) {
+				mpret = mcpkg_mp_ledger_devproof_unpack_cur(c_, a,
+				        &p->proof);
+				break;
 			}
+			/* version 1: a whole record embedded as bin */
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR || pl_ == 0)
+				break;
+			if (mcpkg_mp_ledger_devproof_unpack_arena(bp_, pl_, a,
+			        &p->proof) != MCPKG_MP_NO_ERROR)
+				mpret = MCPKG_MP_ERR_PARSE;
+			break;
+
+		case 6: /* ts_ms */
+			mpret = mcpkg_mp_cur_i64(c_, &p->ts_ms);
+			break;
+
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
-	/* ts_ms */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->provider)
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->project_id)
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[4])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[6])
+		return MCPKG_MP_ERR_PARSE;
 
-		mpret = mcpkg_mp_get_u64(&r, 6, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	return MCPKG_MP_NO_ERROR;
+}
 
-		if (found_)
-			p->ts_ms = (int64_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_ledger_devlink_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgDevLink **out_p, int top)
+{
+	struct McPkgDevLink *p;
+	McPkgArenaMark mark_;
+	int mpret;
 
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_ledger_devlink_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_devlink_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_ledger_devlink_free(p);
+		return mpret;
+	}
 
 	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_ledger_devlink_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_ledger_devlink_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgDevLink **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_devlink_decode_new(c, a, out_p, 0);
+}
+
+MCPKG_API int mcpkg_mp_ledger_devlink_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgDevLink **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_ledger_devlink_decode_new(&c, a, out_p, 1);
 }
@@ -16,7 +16,7 @@
 MCPKG_BEGIN_DECLS
 
 #define MCPKG_MP_MP_LEDGER_DEVLINK_TAG "ledger.devlink"
-#define MCPKG_MP_MP_LEDGER_DEVLINK_VER 1
+#define MCPKG_MP_MP_LEDGER_DEVLINK_VER 2
 
 struct McPkgDevProof;
 
@@ -31,12 +31,54 @@ struct McPkgDevLink {
 MCPKG_API struct McPkgDevLink *mcpkg_mp_ledger_devlink_new(void);
 MCPKG_API void mcpkg_mp_ledger_devlink_free(struct McPkgDevLink *p);
 
+/*
+ * Arena variants: with a non-NULL arena every allocation of the result
+ * (strings, lists, nested structs) comes from it; release it with
+ * mcpkg_arena_reset/free, never _free. A NULL arena means the heap.
+ */
+struct McPkgArena;
+MCPKG_API struct McPkgDevLink *mcpkg_mp_ledger_devlink_new_arena(struct
+                McPkgArena *a);
+
 MCPKG_API int mcpkg_mp_ledger_devlink_pack(const struct McPkgDevLink *p,
                 void **out_buf, size_t *out_len);
 
+/* Exact bytes _pack produces, computed without encoding (0 if p NULL). */
+MCPKG_API size_t mcpkg_mp_ledger_devlink_packed_size(const struct McPkgDevLink *p);
+
+/*
+ * Write the record into buf[0, cap) without allocating. *out_len is its
+ * size; when that exceeds cap the result is MCPKG_MP_ERR_NO_MEMORY and
+ * buf holds nothing usable.
+ */
+MCPKG_API int mcpkg_mp_ledger_devlink_pack_into(const struct McPkgDevLink *p,
+                void *buf, size_t cap, size_t *out_len);
+
+/* Same record appended to w, e.g. many records into one buffer. */
+struct McPkgMpWriter;
+MCPKG_API int mcpkg_mp_ledger_devlink_pack_append(const struct McPkgDevLink *p,
+                struct McPkgMpWriter *w);
+
 MCPKG_API int mcpkg_mp_ledger_devlink_unpack(const void *buf, size_t len,
                 struct McPkgDevLink **out_p);
 
+/* On error nothing is left allocated in a. */
+MCPKG_API int mcpkg_mp_ledger_devlink_unpack_arena(const void *buf,
+                size_t len, struct McPkgArena *a,
+                struct McPkgDevLink **out_p);
+
+/*
+ * Nested form used inside other records: p as a headerless map written
+ * into / read from a stream already in progress.
+ */
+struct McPkgMpCur;
+MCPKG_API int mcpkg_mp_ledger_devlink_pack_w(const struct McPkgDevLink *p,
+                struct McPkgMpWriter *w);
+MCPKG_API size_t mcpkg_mp_ledger_devlink_packed_size_w(const struct McPkgDevLink *p);
+MCPKG_API int mcpkg_mp_ledger_devlink_unpack_cur(struct McPkgMpCur *c,
+                struct McPkgArena *a,
+                struct McPkgDevLink **out_p);
+
 MCPKG_API char *mcpkg_mp_ledger_devlink_debug_str(const struct McPkgDevLink *p);
 
 MCPKG_END_DECLS
@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 
@@ -24,10 +26,18 @@ MCPKG_API struct McPkgRevoke *mcpkg_mp_ledger_revoke_new(void)
 {
 	struct McPkgRevoke *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgRevoke *mcpkg_mp_ledger_revoke_new_arena(struct McPkgArena
+                *a)
+{
+	if (!a)
+		return mcpkg_mp_ledger_revoke_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgRevoke));
+}
+
 MCPKG_API void mcpkg_mp_ledger_revoke_free(struct McPkgRevoke *p)
 {
 	if (!p)
@@ -36,17 +46,17 @@ MCPKG_API void mcpkg_mp_ledger_revoke_free(struct McPkgRevoke *p)
 	/* free kind */
 	/* free target_hash */
 	/* free pkg_id */
-	free(p->pkg_id);
+	mcpkg_free(p->pkg_id);
 	p->pkg_id = NULL;
 
 	/* free version */
-	free(p->version);
+	mcpkg_free(p->version);
 	p->version = NULL;
 
 	/* free reason */
 	/* free ts_ms */
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_ledger_revoke_debug_str(const struct McPkgRevoke *p)
@@ -110,222 +120,345 @@ MCPKG_API char *mcpkg_mp_ledger_revoke_debug_str(const struct McPkgRevoke *p)
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_ledger_revoke_pack(const struct McPkgRevoke *p,
-                void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_ledger_revoke_pack_map(const struct McPkgRevoke *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
-
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 8);
+	mpret = mcpkg_mp_map_begin(w, 6 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
-	mpret = mcpkg_mp_write_header(&w, "ledger.revoke", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "ledger.revoke", 1);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* kind */
-	mpret = mcpkg_mp_kv_u32(&w, 2, p->kind);
+	mpret = mcpkg_mp_kv_u32(w, 2, p->kind);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* target_hash */
-	mpret = mcpkg_mp_kv_bin(&w, 3, p->target_hash, 32);
+	mpret = mcpkg_mp_kv_bin(w, 3, p->target_hash, 32);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* pkg_id */
 	if (p->pkg_id)
-		mpret = mcpkg_mp_kv_str(&w, 4, p->pkg_id);
+		mpret = mcpkg_mp_kv_str(w, 4, p->pkg_id);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 4);
+		mpret = mcpkg_mp_kv_nil(w, 4);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* version */
 	if (p->version)
-		mpret = mcpkg_mp_kv_str(&w, 5, p->version);
+		mpret = mcpkg_mp_kv_str(w, 5, p->version);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 5);
+		mpret = mcpkg_mp_kv_nil(w, 5);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* reason */
-	mpret = mcpkg_mp_kv_u32(&w, 6, p->reason);
+	mpret = mcpkg_mp_kv_u32(w, 6, p->reason);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* ts_ms */
-	mpret = mcpkg_mp_kv_i64(&w, 7, p->ts_ms);
+	mpret = mcpkg_mp_kv_i64(w, 7, p->ts_ms);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
+MCPKG_API int mcpkg_mp_ledger_revoke_pack_w(const struct McPkgRevoke *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_revoke_pack_map(p, w, 0);
+}
 
-MCPKG_API int mcpkg_mp_ledger_revoke_unpack(const void *buf, size_t len,
-                struct McPkgRevoke **out_p)
+MCPKG_API int mcpkg_mp_ledger_revoke_pack_append(const struct McPkgRevoke *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgRevoke *p = NULL;
-	int mpret, ver = 0;
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_revoke_pack_map(p, w, 1);
+}
 
-	if (!buf || !len || !out_p)
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_ledger_revoke_size_map(const struct McPkgRevoke *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(6 + (top ? 2 : 0));
+
+	if (top)
+		n += mcpkg_mp_size_header("ledger.revoke", 1);
+
+	/* kind */
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_int((int64_t)p->kind);
+
+	/* target_hash */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_bin(32);
+
+	/* pkg_id */
+	n += mcpkg_mp_size_int(4);
+	n += mcpkg_mp_size_str(p->pkg_id);
+
+	/* version */
+	n += mcpkg_mp_size_int(5);
+	n += mcpkg_mp_size_str(p->version);
+
+	/* reason */
+	n += mcpkg_mp_size_int(6);
+	n += mcpkg_mp_size_int((int64_t)p->reason);
+
+	/* ts_ms */
+	n += mcpkg_mp_size_int(7);
+	n += mcpkg_mp_size_int(p->ts_ms);
+
+	return n;
+}
+
+MCPKG_API size_t mcpkg_mp_ledger_revoke_packed_size(const struct McPkgRevoke *p)
+{
+	return p ? mcpkg_mp_ledger_revoke_size_map(p, 1) : 0;
+}
+
+MCPKG_API size_t mcpkg_mp_ledger_revoke_packed_size_w(const struct McPkgRevoke *p)
+{
+	return p ? mcpkg_mp_ledger_revoke_size_map(p, 0) : 0;
+}
+
+MCPKG_API int mcpkg_mp_ledger_revoke_pack_into(const struct McPkgRevoke *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
+
+	if (!p || !out_len || (!buf && cap))
 		return MCPKG_MP_ERR_INVALID_ARG;
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
 	if (mpret != MCPKG_MP_NO_ERROR)
 		return mpret;
 
-	mpret = mcpkg_mp_expect_tag(&r, "ledger.revoke", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
-
-	p = mcpkg_mp_ledger_revoke_new();
-	if (!p) {
+	mpret = mcpkg_mp_ledger_revoke_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
 		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
-	}
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
 
-	/* kind */
-	{
-		uint32_t val_ = 0;
-		int found_ = 0;
+MCPKG_API int mcpkg_mp_ledger_revoke_pack(const struct McPkgRevoke *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
 
-		mpret = mcpkg_mp_get_u32(&r, 2, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
 
-		if (found_)
-			p->kind = (int32_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_ledger_revoke_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
 
-	/* target_hash */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	mpret = mcpkg_mp_ledger_revoke_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
+	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 3, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
 
-		if (found_ && ptr_ && pl_ != 32) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+MCPKG_API int mcpkg_mp_ledger_revoke_unpack(const void *buf, size_t len,
+                      struct McPkgRevoke **out_p)
+{
+	return mcpkg_mp_ledger_revoke_unpack_arena(buf, len, NULL, out_p);
+}
 
-		if (found_ && ptr_ && pl_ == 32)
-			memcpy(p->target_hash, ptr_, 32);
-	}
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_ledger_revoke_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgRevoke *p, int top)
+{
+	unsigned char seen_[8] = { 0 };
+	const char *sp_;
+	const void *bp_;
+	size_t n_, i_, pl_;
+	int mpret, key_;
 
-	/* pkg_id */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 4, &ptr_, &pl_, &found_);
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
-
-		if (found_ && ptr_) {
-			p->pkg_id = malloc(pl_ + 1);
-			if (!p->pkg_id) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->pkg_id, ptr_, pl_);
-			p->pkg_id[pl_] = '\0';
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 7 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
 		}
-	}
+		seen_[key_] = 1;
 
-	/* version */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "ledger.revoke");
+			break;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 5, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 
-		if (found_ && ptr_) {
-			p->version = malloc(pl_ + 1);
-			if (!p->version) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
+		case 2: /* kind */
+			mpret = mcpkg_mp_cur_u32(c_, &p->kind);
+			break;
+
+		case 3: /* target_hash */
+			if (mcpkg_mp_cur_nil(c_)) {
+				break;
 			}
-			memcpy(p->version, ptr_, pl_);
-			p->version[pl_] = '\0';
-		}
-	}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 32) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->target_hash, bp_, 32);
+			break;
+
+		case 4: /* pkg_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->pkg_id = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->pkg_id)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 5: /* version */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->version = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->version)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
 
-	/* reason */
-	{
-		uint32_t val_ = 0;
-		int found_ = 0;
+		case 6: /* reason */
+			mpret = mcpkg_mp_cur_u32(c_, &p->reason);
+			break;
 
-		mpret = mcpkg_mp_get_u32(&r, 6, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+		case 7: /* ts_ms */
+			mpret = mcpkg_mp_cur_i64(c_, &p->ts_ms);
+			break;
 
-		if (found_)
-			p->reason = (int32_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
-	/* ts_ms */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[2])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[6])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[7])
+		return MCPKG_MP_ERR_PARSE;
 
-		mpret = mcpkg_mp_get_u64(&r, 7, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	return MCPKG_MP_NO_ERROR;
+}
 
-		if (found_)
-			p->ts_ms = (int64_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_ledger_revoke_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgRevoke **out_p, int top)
+{
+	struct McPkgRevoke *p;
+	McPkgArenaMark mark_;
+	int mpret;
 
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_ledger_revoke_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_revoke_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_ledger_revoke_free(p);
+		return mpret;
+	}
 
 	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_ledger_revoke_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_ledger_revoke_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgRevoke **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_revoke_decode_new(c, a, out_p, 0);
+}
+
+MCPKG_API int mcpkg_mp_ledger_revoke_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgRevoke **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_ledger_revoke_decode_new(&c, a, out_p, 1);
 }
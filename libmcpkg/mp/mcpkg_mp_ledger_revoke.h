@@ -31,12 +31,54 @@ struct McPkgRevoke {
 MCPKG_API struct McPkgRevoke *mcpkg_mp_ledger_revoke_new(void);
 MCPKG_API void mcpkg_mp_ledger_revoke_free(struct McPkgRevoke *p);
 
+/*
+ * Arena variants: with a non-NULL arena every allocation of the result
+ * (strings, lists, nested structs) comes from it; release it with
+ * mcpkg_arena_reset/free, never _free. A NULL arena means the heap.
+ */
+struct McPkgArena;
+MCPKG_API struct McPkgRevoke *mcpkg_mp_ledger_revoke_new_arena(struct McPkgArena
+                *a);
+
 MCPKG_API int mcpkg_mp_ledger_revoke_pack(const struct McPkgRevoke *p,
                 void **out_buf, size_t *out_len);
 
+/* Exact bytes _pack produces, computed without encoding (0 if p NULL). */
+MCPKG_API size_t mcpkg_mp_ledger_revoke_packed_size(const struct McPkgRevoke *p);
+
+/*
+ * Write the record into buf[0, cap) without allocating. *out_len is its
+ * size; when that exceeds cap the result is MCPKG_MP_ERR_NO_MEMORY and
+ * buf holds nothing usable.
+ */
+MCPKG_API int mcpkg_mp_ledger_revoke_pack_into(const struct McPkgRevoke *p,
+                void *buf, size_t cap, size_t *out_len);
+
+/* Same record appended to w, e.g. many records into one buffer. */
+struct McPkgMpWriter;
+MCPKG_API int mcpkg_mp_ledger_revoke_pack_append(const struct McPkgRevoke *p,
+                struct McPkgMpWriter *w);
+
 MCPKG_API int mcpkg_mp_ledger_revoke_unpack(const void *buf, size_t len,
                 struct McPkgRevoke **out_p);
 
+/* On error nothing is left allocated in a. */
+MCPKG_API int mcpkg_mp_ledger_revoke_unpack_arena(const void *buf,
+                size_t len, struct McPkgArena *a,
+                struct McPkgRevoke **out_p);
+
+/*
+ * Nested form used inside other records: p as a headerless map written
+ * into / read from a stream already in progress.
+ */
+struct McPkgMpCur;
+MCPKG_API int mcpkg_mp_ledger_revoke_pack_w(const struct McPkgRevoke *p,
+                struct McPkgMpWriter *w);
+MCPKG_API size_t mcpkg_mp_ledger_revoke_packed_size_w(const struct McPkgRevoke *p);
+MCPKG_API int mcpkg_mp_ledger_revoke_unpack_cur(struct McPkgMpCur *c,
+                struct McPkgArena *a,
+                struct McPkgRevoke **out_p);
+
 MCPKG_API char *mcpkg_mp_ledger_revoke_debug_str(const struct McPkgRevoke *p);
 
 MCPKG_END_DECLS
@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 
@@ -24,10 +26,17 @@ MCPKG_API struct McPkgSTH *mcpkg_mp_ledger_sth_new(void)
 {
 	struct McPkgSTH *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgSTH *mcpkg_mp_ledger_sth_new_arena(struct McPkgArena *a)
+{
+	if (!a)
+		return mcpkg_mp_ledger_sth_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgSTH));
+}
+
 MCPKG_API void mcpkg_mp_ledger_sth_free(struct McPkgSTH *p)
 {
 	if (!p)
@@ -39,7 +48,7 @@ MCPKG_API void mcpkg_mp_ledger_sth_free(struct McPkgSTH *p)
 	/* free first */
 	/* free last */
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_ledger_sth_debug_str(const struct McPkgSTH *p)
@@ -96,190 +105,321 @@ MCPKG_API char *mcpkg_mp_ledger_sth_debug_str(const struct McPkgSTH *p)
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_ledger_sth_pack(const struct McPkgSTH *p,
-                                       void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_ledger_sth_pack_map(const struct McPkgSTH *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
+	mpret = mcpkg_mp_map_begin(w, 5 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
+		goto out;
 
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 7);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
-
-	mpret = mcpkg_mp_write_header(&w, "ledger.sth", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "ledger.sth", 1);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* size */
 	/* encode u64 as i64 (non-negative) via util */
-	mpret = mcpkg_mp_kv_i64(&w, 2, (int64_t)p->size);
+	mpret = mcpkg_mp_kv_i64(w, 2, (int64_t)p->size);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* root */
-	mpret = mcpkg_mp_kv_bin(&w, 3, p->root, 32);
+	mpret = mcpkg_mp_kv_bin(w, 3, p->root, 32);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* ts_ms */
 	/* encode u64 as i64 (non-negative) via util */
-	mpret = mcpkg_mp_kv_i64(&w, 4, (int64_t)p->ts_ms);
+	mpret = mcpkg_mp_kv_i64(w, 4, (int64_t)p->ts_ms);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* first */
 	/* encode u64 as i64 (non-negative) via util */
-	mpret = mcpkg_mp_kv_i64(&w, 5, (int64_t)p->first);
+	mpret = mcpkg_mp_kv_i64(w, 5, (int64_t)p->first);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* last */
 	/* encode u64 as i64 (non-negative) via util */
-	mpret = mcpkg_mp_kv_i64(&w, 6, (int64_t)p->last);
+	mpret = mcpkg_mp_kv_i64(w, 6, (int64_t)p->last);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
-
-MCPKG_API int mcpkg_mp_ledger_sth_unpack(const void *buf, size_t len,
-                struct McPkgSTH **out_p)
+MCPKG_API int mcpkg_mp_ledger_sth_pack_w(const struct McPkgSTH *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgSTH *p = NULL;
-	int mpret, ver = 0;
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_sth_pack_map(p, w, 0);
+}
 
-	if (!buf || !len || !out_p)
+MCPKG_API int mcpkg_mp_ledger_sth_pack_append(const struct McPkgSTH *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
 		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_sth_pack_map(p, w, 1);
+}
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_ledger_sth_size_map(const struct McPkgSTH *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(5 + (top ? 2 : 0));
 
-	mpret = mcpkg_mp_expect_tag(&r, "ledger.sth", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
-
-	p = mcpkg_mp_ledger_sth_new();
-	if (!p) {
-		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
-	}
+	if (top)
+		n += mcpkg_mp_size_header("ledger.sth", 1);
 
 	/* size */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_int((int64_t)p->size);
 
-		mpret = mcpkg_mp_get_u64(&r, 2, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* root */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_bin(32);
 
-		if (found_)
-			p->size = (int64_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* ts_ms */
+	n += mcpkg_mp_size_int(4);
+	n += mcpkg_mp_size_int((int64_t)p->ts_ms);
 
-	/* root */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* first */
+	n += mcpkg_mp_size_int(5);
+	n += mcpkg_mp_size_int((int64_t)p->first);
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 3, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* last */
+	n += mcpkg_mp_size_int(6);
+	n += mcpkg_mp_size_int((int64_t)p->last);
 
-		if (!found_ || pl_ != 32) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+	return n;
+}
 
-		if (found_ && ptr_ && pl_ == 32)
-			memcpy(p->root, ptr_, 32);
-	}
+MCPKG_API size_t mcpkg_mp_ledger_sth_packed_size(const struct McPkgSTH *p)
+{
+	return p ? mcpkg_mp_ledger_sth_size_map(p, 1) : 0;
+}
 
-	/* ts_ms */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
+MCPKG_API size_t mcpkg_mp_ledger_sth_packed_size_w(const struct McPkgSTH *p)
+{
+	return p ? mcpkg_mp_ledger_sth_size_map(p, 0) : 0;
+}
 
-		mpret = mcpkg_mp_get_u64(&r, 4, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_ledger_sth_pack_into(const struct McPkgSTH *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
 
-		if (found_)
-			p->ts_ms = (int64_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	if (!p || !out_len || (!buf && cap))
+		return MCPKG_MP_ERR_INVALID_ARG;
 
-	/* first */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		mpret = mcpkg_mp_get_u64(&r, 5, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	mpret = mcpkg_mp_ledger_sth_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
+		mpret = MCPKG_MP_ERR_NO_MEMORY;
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
 
-		if (found_)
-			p->first = (int64_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+MCPKG_API int mcpkg_mp_ledger_sth_pack(const struct McPkgSTH *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
+
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_ledger_sth_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_sth_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
 	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-	/* last */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
 
-		mpret = mcpkg_mp_get_u64(&r, 6, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_ledger_sth_unpack(const void *buf, size_t len,
+                      struct McPkgSTH **out_p)
+{
+	return mcpkg_mp_ledger_sth_unpack_arena(buf, len, NULL, out_p);
+}
+
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_ledger_sth_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgSTH *p, int top)
+{
+	unsigned char seen_[7] = { 0 };
+	const void *bp_;
+	size_t n_, i_, pl_;
+	int mpret, key_;
+
+	(void)a;        /* nothing here allocates */
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		if (found_)
-			p->last = (int64_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 6 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
+		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "ledger.sth");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* size */
+			mpret = mcpkg_mp_cur_u64(c_, &p->size);
+			break;
+
+		case 3: /* root */
+			if (mcpkg_mp_cur_nil(c_)) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			if (pl_ != 32) {
+				mpret = MCPKG_MP_ERR_PARSE;
+				break;
+			}
+			memcpy(p->root, bp_, 32);
+			break;
+
+		case 4: /* ts_ms */
+			mpret = mcpkg_mp_cur_u64(c_, &p->ts_ms);
+			break;
+
+		case 5: /* first */
+			mpret = mcpkg_mp_cur_u64(c_, &p->first);
+			break;
+
+		case 6: /* last */
+			mpret = mcpkg_mp_cur_u64(c_, &p->last);
+			break;
+
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[2])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[3])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[4])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[5])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[6])
+		return MCPKG_MP_ERR_PARSE;
+
+	return MCPKG_MP_NO_ERROR;
+}
+
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_ledger_sth_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgSTH **out_p, int top)
+{
+	struct McPkgSTH *p;
+	McPkgArenaMark mark_;
+	int mpret;
+
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_ledger_sth_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_ledger_sth_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_ledger_sth_free(p);
+		return mpret;
+	}
 
 	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_ledger_sth_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_ledger_sth_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgSTH **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_ledger_sth_decode_new(c, a, out_p, 0);
+}
+
+MCPKG_API int mcpkg_mp_ledger_sth_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgSTH **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_ledger_sth_decode_new(&c, a, out_p, 1);
 }
@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include "mcpkg_export.h"
+#include "mp/mcpkg_mp_util.h"
 
 
 MCPKG_BEGIN_DECLS
@@ -29,12 +30,72 @@ struct McPkgDepends {
 MCPKG_API struct McPkgDepends *mcpkg_mp_pkg_depends_new(void);
 MCPKG_API void mcpkg_mp_pkg_depends_free(struct McPkgDepends *p);
 
+/*
+ * Arena variants: with a non-NULL arena every allocation of the result
+ * (strings, lists, nested structs) comes from it; release it with
+ * mcpkg_arena_reset/free, never _free. A NULL arena means the heap.
+ */
+struct McPkgArena;
+MCPKG_API struct McPkgDepends *mcpkg_mp_pkg_depends_new_arena(struct McPkgArena
+                *a);
+
 MCPKG_API int mcpkg_mp_pkg_depends_pack(const struct McPkgDepends *p,
                                         void **out_buf, size_t *out_len);
 
+/* Exact bytes _pack produces, computed without encoding (0 if p NULL). */
+MCPKG_API size_t mcpkg_mp_pkg_depends_packed_size(const struct McPkgDepends *p);
+
+/*
+ * Write the record into buf[0, cap) without allocating. *out_len is its
+ * size; when that exceeds cap the result is MCPKG_MP_ERR_NO_MEMORY and
+ * buf holds nothing usable.
+ */
+MCPKG_API int mcpkg_mp_pkg_depends_pack_into(const struct McPkgDepends *p,
+                void *buf, size_t cap, size_t *out_len);
+
+/* Same record appended to w, e.g. many records into one buffer. */
+struct McPkgMpWriter;
+MCPKG_API int mcpkg_mp_pkg_depends_pack_append(const struct McPkgDepends *p,
+                struct McPkgMpWriter *w);
+
 MCPKG_API int mcpkg_mp_pkg_depends_unpack(const void *buf, size_t len,
                 struct McPkgDepends **out_p);
 
+/* On error nothing is left allocated in a. */
+MCPKG_API int mcpkg_mp_pkg_depends_unpack_arena(const void *buf,
+                size_t len, struct McPkgArena *a,
+                struct McPkgDepends **out_p);
+
+/*
+ * Nested form used inside other records: p as a headerless map written
+ * into / read from a stream already in progress.
+ */
+struct McPkgMpCur;
+MCPKG_API int mcpkg_mp_pkg_depends_pack_w(const struct McPkgDepends *p,
+                struct McPkgMpWriter *w);
+MCPKG_API size_t mcpkg_mp_pkg_depends_packed_size_w(const struct McPkgDepends *p);
+MCPKG_API int mcpkg_mp_pkg_depends_unpack_cur(struct McPkgMpCur *c,
+                struct McPkgArena *a,
+                struct McPkgDepends **out_p);
+
+/*
+ * Borrowed view: decoding allocates nothing. Strings point into buf,
+ * lists and nested records stay encoded as spans (McPkgMpSpan); all of
+ * it is valid while buf lives. Validation matches _unpack.
+ */
+struct McPkgDependsView {
+	struct McPkgMpStr	id;
+	struct McPkgMpStr	version_range;
+	uint32_t		kind;
+	int32_t			side;
+};
+
+MCPKG_API int mcpkg_mp_pkg_depends_view(const void *buf, size_t len,
+                struct McPkgDependsView *out);
+/* Nested form: the next value of c (inline map or version 1 bin). */
+MCPKG_API int mcpkg_mp_pkg_depends_view_cur(struct McPkgMpCur *c,
+                struct McPkgDependsView *out);
+
 MCPKG_API char *mcpkg_mp_pkg_depends_debug_str(const struct McPkgDepends *p);
 
 MCPKG_END_DECLS
@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 
@@ -24,10 +26,18 @@ MCPKG_API struct McPkgDigest *mcpkg_mp_pkg_digest_new(void)
 {
 	struct McPkgDigest *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgDigest *mcpkg_mp_pkg_digest_new_arena(struct McPkgArena
+                *a)
+{
+	if (!a)
+		return mcpkg_mp_pkg_digest_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgDigest));
+}
+
 MCPKG_API void mcpkg_mp_pkg_digest_free(struct McPkgDigest *p)
 {
 	if (!p)
@@ -35,11 +45,11 @@ MCPKG_API void mcpkg_mp_pkg_digest_free(struct McPkgDigest *p)
 
 	/* free algo */
 	/* free hex */
-	free(p->hex);
+	mcpkg_free(p->hex);
 	p->hex = NULL;
 
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_pkg_digest_debug_str(const struct McPkgDigest *p)
@@ -72,129 +82,367 @@ MCPKG_API char *mcpkg_mp_pkg_digest_debug_str(const struct McPkgDigest *p)
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_pkg_digest_pack(const struct McPkgDigest *p,
-                                       void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_pkg_digest_pack_map(const struct McPkgDigest *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
-
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 4);
+	mpret = mcpkg_mp_map_begin(w, 2 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
-	mpret = mcpkg_mp_write_header(&w, "pkg.digest", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "pkg.digest", 1);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* algo */
-	mpret = mcpkg_mp_kv_u32(&w, 2, p->algo);
+	mpret = mcpkg_mp_kv_u32(w, 2, p->algo);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* hex */
 	if (p->hex)
-		mpret = mcpkg_mp_kv_str(&w, 3, p->hex);
+		mpret = mcpkg_mp_kv_str(w, 3, p->hex);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 3);
+		mpret = mcpkg_mp_kv_nil(w, 3);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
+MCPKG_API int mcpkg_mp_pkg_digest_pack_w(const struct McPkgDigest *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_digest_pack_map(p, w, 0);
+}
 
-MCPKG_API int mcpkg_mp_pkg_digest_unpack(const void *buf, size_t len,
-                struct McPkgDigest **out_p)
+MCPKG_API int mcpkg_mp_pkg_digest_pack_append(const struct McPkgDigest *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgDigest *p = NULL;
-	int mpret, ver = 0;
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_digest_pack_map(p, w, 1);
+}
 
-	if (!buf || !len || !out_p)
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_pkg_digest_size_map(const struct McPkgDigest *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(2 + (top ? 2 : 0));
+
+	if (top)
+		n += mcpkg_mp_size_header("pkg.digest", 1);
+
+	/* algo */
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_int((int64_t)p->algo);
+
+	/* hex */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_str(p->hex);
+
+	return n;
+}
+
+MCPKG_API size_t mcpkg_mp_pkg_digest_packed_size(const struct McPkgDigest *p)
+{
+	return p ? mcpkg_mp_pkg_digest_size_map(p, 1) : 0;
+}
+
+MCPKG_API size_t mcpkg_mp_pkg_digest_packed_size_w(const struct McPkgDigest *p)
+{
+	return p ? mcpkg_mp_pkg_digest_size_map(p, 0) : 0;
+}
+
+MCPKG_API int mcpkg_mp_pkg_digest_pack_into(const struct McPkgDigest *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
+
+	if (!p || !out_len || (!buf && cap))
 		return MCPKG_MP_ERR_INVALID_ARG;
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
 	if (mpret != MCPKG_MP_NO_ERROR)
 		return mpret;
 
-	mpret = mcpkg_mp_expect_tag(&r, "pkg.digest", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
-
-	p = mcpkg_mp_pkg_digest_new();
-	if (!p) {
+	mpret = mcpkg_mp_pkg_digest_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
 		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
+
+MCPKG_API int mcpkg_mp_pkg_digest_pack(const struct McPkgDigest *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
+
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_pkg_digest_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_pkg_digest_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
 	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-	/* algo */
-	{
-		uint32_t val_ = 0;
-		int found_ = 0;
 
-		mpret = mcpkg_mp_get_u32(&r, 2, &val_, &found_);
+MCPKG_API int mcpkg_mp_pkg_digest_unpack(const void *buf, size_t len,
+                      struct McPkgDigest **out_p)
+{
+	return mcpkg_mp_pkg_digest_unpack_arena(buf, len, NULL, out_p);
+}
+
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_pkg_digest_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgDigest *p, int top)
+{
+	unsigned char seen_[4] = { 0 };
+	const char *sp_;
+	size_t n_, i_, pl_;
+	int mpret, key_;
+
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 3 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
+		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "pkg.digest");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* algo */
+			mpret = mcpkg_mp_cur_u32(c_, &p->algo);
+			break;
+
+		case 3: /* hex */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->hex = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->hex)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
 
-		if (found_)
-			p->algo = (int32_t)val_;
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
-	/* hex */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[2])
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->hex)
+		return MCPKG_MP_ERR_PARSE;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 3, &ptr_, &pl_, &found_);
+	return MCPKG_MP_NO_ERROR;
+}
+
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_pkg_digest_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgDigest **out_p, int top)
+{
+	struct McPkgDigest *p;
+	McPkgArenaMark mark_;
+	int mpret;
+
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_pkg_digest_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_pkg_digest_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_pkg_digest_free(p);
+		return mpret;
+	}
+
+	*out_p = p;
+	return MCPKG_MP_NO_ERROR;
+}
+
+MCPKG_API int mcpkg_mp_pkg_digest_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgDigest **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_digest_decode_new(c, a, out_p, 0);
+}
+
+MCPKG_API int mcpkg_mp_pkg_digest_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgDigest **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_pkg_digest_decode_new(&c, a, out_p, 1);
+}
+
+/*
+ * View decode: same walk as _decode, but strings are borrowed and
+ * lists/nested records are kept as spans, so nothing is allocated.
+ */
+static int mcpkg_mp_pkg_digest_view_decode(struct McPkgMpCur *c_,
+                      struct McPkgDigestView *v, int top)
+{
+	unsigned char seen_[4] = { 0 };
+	size_t n_, i_;
+	int mpret, key_;
+
+	memset(v, 0, sizeof(*v));
+	if (!top && mcpkg_mp_cur_is_bin(c_)) {
+		/* version 1: a whole record embedded as bin */
+		struct McPkgMpCur sub_;
+		const void *rp_;
+		size_t rl_;
+
+		mpret = mcpkg_mp_cur_bin(c_, &rp_, &rl_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+			return mpret;
+		mcpkg_mp_cur_init(&sub_, rp_, rl_);
+		return mcpkg_mp_pkg_digest_view_decode(&sub_, v, 1);
+	}
 
-		if (found_ && ptr_) {
-			p->hex = malloc(pl_ + 1);
-			if (!p->hex) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->hex, ptr_, pl_);
-			p->hex[pl_] = '\0';
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 3 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
 		}
-		if (!found_ || !p->hex) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "pkg.digest");
+			break;
+
+		case 2: /* algo */
+			mpret = mcpkg_mp_cur_u32(c_, &v->algo);
+			break;
+
+		case 3: /* hex */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->hex.p, &v->hex.len);
+			break;
+
+		default:
+			/* the version too: nested values say their own layout */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[2])
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->hex.p)
+		return MCPKG_MP_ERR_PARSE;
 
-	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_pkg_digest_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_pkg_digest_view(const void *buf, size_t len,
+                      struct McPkgDigestView *out)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_pkg_digest_view_decode(&c, out, 1);
+}
+
+MCPKG_API int mcpkg_mp_pkg_digest_view_cur(struct McPkgMpCur *c,
+                      struct McPkgDigestView *out)
+{
+	if (!c || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_digest_view_decode(c, out, 0);
 }
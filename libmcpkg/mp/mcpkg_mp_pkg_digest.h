@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include "mcpkg_export.h"
+#include "mp/mcpkg_mp_util.h"
 
 
 MCPKG_BEGIN_DECLS
@@ -27,12 +28,70 @@ struct McPkgDigest {
 MCPKG_API struct McPkgDigest *mcpkg_mp_pkg_digest_new(void);
 MCPKG_API void mcpkg_mp_pkg_digest_free(struct McPkgDigest *p);
 
+/*
+ * Arena variants: with a non-NULL arena every allocation of the result
+ * (strings, lists, nested structs) comes from it; release it with
+ * mcpkg_arena_reset/free, never _free. A NULL arena means the heap.
+ */
+struct McPkgArena;
+MCPKG_API struct McPkgDigest *mcpkg_mp_pkg_digest_new_arena(struct McPkgArena
+                *a);
+
 MCPKG_API int mcpkg_mp_pkg_digest_pack(const struct McPkgDigest *p,
                                        void **out_buf, size_t *out_len);
 
+/* Exact bytes _pack produces, computed without encoding (0 if p NULL). */
+MCPKG_API size_t mcpkg_mp_pkg_digest_packed_size(const struct McPkgDigest *p);
+
+/*
+ * Write the record into buf[0, cap) without allocating. *out_len is its
+ * size; when that exceeds cap the result is MCPKG_MP_ERR_NO_MEMORY and
+ * buf holds nothing usable.
+ */
+MCPKG_API int mcpkg_mp_pkg_digest_pack_into(const struct McPkgDigest *p,
+                void *buf, size_t cap, size_t *out_len);
+
+/* Same record appended to w, e.g. many records into one buffer. */
+struct McPkgMpWriter;
+MCPKG_API int mcpkg_mp_pkg_digest_pack_append(const struct McPkgDigest *p,
+                struct McPkgMpWriter *w);
+
 MCPKG_API int mcpkg_mp_pkg_digest_unpack(const void *buf, size_t len,
                 struct McPkgDigest **out_p);
 
+/* On error nothing is left allocated in a. */
+MCPKG_API int mcpkg_mp_pkg_digest_unpack_arena(const void *buf,
+                size_t len, struct McPkgArena *a,
+                struct McPkgDigest **out_p);
+
+/*
+ * Nested form used inside other records: p as a headerless map written
+ * into / read from a stream already in progress.
+ */
+struct McPkgMpCur;
+MCPKG_API int mcpkg_mp_pkg_digest_pack_w(const struct McPkgDigest *p,
+                struct McPkgMpWriter *w);
+MCPKG_API size_t mcpkg_mp_pkg_digest_packed_size_w(const struct McPkgDigest *p);
+MCPKG_API int mcpkg_mp_pkg_digest_unpack_cur(struct McPkgMpCur *c,
+                struct McPkgArena *a,
+                struct McPkgDigest **out_p);
+
+/*
+ * Borrowed view: decoding allocates nothing. Strings point into buf,
+ * lists and nested records stay encoded as spans (McPkgMpSpan); all of
+ * it is valid while buf lives. Validation matches _unpack.
+ */
+struct McPkgDigestView {
+	uint32_t		algo;
+	struct McPkgMpStr	hex;
+};
+
+MCPKG_API int mcpkg_mp_pkg_digest_view(const void *buf, size_t len,
+                struct McPkgDigestView *out);
+/* Nested form: the next value of c (inline map or version 1 bin). */
+MCPKG_API int mcpkg_mp_pkg_digest_view_cur(struct McPkgMpCur *c,
+                struct McPkgDigestView *out);
+
 MCPKG_API char *mcpkg_mp_pkg_digest_debug_str(const struct McPkgDigest *p);
 
 MCPKG_END_DECLS
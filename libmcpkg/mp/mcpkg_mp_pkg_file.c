@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 #include "mp/mcpkg_mp_pkg_digest.h"
@@ -25,21 +27,28 @@ MCPKG_API struct McPkgFile *mcpkg_mp_pkg_file_new(void)
 {
 	struct McPkgFile *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgFile *mcpkg_mp_pkg_file_new_arena(struct McPkgArena *a)
+{
+	if (!a)
+		return mcpkg_mp_pkg_file_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgFile));
+}
+
 MCPKG_API void mcpkg_mp_pkg_file_free(struct McPkgFile *p)
 {
 	if (!p)
 		return;
 
 	/* free url */
-	free(p->url);
+	mcpkg_free(p->url);
 	p->url = NULL;
 
 	/* free file_name */
-	free(p->file_name);
+	mcpkg_free(p->file_name);
 	p->file_name = NULL;
 
 	/* free size */
@@ -57,7 +66,7 @@ MCPKG_API void mcpkg_mp_pkg_file_free(struct McPkgFile *p)
 	}
 
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_pkg_file_debug_str(const struct McPkgFile *p)
@@ -101,239 +110,485 @@ MCPKG_API char *mcpkg_mp_pkg_file_debug_str(const struct McPkgFile *p)
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_pkg_file_pack(const struct McPkgFile *p,
-                                     void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_pkg_file_pack_map(const struct McPkgFile *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
+	mpret = mcpkg_mp_map_begin(w, 4 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
+		goto out;
 
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 6);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
-
-	mpret = mcpkg_mp_write_header(&w, "pkg.file", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "pkg.file", 2);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* url */
 	if (p->url)
-		mpret = mcpkg_mp_kv_str(&w, 2, p->url);
+		mpret = mcpkg_mp_kv_str(w, 2, p->url);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 2);
+		mpret = mcpkg_mp_kv_nil(w, 2);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* file_name */
 	if (p->file_name)
-		mpret = mcpkg_mp_kv_str(&w, 3, p->file_name);
+		mpret = mcpkg_mp_kv_str(w, 3, p->file_name);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 3);
+		mpret = mcpkg_mp_kv_nil(w, 3);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* size */
 	/* encode u64 as i64 (non-negative) via util */
-	mpret = mcpkg_mp_kv_i64(&w, 4, (int64_t)p->size);
+	mpret = mcpkg_mp_kv_i64(w, 4, (int64_t)p->size);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* digests */
 	{
 		size_t i_, n_ = p->digests ? mcpkg_list_size(p->digests) : 0;
 
-		mpret = mcpkg_mp_kv_array_begin(&w, 5, (uint32_t)n_);
+		mpret = mcpkg_mp_kv_array_begin(w, 5, (uint32_t)n_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 
 		for (i_ = 0; i_ < n_; i_++) {
 			struct McPkgDigest *elt_ = NULL;
-			void *b_ = NULL;
-			size_t bl_ = 0;
 
 			if (mcpkg_list_at(p->digests, i_, &elt_) != MCPKG_CONTAINER_OK || !elt_) {
 				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_w;
+				goto out;
 			}
-			if (mcpkg_mp_pkg_digest_pack(elt_, &b_, &bl_) != MCPKG_MP_NO_ERROR) {
-				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_w;
-			}
-			mpret = mcpkg_mp_write_bin(&w, b_, (uint32_t)bl_);
-			free(b_);
+			mpret = mcpkg_mp_pkg_digest_pack_w(elt_, w);
 			if (mpret != MCPKG_MP_NO_ERROR)
-				goto out_w;
+				goto out;
 		}
 	}
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
-
-MCPKG_API int mcpkg_mp_pkg_file_unpack(const void *buf, size_t len,
-                                       struct McPkgFile **out_p)
+MCPKG_API int mcpkg_mp_pkg_file_pack_w(const struct McPkgFile *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgFile *p = NULL;
-	int mpret, ver = 0;
-
-	if (!buf || !len || !out_p)
+	if (!p || !w)
 		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_file_pack_map(p, w, 0);
+}
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
+MCPKG_API int mcpkg_mp_pkg_file_pack_append(const struct McPkgFile *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_file_pack_map(p, w, 1);
+}
 
-	mpret = mcpkg_mp_expect_tag(&r, "pkg.file", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_pkg_file_size_map(const struct McPkgFile *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(4 + (top ? 2 : 0));
 
-	p = mcpkg_mp_pkg_file_new();
-	if (!p) {
-		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
-	}
+	if (top)
+		n += mcpkg_mp_size_header("pkg.file", 2);
 
 	/* url */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_str(p->url);
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 2, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* file_name */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_str(p->file_name);
 
-		if (found_ && ptr_) {
-			p->url = malloc(pl_ + 1);
-			if (!p->url) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->url, ptr_, pl_);
-			p->url[pl_] = '\0';
-		}
-		if (!found_ || !p->url) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* size */
+	n += mcpkg_mp_size_int(4);
+	n += mcpkg_mp_size_int((int64_t)p->size);
 
-	/* file_name */
+	/* digests */
+	n += mcpkg_mp_size_int(5);
 	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+		size_t i_, n_ = p->digests ? mcpkg_list_size(p->digests) : 0;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 3, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+		n += mcpkg_mp_size_container(n_);
+		for (i_ = 0; i_ < n_; i_++) {
+			struct McPkgDigest *elt_ = NULL;
 
-		if (found_ && ptr_) {
-			p->file_name = malloc(pl_ + 1);
-			if (!p->file_name) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->file_name, ptr_, pl_);
-			p->file_name[pl_] = '\0';
-		}
-		if (!found_ || !p->file_name) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+			if (mcpkg_list_at(p->digests, i_, &elt_) == MCPKG_CONTAINER_OK && elt_)
+				n += mcpkg_mp_pkg_digest_packed_size_w(elt_);
 		}
 	}
 
-	/* size */
-	{
-		uint64_t val_ = 0;
-		int found_ = 0;
+	return n;
+}
 
-		mpret = mcpkg_mp_get_u64(&r, 4, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API size_t mcpkg_mp_pkg_file_packed_size(const struct McPkgFile *p)
+{
+	return p ? mcpkg_mp_pkg_file_size_map(p, 1) : 0;
+}
+
+MCPKG_API size_t mcpkg_mp_pkg_file_packed_size_w(const struct McPkgFile *p)
+{
+	return p ? mcpkg_mp_pkg_file_size_map(p, 0) : 0;
+}
 
-		if (found_)
-			p->size = (int64_t)val_;
+MCPKG_API int mcpkg_mp_pkg_file_pack_into(const struct McPkgFile *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
+
+	if (!p || !out_len || (!buf && cap))
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	mpret = mcpkg_mp_pkg_file_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
+		mpret = MCPKG_MP_ERR_NO_MEMORY;
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
+
+MCPKG_API int mcpkg_mp_pkg_file_pack(const struct McPkgFile *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
+
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_pkg_file_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_pkg_file_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
 	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-	/* digests */
-	{
-		struct McPkgMpArrayCur *cur_ = NULL;
-		size_t n_ = 0;
-		size_t i_;
-		int found_ = 0;
 
-		mpret = mcpkg_mp_get_array_cur(&r, 5, &cur_, &n_, &found_);
+MCPKG_API int mcpkg_mp_pkg_file_unpack(const void *buf, size_t len,
+                      struct McPkgFile **out_p)
+{
+	return mcpkg_mp_pkg_file_unpack_arena(buf, len, NULL, out_p);
+}
+
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_pkg_file_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgFile *p, int top)
+{
+	unsigned char seen_[6] = { 0 };
+	const char *sp_;
+	const void *bp_;
+	size_t n_, i_, pl_, ln_, j_;
+	int mpret, key_;
+
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+			return mpret;
 
-		if (!found_) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			mcpkg_mp_array_cur_destroy(cur_);
-			goto out_err;
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 5 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
 		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "pkg.file");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* url */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->url = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->url)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
 
-		if (found_ && n_ > 0) {
-			/// yikes
-			p->digests = mcpkg_list_new(sizeof(struct McPkgDigest *), NULL, 0, 0);
+		case 3: /* file_name */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->file_name = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->file_name)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 4: /* size */
+			mpret = mcpkg_mp_cur_u64(c_, &p->size);
+			break;
+
+		case 5: /* digests */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_array(c_, &ln_);
+			if (mpret != MCPKG_MP_NO_ERROR || ln_ == 0)
+				break;
+			if (a)
+				p->digests = mcpkg_list_new_arena(a,
+				                  sizeof(struct McPkgDigest *), NULL, 0, 0);
+			else
+				p->digests = mcpkg_list_new(
+				                  sizeof(struct McPkgDigest *), NULL, 0, 0);
 			if (!p->digests) {
 				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				mcpkg_mp_array_cur_destroy(cur_);
-				goto out_err;
+				break;
 			}
-			for (i_ = 0; i_ < n_; i_++) {
-				const void *ptr_ = NULL;
-				size_t pl_ = 0;
+			for (j_ = 0; j_ < ln_; j_++) {
 				struct McPkgDigest *elt_ = NULL;
 
-				if (mcpkg_mp_array_get_bin_borrow(cur_, i_, &ptr_, &pl_) != MCPKG_MP_NO_ERROR) {
-					mcpkg_mp_array_cur_destroy(cur_);
-					goto out_err;
+				if (!mcpkg_mp_cur_is_bin(c_)) {
+					mpret = mcpkg_mp_pkg_digest_unpack_cur(c_, a, &elt_);
+					if (mpret != MCPKG_MP_NO_ERROR)
+						break;
+				} else {
+					/* version 1: records embedded as bin */
+					mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+					if (mpret != MCPKG_MP_NO_ERROR)
+						break;
+					if (mcpkg_mp_pkg_digest_unpack_arena(bp_, pl_, a,
+					        &elt_) != MCPKG_MP_NO_ERROR) {
+						mpret = MCPKG_MP_ERR_PARSE;
+						break;
+					}
 				}
-				if (mcpkg_mp_pkg_digest_unpack(ptr_, pl_, &elt_) != MCPKG_MP_NO_ERROR) {
-					mcpkg_mp_array_cur_destroy(cur_);
-					mpret = MCPKG_MP_ERR_PARSE;
-					goto out_err;
-				}
-				if (mcpkg_list_push(p->digests, &elt_) != MCPKG_CONTAINER_OK) {
-					mcpkg_mp_pkg_digest_free(elt_);
-					mcpkg_mp_array_cur_destroy(cur_);
+				if (mcpkg_list_push(p->digests, &elt_) !=
+				    MCPKG_CONTAINER_OK) {
+					if (!a)
+						mcpkg_mp_pkg_digest_free(elt_);
 					mpret = MCPKG_MP_ERR_NO_MEMORY;
-					goto out_err;
+					break;
 				}
 			}
-		}
+			break;
 
-		if (cur_)
-			mcpkg_mp_array_cur_destroy(cur_);
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->url)
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->file_name)
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[5])
+		return MCPKG_MP_ERR_PARSE;
+
+	return MCPKG_MP_NO_ERROR;
+}
+
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_pkg_file_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgFile **out_p, int top)
+{
+	struct McPkgFile *p;
+	McPkgArenaMark mark_;
+	int mpret;
+
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_pkg_file_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_pkg_file_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_pkg_file_free(p);
+		return mpret;
+	}
 
 	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_pkg_file_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_pkg_file_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgFile **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_file_decode_new(c, a, out_p, 0);
+}
+
+MCPKG_API int mcpkg_mp_pkg_file_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgFile **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_pkg_file_decode_new(&c, a, out_p, 1);
+}
+
+/*
+ * View decode: same walk as _decode, but strings are borrowed and
+ * lists/nested records are kept as spans, so nothing is allocated.
+ */
+static int mcpkg_mp_pkg_file_view_decode(struct McPkgMpCur *c_,
+                      struct McPkgFileView *v, int top)
+{
+	unsigned char seen_[6] = { 0 };
+	size_t n_, i_;
+	int mpret, key_;
+
+	memset(v, 0, sizeof(*v));
+	if (!top && mcpkg_mp_cur_is_bin(c_)) {
+		/* version 1: a whole record embedded as bin */
+		struct McPkgMpCur sub_;
+		const void *rp_;
+		size_t rl_;
+
+		mpret = mcpkg_mp_cur_bin(c_, &rp_, &rl_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+		mcpkg_mp_cur_init(&sub_, rp_, rl_);
+		return mcpkg_mp_pkg_file_view_decode(&sub_, v, 1);
+	}
+
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 5 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
+		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "pkg.file");
+			break;
+
+		case 2: /* url */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->url.p, &v->url.len);
+			break;
+
+		case 3: /* file_name */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->file_name.p, &v->file_name.len);
+			break;
+
+		case 4: /* size */
+			mpret = mcpkg_mp_cur_u64(c_, &v->size);
+			break;
+
+		case 5: /* digests */
+			mpret = mcpkg_mp_cur_span(c_, &v->digests);
+			break;
+
+		default:
+			/* the version too: nested values say their own layout */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+	}
+
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->url.p)
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->file_name.p)
+		return MCPKG_MP_ERR_PARSE;
+	if (!seen_[5])
+		return MCPKG_MP_ERR_PARSE;
+
+	return MCPKG_MP_NO_ERROR;
+}
+
+MCPKG_API int mcpkg_mp_pkg_file_view(const void *buf, size_t len,
+                      struct McPkgFileView *out)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_pkg_file_view_decode(&c, out, 1);
+}
+
+MCPKG_API int mcpkg_mp_pkg_file_view_cur(struct McPkgMpCur *c,
+                      struct McPkgFileView *out)
+{
+	if (!c || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_file_view_decode(c, out, 0);
 }
@@ -13,11 +13,12 @@
 #include "mcpkg_export.h"
 
 #include "container/mcpkg_list.h"
+#include "mp/mcpkg_mp_util.h"
 
 MCPKG_BEGIN_DECLS
 
 #define MCPKG_MP_MP_PKG_FILE_TAG "pkg.file"
-#define MCPKG_MP_MP_PKG_FILE_VER 1
+#define MCPKG_MP_MP_PKG_FILE_VER 2
 
 struct McPkgDigest;
 
@@ -32,12 +33,72 @@ struct McPkgFile {
 MCPKG_API struct McPkgFile *mcpkg_mp_pkg_file_new(void);
 MCPKG_API void mcpkg_mp_pkg_file_free(struct McPkgFile *p);
 
+/*
+ * Arena variants: with a non-NULL arena every allocation of the result
+ * (strings, lists, nested structs) comes from it; release it with
+ * mcpkg_arena_reset/free, never _free. A NULL arena means the heap.
+ */
+struct McPkgArena;
+MCPKG_API struct McPkgFile *mcpkg_mp_pkg_file_new_arena(struct McPkgArena *a);
+
 MCPKG_API int mcpkg_mp_pkg_file_pack(const struct McPkgFile *p,
                                      void **out_buf, size_t *out_len);
 
+/* Exact bytes _pack produces, computed without encoding (0 if p NULL). */
+MCPKG_API size_t mcpkg_mp_pkg_file_packed_size(const struct McPkgFile *p);
+
+/*
+ * Write the record into buf[0, cap) without allocating. *out_len is its
+ * size; when that exceeds cap the result is MCPKG_MP_ERR_NO_MEMORY and
+ * buf holds nothing usable.
+ */
+MCPKG_API int mcpkg_mp_pkg_file_pack_into(const struct McPkgFile *p,
+                void *buf, size_t cap, size_t *out_len);
+
+/* Same record appended to w, e.g. many records into one buffer. */
+struct McPkgMpWriter;
+MCPKG_API int mcpkg_mp_pkg_file_pack_append(const struct McPkgFile *p,
+                struct McPkgMpWriter *w);
+
 MCPKG_API int mcpkg_mp_pkg_file_unpack(const void *buf, size_t len,
                                        struct McPkgFile **out_p);
 
+/* On error nothing is left allocated in a. */
+MCPKG_API int mcpkg_mp_pkg_file_unpack_arena(const void *buf,
+                size_t len, struct McPkgArena *a,
+                struct McPkgFile **out_p);
+
+/*
+ * Nested form used inside other records: p as a headerless map written
+ * into / read from a stream already in progress.
+ */
+struct McPkgMpCur;
+MCPKG_API int mcpkg_mp_pkg_file_pack_w(const struct McPkgFile *p,
+                struct McPkgMpWriter *w);
+MCPKG_API size_t mcpkg_mp_pkg_file_packed_size_w(const struct McPkgFile *p);
+MCPKG_API int mcpkg_mp_pkg_file_unpack_cur(struct McPkgMpCur *c,
+                struct McPkgArena *a,
+                struct McPkgFile **out_p);
+
+/*
+ * Borrowed view: decoding allocates nothing. Strings point into buf,
+ * lists and nested records stay encoded as spans (McPkgMpSpan); all of
+ * it is valid while buf lives. Validation matches _unpack.
+ */
+struct McPkgFileView {
+	struct McPkgMpStr	url;
+	struct McPkgMpStr	file_name;
+	uint64_t		size;
+	/* McPkgDigest records: mcpkg_mp_pkg_digest_view_cur */
+	struct McPkgMpSpan	digests;
+};
+
+MCPKG_API int mcpkg_mp_pkg_file_view(const void *buf, size_t len,
+                struct McPkgFileView *out);
+/* Nested form: the next value of c (inline map or version 1 bin). */
+MCPKG_API int mcpkg_mp_pkg_file_view_cur(struct McPkgMpCur *c,
+                struct McPkgFileView *out);
+
 MCPKG_API char *mcpkg_mp_pkg_file_debug_str(const struct McPkgFile *p);
 
 MCPKG_END_DECLS
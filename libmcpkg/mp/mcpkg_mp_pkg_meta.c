@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 #include "mp/mcpkg_mp_pkg_depends.h"
@@ -27,45 +29,52 @@ MCPKG_API struct McPkgCache *mcpkg_mp_pkg_meta_new(void)
 {
 	struct McPkgCache *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgCache *mcpkg_mp_pkg_meta_new_arena(struct McPkgArena *a)
+{
+	if (!a)
+		return mcpkg_mp_pkg_meta_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgCache));
+}
+
 MCPKG_API void mcpkg_mp_pkg_meta_free(struct McPkgCache *p)
 {
 	if (!p)
 		return;
 
 	/* free id */
-	free(p->id);
+	mcpkg_free(p->id);
 	p->id = NULL;
 
 	/* free slug */
-	free(p->slug);
+	mcpkg_free(p->slug);
 	p->slug = NULL;
 
 	/* free version */
-	free(p->version);
+	mcpkg_free(p->version);
 	p->version = NULL;
 
 	/* free title */
-	free(p->title);
+	mcpkg_free(p->title);
 	p->title = NULL;
 
 	/* free description */
-	free(p->description);
+	mcpkg_free(p->description);
 	p->description = NULL;
 
 	/* free license_id */
-	free(p->license_id);
+	mcpkg_free(p->license_id);
 	p->license_id = NULL;
 
 	/* free home_page */
-	free(p->home_page);
+	mcpkg_free(p->home_page);
 	p->home_page = NULL;
 
 	/* free source_repo */
-	free(p->source_repo);
+	mcpkg_free(p->source_repo);
 	p->source_repo = NULL;
 
 	/* free loaders */
@@ -116,7 +125,7 @@ MCPKG_API void mcpkg_mp_pkg_meta_free(struct McPkgCache *p)
 	/* free flags */
 	/* free schema */
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_pkg_meta_debug_str(const struct McPkgCache *p)
@@ -236,593 +245,842 @@ MCPKG_API char *mcpkg_mp_pkg_meta_debug_str(const struct McPkgCache *p)
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_pkg_meta_pack(const struct McPkgCache *p,
-                                     void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_pkg_meta_pack_map(const struct McPkgCache *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
-
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 20);
+	mpret = mcpkg_mp_map_begin(w, 18 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
-	mpret = mcpkg_mp_write_header(&w, "pkg.meta", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "pkg.meta", 2);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* id */
 	if (p->id)
-		mpret = mcpkg_mp_kv_str(&w, 2, p->id);
+		mpret = mcpkg_mp_kv_str(w, 2, p->id);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 2);
+		mpret = mcpkg_mp_kv_nil(w, 2);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* slug */
 	if (p->slug)
-		mpret = mcpkg_mp_kv_str(&w, 3, p->slug);
+		mpret = mcpkg_mp_kv_str(w, 3, p->slug);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 3);
+		mpret = mcpkg_mp_kv_nil(w, 3);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* version */
 	if (p->version)
-		mpret = mcpkg_mp_kv_str(&w, 4, p->version);
+		mpret = mcpkg_mp_kv_str(w, 4, p->version);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 4);
+		mpret = mcpkg_mp_kv_nil(w, 4);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* title */
 	if (p->title)
-		mpret = mcpkg_mp_kv_str(&w, 5, p->title);
+		mpret = mcpkg_mp_kv_str(w, 5, p->title);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 5);
+		mpret = mcpkg_mp_kv_nil(w, 5);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* description */
 	if (p->description)
-		mpret = mcpkg_mp_kv_str(&w, 6, p->description);
+		mpret = mcpkg_mp_kv_str(w, 6, p->description);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 6);
+		mpret = mcpkg_mp_kv_nil(w, 6);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* license_id */
 	if (p->license_id)
-		mpret = mcpkg_mp_kv_str(&w, 7, p->license_id);
+		mpret = mcpkg_mp_kv_str(w, 7, p->license_id);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 7);
+		mpret = mcpkg_mp_kv_nil(w, 7);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* home_page */
 	if (p->home_page)
-		mpret = mcpkg_mp_kv_str(&w, 8, p->home_page);
+		mpret = mcpkg_mp_kv_str(w, 8, p->home_page);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 8);
+		mpret = mcpkg_mp_kv_nil(w, 8);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* source_repo */
 	if (p->source_repo)
-		mpret = mcpkg_mp_kv_str(&w, 9, p->source_repo);
+		mpret = mcpkg_mp_kv_str(w, 9, p->source_repo);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 9);
+		mpret = mcpkg_mp_kv_nil(w, 9);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* loaders */
-	mpret = mcpkg_mp_kv_strlist(&w, 10, p->loaders);
+	mpret = mcpkg_mp_kv_strlist(w, 10, p->loaders);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* sections */
-	mpret = mcpkg_mp_kv_strlist(&w, 11, p->sections);
+	mpret = mcpkg_mp_kv_strlist(w, 11, p->sections);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* configs */
-	mpret = mcpkg_mp_kv_strlist(&w, 12, p->configs);
+	mpret = mcpkg_mp_kv_strlist(w, 12, p->configs);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* depends */
 	{
 		size_t i_, n_ = p->depends ? mcpkg_list_size(p->depends) : 0;
 
-		mpret = mcpkg_mp_kv_array_begin(&w, 13, (uint32_t)n_);
+		mpret = mcpkg_mp_kv_array_begin(w, 13, (uint32_t)n_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 
 		for (i_ = 0; i_ < n_; i_++) {
 			struct McPkgDepends *elt_ = NULL;
-			void *b_ = NULL;
-			size_t bl_ = 0;
 
 			if (mcpkg_list_at(p->depends, i_, &elt_) != MCPKG_CONTAINER_OK || !elt_) {
 				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_w;
+				goto out;
 			}
-			if (mcpkg_mp_pkg_depends_pack(elt_, &b_, &bl_) != MCPKG_MP_NO_ERROR) {
-				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_w;
-			}
-			mpret = mcpkg_mp_write_bin(&w, b_, (uint32_t)bl_);
-			free(b_);
+			mpret = mcpkg_mp_pkg_depends_pack_w(elt_, w);
 			if (mpret != MCPKG_MP_NO_ERROR)
-				goto out_w;
+				goto out;
 		}
 	}
 
 	/* file */
 	if (p->file) {
-		void *b_ = NULL;
-		size_t bl_ = 0;
-
-		if (mcpkg_mp_pkg_file_pack(p->file, &b_, &bl_) != MCPKG_MP_NO_ERROR) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_w;
-		}
-		mpret = mcpkg_mp_kv_bin(&w, 14, b_, (uint32_t)bl_);
-		free(b_);
+		mpret = mcpkg_mp_write_key(w, 14);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+		mpret = mcpkg_mp_pkg_file_pack_w(p->file, w);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 	} else {
-		mpret = mcpkg_mp_kv_nil(&w, 14);
+		mpret = mcpkg_mp_kv_nil(w, 14);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 	}
 
 	/* client */
-	mpret = mcpkg_mp_kv_i32(&w, 15, p->client);
+	mpret = mcpkg_mp_kv_i32(w, 15, p->client);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* server */
-	mpret = mcpkg_mp_kv_i32(&w, 16, p->server);
+	mpret = mcpkg_mp_kv_i32(w, 16, p->server);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* origin */
 	if (p->origin) {
-		void *b_ = NULL;
-		size_t bl_ = 0;
-
-		if (mcpkg_mp_pkg_origin_pack(p->origin, &b_, &bl_) != MCPKG_MP_NO_ERROR) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_w;
-		}
-		mpret = mcpkg_mp_kv_bin(&w, 17, b_, (uint32_t)bl_);
-		free(b_);
+		mpret = mcpkg_mp_write_key(w, 17);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
+		mpret = mcpkg_mp_pkg_origin_pack_w(p->origin, w);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
 	} else {
-		mpret = mcpkg_mp_kv_nil(&w, 17);
+		mpret = mcpkg_mp_kv_nil(w, 17);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_w;
+			goto out;
 	}
 
 	/* flags */
-	mpret = mcpkg_mp_kv_u32(&w, 18, p->flags);
+	mpret = mcpkg_mp_kv_u32(w, 18, p->flags);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* schema */
-	mpret = mcpkg_mp_kv_u32(&w, 19, p->schema);
+	mpret = mcpkg_mp_kv_u32(w, 19, p->schema);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
-
-MCPKG_API int mcpkg_mp_pkg_meta_unpack(const void *buf, size_t len,
-                                       struct McPkgCache **out_p)
+MCPKG_API int mcpkg_mp_pkg_meta_pack_w(const struct McPkgCache *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgCache *p = NULL;
-	int mpret, ver = 0;
-
-	if (!buf || !len || !out_p)
+	if (!p || !w)
 		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_meta_pack_map(p, w, 0);
+}
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
+MCPKG_API int mcpkg_mp_pkg_meta_pack_append(const struct McPkgCache *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_meta_pack_map(p, w, 1);
+}
 
-	mpret = mcpkg_mp_expect_tag(&r, "pkg.meta", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_pkg_meta_size_map(const struct McPkgCache *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(18 + (top ? 2 : 0));
 
-	p = mcpkg_mp_pkg_meta_new();
-	if (!p) {
-		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
-	}
+	if (top)
+		n += mcpkg_mp_size_header("pkg.meta", 2);
 
 	/* id */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_str(p->id);
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 2, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* slug */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_str(p->slug);
 
-		if (found_ && ptr_) {
-			p->id = malloc(pl_ + 1);
-			if (!p->id) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->id, ptr_, pl_);
-			p->id[pl_] = '\0';
-		}
-		if (!found_ || !p->id) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* version */
+	n += mcpkg_mp_size_int(4);
+	n += mcpkg_mp_size_str(p->version);
 
-	/* slug */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* title */
+	n += mcpkg_mp_size_int(5);
+	n += mcpkg_mp_size_str(p->title);
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 3, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* description */
+	n += mcpkg_mp_size_int(6);
+	n += mcpkg_mp_size_str(p->description);
 
-		if (found_ && ptr_) {
-			p->slug = malloc(pl_ + 1);
-			if (!p->slug) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->slug, ptr_, pl_);
-			p->slug[pl_] = '\0';
-		}
-	}
+	/* license_id */
+	n += mcpkg_mp_size_int(7);
+	n += mcpkg_mp_size_str(p->license_id);
 
-	/* version */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* home_page */
+	n += mcpkg_mp_size_int(8);
+	n += mcpkg_mp_size_str(p->home_page);
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 4, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* source_repo */
+	n += mcpkg_mp_size_int(9);
+	n += mcpkg_mp_size_str(p->source_repo);
 
-		if (found_ && ptr_) {
-			p->version = malloc(pl_ + 1);
-			if (!p->version) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->version, ptr_, pl_);
-			p->version[pl_] = '\0';
-		}
-		if (!found_ || !p->version) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-	}
+	/* loaders */
+	n += mcpkg_mp_size_int(10);
+	n += mcpkg_mp_size_strlist(p->loaders);
 
-	/* title */
+	/* sections */
+	n += mcpkg_mp_size_int(11);
+	n += mcpkg_mp_size_strlist(p->sections);
+
+	/* configs */
+	n += mcpkg_mp_size_int(12);
+	n += mcpkg_mp_size_strlist(p->configs);
+
+	/* depends */
+	n += mcpkg_mp_size_int(13);
 	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+		size_t i_, n_ = p->depends ? mcpkg_list_size(p->depends) : 0;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 5, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+		n += mcpkg_mp_size_container(n_);
+		for (i_ = 0; i_ < n_; i_++) {
+			struct McPkgDepends *elt_ = NULL;
 
-		if (found_ && ptr_) {
-			p->title = malloc(pl_ + 1);
-			if (!p->title) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->title, ptr_, pl_);
-			p->title[pl_] = '\0';
+			if (mcpkg_list_at(p->depends, i_, &elt_) == MCPKG_CONTAINER_OK && elt_)
+				n += mcpkg_mp_pkg_depends_packed_size_w(elt_);
 		}
 	}
 
-	/* description */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* file */
+	n += mcpkg_mp_size_int(14);
+	n += p->file ? mcpkg_mp_pkg_file_packed_size_w(p->file) : 1;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 6, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* client */
+	n += mcpkg_mp_size_int(15);
+	n += mcpkg_mp_size_int(p->client);
 
-		if (found_ && ptr_) {
-			p->description = malloc(pl_ + 1);
-			if (!p->description) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->description, ptr_, pl_);
-			p->description[pl_] = '\0';
-		}
-	}
+	/* server */
+	n += mcpkg_mp_size_int(16);
+	n += mcpkg_mp_size_int(p->server);
 
-	/* license_id */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* origin */
+	n += mcpkg_mp_size_int(17);
+	n += p->origin ? mcpkg_mp_pkg_origin_packed_size_w(p->origin) : 1;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 7, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	/* flags */
+	n += mcpkg_mp_size_int(18);
+	n += mcpkg_mp_size_int((int64_t)p->flags);
 
-		if (found_ && ptr_) {
-			p->license_id = malloc(pl_ + 1);
-			if (!p->license_id) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->license_id, ptr_, pl_);
-			p->license_id[pl_] = '\0';
-		}
-	}
+	/* schema */
+	n += mcpkg_mp_size_int(19);
+	n += mcpkg_mp_size_int((int64_t)p->schema);
 
-	/* home_page */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	return n;
+}
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 8, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API size_t mcpkg_mp_pkg_meta_packed_size(const struct McPkgCache *p)
+{
+	return p ? mcpkg_mp_pkg_meta_size_map(p, 1) : 0;
+}
 
-		if (found_ && ptr_) {
-			p->home_page = malloc(pl_ + 1);
-			if (!p->home_page) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->home_page, ptr_, pl_);
-			p->home_page[pl_] = '\0';
-		}
-	}
+MCPKG_API size_t mcpkg_mp_pkg_meta_packed_size_w(const struct McPkgCache *p)
+{
+	return p ? mcpkg_mp_pkg_meta_size_map(p, 0) : 0;
+}
 
-	/* source_repo */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+MCPKG_API int mcpkg_mp_pkg_meta_pack_into(const struct McPkgCache *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 9, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	if (!p || !out_len || (!buf && cap))
+		return MCPKG_MP_ERR_INVALID_ARG;
 
-		if (found_ && ptr_) {
-			p->source_repo = malloc(pl_ + 1);
-			if (!p->source_repo) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->source_repo, ptr_, pl_);
-			p->source_repo[pl_] = '\0';
-		}
-	}
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-	/* loaders */
-	{
-		struct McPkgStringList *sl_ = NULL;
+	mpret = mcpkg_mp_pkg_meta_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
+		mpret = MCPKG_MP_ERR_NO_MEMORY;
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
 
-		mpret = mcpkg_mp_get_strlist_dup(&r, 10, &sl_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_pkg_meta_pack(const struct McPkgCache *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
 
-		p->loaders = sl_;
-		if (!p->loaders) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_pkg_meta_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_pkg_meta_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
 	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-	/* sections */
-	{
-		struct McPkgStringList *sl_ = NULL;
 
-		mpret = mcpkg_mp_get_strlist_dup(&r, 11, &sl_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_pkg_meta_unpack(const void *buf, size_t len,
+                      struct McPkgCache **out_p)
+{
+	return mcpkg_mp_pkg_meta_unpack_arena(buf, len, NULL, out_p);
+}
 
-		p->sections = sl_;
-	}
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_pkg_meta_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgCache *p, int top)
+{
+	unsigned char seen_[20] = { 0 };
+	const char *sp_;
+	const void *bp_;
+	size_t n_, i_, pl_, ln_, j_;
+	int mpret, key_;
 
-	/* configs */
-	{
-		struct McPkgStringList *sl_ = NULL;
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		mpret = mcpkg_mp_get_strlist_dup(&r, 12, &sl_);
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+			return mpret;
 
-		p->configs = sl_;
-	}
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 19 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
+		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "pkg.meta");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->id = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->id)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
 
-	/* depends */
-	{
-		struct McPkgMpArrayCur *cur_ = NULL;
-		size_t n_ = 0;
-		size_t i_;
-		int found_ = 0;
+		case 3: /* slug */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->slug = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->slug)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
 
-		mpret = mcpkg_mp_get_array_cur(&r, 13, &cur_, &n_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+		case 4: /* version */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->version = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->version)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 5: /* title */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->title = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->title)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 6: /* description */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->description = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->description)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 7: /* license_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->license_id = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->license_id)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
 
+		case 8: /* home_page */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->home_page = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->home_page)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
 
-		if (found_ && n_ > 0) {
-			/// yikes
-			p->depends = mcpkg_list_new(sizeof(struct McPkgDepends *), NULL, 0, 0);
+		case 9: /* source_repo */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->source_repo = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->source_repo)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 10: /* loaders */
+			mpret = mcpkg_mp_cur_strlist(c_, a, &p->loaders);
+			break;
+
+		case 11: /* sections */
+			mpret = mcpkg_mp_cur_strlist(c_, a, &p->sections);
+			break;
+
+		case 12: /* configs */
+			mpret = mcpkg_mp_cur_strlist(c_, a, &p->configs);
+			break;
+
+		case 13: /* depends */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_array(c_, &ln_);
+			if (mpret != MCPKG_MP_NO_ERROR || ln_ == 0)
+				break;
+			if (a)
+				p->depends = mcpkg_list_new_arena(a,
+				                  sizeof(struct McPkgDepends *), NULL, 0, 0);
+			else
+				p->depends = mcpkg_list_new(
+				                  sizeof(struct McPkgDepends *), NULL, 0, 0);
 			if (!p->depends) {
 				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				mcpkg_mp_array_cur_destroy(cur_);
-				goto out_err;
+				break;
 			}
-			for (i_ = 0; i_ < n_; i_++) {
-				const void *ptr_ = NULL;
-				size_t pl_ = 0;
+			for (j_ = 0; j_ < ln_; j_++) {
 				struct McPkgDepends *elt_ = NULL;
 
-				if (mcpkg_mp_array_get_bin_borrow(cur_, i_, &ptr_, &pl_) != MCPKG_MP_NO_ERROR) {
-					mcpkg_mp_array_cur_destroy(cur_);
-					goto out_err;
+				if (!mcpkg_mp_cur_is_bin(c_)) {
+					mpret = mcpkg_mp_pkg_depends_unpack_cur(c_, a, &elt_);
+					if (mpret != MCPKG_MP_NO_ERROR)
+						break;
+				} else {
+					/* version 1: records embedded as bin */
+					mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+					if (mpret != MCPKG_MP_NO_ERROR)
+						break;
+					if (mcpkg_mp_pkg_depends_unpack_arena(bp_, pl_, a,
+					        &elt_) != MCPKG_MP_NO_ERROR) {
+						mpret = MCPKG_MP_ERR_PARSE;
+						break;
+					}
 				}
-				if (mcpkg_mp_pkg_depends_unpack(ptr_, pl_, &elt_) != MCPKG_MP_NO_ERROR) {
-					mcpkg_mp_array_cur_destroy(cur_);
-					mpret = MCPKG_MP_ERR_PARSE;
-					goto out_err;
-				}
-				if (mcpkg_list_push(p->depends, &elt_) != MCPKG_CONTAINER_OK) {
-					mcpkg_mp_pkg_depends_free(elt_);
-					mcpkg_mp_array_cur_destroy(cur_);
+				if (mcpkg_list_push(p->depends, &elt_) !=
+				    MCPKG_CONTAINER_OK) {
+					if (!a)
+						mcpkg_mp_pkg_depends_free(elt_);
 					mpret = MCPKG_MP_ERR_NO_MEMORY;
-					goto out_err;
+					break;
 				}
 			}
-		}
-
-		if (cur_)
-			mcpkg_mp_array_cur_destroy(cur_);
-	}
-
-	/* file */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
-
-		mpret = mcpkg_mp_get_bin_borrow(&r, 14, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
-
-		if (!found_ || !ptr_ || pl_ == 0) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
-
-		if (found_ && ptr_ && pl_ > 0) {
-			if (mcpkg_mp_pkg_file_unpack(ptr_, pl_, &p->file) != MCPKG_MP_NO_ERROR) {
+			break;
+
+		case 14: /* file */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			if (!mcpkg_mp_cur_is_bin(c_)) {
+				mpret = mcpkg_mp_pkg_file_unpack_cur(c_, a,
+				        &p->file);
+				break;
+			}
+			/* version 1: a whole record embedded as bin */
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR || pl_ == 0)
+				break;
+			if (mcpkg_mp_pkg_file_unpack_arena(bp_, pl_, a,
+			        &p->file) != MCPKG_MP_NO_ERROR)
 				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_err;
+			break;
+
+		case 15: /* client */
+			mpret = mcpkg_mp_cur_i32(c_, &p->client);
+			break;
+
+		case 16: /* server */
+			mpret = mcpkg_mp_cur_i32(c_, &p->server);
+			break;
+
+		case 17: /* origin */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			if (!mcpkg_mp_cur_is_bin(c_)) {
+				mpret = mcpkg_mp_pkg_origin_unpack_cur(c_, a,
+				        &p->origin);
+				break;
 			}
-		}
-	}
+			/* version 1: a whole record embedded as bin */
+			mpret = mcpkg_mp_cur_bin(c_, &bp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR || pl_ == 0)
+				break;
+			if (mcpkg_mp_pkg_origin_unpack_arena(bp_, pl_, a,
+			        &p->origin) != MCPKG_MP_NO_ERROR)
+				mpret = MCPKG_MP_ERR_PARSE;
+			break;
 
-	/* client */
-	{
-		uint32_t val_ = 0;
-		int found_ = 0;
+		case 18: /* flags */
+			mpret = mcpkg_mp_cur_u32(c_, &p->flags);
+			break;
 
-		mpret = mcpkg_mp_get_u32(&r, 15, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+		case 19: /* schema */
+			mpret = mcpkg_mp_cur_u32(c_, &p->schema);
+			break;
 
-		if (found_)
-			p->client = (int32_t)val_;
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
-	/* server */
-	{
-		uint32_t val_ = 0;
-		int found_ = 0;
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->id)
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->version)
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->loaders)
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->file)
+		return MCPKG_MP_ERR_PARSE;
 
-		mpret = mcpkg_mp_get_u32(&r, 16, &val_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	return MCPKG_MP_NO_ERROR;
+}
 
-		if (found_)
-			p->server = (int32_t)val_;
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_pkg_meta_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgCache **out_p, int top)
+{
+	struct McPkgCache *p;
+	McPkgArenaMark mark_;
+	int mpret;
+
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_pkg_meta_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_pkg_meta_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_pkg_meta_free(p);
+		return mpret;
 	}
 
-	/* origin */
-	{
-		const void *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	*out_p = p;
+	return MCPKG_MP_NO_ERROR;
+}
 
-		mpret = mcpkg_mp_get_bin_borrow(&r, 17, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_pkg_meta_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgCache **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_meta_decode_new(c, a, out_p, 0);
+}
 
+MCPKG_API int mcpkg_mp_pkg_meta_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgCache **out_p)
+{
+	struct McPkgMpCur c;
 
-		if (found_ && ptr_ && pl_ > 0) {
-			if (mcpkg_mp_pkg_origin_unpack(ptr_, pl_, &p->origin) != MCPKG_MP_NO_ERROR) {
-				mpret = MCPKG_MP_ERR_PARSE;
-				goto out_err;
-			}
-		}
-	}
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
 
-	/* flags */
-	{
-		uint32_t val_ = 0;
-		int found_ = 0;
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_pkg_meta_decode_new(&c, a, out_p, 1);
+}
 
-		mpret = mcpkg_mp_get_u32(&r, 18, &val_, &found_);
+/*
+ * View decode: same walk as _decode, but strings are borrowed and
+ * lists/nested records are kept as spans, so nothing is allocated.
+ */
+static int mcpkg_mp_pkg_meta_view_decode(struct McPkgMpCur *c_,
+                      struct McPkgCacheView *v, int top)
+{
+	unsigned char seen_[20] = { 0 };
+	size_t n_, i_;
+	int mpret, key_;
+
+	memset(v, 0, sizeof(*v));
+	if (!top && mcpkg_mp_cur_is_bin(c_)) {
+		/* version 1: a whole record embedded as bin */
+		struct McPkgMpCur sub_;
+		const void *rp_;
+		size_t rl_;
+
+		mpret = mcpkg_mp_cur_bin(c_, &rp_, &rl_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
-
-		if (found_)
-			p->flags = (int32_t)val_;
+			return mpret;
+		mcpkg_mp_cur_init(&sub_, rp_, rl_);
+		return mcpkg_mp_pkg_meta_view_decode(&sub_, v, 1);
 	}
 
-	/* schema */
-	{
-		uint32_t val_ = 0;
-		int found_ = 0;
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
 
-		mpret = mcpkg_mp_get_u32(&r, 19, &val_, &found_);
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+			return mpret;
 
-		if (found_)
-			p->schema = (int32_t)val_;
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 19 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
+		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "pkg.meta");
+			break;
+
+		case 2: /* id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->id.p, &v->id.len);
+			break;
+
+		case 3: /* slug */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->slug.p, &v->slug.len);
+			break;
+
+		case 4: /* version */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->version.p, &v->version.len);
+			break;
+
+		case 5: /* title */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->title.p, &v->title.len);
+			break;
+
+		case 6: /* description */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->description.p, &v->description.len);
+			break;
+
+		case 7: /* license_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->license_id.p, &v->license_id.len);
+			break;
+
+		case 8: /* home_page */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->home_page.p, &v->home_page.len);
+			break;
+
+		case 9: /* source_repo */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->source_repo.p, &v->source_repo.len);
+			break;
+
+		case 10: /* loaders */
+			mpret = mcpkg_mp_cur_span(c_, &v->loaders);
+			break;
+
+		case 11: /* sections */
+			mpret = mcpkg_mp_cur_span(c_, &v->sections);
+			break;
+
+		case 12: /* configs */
+			mpret = mcpkg_mp_cur_span(c_, &v->configs);
+			break;
+
+		case 13: /* depends */
+			mpret = mcpkg_mp_cur_span(c_, &v->depends);
+			break;
+
+		case 14: /* file */
+			mpret = mcpkg_mp_cur_span(c_, &v->file);
+			break;
+
+		case 15: /* client */
+			mpret = mcpkg_mp_cur_i32(c_, &v->client);
+			break;
+
+		case 16: /* server */
+			mpret = mcpkg_mp_cur_i32(c_, &v->server);
+			break;
+
+		case 17: /* origin */
+			mpret = mcpkg_mp_cur_span(c_, &v->origin);
+			break;
+
+		case 18: /* flags */
+			mpret = mcpkg_mp_cur_u32(c_, &v->flags);
+			break;
+
+		case 19: /* schema */
+			mpret = mcpkg_mp_cur_u32(c_, &v->schema);
+			break;
+
+		default:
+			/* the version too: nested values say their own layout */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->id.p)
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->version.p)
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->loaders.p)
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->file.p)
+		return MCPKG_MP_ERR_PARSE;
 
-	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_pkg_meta_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_pkg_meta_view(const void *buf, size_t len,
+                      struct McPkgCacheView *out)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_pkg_meta_view_decode(&c, out, 1);
+}
+
+MCPKG_API int mcpkg_mp_pkg_meta_view_cur(struct McPkgMpCur *c,
+                      struct McPkgCacheView *out)
+{
+	if (!c || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_meta_view_decode(c, out, 0);
 }
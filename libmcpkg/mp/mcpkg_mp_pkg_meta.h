@@ -14,11 +14,12 @@
 
 #include "container/mcpkg_str_list.h"
 #include "container/mcpkg_list.h"
+#include "mp/mcpkg_mp_util.h"
 
 MCPKG_BEGIN_DECLS
 
 #define MCPKG_MP_MP_PKG_META_TAG "pkg.meta"
-#define MCPKG_MP_MP_PKG_META_VER 1
+#define MCPKG_MP_MP_PKG_META_VER 2
 
 struct McPkgDepends;
 struct McPkgFile;
@@ -49,12 +50,88 @@ struct McPkgCache {
 MCPKG_API struct McPkgCache *mcpkg_mp_pkg_meta_new(void);
 MCPKG_API void mcpkg_mp_pkg_meta_free(struct McPkgCache *p);
 
+/*
+ * Arena variants: with a non-NULL arena every allocation of the result
+ * (strings, lists, nested structs) comes from it; release it with
+ * mcpkg_arena_reset/free, never _free. A NULL arena means the heap.
+ */
+struct McPkgArena;
+MCPKG_API struct McPkgCache *mcpkg_mp_pkg_meta_new_arena(struct McPkgArena *a);
+
 MCPKG_API int mcpkg_mp_pkg_meta_pack(const struct McPkgCache *p,
                                      void **out_buf, size_t *out_len);
 
+/* Exact bytes _pack produces, computed without encoding (0 if p NULL). */
+MCPKG_API size_t mcpkg_mp_pkg_meta_packed_size(const struct McPkgCache *p);
+
+/*
+ * Write the record into buf[0, cap) without allocating. *out_len is its
+ * size; when that exceeds cap the result is MCPKG_MP_ERR_NO_MEMORY and
+ * buf holds nothing usable.
+ */
+MCPKG_API int mcpkg_mp_pkg_meta_pack_into(const struct McPkgCache *p,
+                void *buf, size_t cap, size_t *out_len);
+
+/* Same record appended to w, e.g. many records into one buffer. */
+struct McPkgMpWriter;
+MCPKG_API int mcpkg_mp_pkg_meta_pack_append(const struct McPkgCache *p,
+                struct McPkgMpWriter *w);
+
 MCPKG_API int mcpkg_mp_pkg_meta_unpack(const void *buf, size_t len,
                                        struct McPkgCache **out_p);
 
+/* On error nothing is left allocated in a. */
+MCPKG_API int mcpkg_mp_pkg_meta_unpack_arena(const void *buf,
+                size_t len, struct McPkgArena *a,
+                struct McPkgCache **out_p);
+
+/*
+ * Nested form used inside other records: p as a headerless map written
+ * into / read from a stream already in progress.
+ */
+struct McPkgMpCur;
+MCPKG_API int mcpkg_mp_pkg_meta_pack_w(const struct McPkgCache *p,
+                struct McPkgMpWriter *w);
+MCPKG_API size_t mcpkg_mp_pkg_meta_packed_size_w(const struct McPkgCache *p);
+MCPKG_API int mcpkg_mp_pkg_meta_unpack_cur(struct McPkgMpCur *c,
+                struct McPkgArena *a,
+                struct McPkgCache **out_p);
+
+/*
+ * Borrowed view: decoding allocates nothing. Strings point into buf,
+ * lists and nested records stay encoded as spans (McPkgMpSpan); all of
+ * it is valid while buf lives. Validation matches _unpack.
+ */
+struct McPkgCacheView {
+	struct McPkgMpStr	id;
+	struct McPkgMpStr	slug;
+	struct McPkgMpStr	version;
+	struct McPkgMpStr	title;
+	struct McPkgMpStr	description;
+	struct McPkgMpStr	license_id;
+	struct McPkgMpStr	home_page;
+	struct McPkgMpStr	source_repo;
+	struct McPkgMpSpan	loaders;	/* str elements */
+	struct McPkgMpSpan	sections;	/* str elements */
+	struct McPkgMpSpan	configs;	/* str elements */
+	/* McPkgDepends records: mcpkg_mp_pkg_depends_view_cur */
+	struct McPkgMpSpan	depends;
+	/* one McPkgFile: mcpkg_mp_pkg_file_view_cur */
+	struct McPkgMpSpan	file;
+	int32_t			client;
+	int32_t			server;
+	/* one McPkgOrigin: mcpkg_mp_pkg_origin_view_cur */
+	struct McPkgMpSpan	origin;
+	uint32_t		flags;
+	uint32_t		schema;
+};
+
+MCPKG_API int mcpkg_mp_pkg_meta_view(const void *buf, size_t len,
+                struct McPkgCacheView *out);
+/* Nested form: the next value of c (inline map or version 1 bin). */
+MCPKG_API int mcpkg_mp_pkg_meta_view_cur(struct McPkgMpCur *c,
+                struct McPkgCacheView *out);
+
 MCPKG_API char *mcpkg_mp_pkg_meta_debug_str(const struct McPkgCache *p);
 
 MCPKG_END_DECLS
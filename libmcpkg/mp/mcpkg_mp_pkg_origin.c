@@ -15,6 +15,8 @@
 #include "mp/mcpkg_mp_util.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
 
 /* If we reference nested structs, pull in their generated headers. */
 
@@ -24,33 +26,41 @@ MCPKG_API struct McPkgOrigin *mcpkg_mp_pkg_origin_new(void)
 {
 	struct McPkgOrigin *p;
 
-	p = calloc(1, sizeof(*p));
+	p = mcpkg_calloc(1, sizeof(*p));
 	return p;
 }
 
+MCPKG_API struct McPkgOrigin *mcpkg_mp_pkg_origin_new_arena(struct McPkgArena
+                *a)
+{
+	if (!a)
+		return mcpkg_mp_pkg_origin_new();
+	return mcpkg_arena_calloc(a, 1, sizeof(struct McPkgOrigin));
+}
+
 MCPKG_API void mcpkg_mp_pkg_origin_free(struct McPkgOrigin *p)
 {
 	if (!p)
 		return;
 
 	/* free provider */
-	free(p->provider);
+	mcpkg_free(p->provider);
 	p->provider = NULL;
 
 	/* free project_id */
-	free(p->project_id);
+	mcpkg_free(p->project_id);
 	p->project_id = NULL;
 
 	/* free version_id */
-	free(p->version_id);
+	mcpkg_free(p->version_id);
 	p->version_id = NULL;
 
 	/* free source_url */
-	free(p->source_url);
+	mcpkg_free(p->source_url);
 	p->source_url = NULL;
 
 
-	free(p);
+	mcpkg_free(p);
 }
 
 MCPKG_API char *mcpkg_mp_pkg_origin_debug_str(const struct McPkgOrigin *p)
@@ -96,198 +106,437 @@ MCPKG_API char *mcpkg_mp_pkg_origin_debug_str(const struct McPkgOrigin *p)
 
 	return s;
 oom:
-	free(s);
+	mcpkg_free(s);
 	return NULL;
 }
 
 
 
-MCPKG_API int mcpkg_mp_pkg_origin_pack(const struct McPkgOrigin *p,
-                                       void **out_buf, size_t *out_len)
+/*
+ * p as one map: all fields (nil for missing optionals), plus the
+ * tag/version header at the top level. Nested structs are written
+ * inline as headerless maps; their schema follows from the parent's.
+ */
+static int mcpkg_mp_pkg_origin_pack_map(const struct McPkgOrigin *p,
+                    struct McPkgMpWriter *w, int top)
 {
-	struct McPkgMpWriter w;
 	int mpret;
 
-	if (!p || !out_buf || !out_len)
-		return MCPKG_MP_ERR_INVALID_ARG;
-
-	mpret = mcpkg_mp_writer_init(&w);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		return mpret;
-
-	/* header(2) + all fields (pack nil for missing optionals) */
-	mpret = mcpkg_mp_map_begin(&w, 6);
+	mpret = mcpkg_mp_map_begin(w, 4 + (top ? 2 : 0));
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
-	mpret = mcpkg_mp_write_header(&w, "pkg.origin", 1);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+	if (top) {
+		mpret = mcpkg_mp_write_header(w, "pkg.origin", 1);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			goto out;
+	}
 
 	/* provider */
 	if (p->provider)
-		mpret = mcpkg_mp_kv_str(&w, 2, p->provider);
+		mpret = mcpkg_mp_kv_str(w, 2, p->provider);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 2);
+		mpret = mcpkg_mp_kv_nil(w, 2);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* project_id */
 	if (p->project_id)
-		mpret = mcpkg_mp_kv_str(&w, 3, p->project_id);
+		mpret = mcpkg_mp_kv_str(w, 3, p->project_id);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 3);
+		mpret = mcpkg_mp_kv_nil(w, 3);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* version_id */
 	if (p->version_id)
-		mpret = mcpkg_mp_kv_str(&w, 4, p->version_id);
+		mpret = mcpkg_mp_kv_str(w, 4, p->version_id);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 4);
+		mpret = mcpkg_mp_kv_nil(w, 4);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 	/* source_url */
 	if (p->source_url)
-		mpret = mcpkg_mp_kv_str(&w, 5, p->source_url);
+		mpret = mcpkg_mp_kv_str(w, 5, p->source_url);
 	else
-		mpret = mcpkg_mp_kv_nil(&w, 5);
+		mpret = mcpkg_mp_kv_nil(w, 5);
 	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_w;
+		goto out;
 
 
-	mpret = mcpkg_mp_writer_finish(&w, out_buf, out_len);
-out_w:
-	mcpkg_mp_writer_destroy(&w);
+out:
 	return mpret;
 }
 
+MCPKG_API int mcpkg_mp_pkg_origin_pack_w(const struct McPkgOrigin *p,
+                    struct McPkgMpWriter *w)
+{
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_origin_pack_map(p, w, 0);
+}
 
-MCPKG_API int mcpkg_mp_pkg_origin_unpack(const void *buf, size_t len,
-                struct McPkgOrigin **out_p)
+MCPKG_API int mcpkg_mp_pkg_origin_pack_append(const struct McPkgOrigin *p,
+                    struct McPkgMpWriter *w)
 {
-	struct McPkgMpReader r;
-	struct McPkgOrigin *p = NULL;
-	int mpret, ver = 0;
+	if (!p || !w)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_origin_pack_map(p, w, 1);
+}
 
-	if (!buf || !len || !out_p)
+/* bytes pack_map writes for p; mirrors it field by field */
+static size_t mcpkg_mp_pkg_origin_size_map(const struct McPkgOrigin *p, int top)
+{
+	size_t n = mcpkg_mp_size_container(4 + (top ? 2 : 0));
+
+	if (top)
+		n += mcpkg_mp_size_header("pkg.origin", 1);
+
+	/* provider */
+	n += mcpkg_mp_size_int(2);
+	n += mcpkg_mp_size_str(p->provider);
+
+	/* project_id */
+	n += mcpkg_mp_size_int(3);
+	n += mcpkg_mp_size_str(p->project_id);
+
+	/* version_id */
+	n += mcpkg_mp_size_int(4);
+	n += mcpkg_mp_size_str(p->version_id);
+
+	/* source_url */
+	n += mcpkg_mp_size_int(5);
+	n += mcpkg_mp_size_str(p->source_url);
+
+	return n;
+}
+
+MCPKG_API size_t mcpkg_mp_pkg_origin_packed_size(const struct McPkgOrigin *p)
+{
+	return p ? mcpkg_mp_pkg_origin_size_map(p, 1) : 0;
+}
+
+MCPKG_API size_t mcpkg_mp_pkg_origin_packed_size_w(const struct McPkgOrigin *p)
+{
+	return p ? mcpkg_mp_pkg_origin_size_map(p, 0) : 0;
+}
+
+MCPKG_API int mcpkg_mp_pkg_origin_pack_into(const struct McPkgOrigin *p,
+                    void *buf, size_t cap, size_t *out_len)
+{
+	struct McPkgMpWriter w;
+	int mpret;
+
+	if (!p || !out_len || (!buf && cap))
 		return MCPKG_MP_ERR_INVALID_ARG;
 
-	mpret = mcpkg_mp_reader_init(&r, buf, len);
+	mpret = mcpkg_mp_writer_init_fixed(&w, buf, cap);
 	if (mpret != MCPKG_MP_NO_ERROR)
 		return mpret;
 
-	mpret = mcpkg_mp_expect_tag(&r, "pkg.origin", &ver);
-	if (mpret != MCPKG_MP_NO_ERROR)
-		goto out_r;
-
-	p = mcpkg_mp_pkg_origin_new();
-	if (!p) {
+	mpret = mcpkg_mp_pkg_origin_pack_map(p, &w, 1);
+	*out_len = mcpkg_mp_writer_len(&w);
+	if (mpret == MCPKG_MP_NO_ERROR && *out_len > cap)
 		mpret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out_r;
-	}
+	mcpkg_mp_writer_destroy(&w);
+	return mpret;
+}
 
-	/* provider */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+MCPKG_API int mcpkg_mp_pkg_origin_pack(const struct McPkgOrigin *p,
+                    void **out_buf, size_t *out_len)
+{
+	size_t n, len;
+	void *buf;
+	int mpret;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 2, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	if (!p || !out_buf || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
 
-		if (found_ && ptr_) {
-			p->provider = malloc(pl_ + 1);
-			if (!p->provider) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->provider, ptr_, pl_);
-			p->provider[pl_] = '\0';
-		}
-		if (!found_ || !p->provider) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
-		}
+	/* exact size first: one allocation, no regrowth */
+	n = mcpkg_mp_pkg_origin_size_map(p, 1);
+	buf = mcpkg_malloc(n);
+	if (!buf)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_pkg_origin_pack_into(p, buf, n, &len);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		mcpkg_free(buf);
+		return mpret;
 	}
+	*out_buf = buf;
+	*out_len = len;
+	return MCPKG_MP_NO_ERROR;
+}
 
-	/* project_id */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 3, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+MCPKG_API int mcpkg_mp_pkg_origin_unpack(const void *buf, size_t len,
+                      struct McPkgOrigin **out_p)
+{
+	return mcpkg_mp_pkg_origin_unpack_arena(buf, len, NULL, out_p);
+}
 
-		if (found_ && ptr_) {
-			p->project_id = malloc(pl_ + 1);
-			if (!p->project_id) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->project_id, ptr_, pl_);
-			p->project_id[pl_] = '\0';
+/*
+ * One map into p in a single pass: fields land in p as their keys come.
+ * top: the record itself (tag required); else a nested headerless map.
+ */
+static int mcpkg_mp_pkg_origin_decode(struct McPkgMpCur *c_,
+                      struct McPkgArena *a,
+                      struct McPkgOrigin *p, int top)
+{
+	unsigned char seen_[6] = { 0 };
+	const char *sp_;
+	size_t n_, i_, pl_;
+	int mpret, key_;
+
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 5 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
 		}
-		if (!found_ || !p->project_id) {
-			mpret = MCPKG_MP_ERR_PARSE;
-			goto out_err;
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "pkg.origin");
+			break;
+
+		case MCPKG_MP_K_VER:
+			/* nested values say their own layout; nothing to dispatch on */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
+
+		case 2: /* provider */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->provider = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->provider)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 3: /* project_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->project_id = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->project_id)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 4: /* version_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->version_id = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->version_id)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		case 5: /* source_url */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &sp_, &pl_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				break;
+			p->source_url = mcpkg_mp_util_dup_strn(a, sp_, pl_);
+			if (!p->source_url)
+				mpret = MCPKG_MP_ERR_NO_MEMORY;
+			break;
+
+		default:
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
-	/* version_id */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	/* the tag and every required field must have been there */
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->provider)
+		return MCPKG_MP_ERR_PARSE;
+	if (!p->project_id)
+		return MCPKG_MP_ERR_PARSE;
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 4, &ptr_, &pl_, &found_);
-		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+	return MCPKG_MP_NO_ERROR;
+}
 
-		if (found_ && ptr_) {
-			p->version_id = malloc(pl_ + 1);
-			if (!p->version_id) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->version_id, ptr_, pl_);
-			p->version_id[pl_] = '\0';
-		}
+/* New p in a (NULL: heap) from one map; nothing is left on error. */
+static int mcpkg_mp_pkg_origin_decode_new(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgOrigin **out_p, int top)
+{
+	struct McPkgOrigin *p;
+	McPkgArenaMark mark_;
+	int mpret;
+
+	mark_ = mcpkg_arena_mark(a);
+	p = mcpkg_mp_pkg_origin_new_arena(a);
+	if (!p)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	mpret = mcpkg_mp_pkg_origin_decode(c, a, p, top);
+	if (mpret != MCPKG_MP_NO_ERROR) {
+		/* arena graphs are dropped by rewinding, not freed piecewise */
+		if (a)
+			mcpkg_arena_rewind(a, &mark_);
+		else
+			mcpkg_mp_pkg_origin_free(p);
+		return mpret;
 	}
 
-	/* source_url */
-	{
-		const char *ptr_ = NULL;
-		size_t pl_ = 0;
-		int found_ = 0;
+	*out_p = p;
+	return MCPKG_MP_NO_ERROR;
+}
+
+MCPKG_API int mcpkg_mp_pkg_origin_unpack_cur(struct McPkgMpCur *c,
+                      struct McPkgArena *a,
+                      struct McPkgOrigin **out_p)
+{
+	if (!c || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_origin_decode_new(c, a, out_p, 0);
+}
 
-		mpret = mcpkg_mp_get_str_borrow(&r, 5, &ptr_, &pl_, &found_);
+MCPKG_API int mcpkg_mp_pkg_origin_unpack_arena(const void *buf,
+                      size_t len, struct McPkgArena *a,
+                      struct McPkgOrigin **out_p)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out_p)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_pkg_origin_decode_new(&c, a, out_p, 1);
+}
+
+/*
+ * View decode: same walk as _decode, but strings are borrowed and
+ * lists/nested records are kept as spans, so nothing is allocated.
+ */
+static int mcpkg_mp_pkg_origin_view_decode(struct McPkgMpCur *c_,
+                      struct McPkgOriginView *v, int top)
+{
+	unsigned char seen_[6] = { 0 };
+	size_t n_, i_;
+	int mpret, key_;
+
+	memset(v, 0, sizeof(*v));
+	if (!top && mcpkg_mp_cur_is_bin(c_)) {
+		/* version 1: a whole record embedded as bin */
+		struct McPkgMpCur sub_;
+		const void *rp_;
+		size_t rl_;
+
+		mpret = mcpkg_mp_cur_bin(c_, &rp_, &rl_);
 		if (mpret != MCPKG_MP_NO_ERROR)
-			goto out_err;
+			return mpret;
+		mcpkg_mp_cur_init(&sub_, rp_, rl_);
+		return mcpkg_mp_pkg_origin_view_decode(&sub_, v, 1);
+	}
 
-		if (found_ && ptr_) {
-			p->source_url = malloc(pl_ + 1);
-			if (!p->source_url) {
-				mpret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_err;
-			}
-			memcpy(p->source_url, ptr_, pl_);
-			p->source_url[pl_] = '\0';
+	mpret = mcpkg_mp_cur_map(c_, &n_);
+	if (mpret != MCPKG_MP_NO_ERROR)
+		return mpret;
+
+	for (i_ = 0; i_ < n_; i_++) {
+		mpret = mcpkg_mp_cur_key(c_, &key_);
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
+
+		/* unknown keys and repeats are skipped; the first one wins */
+		if (key_ < 0 || key_ > 5 || seen_[key_]) {
+			mpret = mcpkg_mp_cur_skip(c_);
+			if (mpret != MCPKG_MP_NO_ERROR)
+				return mpret;
+			continue;
+		}
+		seen_[key_] = 1;
+
+		switch (key_) {
+		case MCPKG_MP_K_TAG:
+			mpret = mcpkg_mp_cur_tag(c_, "pkg.origin");
+			break;
+
+		case 2: /* provider */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->provider.p, &v->provider.len);
+			break;
+
+		case 3: /* project_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->project_id.p, &v->project_id.len);
+			break;
+
+		case 4: /* version_id */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->version_id.p, &v->version_id.len);
+			break;
+
+		case 5: /* source_url */
+			if (mcpkg_mp_cur_nil(c_))
+				break;
+			mpret = mcpkg_mp_cur_str(c_, &v->source_url.p, &v->source_url.len);
+			break;
+
+		default:
+			/* the version too: nested values say their own layout */
+			mpret = mcpkg_mp_cur_skip(c_);
+			break;
 		}
+		if (mpret != MCPKG_MP_NO_ERROR)
+			return mpret;
 	}
 
+	if (top && !seen_[MCPKG_MP_K_TAG])
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->provider.p)
+		return MCPKG_MP_ERR_PARSE;
+	if (!v->project_id.p)
+		return MCPKG_MP_ERR_PARSE;
 
-	*out_p = p;
-	mcpkg_mp_reader_destroy(&r);
 	return MCPKG_MP_NO_ERROR;
+}
 
-out_err:
-	mcpkg_mp_pkg_origin_free(p);
-out_r:
-	mcpkg_mp_reader_destroy(&r);
-	return mpret;
+MCPKG_API int mcpkg_mp_pkg_origin_view(const void *buf, size_t len,
+                      struct McPkgOriginView *out)
+{
+	struct McPkgMpCur c;
+
+	if (!buf || !len || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	mcpkg_mp_cur_init(&c, buf, len);
+	return mcpkg_mp_pkg_origin_view_decode(&c, out, 1);
+}
+
+MCPKG_API int mcpkg_mp_pkg_origin_view_cur(struct McPkgMpCur *c,
+                      struct McPkgOriginView *out)
+{
+	if (!c || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg_mp_pkg_origin_view_decode(c, out, 0);
 }
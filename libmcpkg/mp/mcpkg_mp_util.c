@@ -1,5 +1,7 @@
 #include "mcpkg_mp_util.h"
 
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <msgpack.h>
@@ -12,22 +14,77 @@
 
 // Optional: string list helpers (adjust includes if your path differs)
 #include "container/mcpkg_str_list.h"
+#include "container/mcpkg_alloc.h"
+#include "container/mcpkg_arena.h"
+
+/* first buffer size; records are small, nested ones smaller */
+#define MCPKG_MP_WR_INIT_CAP  256u
 
 struct mcpkg_mp_wr {
-	msgpack_sbuffer	sbuf;
-	msgpack_packer	pk;
-	int		init;
+	const McPkgAllocator	*alloc;
+	char			*data;
+	size_t			size;   /* fixed: bytes needed, may pass cap */
+	size_t			cap;
+	msgpack_packer		pk;
+	int			fixed;  /* caller's buffer, never grown */
 };
 
+_Static_assert(sizeof(struct mcpkg_mp_wr) <=
+               sizeof(((struct McPkgMpWriter *)0)->store_),
+               "McPkgMpWriter.store_ too small");
+
+/* int keys below this are looked up through mcpkg_mp_rd.key_pos */
+#define MCPKG_MP_RD_DENSE_KEYS  32
+
 struct mcpkg_mp_rd {
 	msgpack_unpacked	upk;
 	msgpack_object		root;
 	int			has_root;
+	int			indexed;
 	const char		*buf;
 	size_t			len;
+	/* root map slot + 1 of each small key, 0 = absent */
+	uint16_t		key_pos[MCPKG_MP_RD_DENSE_KEYS];
 };
 
+/* msgpack_packer_write: append to the writer's buffer */
+static int mcpkg__wr_write(void *data, const char *buf, size_t len)
+{
+	struct mcpkg_mp_wr *wr = (struct mcpkg_mp_wr *)data;
+	size_t need, cap;
+	char *p;
+
+	if (len > SIZE_MAX - wr->size)
+		return -1;
+	need = wr->size + len;
+	if (wr->fixed && need > wr->cap) {
+		/* keep counting so the caller learns the size */
+		wr->size = need;
+		return 0;
+	}
+	if (need > wr->cap) {
+		cap = wr->cap ? wr->cap : MCPKG_MP_WR_INIT_CAP;
+		while (cap < need)
+			cap = cap <= SIZE_MAX / 2 ? cap * 2 : need;
+		p = mcpkg_allocator_realloc(wr->alloc, wr->data, wr->cap, cap);
+		if (!p)
+			return -1;
+		wr->data = p;
+		wr->cap = cap;
+	}
+	if (len)
+		memcpy(wr->data + wr->size, buf, len);
+	wr->size = need;
+	return 0;
+}
+
 int mcpkg_mp_writer_init(struct McPkgMpWriter *w)
+{
+	return mcpkg_mp_writer_init_alloc(w, NULL);
+}
+
+int mcpkg_mp_writer_init_alloc(struct McPkgMpWriter *w,
+                               const McPkgAllocator *alloc)
 {
 	int ret = MCPKG_MP_NO_ERROR;
 	struct mcpkg_mp_wr *wr;
@@ -37,15 +94,10 @@ int mcpkg_mp_writer_init(struct McPkgMpWriter *w)
 		goto out;
 	}
 
-	wr = (struct mcpkg_mp_wr *)malloc(sizeof(*wr));
-	if (!wr) {
-		ret = MCPKG_MP_ERR_NO_MEMORY;
-		goto out;
-	}
-
-	msgpack_sbuffer_init(&wr->sbuf);
-	msgpack_packer_init(&wr->pk, &wr->sbuf, msgpack_sbuffer_write);
-	wr->init = 1;
+	wr = (struct mcpkg_mp_wr *)(void *)&w->store_;
+	memset(wr, 0, sizeof(*wr));
+	wr->alloc = alloc ? alloc : mcpkg_allocator_default();
+	msgpack_packer_init(&wr->pk, wr, mcpkg__wr_write);
 
 	w->impl = wr;
 	w->buf = NULL;
@@ -55,6 +107,47 @@ out:
 	return ret;
 }
 
+int mcpkg_mp_writer_init_append(struct McPkgMpWriter *w,
+                                const McPkgAllocator *alloc, void *buf,
+                                size_t len, size_t cap)
+{
+	struct mcpkg_mp_wr *wr;
+	int ret;
+
+	if (!w || len > cap || (!buf && cap))
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	ret = mcpkg_mp_writer_init_alloc(w, alloc);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+
+	wr = (struct mcpkg_mp_wr *)w->impl;
+	wr->data = buf;
+	wr->size = len;
+	wr->cap = cap;
+	return MCPKG_MP_NO_ERROR;
+}
+
+int mcpkg_mp_writer_init_fixed(struct McPkgMpWriter *w, void *buf,
+                               size_t cap)
+{
+	struct mcpkg_mp_wr *wr;
+	int ret;
+
+	if (!w || (!buf && cap))
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	ret = mcpkg_mp_writer_init_alloc(w, NULL);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+
+	wr = (struct mcpkg_mp_wr *)w->impl;
+	wr->data = buf;
+	wr->cap = cap;
+	wr->fixed = 1;
+	return MCPKG_MP_NO_ERROR;
+}
+
 void mcpkg_mp_writer_destroy(struct McPkgMpWriter *w)
 {
 	struct mcpkg_mp_wr *wr;
@@ -64,10 +157,8 @@ void mcpkg_mp_writer_destroy(struct McPkgMpWriter *w)
 
 	wr = (struct mcpkg_mp_wr *)w->impl;
 
-	if (wr->init)
-		msgpack_sbuffer_destroy(&wr->sbuf);
-
-	free(wr);
+	if (!wr->fixed)
+		mcpkg_allocator_free(wr->alloc, wr->data, wr->cap);
 	w->impl = NULL;
 
 	// If the caller never called finish(), w->buf/w->len are untouched here.
@@ -79,7 +170,6 @@ int mcpkg_mp_writer_finish(struct McPkgMpWriter *w, void **out_buf,
 {
 	int ret = MCPKG_MP_NO_ERROR;
 	struct mcpkg_mp_wr *wr;
-	void *dst;
 
 	if (!w || !w->impl || !out_buf || !out_len) {
 		ret = MCPKG_MP_ERR_INVALID_ARG;
@@ -87,24 +177,64 @@ int mcpkg_mp_writer_finish(struct McPkgMpWriter *w, void **out_buf,
 	}
 
 	wr = (struct mcpkg_mp_wr *)w->impl;
-
-	dst = malloc(wr->sbuf.size);
-	if (!dst) {
-		ret = MCPKG_MP_ERR_NO_MEMORY;
+	if (wr->fixed) {
+		ret = MCPKG_MP_ERR_INVALID_ARG;
 		goto out;
 	}
 
-	memcpy(dst, wr->sbuf.data, wr->sbuf.size);
-	*out_buf = dst;
-	*out_len = wr->sbuf.size;
+	/* nothing written: still hand out a block the caller can free */
+	if (!wr->data) {
+		wr->data = mcpkg_allocator_alloc(wr->alloc, 0);
+		if (!wr->data) {
+			ret = MCPKG_MP_ERR_NO_MEMORY;
+			goto out;
+		}
+	}
+
+	*out_buf = wr->data;
+	*out_len = wr->size;
+
+	w->buf = wr->data;
+	w->len = wr->size;
 
-	w->buf = dst;
-	w->len = wr->sbuf.size;
+	wr->data = NULL;
+	wr->size = 0;
+	wr->cap = 0;
 
 out:
 	return ret;
 }
 
+void mcpkg_mp_writer_reset(struct McPkgMpWriter *w)
+{
+	if (!w || !w->impl)
+		return;
+	((struct mcpkg_mp_wr *)w->impl)->size = 0;
+}
+
+size_t mcpkg_mp_writer_len(const struct McPkgMpWriter *w)
+{
+	if (!w || !w->impl)
+		return 0;
+	return ((const struct mcpkg_mp_wr *)w->impl)->size;
+}
+
+const void *mcpkg_mp_writer_data(const struct McPkgMpWriter *w,
+                                 size_t *out_len)
+{
+	const struct mcpkg_mp_wr *wr;
+
+	if (out_len)
+		*out_len = 0;
+	if (!w || !w->impl)
+		return NULL;
+
+	wr = (const struct mcpkg_mp_wr *)w->impl;
+	if (out_len)
+		*out_len = wr->size;
+	return wr->data;
+}
+
 int mcpkg_mp_map_begin(struct McPkgMpWriter *w, uint32_t key_count)
 {
 	int ret = MCPKG_MP_NO_ERROR;
@@ -329,6 +459,33 @@ out:
 	return ret;
 }
 
+/*
+ * One pass over the root map so field lookups skip the scan. Keys are
+ * matched as (int) like the scan does; the first duplicate wins.
+ */
+static void mcpkg__rd_index(struct mcpkg_mp_rd *rd)
+{
+	size_t i, n = rd->root.via.map.size;
+
+	memset(rd->key_pos, 0, sizeof(rd->key_pos));
+	rd->indexed = n < UINT16_MAX;
+	if (!rd->indexed)
+		return;
+
+	for (i = 0; i < n; i++) {
+		const msgpack_object *k = &rd->root.via.map.ptr[i].key;
+		int key;
+
+		if (k->type != MSGPACK_OBJECT_POSITIVE_INTEGER &&
+		    k->type != MSGPACK_OBJECT_NEGATIVE_INTEGER)
+			continue;
+		key = (int)k->via.i64;
+		if (key >= 0 && key < MCPKG_MP_RD_DENSE_KEYS &&
+		    !rd->key_pos[key])
+			rd->key_pos[key] = (uint16_t)(i + 1);
+	}
+}
+
 int mcpkg_mp_reader_init(struct McPkgMpReader *r,
                          const void *buf, size_t len)
 {
@@ -340,7 +497,7 @@ int mcpkg_mp_reader_init(struct McPkgMpReader *r,
 		goto out;
 	}
 
-	rd = (struct mcpkg_mp_rd *)malloc(sizeof(*rd));
+	rd = (struct mcpkg_mp_rd *)mcpkg_malloc(sizeof(*rd));
 	if (!rd) {
 		ret = MCPKG_MP_ERR_NO_MEMORY;
 		goto out;
@@ -349,7 +506,7 @@ int mcpkg_mp_reader_init(struct McPkgMpReader *r,
 	msgpack_unpacked_init(&rd->upk);
 	if (!msgpack_unpack_next(&rd->upk, (const char *)buf, len, NULL)) {
 		msgpack_unpacked_destroy(&rd->upk);
-		free(rd);
+		mcpkg_free(rd);
 		ret = MCPKG_MP_ERR_PARSE;
 		goto out;
 	}
@@ -357,7 +514,7 @@ int mcpkg_mp_reader_init(struct McPkgMpReader *r,
 	rd->root = rd->upk.data;
 	if (rd->root.type != MSGPACK_OBJECT_MAP) {
 		msgpack_unpacked_destroy(&rd->upk);
-		free(rd);
+		mcpkg_free(rd);
 		ret = MCPKG_MP_ERR_PARSE;
 		goto out;
 	}
@@ -365,6 +522,7 @@ int mcpkg_mp_reader_init(struct McPkgMpReader *r,
 	rd->has_root = 1;
 	rd->buf = (const char *)buf;
 	rd->len = len;
+	mcpkg__rd_index(rd);
 
 	r->impl = rd;
 	r->buf = buf;
@@ -387,7 +545,7 @@ void mcpkg_mp_reader_destroy(struct McPkgMpReader *r)
 	if (rd->has_root)
 		msgpack_unpacked_destroy(&rd->upk);
 
-	free(rd);
+	mcpkg_free(rd);
 	r->impl = NULL;
 	r->root = NULL;
 	r->buf = NULL;
@@ -407,6 +565,15 @@ static int mcpkg__find_map_key(const struct mcpkg_mp_rd *rd, int key,
 	if (!rd->has_root || rd->root.type != MSGPACK_OBJECT_MAP)
 		return MCPKG_MP_ERR_PARSE;
 
+	if (rd->indexed && key >= 0 && key < MCPKG_MP_RD_DENSE_KEYS) {
+		i = rd->key_pos[key];
+		if (i) {
+			*out_val = rd->root.via.map.ptr[i - 1].val;
+			*found = 1;
+		}
+		return MCPKG_MP_NO_ERROR;
+	}
+
 	n = rd->root.via.map.size;
 	for (i = 0; i < n; i++) {
 		msgpack_object k = rd->root.via.map.ptr[i].key;
@@ -679,15 +846,38 @@ out:
 	return ret;
 }
 
+size_t mcpkg_mp_size_strlist(const struct McPkgStringList *sl)
+{
+	size_t i, n, sz;
+
+	if (!sl)
+		return 1;
+
+	n = mcpkg_stringlist_size(sl);
+	sz = mcpkg_mp_size_container(n);
+	for (i = 0; i < n; i++) {
+		const char *s = mcpkg_stringlist_at(sl, i);
+
+		sz += mcpkg_mp_size_str(s ? s : "");
+	}
+	return sz;
+}
+
 int mcpkg_mp_get_strlist_dup(const struct McPkgMpReader *r, int key,
                              McPkgStringList **out_sl)
+{
+	return mcpkg_mp_get_strlist_dup_arena(r, key, NULL, out_sl);
+}
+
+int mcpkg_mp_get_strlist_dup_arena(const struct McPkgMpReader *r, int key,
+                                   McPkgArena *a, McPkgStringList **out_sl)
 {
 	int ret = MCPKG_MP_NO_ERROR;
 	const struct mcpkg_mp_rd *rd;
 	msgpack_object v;
 	int found = 0;
 	McPkgStringList *sl = NULL;
-	size_t i, n;
+	size_t i, n, len;
 
 	if (!r || !r->impl || !out_sl)
 		return MCPKG_MP_ERR_INVALID_ARG;
@@ -708,29 +898,27 @@ int mcpkg_mp_get_strlist_dup(const struct McPkgMpReader *r, int key,
 		return MCPKG_MP_ERR_PARSE;
 
 	n = v.via.array.size;
-	sl = mcpkg_stringlist_new(0, 0); // no hard caps by default
+	// decoded lists are built once: one packed text block, no hard caps
+	sl = a ? mcpkg_stringlist_new_arena(a, 0, 0)
+	     : mcpkg_stringlist_new_packed(0, 0);
 	if (!sl)
 		return MCPKG_MP_ERR_NO_MEMORY;
 
 	for (i = 0; i < n; i++) {
 		msgpack_object e = v.via.array.ptr[i];
+		MCPKG_CONTAINER_ERROR cret;
 
 		if (e.type != MSGPACK_OBJECT_STR) {
 			ret = MCPKG_MP_ERR_PARSE;
 			goto out_free;
 		}
-		{
-			char *dup = strndup(e.via.str.ptr, e.via.str.size);
-			if (!dup) {
-				ret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_free;
-			}
-			if (mcpkg_stringlist_push(sl, dup) != MCPKG_CONTAINER_OK) {
-				free(dup);
-				ret = MCPKG_MP_ERR_NO_MEMORY;
-				goto out_free;
-			}
-			free(dup); // push() duplicates, so free our temp
+		// strnlen: an embedded NUL truncates, as strndup() did
+		len = e.via.str.size ? strnlen(e.via.str.ptr, e.via.str.size)
+		      : 0;
+		cret = mcpkg_stringlist_push_n(sl, e.via.str.ptr, len);
+		if (cret != MCPKG_CONTAINER_OK) {
+			ret = MCPKG_MP_ERR_NO_MEMORY;
+			goto out_free;
 		}
 	}
 
@@ -798,6 +986,13 @@ mcpkg_mp_write_bin(struct McPkgMpWriter *w, const void *data, uint32_t len)
 	return MCPKG_MP_NO_ERROR;
 }
 
+MCPKG_API int
+mcpkg_mp_write_key(struct McPkgMpWriter *w, int key)
+{
+	if (!w || !w->impl) return MCPKG_MP_ERR_INVALID_ARG;
+	return mcpkg__kv_key((struct mcpkg_mp_wr *)w->impl, key);
+}
+
 /* ---- array cursor (reader) ---- */
 
 struct McPkgMpArrayCur {
@@ -842,7 +1037,7 @@ mcpkg_mp_get_array_cur(const struct McPkgMpReader *r, int key,
 
 	{
 		struct McPkgMpArrayCur *cur =
-		        (struct McPkgMpArrayCur *)malloc(sizeof(*cur));
+		        (struct McPkgMpArrayCur *)mcpkg_malloc(sizeof(*cur));
 		if (!cur)
 			return MCPKG_MP_ERR_NO_MEMORY;
 		cur->arr = v; /* shallow copy */
@@ -879,25 +1074,516 @@ mcpkg_mp_array_get_bin_borrow(struct McPkgMpArrayCur *cur,
 MCPKG_API void
 mcpkg_mp_array_cur_destroy(struct McPkgMpArrayCur *cur)
 {
-	free(cur);
+	mcpkg_free(cur);
+}
+
+/* ---- raw cursor (single-pass decoders) ---- */
+
+enum mcpkg_mp_cls {
+	MCPKG_MP_CLS_NIL,
+	MCPKG_MP_CLS_BOOL,
+	MCPKG_MP_CLS_UINT,      /* v.u */
+	MCPKG_MP_CLS_INT,       /* v.i, signed formats */
+	MCPKG_MP_CLS_FLOAT,     /* n payload bytes */
+	MCPKG_MP_CLS_STR,       /* n payload bytes */
+	MCPKG_MP_CLS_BIN,       /* n payload bytes */
+	MCPKG_MP_CLS_EXT,       /* n payload bytes, type byte included */
+	MCPKG_MP_CLS_ARRAY,     /* n elements */
+	MCPKG_MP_CLS_MAP,       /* n pairs */
+};
+
+struct mcpkg_mp_head {
+	enum mcpkg_mp_cls	cls;
+	uint64_t		n;
+	union {
+		uint64_t	u;
+		int64_t		i;
+	} v;
+};
+
+static inline uint64_t mcpkg__be(const unsigned char *p, unsigned n)
+{
+	uint64_t v = 0;
+
+	while (n--)
+		v = v << 8 | *p++;
+	return v;
+}
+
+/*
+ * Decode one value head and leave c->p at its payload. Payload lengths
+ * are checked against the buffer, and element counts too (every element
+ * takes at least a byte), so callers can size things from n.
+ */
+static int mcpkg__cur_head(struct McPkgMpCur *c, struct mcpkg_mp_head *h)
+{
+	const unsigned char *p = c->p;
+	unsigned w = 0;         /* bytes of the length/value field */
+	unsigned char b;
+	uint64_t v, left;
+
+	if (!p || p >= c->end)
+		return MCPKG_MP_ERR_PARSE;
+
+	b = *p++;
+	h->n = 0;
+	if (b <= 0x7f) {
+		h->cls = MCPKG_MP_CLS_UINT;
+		h->v.u = b;
+	} else if (b >= 0xe0) {
+		h->cls = MCPKG_MP_CLS_INT;
+		h->v.i = (int8_t)b;
+	} else if (b <= 0x8f) {
+		h->cls = MCPKG_MP_CLS_MAP;
+		h->n = b & 0x0f;
+	} else if (b <= 0x9f) {
+		h->cls = MCPKG_MP_CLS_ARRAY;
+		h->n = b & 0x0f;
+	} else if (b <= 0xbf) {
+		h->cls = MCPKG_MP_CLS_STR;
+		h->n = b & 0x1f;
+	} else {
+		switch (b) {
+		case 0xc0:
+			h->cls = MCPKG_MP_CLS_NIL;
+			break;
+		case 0xc2:
+		case 0xc3:
+			h->cls = MCPKG_MP_CLS_BOOL;
+			h->v.u = b & 1;
+			break;
+		case 0xc4: case 0xc5: case 0xc6:
+			h->cls = MCPKG_MP_CLS_BIN;
+			w = 1u << (b - 0xc4);
+			break;
+		case 0xc7: case 0xc8: case 0xc9:
+			h->cls = MCPKG_MP_CLS_EXT;
+			w = 1u << (b - 0xc7);
+			break;
+		case 0xca:
+		case 0xcb:
+			h->cls = MCPKG_MP_CLS_FLOAT;
+			h->n = b == 0xca ? 4 : 8;
+			break;
+		case 0xcc: case 0xcd: case 0xce: case 0xcf:
+			h->cls = MCPKG_MP_CLS_UINT;
+			w = 1u << (b - 0xcc);
+			break;
+		case 0xd0: case 0xd1: case 0xd2: case 0xd3:
+			h->cls = MCPKG_MP_CLS_INT;
+			w = 1u << (b - 0xd0);
+			break;
+		case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8:
+			h->cls = MCPKG_MP_CLS_EXT;
+			h->n = (1u << (b - 0xd4)) + 1;
+			break;
+		case 0xd9: case 0xda: case 0xdb:
+			h->cls = MCPKG_MP_CLS_STR;
+			w = 1u << (b - 0xd9);
+			break;
+		case 0xdc:
+		case 0xdd:
+			h->cls = MCPKG_MP_CLS_ARRAY;
+			w = b == 0xdc ? 2 : 4;
+			break;
+		case 0xde:
+		case 0xdf:
+			h->cls = MCPKG_MP_CLS_MAP;
+			w = b == 0xde ? 2 : 4;
+			break;
+		default:
+			return MCPKG_MP_ERR_PARSE;  /* 0xc1 is never used */
+		}
+	}
+
+	if (w) {
+		if ((size_t)(c->end - p) < w)
+			return MCPKG_MP_ERR_PARSE;
+		v = mcpkg__be(p, w);
+		p += w;
+		switch (h->cls) {
+		case MCPKG_MP_CLS_UINT:
+			h->v.u = v;
+			break;
+		case MCPKG_MP_CLS_INT:
+			h->v.i = w == 1 ? (int8_t)v : w == 2 ? (int16_t)v
+			         : w == 4 ? (int32_t)v : (int64_t)v;
+			break;
+		case MCPKG_MP_CLS_EXT:
+			h->n = v + 1;
+			break;
+		default:
+			h->n = v;
+			break;
+		}
+	}
+
+	left = (uint64_t)(c->end - p);
+	if ((h->cls == MCPKG_MP_CLS_MAP && h->n > left / 2) || h->n > left)
+		return MCPKG_MP_ERR_PARSE;
+
+	c->p = p;
+	return MCPKG_MP_NO_ERROR;
+}
+
+void mcpkg_mp_cur_init(struct McPkgMpCur *c, const void *buf, size_t len)
+{
+	if (!c)
+		return;
+	c->p = buf;
+	c->end = buf ? c->p + len : NULL;
+}
+
+static int mcpkg__cur_expect(struct McPkgMpCur *c, enum mcpkg_mp_cls cls,
+                             struct mcpkg_mp_head *h)
+{
+	int ret;
+
+	if (!c)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg__cur_head(c, h);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+	return h->cls == cls ? MCPKG_MP_NO_ERROR : MCPKG_MP_ERR_PARSE;
+}
+
+int mcpkg_mp_cur_map(struct McPkgMpCur *c, size_t *n)
+{
+	struct mcpkg_mp_head h;
+	int ret;
+
+	if (!n)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg__cur_expect(c, MCPKG_MP_CLS_MAP, &h);
+	if (ret == MCPKG_MP_NO_ERROR)
+		*n = (size_t)h.n;
+	return ret;
+}
+
+int mcpkg_mp_cur_array(struct McPkgMpCur *c, size_t *n)
+{
+	struct mcpkg_mp_head h;
+	int ret;
+
+	if (!n)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg__cur_expect(c, MCPKG_MP_CLS_ARRAY, &h);
+	if (ret == MCPKG_MP_NO_ERROR)
+		*n = (size_t)h.n;
+	return ret;
+}
+
+int mcpkg_mp_cur_nil(struct McPkgMpCur *c)
+{
+	if (!c || !c->p || c->p >= c->end || *c->p != 0xc0)
+		return 0;
+	c->p++;
+	return 1;
+}
+
+int mcpkg_mp_cur_is_bin(const struct McPkgMpCur *c)
+{
+	return c && c->p && c->p < c->end && *c->p >= 0xc4 && *c->p <= 0xc6;
+}
+
+int mcpkg_mp_cur_i64(struct McPkgMpCur *c, int64_t *out)
+{
+	struct mcpkg_mp_head h;
+	int ret;
+
+	if (!c || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg__cur_head(c, &h);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+
+	if (h.cls == MCPKG_MP_CLS_INT) {
+		*out = h.v.i;
+		return MCPKG_MP_NO_ERROR;
+	}
+	if (h.cls == MCPKG_MP_CLS_UINT && h.v.u <= INT64_MAX) {
+		*out = (int64_t)h.v.u;
+		return MCPKG_MP_NO_ERROR;
+	}
+	return MCPKG_MP_ERR_PARSE;
+}
+
+int mcpkg_mp_cur_u64(struct McPkgMpCur *c, uint64_t *out)
+{
+	struct mcpkg_mp_head h;
+	int ret;
+
+	if (!c || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg__cur_head(c, &h);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+
+	if (h.cls == MCPKG_MP_CLS_UINT) {
+		*out = h.v.u;
+		return MCPKG_MP_NO_ERROR;
+	}
+	if (h.cls == MCPKG_MP_CLS_INT && h.v.i >= 0) {
+		*out = (uint64_t)h.v.i;
+		return MCPKG_MP_NO_ERROR;
+	}
+	return MCPKG_MP_ERR_PARSE;
+}
+
+int mcpkg_mp_cur_i32(struct McPkgMpCur *c, int32_t *out)
+{
+	int64_t v;
+	int ret;
+
+	if (!out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg_mp_cur_i64(c, &v);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+	if (v < INT32_MIN || v > INT32_MAX)
+		return MCPKG_MP_ERR_PARSE;
+	*out = (int32_t)v;
+	return MCPKG_MP_NO_ERROR;
+}
+
+int mcpkg_mp_cur_u32(struct McPkgMpCur *c, uint32_t *out)
+{
+	uint64_t v;
+	int ret;
+
+	if (!out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg_mp_cur_u64(c, &v);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+	if (v > UINT32_MAX)
+		return MCPKG_MP_ERR_PARSE;
+	*out = (uint32_t)v;
+	return MCPKG_MP_NO_ERROR;
+}
+
+int mcpkg_mp_cur_key(struct McPkgMpCur *c, int *key)
+{
+	const unsigned char *at;
+	struct mcpkg_mp_head h;
+	int ret;
+
+	if (!c || !key)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	at = c->p;
+	ret = mcpkg__cur_head(c, &h);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+
+	if (h.cls == MCPKG_MP_CLS_UINT && h.v.u <= INT_MAX) {
+		*key = (int)h.v.u;
+		return MCPKG_MP_NO_ERROR;
+	}
+	if (h.cls == MCPKG_MP_CLS_INT && h.v.i >= INT_MIN &&
+	    h.v.i <= INT_MAX) {
+		*key = (int)h.v.i;
+		return MCPKG_MP_NO_ERROR;
+	}
+
+	/* not an int we can name: step over the whole key */
+	*key = -1;
+	c->p = at;
+	return mcpkg_mp_cur_skip(c);
+}
+
+int mcpkg_mp_cur_str(struct McPkgMpCur *c, const char **out_ptr,
+                     size_t *out_len)
+{
+	struct mcpkg_mp_head h;
+	int ret;
+
+	if (!out_ptr || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg__cur_expect(c, MCPKG_MP_CLS_STR, &h);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+
+	*out_ptr = (const char *)c->p;
+	*out_len = (size_t)h.n;
+	c->p += h.n;
+	return MCPKG_MP_NO_ERROR;
+}
+
+int mcpkg_mp_cur_bin(struct McPkgMpCur *c, const void **out_ptr,
+                     size_t *out_len)
+{
+	struct mcpkg_mp_head h;
+	int ret;
+
+	if (!out_ptr || !out_len)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg__cur_expect(c, MCPKG_MP_CLS_BIN, &h);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+
+	*out_ptr = c->p;
+	*out_len = (size_t)h.n;
+	c->p += h.n;
+	return MCPKG_MP_NO_ERROR;
+}
+
+int mcpkg_mp_cur_tag(struct McPkgMpCur *c, const char *tag)
+{
+	const char *s;
+	size_t len;
+	int ret;
+
+	if (!tag)
+		return MCPKG_MP_ERR_INVALID_ARG;
+	ret = mcpkg_mp_cur_str(c, &s, &len);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+	if (len != strlen(tag) || memcmp(s, tag, len) != 0)
+		return MCPKG_MP_ERR_PARSE;
+	return MCPKG_MP_NO_ERROR;
+}
+
+int mcpkg_mp_cur_skip(struct McPkgMpCur *c)
+{
+	struct mcpkg_mp_head h;
+	uint64_t pending = 1;
+	int ret;
+
+	if (!c)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	/* iterative: nesting depth costs nothing */
+	while (pending) {
+		ret = mcpkg__cur_head(c, &h);
+		if (ret != MCPKG_MP_NO_ERROR)
+			return ret;
+		pending--;
+
+		switch (h.cls) {
+		case MCPKG_MP_CLS_ARRAY:
+			pending += h.n;
+			break;
+		case MCPKG_MP_CLS_MAP:
+			pending += 2 * h.n;
+			break;
+		case MCPKG_MP_CLS_FLOAT:
+		case MCPKG_MP_CLS_STR:
+		case MCPKG_MP_CLS_BIN:
+		case MCPKG_MP_CLS_EXT:
+			c->p += h.n;
+			break;
+		default:
+			break;
+		}
+		/* each pending value needs at least one more byte */
+		if (pending > (uint64_t)(c->end - c->p))
+			return MCPKG_MP_ERR_PARSE;
+	}
+	return MCPKG_MP_NO_ERROR;
+}
+
+int mcpkg_mp_cur_strlist(struct McPkgMpCur *c, McPkgArena *a,
+                         McPkgStringList **out_sl)
+{
+	int ret = MCPKG_MP_NO_ERROR;
+	McPkgStringList *sl;
+	const char *s;
+	size_t i, n, len;
+
+	if (!c || !out_sl)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	*out_sl = NULL;
+	if (mcpkg_mp_cur_nil(c))
+		return MCPKG_MP_NO_ERROR;
+
+	ret = mcpkg_mp_cur_array(c, &n);
+	if (ret != MCPKG_MP_NO_ERROR)
+		return ret;
+
+	sl = a ? mcpkg_stringlist_new_arena(a, 0, 0)
+	     : mcpkg_stringlist_new_packed(0, 0);
+	if (!sl)
+		return MCPKG_MP_ERR_NO_MEMORY;
+
+	for (i = 0; i < n; i++) {
+		ret = mcpkg_mp_cur_str(c, &s, &len);
+		if (ret != MCPKG_MP_NO_ERROR)
+			goto out_free;
+		// strnlen: an embedded NUL truncates, as in the reader path
+		len = len ? strnlen(s, len) : 0;
+		if (mcpkg_stringlist_push_n(sl, s, len) != MCPKG_CONTAINER_OK) {
+			ret = MCPKG_MP_ERR_NO_MEMORY;
+			goto out_free;
+		}
+	}
+
+	*out_sl = sl;
+	return MCPKG_MP_NO_ERROR;
+
+out_free:
+	mcpkg_stringlist_free(sl);
+	return ret;
+}
+
+int mcpkg_mp_cur_span(struct McPkgMpCur *c, struct McPkgMpSpan *out)
+{
+	const unsigned char *start;
+	size_t i, n;
+	int ret;
+
+	if (!c || !out)
+		return MCPKG_MP_ERR_INVALID_ARG;
+
+	memset(out, 0, sizeof(*out));
+	if (mcpkg_mp_cur_nil(c))
+		return MCPKG_MP_NO_ERROR;
+
+	if (c->p && c->p < c->end &&
+	    ((*c->p & 0xf0) == 0x90 || *c->p == 0xdc || *c->p == 0xdd)) {
+		ret = mcpkg_mp_cur_array(c, &n);
+		if (ret != MCPKG_MP_NO_ERROR)
+			return ret;
+		start = c->p;
+		for (i = 0; i < n; i++) {
+			ret = mcpkg_mp_cur_skip(c);
+			if (ret != MCPKG_MP_NO_ERROR)
+				return ret;
+		}
+	} else {
+		n = 1;
+		start = c->p;
+		ret = mcpkg_mp_cur_skip(c);
+		if (ret != MCPKG_MP_NO_ERROR)
+			return ret;
+	}
+
+	out->p = start;
+	out->len = (size_t)(c->p - start);
+	out->n = n;
+	return MCPKG_MP_NO_ERROR;
+}
+
+int mcpkg_mp_str_eq(const struct McPkgMpStr *s, const char *z)
+{
+	if (!s || !s->p || !z)
+		return (!s || !s->p) && !z;
+	return strlen(z) == s->len && !memcmp(s->p, z, s->len);
 }
 
 char *mcpkg_mp_util_dup_str(const char *s)
 {
-	size_t n;
-	char *d;
+	return mcpkg_strdup(s);
+}
 
+char *mcpkg_mp_util_dup_strn(McPkgArena *a, const char *s, size_t len)
+{
 	if (!s)
 		return NULL;
-
-	n = strlen(s);
-	d = malloc(n + 1);
-	if (!d)
-		return NULL;
-
-	memcpy(d, s, n);
-	d[n] = '\0';
-	return d;
+	if (a)
+		return mcpkg_arena_strndup(a, s, len);
+	return mcpkg_strndup(s, len);
 }
 
 int mcpkg_mp_util_dbg_append(char **dst, size_t *cap, size_t *len,
@@ -915,7 +1601,7 @@ int mcpkg_mp_util_dbg_append(char **dst, size_t *cap, size_t *len,
 
 		if (*dst == NULL || *cap == 0) {
 			*cap = 128;
-			*dst = malloc(*cap);
+			*dst = mcpkg_malloc(*cap);
 			if (!*dst)
 				return -1;
 			*len = 0;
@@ -938,11 +1624,11 @@ int mcpkg_mp_util_dbg_append(char **dst, size_t *cap, size_t *len,
 		}
 
 		/* grow and retry */
-		*cap *= 2;
-		p = realloc(*dst, *cap);
+		p = mcpkg_allocator_realloc(NULL, *dst, *cap, *cap * 2);
 		if (!p)
 			return -1;
 		*dst = p;
+		*cap *= 2;
 	}
 }
 
@@ -9,6 +9,7 @@
 #include <string.h>
 
 #include "mcpkg_export.h"
+#include "container/mcpkg_alloc.h"
 #include "container/mcpkg_str_list.h"
 
 MCPKG_BEGIN_DECLS
@@ -21,11 +22,18 @@ typedef enum {
 	MCPKG_MP_ERR_IO          = -4,
 } MCPKG_MP_ERROR;
 
-/* Writer context for building a buffer. */
+/*
+ * Writer context for building a buffer. The state lives in store_, so
+ * init allocates nothing; do not copy or move a writer once initialized.
+ */
 struct McPkgMpWriter {
 	void    *impl;
 	void    *buf;
 	size_t   len;
+	union {
+		void            *p[8];
+		uint64_t         u[8];
+	} store_;
 };
 
 /* Reader for a single top-level object. */
@@ -37,10 +45,41 @@ struct McPkgMpReader {
 };
 
 MCPKG_API int  mcpkg_mp_writer_init(struct McPkgMpWriter *w);
+/* Buffers (and finish's copy) come from alloc; NULL = default. */
+MCPKG_API int  mcpkg_mp_writer_init_alloc(struct McPkgMpWriter *w,
+                const McPkgAllocator *alloc);
+/*
+ * Append mode: adopt buf (len bytes used of cap, allocated from alloc;
+ * NULL/0/0 for none) and write after its end. finish hands it back,
+ * grown as needed; destroy without finish frees it.
+ */
+MCPKG_API int  mcpkg_mp_writer_init_append(struct McPkgMpWriter *w,
+                const McPkgAllocator *alloc, void *buf, size_t len,
+                size_t cap);
+/*
+ * Fixed mode: write into buf[0, cap) and never allocate. Past cap
+ * nothing more is stored but writer_len keeps counting, so it ends as
+ * the size needed. Read the result with writer_data; finish refuses.
+ */
+MCPKG_API int  mcpkg_mp_writer_init_fixed(struct McPkgMpWriter *w,
+                void *buf, size_t cap);
 MCPKG_API void mcpkg_mp_writer_destroy(struct McPkgMpWriter *w);
+/*
+ * Hand the written bytes over without copying; the writer is left empty
+ * and can be reused. *out_buf is the caller's: release it with mcpkg_free
+ * (default alloc) or mcpkg_allocator_free(alloc, p, 0).
+ */
 MCPKG_API int  mcpkg_mp_writer_finish(struct McPkgMpWriter *w, void **out_buf,
                                       size_t *out_len);
+/* Drop what was written but keep the buffer, for the next record. */
+MCPKG_API void mcpkg_mp_writer_reset(struct McPkgMpWriter *w);
+/* Bytes written so far (record offsets in append mode; fixed: needed). */
+MCPKG_API size_t mcpkg_mp_writer_len(const struct McPkgMpWriter *w);
+/* Borrow the bytes written so far; valid until the next write/reset. */
+MCPKG_API const void *mcpkg_mp_writer_data(const struct McPkgMpWriter *w,
+                size_t *out_len);
 
+/* Indexes root keys 0..31 once; lookups of those are O(1). */
 MCPKG_API int  mcpkg_mp_reader_init(struct McPkgMpReader *r,
                                     const void *buf, size_t len);
 MCPKG_API void mcpkg_mp_reader_destroy(struct McPkgMpReader *r);
@@ -61,13 +100,63 @@ MCPKG_API int  mcpkg_mp_kv_nil(struct McPkgMpWriter *w, int key);
 #define MCPKG_MP_K_TAG  0
 #define MCPKG_MP_K_VER  1
 
+/*
+ * Exact encoded sizes of what the writer emits (smallest int/str/bin/
+ * container forms), for *_packed_size.
+ */
+static inline size_t mcpkg_mp_size_int(int64_t v)
+{
+	if (v >= 0)
+		return v < 128 ? 1 : v < 256 ? 2 : v < 65536 ? 3 :
+		       v <= UINT32_MAX ? 5 : 9;
+	return v >= -32 ? 1 : v >= INT8_MIN ? 2 : v >= INT16_MIN ? 3 :
+	       v >= INT32_MIN ? 5 : 9;
+}
+
+static inline size_t mcpkg_mp_size_str_n(size_t n)
+{
+	return n + (n < 32 ? 1 : n < 256 ? 2 : n < 65536 ? 3 : 5);
+}
+
+/* nil when s is NULL */
+static inline size_t mcpkg_mp_size_str(const char *s)
+{
+	return s ? mcpkg_mp_size_str_n(strlen(s)) : 1;
+}
+
+static inline size_t mcpkg_mp_size_bin(size_t n)
+{
+	return n + (n < 256 ? 2 : n < 65536 ? 3 : 5);
+}
+
+/* map or array header for n pairs / elements */
+static inline size_t mcpkg_mp_size_container(size_t n)
+{
+	return n < 16 ? 1 : n < 65536 ? 3 : 5;
+}
+
+/* tag/version header pairs, as mcpkg_mp_write_header writes them */
+static inline size_t mcpkg_mp_size_header(const char *tag, int version)
+{
+	return mcpkg_mp_size_int(MCPKG_MP_K_TAG) + mcpkg_mp_size_str(tag) +
+	       mcpkg_mp_size_int(MCPKG_MP_K_VER) + mcpkg_mp_size_int(version);
+}
+
+/* value of mcpkg_mp_kv_strlist (nil when sl is NULL) */
+MCPKG_API size_t mcpkg_mp_size_strlist(const struct McPkgStringList *sl);
+
 
 
 // ## Debugging helpers
 
 MCPKG_API char *mcpkg_mp_util_dup_str(const char *s);
 
-/* Small printf-style builder. Grows *dst via realloc. */
+/* Copy s[0, len) NUL-terminated into a, or the heap when a is NULL. */
+struct McPkgArena;
+MCPKG_API char *mcpkg_mp_util_dup_strn(struct McPkgArena *a, const char *s,
+                                       size_t len);
+
+/* Small printf-style builder. Grows *dst on the default allocator. */
 MCPKG_API int mcpkg_mp_util_dbg_append(char **dst, size_t *cap, size_t *len,
                                        const char *fmt, ...);
 
@@ -99,6 +188,10 @@ MCPKG_API int  mcpkg_mp_kv_strlist(struct McPkgMpWriter *w, int key,
                                    const struct McPkgStringList *sl);
 MCPKG_API int  mcpkg_mp_get_strlist_dup(const struct McPkgMpReader *r, int key,
                                         struct McPkgStringList **out_sl);
+/* Same; with a non-NULL arena the list lives in it (see new_arena). */
+MCPKG_API int  mcpkg_mp_get_strlist_dup_arena(const struct McPkgMpReader *r,
+                int key, struct McPkgArena *a,
+                struct McPkgStringList **out_sl);
 
 /* Begin a map or array as the VALUE for an int key */
 MCPKG_API int  mcpkg_mp_kv_map_begin(struct McPkgMpWriter *w, int key,
@@ -112,6 +205,9 @@ MCPKG_API int  mcpkg_mp_kv_array_begin(struct McPkgMpWriter *w, int key,
 MCPKG_API int  mcpkg_mp_write_bin(struct McPkgMpWriter *w,
                                   const void *data, uint32_t len);
 
+/* Write just an int key; the next value written belongs to it. */
+MCPKG_API int  mcpkg_mp_write_key(struct McPkgMpWriter *w, int key);
+
 /* Opaque cursor over an array value (borrowed; reader must outlive cursor). */
 struct McPkgMpArrayCur;
 
@@ -129,5 +225,85 @@ MCPKG_API int  mcpkg_mp_array_get_bin_borrow(struct McPkgMpArrayCur *cur,
 /* Destroy array cursor (does not affect reader). */
 MCPKG_API void mcpkg_mp_array_cur_destroy(struct McPkgMpArrayCur *cur);
 
+/*
+ * Single-pass cursor over raw msgpack bytes (generated decoders).
+ * - Values are read in order; each call consumes one value.
+ * - Nothing is allocated; strings and bins point into the buffer.
+ * - Any error (PARSE on truncated/mistyped input) leaves the cursor
+ *   position unspecified; callers give up on the buffer.
+ */
+struct McPkgMpCur {
+	const unsigned char	*p;
+	const unsigned char	*end;
+};
+
+MCPKG_API void mcpkg_mp_cur_init(struct McPkgMpCur *c, const void *buf,
+                                 size_t len);
+
+/* Map/array header: *n entries (pairs for maps) follow. */
+MCPKG_API int  mcpkg_mp_cur_map(struct McPkgMpCur *c, size_t *n);
+MCPKG_API int  mcpkg_mp_cur_array(struct McPkgMpCur *c, size_t *n);
+
+/* 1 (and consumed) if the next value is nil, else 0. */
+MCPKG_API int  mcpkg_mp_cur_nil(struct McPkgMpCur *c);
+
+/* 1 if the next value is a bin (not consumed), else 0. */
+MCPKG_API int  mcpkg_mp_cur_is_bin(const struct McPkgMpCur *c);
+
+/* Map key: int keys as is; any other key is skipped and reads as -1. */
+MCPKG_API int  mcpkg_mp_cur_key(struct McPkgMpCur *c, int *key);
+
+/* Integers; out-of-range values are PARSE errors. */
+MCPKG_API int  mcpkg_mp_cur_i64(struct McPkgMpCur *c, int64_t *out);
+MCPKG_API int  mcpkg_mp_cur_u64(struct McPkgMpCur *c, uint64_t *out);
+MCPKG_API int  mcpkg_mp_cur_i32(struct McPkgMpCur *c, int32_t *out);
+MCPKG_API int  mcpkg_mp_cur_u32(struct McPkgMpCur *c, uint32_t *out);
+
+/* Borrow a str/bin payload (not NUL-terminated). */
+MCPKG_API int  mcpkg_mp_cur_str(struct McPkgMpCur *c, const char **out_ptr,
+                                size_t *out_len);
+MCPKG_API int  mcpkg_mp_cur_bin(struct McPkgMpCur *c, const void **out_ptr,
+                                size_t *out_len);
+
+/* Read a str and require it to equal tag (PARSE otherwise). */
+MCPKG_API int  mcpkg_mp_cur_tag(struct McPkgMpCur *c, const char *tag);
+
+/* Skip one value of any type, nested containers included. */
+MCPKG_API int  mcpkg_mp_cur_skip(struct McPkgMpCur *c);
+
+/*
+ * Array of str (or nil -> *out_sl NULL) into a new packed string list,
+ * in a when non-NULL; same rules as mcpkg_mp_get_strlist_dup_arena.
+ */
+MCPKG_API int  mcpkg_mp_cur_strlist(struct McPkgMpCur *c,
+                                    struct McPkgArena *a,
+                                    struct McPkgStringList **out_sl);
+
+/*
+ * Borrowed pieces of a buffer, for the generated *View decoders. Both
+ * are valid while the buffer lives; p NULL means nil/absent.
+ * - McPkgMpStr: a str payload, not NUL-terminated.
+ * - McPkgMpSpan: still-encoded values; for arrays the n elements after
+ *   the header, otherwise one whole value (n = 1). Read it back with
+ *   mcpkg_mp_cur_init(&c, s.p, s.len).
+ */
+struct McPkgMpStr {
+	const char		*p;
+	size_t			len;
+};
+
+struct McPkgMpSpan {
+	const unsigned char	*p;
+	size_t			len;
+	size_t			n;
+};
+
+/* Take the next value as a span (nil: all zero) without decoding it. */
+MCPKG_API int  mcpkg_mp_cur_span(struct McPkgMpCur *c,
+                                 struct McPkgMpSpan *out);
+
+/* 1 if s holds exactly z (an absent s only matches NULL), else 0. */
+MCPKG_API int  mcpkg_mp_str_eq(const struct McPkgMpStr *s, const char *z);
+
 MCPKG_END_DECLS
 #endif /* MCPKG_MP_UTILS_H */
@@ -92,6 +92,13 @@ mcpkg_net_curl_to_net_error(CURLcode cc)
 
 MCPKG_API int
 mcpkg_net_buf_init(struct McPkgNetBuf *b, size_t initial_cap)
+{
+	return mcpkg_net_buf_init_alloc(b, initial_cap, NULL);
+}
+
+MCPKG_API int
+mcpkg_net_buf_init_alloc(struct McPkgNetBuf *b, size_t initial_cap,
+                         const McPkgAllocator *alloc)
 {
 	int ret = MCPKG_NET_NO_ERROR;
 
@@ -102,8 +109,10 @@ mcpkg_net_buf_init(struct McPkgNetBuf *b, size_t initial_cap)
 		b->data = NULL;
 		b->len = 0;
 		b->cap = 0;
+		b->alloc = alloc ? alloc : mcpkg_allocator_default();
 		if (initial_cap) {
-			b->data = (unsigned char *)malloc(initial_cap);
+			b->data = (unsigned char *)mcpkg_allocator_alloc(b->alloc,
+			                initial_cap);
 			if (!b->data) {
 				ret = MCPKG_NET_ERR_NOMEM;
 			} else {
@@ -130,7 +139,7 @@ mcpkg_net_buf_reserve(struct McPkgNetBuf *b, size_t need_cap)
 		new_cap *= 2;
 	}
 
-	p = realloc(b->data, new_cap);
+	p = mcpkg_allocator_realloc(b->alloc, b->data, b->cap, new_cap);
 	if (!p) return MCPKG_NET_ERR_NOMEM;
 
 	b->data = (unsigned char *)p;
@@ -174,7 +183,7 @@ mcpkg_net_buf_free(struct McPkgNetBuf *b)
 {
 	if (!b)
 		return;
-	free(b->data);
+	mcpkg_allocator_free(b->alloc, b->data, b->cap);
 	b->data = NULL;
 	b->len = 0;
 	b->cap = 0;
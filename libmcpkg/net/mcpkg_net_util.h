@@ -5,6 +5,7 @@
 #include <stddef.h>
 #include "mcpkg_export.h"
 #include "mcpkg_fs_error.h"
+#include "container/mcpkg_alloc.h"
 
 MCPKG_BEGIN_DECLS
 typedef enum MCPKG_NET_ERROR {
@@ -33,6 +34,7 @@ struct McPkgNetBuf {
 	unsigned char *data; // own
 	size_t len;
 	size_t cap;          // alloc
+	const McPkgAllocator *alloc; // NULL = default
 };
 
 
@@ -78,6 +80,10 @@ static int mcpkg_net_utils_fs_err_to_net_err(int fs_err)
 MCPKG_API int mcpkg_net_curl_to_net_error(CURLcode cc);
 
 MCPKG_API int  mcpkg_net_buf_init(struct McPkgNetBuf *b, size_t initial_cap);
+// Same; data comes from alloc (NULL = default), which must outlive b
+MCPKG_API int  mcpkg_net_buf_init_alloc(struct McPkgNetBuf *b,
+                                        size_t initial_cap,
+                                        const McPkgAllocator *alloc);
 MCPKG_API int  mcpkg_net_buf_reserve(struct McPkgNetBuf *b, size_t need_cap);
 MCPKG_API int  mcpkg_net_buf_append(struct McPkgNetBuf *b, const void *data,
                                     size_t n);
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: MIT */
 #include "net/modrinth/mcpkg_modrinth_json.h"
 
+#include "container/mcpkg_arena.h"
 #include "container/mcpkg_list.h"
 #include "container/mcpkg_str_list.h"
 
@@ -24,6 +25,44 @@ static char *dup_str(const char *s)
 	return mcpkg_mp_util_dup_str(s);
 }
 
+/* arena-or-heap allocation for build_pkg_meta */
+static char *dup_str_a(McPkgArena *a, const char *s)
+{
+	return a ? mcpkg_arena_strdup(a, s) : dup_str(s);
+}
+
+static struct McPkgStringList *new_strlist(McPkgArena *a)
+{
+	return a ? mcpkg_stringlist_new_arena(a, 0, 0)
+	       : mcpkg_stringlist_new(0, 0);
+}
+
+/* list of struct pointers */
+static struct McPkgList *new_ptr_list(McPkgArena *a)
+{
+	return a ? mcpkg_list_new_arena(a, sizeof(void *), NULL, 0, 0)
+	       : mcpkg_list_new(sizeof(void *), NULL, 0, 0);
+}
+
+/* partial objects: arena ones go with the rewind in build_pkg_meta */
+static void drop_file(McPkgArena *a, struct McPkgFile *pf)
+{
+	if (!a)
+		mcpkg_mp_pkg_file_free(pf);
+}
+
+static void drop_digest(McPkgArena *a, struct McPkgDigest *dg)
+{
+	if (!a)
+		mcpkg_mp_pkg_digest_free(dg);
+}
+
+static void drop_depends(McPkgArena *a, struct McPkgDepends *dp)
+{
+	if (!a)
+		mcpkg_mp_pkg_depends_free(dp);
+}
+
 static int sl_push(struct McPkgStringList *sl, const char *s)
 {
 	return mcpkg_stringlist_push(sl, s);
@@ -99,7 +138,7 @@ static int push_string_ptr(struct McPkgList *lst, const char *s)
 	if (!d)
 		return MCPKG_MODRINTH_JSON_ERR_NOMEM;
 	if (mcpkg_list_push(lst, &d) != MCPKG_CONTAINER_OK) {
-		free(d);
+		mcpkg_free(d);
 		return MCPKG_MODRINTH_JSON_ERR_NOMEM;
 	}
 	return MCPKG_MODRINTH_JSON_NO_ERROR;
@@ -113,7 +152,7 @@ static void free_string_ptr_list(struct McPkgList *lst)
 	for (i = 0; i < n; i++) {
 		char *s = NULL;
 		if (mcpkg_list_at(lst, i, &s) == MCPKG_CONTAINER_OK && s)
-			free(s);
+			mcpkg_free(s);
 	}
 	mcpkg_list_free(lst);
 }
@@ -138,14 +177,14 @@ MCPKG_API void
 mcpkg_modrinth_hit_free(struct McPkgModrinthHit *h)
 {
 	if (!h) return;
-	if (h->project_id) free(h->project_id);
-	if (h->slug) free(h->slug);
-	if (h->title) free(h->title);
-	if (h->description) free(h->description);
-	if (h->license_id) free(h->license_id);
-	if (h->icon_url) free(h->icon_url);
+	if (h->project_id) mcpkg_free(h->project_id);
+	if (h->slug) mcpkg_free(h->slug);
+	if (h->title) mcpkg_free(h->title);
+	if (h->description) mcpkg_free(h->description);
+	if (h->license_id) mcpkg_free(h->license_id);
+	if (h->icon_url) mcpkg_free(h->icon_url);
 	if (h->categories) mcpkg_stringlist_free(h->categories);
-	free(h);
+	mcpkg_free(h);
 }
 
 /* ---- public: parse search (detailed) ---- */
@@ -169,7 +208,7 @@ mcpkg_modrinth_parse_search_hits_detailed(const char *json,
 	if (!hits_out)
 		return MCPKG_MODRINTH_JSON_ERR_NOMEM;
 
-	tmp = (char *)malloc(json_len + 1U);
+	tmp = (char *)mcpkg_malloc(json_len + 1U);
 	if (!tmp) {
 		ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 		goto out;
@@ -217,7 +256,7 @@ mcpkg_modrinth_parse_search_hits_detailed(const char *json,
 			if (!id_str || !id_str[0])
 				continue;
 
-			h = (struct McPkgModrinthHit *)calloc(1, sizeof(*h));
+			h = (struct McPkgModrinthHit *)mcpkg_calloc(1, sizeof(*h));
 			if (!h) {
 				ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 				goto out;
@@ -279,7 +318,7 @@ mcpkg_modrinth_parse_search_hits_detailed(const char *json,
 out:
 	if (hits_out) free_hit_list(hits_out);
 	if (root) cJSON_Delete(root);
-	if (tmp) free(tmp);
+	if (tmp) mcpkg_free(tmp);
 	return ret;
 }
 
@@ -304,7 +343,7 @@ mcpkg_modrinth_parse_search_hit_ids(const char *json,
 	if (!ids)
 		return MCPKG_MODRINTH_JSON_ERR_NOMEM;
 
-	tmp = (char *)malloc(json_len + 1U);
+	tmp = (char *)mcpkg_malloc(json_len + 1U);
 	if (!tmp) {
 		ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 		goto out;
@@ -358,7 +397,7 @@ mcpkg_modrinth_parse_search_hit_ids(const char *json,
 out:
 	if (ids) free_string_ptr_list(ids);
 	if (root) cJSON_Delete(root);
-	if (tmp) free(tmp);
+	if (tmp) mcpkg_free(tmp);
 	return ret;
 }
 
@@ -384,7 +423,7 @@ mcpkg_modrinth_choose_version_idx(const char *versions_json,
 	if (!versions_json || !out_idx)
 		return MCPKG_MODRINTH_JSON_ERR_INVALID;
 
-	tmp = (char *)malloc(versions_len + 1U);
+	tmp = (char *)mcpkg_malloc(versions_len + 1U);
 	if (!tmp) return MCPKG_MODRINTH_JSON_ERR_NOMEM;
 	memcpy(tmp, versions_json, versions_len);
 	tmp[versions_len] = '\0';
@@ -392,7 +431,7 @@ mcpkg_modrinth_choose_version_idx(const char *versions_json,
 	arr = cJSON_Parse(tmp);
 	if (!cJSON_IsArray(arr)) {
 		cJSON_Delete(arr);
-		free(tmp);
+		mcpkg_free(tmp);
 		return MCPKG_MODRINTH_JSON_ERR_PARSE;
 	}
 
@@ -461,21 +500,23 @@ mcpkg_modrinth_choose_version_idx(const char *versions_json,
 
 	*out_idx = idx;
 	cJSON_Delete(arr);
-	free(tmp);
+	mcpkg_free(tmp);
 	return MCPKG_MODRINTH_JSON_NO_ERROR;
 }
 
-/* ---- public: build McPkgCache from chosen version + optional hit ---- */
-
-MCPKG_API int
-mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
-                              const char *versions_json,
-                              size_t versions_len,
-                              int ver_idx,
-                              const char *provider,
-                              struct McPkgCache **out_cache,
-                              uint32_t *out_flags)
+/* ---- build McPkgCache from chosen version + optional hit ---- */
+
+/* a == NULL: heap graph, else everything comes from a */
+static int build_pkg_meta(const struct McPkgModrinthHit *hit,
+                          const char *versions_json,
+                          size_t versions_len,
+                          int ver_idx,
+                          const char *provider,
+                          McPkgArena *a,
+                          struct McPkgCache **out_cache,
+                          uint32_t *out_flags)
 {
+	McPkgArenaMark mark = mcpkg_arena_mark(a);
 	char *tmp = NULL;
 	cJSON *arr = NULL;
 	const cJSON *ver = NULL;
@@ -486,7 +527,7 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 	if (!versions_json || ver_idx < 0 || !out_cache || !provider)
 		return MCPKG_MODRINTH_JSON_ERR_INVALID;
 
-	tmp = (char *)malloc(versions_len + 1U);
+	tmp = (char *)mcpkg_malloc(versions_len + 1U);
 	if (!tmp) return MCPKG_MODRINTH_JSON_ERR_NOMEM;
 	memcpy(tmp, versions_json, versions_len);
 	tmp[versions_len] = '\0';
@@ -502,7 +543,7 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 		goto out;
 	}
 
-	p = mcpkg_mp_pkg_meta_new();
+	p = mcpkg_mp_pkg_meta_new_arena(a);
 	if (!p) {
 		ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 		goto out;
@@ -517,14 +558,14 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 		const cJSON *loaders    = cJSON_GetObjectItemCaseSensitive(ver, "loaders");
 
 		if (cJSON_IsString(project_id) && project_id->valuestring)
-			p->id = dup_str(project_id->valuestring);
+			p->id = dup_str_a(a, project_id->valuestring);
 		if (!p->id) {
 			ret = MCPKG_MODRINTH_JSON_ERR_PARSE;
 			goto out_err;
 		}
 
 		if (cJSON_IsString(version_no) && version_no->valuestring)
-			p->version = dup_str(version_no->valuestring);
+			p->version = dup_str_a(a, version_no->valuestring);
 		if (!p->version) {
 			ret = MCPKG_MODRINTH_JSON_ERR_PARSE;
 			goto out_err;
@@ -533,7 +574,7 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 		/* loaders (>=1) */
 		if (cJSON_IsArray(loaders)) {
 			const cJSON *e;
-			p->loaders = mcpkg_stringlist_new(0, 0);
+			p->loaders = new_strlist(a);
 			if (!p->loaders) {
 				ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 				goto out_err;
@@ -554,7 +595,7 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 
 		/* origin */
 		{
-			struct McPkgOrigin *o = mcpkg_mp_pkg_origin_new();
+			struct McPkgOrigin *o = mcpkg_mp_pkg_origin_new_arena(a);
 			const cJSON *files = cJSON_GetObjectItemCaseSensitive(ver, "files");
 			const cJSON *primary = NULL;
 
@@ -563,10 +604,10 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 				goto out_err;
 			}
 
-			o->provider   = dup_str(provider);
-			o->project_id = dup_str(p->id);
+			o->provider   = dup_str_a(a, provider);
+			o->project_id = dup_str_a(a, p->id);
 			if (cJSON_IsString(version_id) && version_id->valuestring)
-				o->version_id = dup_str(version_id->valuestring);
+				o->version_id = dup_str_a(a, version_id->valuestring);
 
 			if (cJSON_IsArray(files)) {
 				const cJSON *f;
@@ -582,7 +623,7 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 				if (cJSON_IsObject(primary)) {
 					const cJSON *url = cJSON_GetObjectItemCaseSensitive(primary, "url");
 					if (cJSON_IsString(url) && url->valuestring)
-						o->source_url = dup_str(url->valuestring);
+						o->source_url = dup_str_a(a, url->valuestring);
 				}
 			}
 			p->origin = o;
@@ -591,17 +632,17 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 
 	/* enrich from hit */
 	if (hit) {
-		if (hit->slug && hit->slug[0]) p->slug = dup_str(hit->slug);
-		if (hit->title && hit->title[0]) p->title = dup_str(hit->title);
+		if (hit->slug && hit->slug[0]) p->slug = dup_str_a(a, hit->slug);
+		if (hit->title && hit->title[0]) p->title = dup_str_a(a, hit->title);
 		if (hit->description
-		    && hit->description[0]) p->description = dup_str(hit->description);
+		    && hit->description[0]) p->description = dup_str_a(a, hit->description);
 		if (hit->license_id
-		    && hit->license_id[0]) p->license_id = dup_str(hit->license_id);
+		    && hit->license_id[0]) p->license_id = dup_str_a(a, hit->license_id);
 		p->client = hit->client;
 		p->server = hit->server;
 		if (hit->categories) {
 			size_t i, n = mcpkg_stringlist_size(hit->categories);
-			p->sections = mcpkg_stringlist_new(0, 0);
+			p->sections = new_strlist(a);
 			if (!p->sections) {
 				ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 				goto out_err;
@@ -619,7 +660,7 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 	} else {
 		const cJSON *proj_slug = cJSON_GetObjectItemCaseSensitive(ver, "project_slug");
 		if (cJSON_IsString(proj_slug) && proj_slug->valuestring)
-			p->slug = dup_str(proj_slug->valuestring);
+			p->slug = dup_str_a(a, proj_slug->valuestring);
 	}
 
 	/* files -> McPkgFile */
@@ -655,28 +696,28 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 			const cJSON *size = cJSON_GetObjectItemCaseSensitive(usef, "size");
 			const cJSON *hash = cJSON_GetObjectItemCaseSensitive(usef, "hashes");
 
-			struct McPkgFile *pf = mcpkg_mp_pkg_file_new();
+			struct McPkgFile *pf = mcpkg_mp_pkg_file_new_arena(a);
 			if (!pf) {
 				ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 				goto out_err;
 			}
 
 			if (cJSON_IsString(url)
-			    && url->valuestring)      pf->url       = dup_str(url->valuestring);
+			    && url->valuestring)      pf->url       = dup_str_a(a, url->valuestring);
 			if (cJSON_IsString(name)
-			    && name->valuestring)    pf->file_name = dup_str(name->valuestring);
+			    && name->valuestring)    pf->file_name = dup_str_a(a, name->valuestring);
 			if (cJSON_IsNumber(size) && size->valuedouble >= 0.0)
 				pf->size = (uint64_t)size->valuedouble;
 
 			if (!pf->url || !pf->file_name) {
-				mcpkg_mp_pkg_file_free(pf);
+				drop_file(a, pf);
 				ret = MCPKG_MODRINTH_JSON_ERR_PARSE;
 				goto out_err;
 			}
 
-			pf->digests = mcpkg_list_new(sizeof(struct McPkgDigest *), NULL, 0, 0);
+			pf->digests = new_ptr_list(a);
 			if (!pf->digests) {
-				mcpkg_mp_pkg_file_free(pf);
+				drop_file(a, pf);
 				ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 				goto out_err;
 			}
@@ -686,34 +727,34 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 				const cJSON *sha1   = cJSON_GetObjectItemCaseSensitive(hash, "sha1");
 
 				if (cJSON_IsString(sha512) && sha512->valuestring && sha512->valuestring[0]) {
-					struct McPkgDigest *dg = mcpkg_mp_pkg_digest_new();
+					struct McPkgDigest *dg = mcpkg_mp_pkg_digest_new_arena(a);
 					if (!dg) {
-						mcpkg_mp_pkg_file_free(pf);
+						drop_file(a, pf);
 						ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 						goto out_err;
 					}
 					dg->algo = 3u; /* SHA512 */
-					dg->hex  = dup_str(sha512->valuestring);
+					dg->hex  = dup_str_a(a, sha512->valuestring);
 					if (!dg->hex || mcpkg_list_push(pf->digests, &dg) != MCPKG_CONTAINER_OK) {
-						mcpkg_mp_pkg_digest_free(dg);
-						mcpkg_mp_pkg_file_free(pf);
+						drop_digest(a, dg);
+						drop_file(a, pf);
 						ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 						goto out_err;
 					}
 					flags |= MCPKG_MODRINTH_F_HAS_SHA512;
 				}
 				if (cJSON_IsString(sha1) && sha1->valuestring && sha1->valuestring[0]) {
-					struct McPkgDigest *dg = mcpkg_mp_pkg_digest_new();
+					struct McPkgDigest *dg = mcpkg_mp_pkg_digest_new_arena(a);
 					if (!dg) {
-						mcpkg_mp_pkg_file_free(pf);
+						drop_file(a, pf);
 						ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 						goto out_err;
 					}
 					dg->algo = 1u; /* SHA1 */
-					dg->hex  = dup_str(sha1->valuestring);
+					dg->hex  = dup_str_a(a, sha1->valuestring);
 					if (!dg->hex || mcpkg_list_push(pf->digests, &dg) != MCPKG_CONTAINER_OK) {
-						mcpkg_mp_pkg_digest_free(dg);
-						mcpkg_mp_pkg_file_free(pf);
+						drop_digest(a, dg);
+						drop_file(a, pf);
 						ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 						goto out_err;
 					}
@@ -730,7 +771,7 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 		const cJSON *deps = cJSON_GetObjectItemCaseSensitive(ver, "dependencies");
 		if (cJSON_IsArray(deps)) {
 			const cJSON *d;
-			p->depends = mcpkg_list_new(sizeof(struct McPkgDepends *), NULL, 0, 0);
+			p->depends = new_ptr_list(a);
 			if (!p->depends) {
 				ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 				goto out_err;
@@ -742,15 +783,15 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 				const cJSON *kind = cJSON_GetObjectItemCaseSensitive(d, "dependency_type");
 
 				if (cJSON_IsString(proj) && proj->valuestring && proj->valuestring[0]) {
-					struct McPkgDepends *dp = mcpkg_mp_pkg_depends_new();
+					struct McPkgDepends *dp = mcpkg_mp_pkg_depends_new_arena(a);
 					if (!dp) {
 						ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 						goto out_err;
 					}
 
-					dp->id = dup_str(proj->valuestring);
+					dp->id = dup_str_a(a, proj->valuestring);
 					if (!dp->id) {
-						mcpkg_mp_pkg_depends_free(dp);
+						drop_depends(a, dp);
 						ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 						goto out_err;
 					}
@@ -760,12 +801,12 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 						if (need < 256) {
 							char vr[256];
 							snprintf(vr, sizeof(vr), "id:%s", verid->valuestring);
-							dp->version_range = dup_str(vr);
+							dp->version_range = dup_str_a(a, vr);
 						} else {
-							dp->version_range = dup_str("*");
+							dp->version_range = dup_str_a(a, "*");
 						}
 					} else {
-						dp->version_range = dup_str("*");
+						dp->version_range = dup_str_a(a, "*");
 					}
 
 					dp->kind = dep_kind_from_str(cJSON_IsString(kind) ? kind->valuestring :
@@ -777,7 +818,7 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 
 					if (!dp->version_range ||
 					    mcpkg_list_push(p->depends, &dp) != MCPKG_CONTAINER_OK) {
-						mcpkg_mp_pkg_depends_free(dp);
+						drop_depends(a, dp);
 						ret = MCPKG_MODRINTH_JSON_ERR_NOMEM;
 						goto out_err;
 					}
@@ -793,9 +834,41 @@ mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
 	goto out;
 
 out_err:
-	mcpkg_mp_pkg_meta_free(p);
+	if (a)
+		mcpkg_arena_rewind(a, &mark);
+	else
+		mcpkg_mp_pkg_meta_free(p);
 out:
 	if (arr) cJSON_Delete(arr);
-	if (tmp) free(tmp);
+	if (tmp) mcpkg_free(tmp);
 	return ret;
 }
+
+MCPKG_API int
+mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
+                              const char *versions_json,
+                              size_t versions_len,
+                              int ver_idx,
+                              const char *provider,
+                              struct McPkgCache **out_cache,
+                              uint32_t *out_flags)
+{
+	return build_pkg_meta(hit, versions_json, versions_len, ver_idx,
+	                      provider, NULL, out_cache, out_flags);
+}
+
+MCPKG_API int
+mcpkg_modrinth_build_pkg_meta_arena(const struct McPkgModrinthHit *hit,
+                                    const char *versions_json,
+                                    size_t versions_len,
+                                    int ver_idx,
+                                    const char *provider,
+                                    McPkgArena *arena,
+                                    struct McPkgCache **out_cache,
+                                    uint32_t *out_flags)
+{
+	if (!arena)
+		return MCPKG_MODRINTH_JSON_ERR_INVALID;
+	return build_pkg_meta(hit, versions_json, versions_len, ver_idx,
+	                      provider, arena, out_cache, out_flags);
+}
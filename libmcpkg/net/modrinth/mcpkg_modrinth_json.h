@@ -76,5 +76,18 @@ MCPKG_API int mcpkg_modrinth_build_pkg_meta(const struct McPkgModrinthHit *hit,
                 struct McPkgCache **out_cache,
                 uint32_t *out_flags);
 
+// same, but the whole McPkgCache graph is allocated from arena (one page
+// of results can share one arena); release it with mcpkg_arena_reset/free,
+// never mcpkg_mp_pkg_meta_free. On error nothing is left in arena.
+MCPKG_API int mcpkg_modrinth_build_pkg_meta_arena(
+        const struct McPkgModrinthHit *hit,
+        const char *versions_json,
+        size_t versions_len,
+        int ver_idx,
+        const char *provider,
+        struct McPkgArena *arena,
+        struct McPkgCache **out_cache,
+        uint32_t *out_flags);
+
 MCPKG_END_DECLS
 #endif /* MCPKG_MODRINTH_JSON_H */
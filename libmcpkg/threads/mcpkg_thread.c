@@ -84,3 +84,57 @@ void mcpkg_cond_broadcast(struct McPkgCond *c)
 {
 	mcpkg_cond_impl_broadcast(c);
 }
+
+/* ---------- rw lock ---------- */
+
+struct McPkgRwLock *mcpkg_rwlock_new(void)
+{
+	return mcpkg_rwlock_impl_new();
+}
+
+void mcpkg_rwlock_free(struct McPkgRwLock *l)
+{
+	mcpkg_rwlock_impl_free(l);
+}
+
+void mcpkg_rwlock_rdlock(struct McPkgRwLock *l)
+{
+	mcpkg_rwlock_impl_rdlock(l);
+}
+
+void mcpkg_rwlock_rdunlock(struct McPkgRwLock *l)
+{
+	mcpkg_rwlock_impl_rdunlock(l);
+}
+
+void mcpkg_rwlock_wrlock(struct McPkgRwLock *l)
+{
+	mcpkg_rwlock_impl_wrlock(l);
+}
+
+void mcpkg_rwlock_wrunlock(struct McPkgRwLock *l)
+{
+	mcpkg_rwlock_impl_wrunlock(l);
+}
+
+/* ---------- thread-local slot ---------- */
+
+struct McPkgTls *mcpkg_tls_new(void (*dtor)(void *))
+{
+	return mcpkg_tls_impl_new(dtor);
+}
+
+void mcpkg_tls_free(struct McPkgTls *k)
+{
+	mcpkg_tls_impl_free(k);
+}
+
+void *mcpkg_tls_get(struct McPkgTls *k)
+{
+	return mcpkg_tls_impl_get(k);
+}
+
+int mcpkg_tls_set(struct McPkgTls *k, void *v)
+{
+	return mcpkg_tls_impl_set(k, v);
+}
@@ -12,6 +12,8 @@ MCPKG_BEGIN_DECLS
 struct McPkgThread;
 struct McPkgMutex;
 struct McPkgCond;
+struct McPkgRwLock;
+struct McPkgTls;
 
 typedef int (*mcpkg_thread_fn)(void *arg);
 
@@ -40,6 +42,24 @@ MCPKG_API int  mcpkg_cond_timedwait(struct McPkgCond *c, struct McPkgMutex *m,
 MCPKG_API void mcpkg_cond_signal(struct McPkgCond *c);
 MCPKG_API void mcpkg_cond_broadcast(struct McPkgCond *c);
 
+/* RW lock; unlock must match the mode it was taken in */
+MCPKG_API struct McPkgRwLock *mcpkg_rwlock_new(void);
+MCPKG_API void mcpkg_rwlock_free(struct McPkgRwLock *l);
+MCPKG_API void mcpkg_rwlock_rdlock(struct McPkgRwLock *l);
+MCPKG_API void mcpkg_rwlock_rdunlock(struct McPkgRwLock *l);
+MCPKG_API void mcpkg_rwlock_wrlock(struct McPkgRwLock *l);
+MCPKG_API void mcpkg_rwlock_wrunlock(struct McPkgRwLock *l);
+
+/*
+ * Thread-local slot. dtor (may be NULL) runs on a thread's non-NULL
+ * value when that thread exits. Free the slot only once no thread
+ * uses it; leftover values may or may not be destroyed (per OS).
+ */
+MCPKG_API struct McPkgTls *mcpkg_tls_new(void (*dtor)(void *));
+MCPKG_API void mcpkg_tls_free(struct McPkgTls *k);
+MCPKG_API void *mcpkg_tls_get(struct McPkgTls *k);
+MCPKG_API int mcpkg_tls_set(struct McPkgTls *k, void *v);
+
 
 MCPKG_END_DECLS
 #endif
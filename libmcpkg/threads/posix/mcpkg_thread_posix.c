@@ -189,3 +189,67 @@ void mcpkg_cond_impl_broadcast(struct McPkgCond *c)
 {
 	pthread_cond_broadcast(&c->c);
 }
+
+/* RW lock */
+struct McPkgRwLock *mcpkg_rwlock_impl_new(void)
+{
+	struct McPkgRwLock *l = malloc(sizeof(*l));
+	if (!l) return NULL;
+	if (pthread_rwlock_init(&l->l, NULL) != 0) {
+		free(l);
+		return NULL;
+	}
+	return l;
+}
+void mcpkg_rwlock_impl_free(struct McPkgRwLock *l)
+{
+	if (l) {
+		pthread_rwlock_destroy(&l->l);
+		free(l);
+	}
+}
+void mcpkg_rwlock_impl_rdlock(struct McPkgRwLock *l)
+{
+	pthread_rwlock_rdlock(&l->l);
+}
+void mcpkg_rwlock_impl_rdunlock(struct McPkgRwLock *l)
+{
+	pthread_rwlock_unlock(&l->l);
+}
+void mcpkg_rwlock_impl_wrlock(struct McPkgRwLock *l)
+{
+	pthread_rwlock_wrlock(&l->l);
+}
+void mcpkg_rwlock_impl_wrunlock(struct McPkgRwLock *l)
+{
+	pthread_rwlock_unlock(&l->l);
+}
+
+/* Thread-local slot */
+struct McPkgTls *mcpkg_tls_impl_new(void (*dtor)(void *))
+{
+	struct McPkgTls *k = malloc(sizeof(*k));
+	if (!k) return NULL;
+	if (pthread_key_create(&k->k, dtor) != 0) {
+		free(k);
+		return NULL;
+	}
+	return k;
+}
+void mcpkg_tls_impl_free(struct McPkgTls *k)
+{
+	if (k) {
+		pthread_key_delete(k->k);
+		free(k);
+	}
+}
+void *mcpkg_tls_impl_get(struct McPkgTls *k)
+{
+	return pthread_getspecific(k->k);
+}
+int mcpkg_tls_impl_set(struct McPkgTls *k, void *v)
+{
+	int r = pthread_setspecific(k->k, v);
+	return r == 0 ? MCPKG_THREAD_NO_ERROR :
+	       (r == ENOMEM ? MCPKG_THREAD_E_NOMEM : MCPKG_THREAD_E_SYS);
+}
@@ -157,3 +157,89 @@ void mcpkg_cond_impl_broadcast(struct McPkgCond *c)
 {
 	WakeAllConditionVariable(&c->cv);
 }
+
+/* RW lock (SRW locks need no teardown) */
+struct McPkgRwLock *mcpkg_rwlock_impl_new(void)
+{
+	struct McPkgRwLock *l = (struct McPkgRwLock *)malloc(sizeof(*l));
+	if (!l) return NULL;
+	InitializeSRWLock(&l->l);
+	return l;
+}
+void mcpkg_rwlock_impl_free(struct McPkgRwLock *l)
+{
+	if (l) free(l);
+}
+void mcpkg_rwlock_impl_rdlock(struct McPkgRwLock *l)
+{
+	AcquireSRWLockShared(&l->l);
+}
+void mcpkg_rwlock_impl_rdunlock(struct McPkgRwLock *l)
+{
+	ReleaseSRWLockShared(&l->l);
+}
+void mcpkg_rwlock_impl_wrlock(struct McPkgRwLock *l)
+{
+	AcquireSRWLockExclusive(&l->l);
+}
+void mcpkg_rwlock_impl_wrunlock(struct McPkgRwLock *l)
+{
+	ReleaseSRWLockExclusive(&l->l);
+}
+
+/*
+ * Thread-local slot on fibre-local storage, whose callback gets only
+ * the value: each thread stores a cell carrying the dtor with it.
+ */
+struct tls_cell {
+	void (*dtor)(void *);
+	void *v;
+};
+
+static VOID NTAPI tls_cell_free(PVOID p)
+{
+	struct tls_cell *c = (struct tls_cell *)p;
+	if (!c) return;
+	if (c->v && c->dtor) c->dtor(c->v);
+	free(c);
+}
+struct McPkgTls *mcpkg_tls_impl_new(void (*dtor)(void *))
+{
+	struct McPkgTls *k = (struct McPkgTls *)malloc(sizeof(*k));
+	if (!k) return NULL;
+	k->k = FlsAlloc(tls_cell_free);
+	if (k->k == FLS_OUT_OF_INDEXES) {
+		free(k);
+		return NULL;
+	}
+	k->dtor = dtor;
+	return k;
+}
+void mcpkg_tls_impl_free(struct McPkgTls *k)
+{
+	if (k) {
+		FlsFree(k->k);  /* runs the callback for live cells */
+		free(k);
+	}
+}
+void *mcpkg_tls_impl_get(struct McPkgTls *k)
+{
+	struct tls_cell *c = (struct tls_cell *)FlsGetValue(k->k);
+	return c ? c->v : NULL;
+}
+int mcpkg_tls_impl_set(struct McPkgTls *k, void *v)
+{
+	struct tls_cell *c = (struct tls_cell *)FlsGetValue(k->k);
+	if (!c) {
+		if (!v) return MCPKG_THREAD_NO_ERROR;
+		c = (struct tls_cell *)calloc(1, sizeof(*c));
+		if (!c) return MCPKG_THREAD_E_NOMEM;
+		c->dtor = k->dtor;
+		if (!FlsSetValue(k->k, c)) {
+			free(c);
+			return MCPKG_THREAD_E_SYS;
+		}
+	}
+	c->v = v;
+	return MCPKG_THREAD_NO_ERROR;
+}
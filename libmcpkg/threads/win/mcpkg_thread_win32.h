@@ -20,6 +20,13 @@ struct McPkgMutex  {
 struct McPkgCond   {
 	CONDITION_VARIABLE cv;
 };
+struct McPkgRwLock {
+	SRWLOCK l;
+};
+struct McPkgTls {
+	DWORD k;
+	void (*dtor)(void *);
+};
 
 MCPKG_API struct McPkgThread *mcpkg_thread_impl_create(int (*fn)(void *),
                 void *arg);
@@ -41,6 +48,18 @@ MCPKG_API int  mcpkg_cond_impl_timedwait(struct McPkgCond *c,
 MCPKG_API void mcpkg_cond_impl_signal(struct McPkgCond *c);
 MCPKG_API void mcpkg_cond_impl_broadcast(struct McPkgCond *c);
 
+MCPKG_API struct McPkgRwLock *mcpkg_rwlock_impl_new(void);
+MCPKG_API void mcpkg_rwlock_impl_free(struct McPkgRwLock *l);
+MCPKG_API void mcpkg_rwlock_impl_rdlock(struct McPkgRwLock *l);
+MCPKG_API void mcpkg_rwlock_impl_rdunlock(struct McPkgRwLock *l);
+MCPKG_API void mcpkg_rwlock_impl_wrlock(struct McPkgRwLock *l);
+MCPKG_API void mcpkg_rwlock_impl_wrunlock(struct McPkgRwLock *l);
+
+MCPKG_API struct McPkgTls *mcpkg_tls_impl_new(void (*dtor)(void *));
+MCPKG_API void mcpkg_tls_impl_free(struct McPkgTls *k);
+MCPKG_API void *mcpkg_tls_impl_get(struct McPkgTls *k);
+MCPKG_API int mcpkg_tls_impl_set(struct McPkgTls *k, void *v);
+
 MCPKG_END_DECLS
 
 #endif
@@ -345,9 +345,12 @@ def load_and_normalize_schema(path: str, schema_doc: Dict[str, Any]) -> Dict[str
         "include_prefix": include_prefix,
         "out_base": out_base,
         "fields": fields,
+        "view": bool(data.get("view", False)),
         "hdr_name": hdr_name,
         "src_name": src_name,
         "schema_path": path,
+        # stable across checkouts, for files committed under tests/
+        "schema_rel": os.path.relpath(path, os.path.dirname(os.path.abspath(__file__))),
     }
     dbg_dump(2, "Normalized schema (summary)", {
         "tag": normalized["tag"],
@@ -384,6 +387,27 @@ def render_schema(env: Environment, sch: Dict[str, Any], out_dir: str) -> List[s
     dbg(1, f"Wrote: {src_out}")
     return [hdr_out, src_out]
 
+def render_bench(env: Environment, sch: Dict[str, Any], bench_dir: str) -> List[str]:
+    """Random generator + throughput bench header and libFuzzer entry."""
+    dbg(1, f"Rendering bench/fuzz for {sch.get('out_base')} -> {bench_dir}")
+    outs = [
+        ("c_bench.jinja", f"bench_mp_{sch['out_base']}.h"),
+        ("c_fuzz.jinja", f"fuzz_mp_{sch['out_base']}.c"),
+    ]
+    wrote: List[str] = []
+    for tpl, name in outs:
+        path = os.path.join(bench_dir, name)
+        write_text_if_changed(path, env.get_template(tpl).render(sch=sch))
+        wrote.append(path)
+    return wrote
+
+def render_bench_run(env: Environment, schemas: List[Dict[str, Any]], bench_dir: str) -> str:
+    """run_bench_mpgen() over every schema, in out_base order."""
+    ordered = sorted(schemas, key=lambda s: s["out_base"])
+    path = os.path.join(bench_dir, "bench_mpgen_run.h")
+    write_text_if_changed(path, env.get_template("c_bench_run.jinja").render(schemas=ordered))
+    return path
+
 # ---------------- Schema file discovery ----------------
 
 def gather_schema_files(paths: List[str]) -> List[str]:
@@ -426,6 +450,11 @@ def main() -> None:
         help=f"templates directory (default: {default_templates})",
     )
     ap.add_argument("--out", required=True, help="output root directory")
+    ap.add_argument(
+        "--bench-out",
+        default=None,
+        help="also write per-schema benches and fuzz entries here (default: off)",
+    )
     ap.add_argument("--fail-fast", action="store_true", help="stop on first schema error")
     args = ap.parse_args()
 
@@ -442,6 +471,7 @@ def main() -> None:
 
     wrote: List[str] = []
     errors: List[str] = []
+    done: List[Dict[str, Any]] = []
 
     print(f"[mpgen] generating from {len(schema_paths)} schema(s)")
     schema_id = schema_doc.get("$id", "<no $id>")
@@ -451,6 +481,9 @@ def main() -> None:
         try:
             sch = load_and_normalize_schema(spath, schema_doc)
             wrote.extend(render_schema(env, sch, args.out))
+            if args.bench_out:
+                wrote.extend(render_bench(env, sch, args.bench_out))
+            done.append(sch)
             print(f"[mpgen] ok: {os.path.relpath(spath)} -> {sch.get('include_prefix')}/mcpkg_mp_{sch.get('out_base')}.{{h,c}}")
         except Exception as e:
             msg = f"{spath}: {e}"
@@ -465,6 +498,10 @@ def main() -> None:
         print(f"[mpgen] {len(errors)} error(s)", file=sys.stderr)
         sys.exit(2)
 
+    if args.bench_out:
+        wrote.append(render_bench_run(env, done, args.bench_out))
+        print(f"[mpgen] ok: benches -> {args.bench_out}")
+
     # Touch a stamp to help CMake dependency chains
     stamp = os.path.join(args.out, ".stamp")
     ensure_dir(args.out)
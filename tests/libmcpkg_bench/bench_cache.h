@@ -0,0 +1,171 @@
+#ifndef BENCH_CACHE_H
+#define BENCH_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <fs/mcpkg_cache_file.h>
+#include <fs/mcpkg_fs_file.h>
+#include <threads/mcpkg_thread_pool.h>
+
+#include "bench_mp.h"
+#include "bench_util.h"
+
+/* cache file of n copies of the bench record, distinct ids */
+static int bench_cache_write(const char *path, size_t n, size_t per_block,
+                             const McPkgZstdDict *d)
+{
+	struct McPkgCache *m = bench_mp_meta_new();
+	char **ids = bench_pkg_ids_new(0, n);
+	McPkgCacheWriter *w = NULL;
+	size_t i;
+	int ret = -1;
+
+	if (!m || !ids || mcpkg_cache_writer_open(path, per_block, 3, &w) ||
+	    (d && mcpkg_cache_writer_set_dict(w, d)))
+		goto out;
+	for (i = 0; i < n; i++) {
+		m->id = ids[i];         /* borrowed; cleared before free */
+		if (mcpkg_cache_writer_add(w, m))
+			goto out;
+	}
+	ret = mcpkg_cache_writer_finish(w) ? -1 : 0;
+out:
+	mcpkg_cache_writer_free(w);
+	if (m)
+		m->id = NULL;
+	mcpkg_mp_pkg_meta_free(m);
+	bench_pkg_ids_free(ids);
+	return ret;
+}
+
+/* whole-file decode on 1..8 jobs; the caller thread is one of them */
+static void bench_cache_load(const McPkgCacheFile *cf, size_t n)
+{
+	static const unsigned jobs[] = { 1, 2, 4, 8 };
+	struct McPkgThreadPool *pool = NULL;
+	struct McPkgThreadPoolCfg cfg;
+	McPkgCacheLoad ld;
+	char name[32];
+	uint64_t t0, t1;
+	size_t k;
+
+	for (k = 0; k < sizeof(jobs) / sizeof(jobs[0]); k++) {
+		pool = NULL;
+		cfg.threads = jobs[k] - 1;
+		cfg.q_capacity = jobs[k];
+		if (cfg.threads && mcpkg_thread_pool_new(&cfg, &pool)) {
+			printf("%-12s n=%zu: pool failed\n", "cache", n);
+			return;
+		}
+
+		t0 = bench_now_ns();
+		if (mcpkg_cache_file_load(cf, pool, jobs[k], &ld)) {
+			printf("%-12s n=%zu: load failed\n", "cache", n);
+			mcpkg_thread_pool_free(pool);
+			return;
+		}
+		t1 = bench_now_ns();
+		snprintf(name, sizeof(name), "load jobs=%u", jobs[k]);
+		bench_report("cache", name, n, n, t1 - t0);
+
+		mcpkg_cache_load_free(&ld);
+		mcpkg_thread_pool_free(pool);
+	}
+}
+
+/* point lookups: index search + one block, reused buffer */
+static void bench_cache_get(const McPkgCacheFile *cf, size_t n,
+                            const char *name)
+{
+	size_t i, len, bad = 0, ops = n < 10000 ? n : 10000;
+	McPkgCacheBlock b;
+	const void *rec;
+	uint64_t t0, t1;
+	char id[9];
+
+	memset(&b, 0, sizeof(b));
+	t0 = bench_now_ns();
+	for (i = 0; i < ops; i++) {
+		/* stride across blocks so every get decompresses */
+		bench_pkg_id((i * 7919u) % n, id);
+		if (mcpkg_cache_file_get(cf, MCPKG_CACHE_KEY_ID, id, 8, &b,
+		                         &rec, &len))
+			bad++;
+	}
+	t1 = bench_now_ns();
+	bench_report("cache", name, n, ops, t1 - t0);
+	if (bad)
+		printf("%-12s n=%zu: %zu lookup errors\n", "cache", n, bad);
+	mcpkg_cache_block_free(&b);
+}
+
+static void bench_cache_size(const char *path, size_t n, const char *name)
+{
+	unsigned char *img = NULL;
+	size_t sz = 0;
+
+	if (mcpkg_fs_read_all(path, &img, &sz) == MCPKG_FS_OK)
+		printf("%-12s %-22s n=%-9zu %10.1f bytes/rec\n", "cache", name,
+		       n, (double)sz / (double)n);
+	free(img);
+}
+
+static inline void run_bench_cache(void)
+{
+#ifndef _WIN32
+	char path[] = "/tmp/mcpkg_bench_cache.XXXXXX";
+	size_t n = bench_max_n(100000);
+	McPkgCacheFile *cf = NULL;
+	McPkgZstdDict *d = NULL;
+	size_t k;
+	int fd;
+
+	if (n > 100000)
+		n = 100000;
+	fd = mkstemp(path);
+	if (fd < 0) {
+		printf("%-12s n=%zu: setup failed\n", "cache", n);
+		return;
+	}
+	close(fd);
+
+	if (bench_cache_write(path, n, 0, NULL) || mcpkg_cache_file_open(path, &cf)) {
+		printf("%-12s n=%zu: setup failed\n", "cache", n);
+		unlink(path);
+		return;
+	}
+	bench_cache_size(path, n, "size");
+	bench_cache_load(cf, n);
+	bench_cache_get(cf, n, "get by id");
+
+	/* random access layout: one record per block, with and without */
+	if (mcpkg_cache_file_train_dict(cf, 0, 3, &d))
+		printf("%-12s n=%zu: train failed\n", "cache", n);
+	mcpkg_cache_file_close(cf);
+	cf = NULL;
+	for (k = 0; k < 2; k++) {
+		if (k && !d)
+			break;
+		if (bench_cache_write(path, n, 1, k ? d : NULL) ||
+		    mcpkg_cache_file_open(path, &cf)) {
+			printf("%-12s n=%zu: setup failed\n", "cache", n);
+			break;
+		}
+		bench_cache_size(path, n, k ? "size 1/block dict"
+		                 : "size 1/block");
+		bench_cache_get(cf, n, k ? "get 1/block dict" : "get 1/block");
+		mcpkg_cache_file_close(cf);
+		cf = NULL;
+	}
+
+	mcpkg_fs_zstd_dict_free(d);
+	unlink(path);
+#endif /* mkstemp */
+}
+
+#endif /* BENCH_CACHE_H */
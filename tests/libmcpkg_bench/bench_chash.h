@@ -0,0 +1,108 @@
+#ifndef BENCH_CHASH_H
+#define BENCH_CHASH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_chash.h>
+#include <threads/mcpkg_thread.h>
+
+#include "bench_util.h"
+
+#define BENCH_CHASH_OPS  200000u  /* per thread */
+
+struct bench_chash_job {
+	McPkgCHash *ch;
+	char      **keys;
+	size_t      n;
+	uint64_t    seed;
+	size_t      miss;
+};
+
+/* read-mostly cache traffic: 90% get, 10% set */
+static int bench_chash_worker(void *arg)
+{
+	struct bench_chash_job *j = arg;
+	uint64_t r;
+	size_t i;
+	int v;
+
+	for (i = 0; i < BENCH_CHASH_OPS; i++) {
+		r = bench_rand(&j->seed);
+		if (r % 10 == 0) {
+			v = (int)i;
+			mcpkg_chash_set(j->ch, j->keys[(r >> 8) % j->n], &v);
+		} else if (mcpkg_chash_get(j->ch, j->keys[(r >> 8) % j->n],
+		                           &v) != MCPKG_CONTAINER_OK) {
+			j->miss++;
+		}
+	}
+	return 0;
+}
+
+static void bench_chash_mixed(unsigned shards, unsigned nthreads,
+                              size_t n)
+{
+	struct bench_chash_job jobs[32];
+	struct McPkgThread *th[32];
+	McPkgCHash *ch = mcpkg_chash_new(sizeof(int), NULL, shards, 0, 0);
+	char **keys = bench_pkg_ids_new(0, n);
+	char group[16], name[24];
+	uint64_t t0, t1;
+	size_t miss = 0;
+	unsigned t;
+	int v = 0;
+	size_t i;
+
+	snprintf(group, sizeof(group), "chash/s%u", shards);
+	snprintf(name, sizeof(name), "get90/set10 t%u", nthreads);
+	if (!ch || !keys) {
+		printf("%-12s n=%zu: setup failed\n", group, n);
+		goto out;
+	}
+	for (i = 0; i < n; i++)
+		mcpkg_chash_set(ch, keys[i], &v);
+
+	t0 = bench_now_ns();
+	for (t = 0; t < nthreads; t++) {
+		jobs[t].ch = ch;
+		jobs[t].keys = keys;
+		jobs[t].n = n;
+		jobs[t].seed = 0x9E3779B97F4A7C15ull * (t + 1);
+		jobs[t].miss = 0;
+		th[t] = mcpkg_thread_create(bench_chash_worker, &jobs[t]);
+	}
+	for (t = 0; t < nthreads; t++) {
+		if (th[t])
+			mcpkg_thread_join(th[t]);
+		else
+			bench_chash_worker(&jobs[t]);
+		miss += jobs[t].miss;
+	}
+	t1 = bench_now_ns();
+	bench_report(group, name, n, (size_t)BENCH_CHASH_OPS * nthreads,
+	             t1 - t0);
+
+	if (miss)
+		printf("%-12s n=%zu: %zu unexpected misses\n", group, n, miss);
+out:
+	mcpkg_chash_free(ch);
+	bench_pkg_ids_free(keys);
+}
+
+/* one shard = a single RW-locked McPkgHash, the baseline */
+static inline void run_bench_chash(void)
+{
+	static const unsigned threads[] = { 1, 2, 4, 8, 16, 32 };
+	static const unsigned shards[] = { 1, MCPKG_CHASH_DEFAULT_SHARDS };
+	size_t n = bench_max_n(100000);
+	size_t s, t;
+
+	if (n > 100000)
+		n = 100000;
+	for (s = 0; s < sizeof(shards) / sizeof(shards[0]); s++)
+		for (t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+			bench_chash_mixed(shards[s], threads[t], n);
+}
+
+#endif /* BENCH_CHASH_H */
@@ -0,0 +1,258 @@
+#ifndef BENCH_HASH_H
+#define BENCH_HASH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_hash.h>
+#include <container/mcpkg_hash_frozen.h>
+
+#include "bench_util.h"
+
+/* insert / lookup-hit / lookup-miss over package-id keys */
+static void bench_hash_size(size_t n)
+{
+	McPkgHash *h;
+	char **hit, **miss;
+	uint64_t t0, t1;
+	size_t i, v, found = 0;
+
+	hit = bench_pkg_ids_new(0, n);
+	miss = bench_pkg_ids_new(n, n);
+	h = mcpkg_hash_new(sizeof(size_t), NULL, n + 1, ~0ull);
+	if (!hit || !miss || !h) {
+		printf("hash       n=%zu: setup failed\n", n);
+		goto out;
+	}
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		mcpkg_hash_set(h, hit[i], &i);
+	t1 = bench_now_ns();
+	bench_report("hash", "insert", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		found += mcpkg_hash_get(h, hit[i], &v) == MCPKG_CONTAINER_OK;
+	t1 = bench_now_ns();
+	bench_report("hash", "lookup hit", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		found += mcpkg_hash_contains(h, miss[i]);
+	t1 = bench_now_ns();
+	bench_report("hash", "lookup miss", n, n, t1 - t0);
+
+	if (found != n)
+		printf("hash       n=%zu: expected %zu hits, got %zu\n",
+		       n, n, found);
+out:
+	mcpkg_hash_free(h);
+	bench_pkg_ids_free(hit);
+	bench_pkg_ids_free(miss);
+}
+
+/* hash function choice over package ids: insert, hit, miss */
+static void bench_hash_fns(size_t n)
+{
+	static const char *names[] = { "hash/sip24", "hash/sip13",
+	                               "hash/wyhash"
+	                             };
+	McPkgHash *h;
+	char **hit, **miss;
+	uint64_t t0, t1;
+	size_t i, v;
+	int fn;
+
+	hit = bench_pkg_ids_new(0, n);
+	miss = bench_pkg_ids_new(n, n);
+	if (!hit || !miss) {
+		printf("hash fns   n=%zu: setup failed\n", n);
+		goto out;
+	}
+
+	for (fn = MCPKG_HASH_FN_SIPHASH24; fn <= MCPKG_HASH_FN_WYHASH; fn++) {
+		h = mcpkg_hash_new(sizeof(size_t), NULL, n + 1, ~0ull);
+		if (!h || mcpkg_hash_set_hash_fn(h, (MCPKG_HASH_FN)fn)) {
+			mcpkg_hash_free(h);
+			continue;
+		}
+
+		t0 = bench_now_ns();
+		for (i = 0; i < n; i++)
+			mcpkg_hash_set(h, hit[i], &i);
+		t1 = bench_now_ns();
+		bench_report(names[fn], "insert", n, n, t1 - t0);
+
+		t0 = bench_now_ns();
+		for (i = 0; i < n; i++)
+			mcpkg_hash_get(h, hit[i], &v);
+		t1 = bench_now_ns();
+		bench_report(names[fn], "lookup hit", n, n, t1 - t0);
+
+		t0 = bench_now_ns();
+		for (i = 0; i < n; i++)
+			mcpkg_hash_contains(h, miss[i]);
+		t1 = bench_now_ns();
+		bench_report(names[fn], "lookup miss", n, n, t1 - t0);
+
+		mcpkg_hash_free(h);
+	}
+out:
+	bench_pkg_ids_free(hit);
+	bench_pkg_ids_free(miss);
+}
+
+/* key storage modes: insert, hit lookup and teardown */
+static void bench_hash_keys(size_t n)
+{
+	static const char *names[] = { "hash/owned", "hash/arena",
+	                               "hash/intern"
+	                             };
+	McPkgStrIntern *in;
+	McPkgHash *h;
+	const char **canon;
+	char **hit;
+	uint64_t t0, t1;
+	size_t i, v;
+	int mode;
+
+	hit = bench_pkg_ids_new(0, n);
+	canon = malloc(n * sizeof(*canon));
+	in = mcpkg_str_intern_new(n + 1, ~0ull);
+	if (!hit || !canon || !in) {
+		printf("hash keys  n=%zu: setup failed\n", n);
+		goto out;
+	}
+	/* interned callers already hold canonical pointers */
+	for (i = 0; i < n; i++)
+		canon[i] = mcpkg_str_intern_add(in, hit[i]);
+
+	for (mode = 0; mode < 3; mode++) {
+		const char **keys = mode == MCPKG_CONTAINER_KEYS_INTERNED
+		                    ? canon : (const char **)hit;
+
+		h = mcpkg_hash_new(sizeof(size_t), NULL, n + 1, ~0ull);
+		if (!h || mcpkg_hash_set_key_mode(h,
+		                                  (MCPKG_CONTAINER_KEYS)mode, in)) {
+			mcpkg_hash_free(h);
+			continue;
+		}
+
+		t0 = bench_now_ns();
+		for (i = 0; i < n; i++)
+			mcpkg_hash_set(h, keys[i], &i);
+		t1 = bench_now_ns();
+		bench_report(names[mode], "insert", n, n, t1 - t0);
+
+		t0 = bench_now_ns();
+		for (i = 0; i < n; i++)
+			mcpkg_hash_get(h, keys[i], &v);
+		t1 = bench_now_ns();
+		bench_report(names[mode], "lookup hit", n, n, t1 - t0);
+
+		t0 = bench_now_ns();
+		mcpkg_hash_free(h);
+		t1 = bench_now_ns();
+		bench_report(names[mode], "free", n, n, t1 - t0);
+	}
+out:
+	mcpkg_str_intern_free(in);
+	free(canon);
+	bench_pkg_ids_free(hit);
+}
+
+/*
+ * Startup cost: rebuilding a live index vs opening a frozen image (the
+ * image is what mcpkg_fs_map_ro would hand back), then lookups on it.
+ */
+static void bench_hash_frozen(size_t n)
+{
+	McPkgFrozenHash *fh = NULL;
+	McPkgHash *h;
+	char **hit, **miss;
+	void *img = NULL;
+	size_t i, v, len = 0, found = 0;
+	uint64_t t0, t1;
+
+	hit = bench_pkg_ids_new(0, n);
+	miss = bench_pkg_ids_new(n, n);
+	h = mcpkg_hash_new(sizeof(size_t), NULL, n + 1, ~0ull);
+	if (!hit || !miss || !h) {
+		printf("hash/frozen n=%zu: setup failed\n", n);
+		goto out;
+	}
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		mcpkg_hash_set(h, hit[i], &i);
+	t1 = bench_now_ns();
+	bench_report("hash/frozen", "rebuild (old start)", n, 1, t1 - t0);
+
+	t0 = bench_now_ns();
+	if (mcpkg_hash_freeze(h, &img, &len) != MCPKG_CONTAINER_OK) {
+		printf("hash/frozen n=%zu: freeze failed\n", n);
+		goto out;
+	}
+	t1 = bench_now_ns();
+	bench_report("hash/frozen", "freeze", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	if (mcpkg_frozen_hash_open(img, len, sizeof(size_t), &fh) !=
+	    MCPKG_CONTAINER_OK) {
+		printf("hash/frozen n=%zu: open failed\n", n);
+		goto out;
+	}
+	t1 = bench_now_ns();
+	bench_report("hash/frozen", "open", n, 1, t1 - t0);
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		found += mcpkg_frozen_hash_get(fh, hit[i], &v) ==
+		         MCPKG_CONTAINER_OK;
+	t1 = bench_now_ns();
+	bench_report("hash/frozen", "lookup hit", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		found += mcpkg_frozen_hash_contains(fh, miss[i]);
+	t1 = bench_now_ns();
+	bench_report("hash/frozen", "lookup miss", n, n, t1 - t0);
+
+	if (found != n)
+		printf("hash/frozen n=%zu: expected %zu hits, got %zu\n",
+		       n, n, found);
+out:
+	mcpkg_frozen_hash_close(fh);
+	mcpkg_free(img);
+	mcpkg_hash_free(h);
+	bench_pkg_ids_free(hit);
+	bench_pkg_ids_free(miss);
+}
+
+static inline void run_bench_hash(void)
+{
+	static const size_t sizes[] = {
+		1000, 10000, 100000, 1000000, 10000000
+	};
+	size_t max = bench_max_n((size_t) -1);
+	size_t i;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		if (sizes[i] <= max)
+			bench_hash_size(sizes[i]);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		if (sizes[i] <= max && sizes[i] <= 1000000)
+			bench_hash_fns(sizes[i]);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		if (sizes[i] <= max && sizes[i] <= 1000000)
+			bench_hash_keys(sizes[i]);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		if (sizes[i] <= max && sizes[i] <= 1000000)
+			bench_hash_frozen(sizes[i]);
+}
+
+#endif /* BENCH_HASH_H */
@@ -0,0 +1,59 @@
+#ifndef BENCH_LIST_H
+#define BENCH_LIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_str_list.h>
+
+#include "bench_util.h"
+
+/* "push unless present" over 2n ids with n distinct (dependency dedup) */
+static void bench_strlist_dedup(int indexed, size_t n)
+{
+	const char *group = indexed ? "strlist/ix" : "strlist/scan";
+	McPkgStringList *sl = mcpkg_stringlist_new(0, 0);
+	char **keys = bench_pkg_ids_new(0, n);
+	uint64_t t0, t1;
+	size_t i;
+
+	if (!sl || !keys ||
+	    (indexed && mcpkg_stringlist_set_indexed(sl, 1))) {
+		printf("%-12s n=%zu: setup failed\n", group, n);
+		goto out;
+	}
+
+	t0 = bench_now_ns();
+	for (i = 0; i < 2 * n; i++) {
+		const char *k = keys[(i * 7) % n];
+
+		if (mcpkg_stringlist_index_of(sl, k) < 0)
+			mcpkg_stringlist_push(sl, k);
+	}
+	t1 = bench_now_ns();
+	bench_report(group, "dedup push", n, 2 * n, t1 - t0);
+
+	if (mcpkg_stringlist_size(sl) != n)
+		printf("%-12s n=%zu: dedup mismatch\n", group, n);
+out:
+	mcpkg_stringlist_free(sl);
+	bench_pkg_ids_free(keys);
+}
+
+static inline void run_bench_list(void)
+{
+	static const size_t sizes[] = { 100, 1000, 10000, 100000 };
+	size_t max = bench_max_n((size_t) -1);
+	size_t i;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if (sizes[i] > max)
+			continue;
+		/* the quadratic scan is the point; skip it where it drags */
+		if (sizes[i] <= 10000)
+			bench_strlist_dedup(0, sizes[i]);
+		bench_strlist_dedup(1, sizes[i]);
+	}
+}
+
+#endif /* BENCH_LIST_H */
@@ -0,0 +1,143 @@
+#ifndef BENCH_MAP_H
+#define BENCH_MAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_map.h>
+
+#include "bench_util.h"
+
+#define BENCH_MAP_RANGE  100u
+
+/* sorted input: per-key insert vs bulk load, then one range erase */
+static void bench_map_bulk(const McPkgMap *src, MCPKG_MAP_BACKEND be,
+                           size_t n)
+{
+	const char *group = be == MCPKG_MAP_BTREE ? "map/btree" : "map/rbtree";
+	const char **sorted = malloc(n * sizeof(*sorted));
+	size_t *vals = malloc(n * sizeof(*vals));
+	McPkgMap *a = mcpkg_map_new(sizeof(size_t), NULL, n + 1, ~0ull);
+	McPkgMap *b = mcpkg_map_new(sizeof(size_t), NULL, n + 1, ~0ull);
+	uint64_t t0, t1;
+	size_t i = 0;
+	void *it;
+
+	if (!sorted || !vals || !a || !b || mcpkg_map_set_backend(a, be) ||
+	    mcpkg_map_set_backend(b, be)) {
+		printf("%-12s n=%zu: bulk setup failed\n", group, n);
+		goto out;
+	}
+	mcpkg_map_iter_begin(src, &it);
+	while (i < n && mcpkg_map_iter_next(src, &it, &sorted[i], &vals[i]))
+		i++;
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		mcpkg_map_set(a, sorted[i], &vals[i]);
+	t1 = bench_now_ns();
+	bench_report(group, "insert sorted", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	if (mcpkg_map_bulk_load(b, sorted, vals, n) != MCPKG_CONTAINER_OK)
+		printf("%-12s n=%zu: bulk load failed\n", group, n);
+	t1 = bench_now_ns();
+	bench_report(group, "bulk load", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	mcpkg_map_remove_range(b, NULL, NULL, NULL);
+	t1 = bench_now_ns();
+	bench_report(group, "range erase", n, n, t1 - t0);
+out:
+	mcpkg_map_free(a);
+	mcpkg_map_free(b);
+	free(sorted);
+	free(vals);
+}
+
+/* insert, point lookup, full ordered scan, seek + short range scans */
+static void bench_map_backend(MCPKG_MAP_BACKEND be, size_t n)
+{
+	const char *group = be == MCPKG_MAP_BTREE ? "map/btree" : "map/rbtree";
+	McPkgMap *m;
+	char **keys;
+	size_t *order = NULL;
+	const char *k;
+	uint64_t t0, t1, rs = 42;
+	size_t i, j, v, sum = 0, scans;
+	void *it;
+
+	keys = bench_pkg_ids_new(0, n);
+	order = malloc(n * sizeof(*order));
+	m = mcpkg_map_new(sizeof(size_t), NULL, n + 1, ~0ull);
+	if (!keys || !order || !m || mcpkg_map_set_backend(m, be)) {
+		printf("%-12s n=%zu: setup failed\n", group, n);
+		goto out;
+	}
+	/* lookups in a different order than inserts */
+	for (i = 0; i < n; i++)
+		order[i] = i;
+	for (i = n; i > 1; i--) {
+		j = (size_t)(bench_rand(&rs) % i);
+		v = order[i - 1];
+		order[i - 1] = order[j];
+		order[j] = v;
+	}
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		mcpkg_map_set(m, keys[i], &i);
+	t1 = bench_now_ns();
+	bench_report(group, "insert", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++)
+		sum += mcpkg_map_get(m, keys[order[i]], &v) ==
+		       MCPKG_CONTAINER_OK;
+	t1 = bench_now_ns();
+	bench_report(group, "lookup hit", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	mcpkg_map_iter_begin(m, &it);
+	while (mcpkg_map_iter_next(m, &it, &k, &v))
+		sum += v;
+	t1 = bench_now_ns();
+	bench_report(group, "full scan", n, n, t1 - t0);
+
+	scans = n / 10 ? n / 10 : 1;
+	t0 = bench_now_ns();
+	for (i = 0; i < scans; i++) {
+		mcpkg_map_iter_seek(m, &it, keys[order[i]]);
+		for (j = 0; j < BENCH_MAP_RANGE &&
+		     mcpkg_map_iter_next(m, &it, &k, &v); j++)
+			sum += v;
+	}
+	t1 = bench_now_ns();
+	bench_report(group, "seek+scan 100", n, scans * BENCH_MAP_RANGE,
+	             t1 - t0);
+
+	bench_map_bulk(m, be, n);
+
+	if (!sum)
+		printf("%-12s n=%zu: empty scan\n", group, n);
+out:
+	mcpkg_map_free(m);
+	bench_pkg_ids_free(keys);
+	free(order);
+}
+
+static inline void run_bench_map(void)
+{
+	static const size_t sizes[] = { 1000, 100000, 1000000 };
+	size_t max = bench_max_n((size_t) -1);
+	size_t i;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if (sizes[i] > max)
+			continue;
+		bench_map_backend(MCPKG_MAP_RBTREE, sizes[i]);
+		bench_map_backend(MCPKG_MAP_BTREE, sizes[i]);
+	}
+}
+
+#endif /* BENCH_MAP_H */
@@ -0,0 +1,318 @@
+#ifndef BENCH_MP_H
+#define BENCH_MP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <container/mcpkg_alloc.h>
+#include <container/mcpkg_arena.h>
+#include <container/mcpkg_list.h>
+#include <container/mcpkg_str_list.h>
+#include <mp/mcpkg_mp_util.h>
+#include <mp/mcpkg_mp_pkg_digest.h>
+#include <mp/mcpkg_mp_pkg_file.h>
+#include <mp/mcpkg_mp_pkg_meta.h>
+
+#include "bench_util.h"
+
+/* records decoded per arena reset in the arena run (one cache page) */
+#define BENCH_MP_PAGE  1024u
+
+/* n packed pkg.meta records back to back, as in a cache file */
+struct bench_mp_cache {
+	unsigned char	*blob;
+	size_t		*off;           /* n + 1 offsets into blob */
+	size_t		n;
+};
+
+static struct McPkgStringList *bench_mp_strlist(const char *a,
+                const char *b)
+{
+	struct McPkgStringList *sl = mcpkg_stringlist_new(0, 0);
+
+	if (sl && (mcpkg_stringlist_push(sl, a) ||
+	           mcpkg_stringlist_push(sl, b))) {
+		mcpkg_stringlist_free(sl);
+		return NULL;
+	}
+	return sl;
+}
+
+/* typical modrinth record: every scalar field, two loaders, a file */
+static struct McPkgCache *bench_mp_meta_new(void)
+{
+	struct McPkgCache *m = mcpkg_mp_pkg_meta_new();
+	struct McPkgDigest *d;
+
+	if (!m)
+		return NULL;
+	m->slug = mcpkg_strdup("sodium");
+	m->version = mcpkg_strdup("mc1.21.1-0.6.0-fabric");
+	m->title = mcpkg_strdup("Sodium");
+	m->description = mcpkg_strdup("The fastest and most compatible "
+	                              "rendering optimization mod");
+	m->license_id = mcpkg_strdup("LicenseRef-Polyform-Shield");
+	m->home_page = mcpkg_strdup("https://modrinth.com/mod/sodium");
+	m->source_repo = mcpkg_strdup("https://github.com/CaffeineMC/sodium");
+	m->loaders = bench_mp_strlist("fabric", "quilt");
+	m->sections = bench_mp_strlist("optimization", "");
+	m->file = mcpkg_mp_pkg_file_new();
+	m->client = 1;
+	m->server = 0;
+	m->schema = 1u;
+	if (!m->file || !m->loaders || !m->sections)
+		goto fail;
+
+	m->file->url = mcpkg_strdup("https://cdn.modrinth.com/data/AANobbMI/"
+	                            "versions/u1OEbNKx/sodium-fabric.jar");
+	m->file->file_name = mcpkg_strdup("sodium-fabric.jar");
+	m->file->size = 1046528ull;
+	m->file->digests = mcpkg_list_new(sizeof(d), NULL, 0, 0);
+	d = mcpkg_mp_pkg_digest_new();
+	if (!m->file->digests || !d)
+		goto fail_d;
+	d->algo = 2u;
+	d->hex = mcpkg_strdup("c0ffee00c0ffee00c0ffee00c0ffee00"
+	                      "c0ffee00c0ffee00c0ffee00c0ffee00");
+	if (mcpkg_list_push(m->file->digests, &d))
+		goto fail_d;
+	return m;
+
+fail_d:
+	mcpkg_mp_pkg_digest_free(d);
+fail:
+	mcpkg_mp_pkg_meta_free(m);
+	return NULL;
+}
+
+static void bench_mp_cache_free(struct bench_mp_cache *c)
+{
+	mcpkg_free(c->blob);
+	free(c->off);
+	memset(c, 0, sizeof(*c));
+}
+
+/* every record appended to one writer; finish hands the blob over */
+static int bench_mp_cache_build(struct bench_mp_cache *c, size_t n)
+{
+	struct McPkgCache *m = bench_mp_meta_new();
+	char **ids = bench_pkg_ids_new(0, n);
+	struct McPkgMpWriter w;
+	size_t i, len;
+	void *blob;
+	int ret = -1;
+
+	memset(c, 0, sizeof(*c));
+	c->off = calloc(n + 1, sizeof(*c->off));
+	if (!m || !ids || !c->off || mcpkg_mp_writer_init(&w))
+		goto out_m;
+
+	for (i = 0; i < n; i++) {
+		m->id = ids[i];         /* borrowed; cleared before free */
+		c->off[i] = mcpkg_mp_writer_len(&w);
+		if (mcpkg_mp_pkg_meta_pack_append(m, &w))
+			goto out;
+	}
+	c->off[n] = mcpkg_mp_writer_len(&w);
+	if (mcpkg_mp_writer_finish(&w, &blob, &len))
+		goto out;
+	c->blob = blob;
+	c->n = n;
+	ret = 0;
+out:
+	mcpkg_mp_writer_destroy(&w);
+out_m:
+	if (m)
+		m->id = NULL;
+	mcpkg_mp_pkg_meta_free(m);
+	bench_pkg_ids_free(ids);
+	if (ret)
+		bench_mp_cache_free(c);
+	return ret;
+}
+
+/* one buffer per record, a reused writer, or caller memory */
+static void bench_mp_pack(size_t n)
+{
+	unsigned char stack[1024];
+	struct McPkgCache *m = bench_mp_meta_new();
+	struct McPkgMpWriter w;
+	size_t i, len, bad = 0;
+	uint64_t t0, t1;
+	void *buf;
+
+	if (!m || mcpkg_mp_writer_init(&w)) {
+		printf("%-12s n=%zu: setup failed\n", "mp/meta", n);
+		mcpkg_mp_pkg_meta_free(m);
+		return;
+	}
+	m->id = mcpkg_strdup("AANobbMI");
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		if (mcpkg_mp_pkg_meta_pack(m, &buf, &len)) {
+			bad++;
+			continue;
+		}
+		mcpkg_free(buf);
+	}
+	t1 = bench_now_ns();
+	bench_report("mp/meta", "pack+free", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		mcpkg_mp_writer_reset(&w);
+		if (mcpkg_mp_pkg_meta_pack_append(m, &w))
+			bad++;
+	}
+	t1 = bench_now_ns();
+	bench_report("mp/meta", "pack reused writer", n, n, t1 - t0);
+
+	t0 = bench_now_ns();
+	for (i = 0; i < n; i++) {
+		if (mcpkg_mp_pkg_meta_packed_size(m) > sizeof(stack) ||
+		    mcpkg_mp_pkg_meta_pack_into(m, stack, sizeof(stack), &len))
+			bad++;
+	}
+	t1 = bench_now_ns();
+	bench_report("mp/meta", "size+pack_into stack", n, n, t1 - t0);
+	if (bad)
+		printf("%-12s n=%zu: %zu pack errors\n", "mp/meta", n, bad);
+
+	mcpkg_mp_writer_destroy(&w);
+	mcpkg_mp_pkg_meta_free(m);
+}
+
+static inline const unsigned char *bench_mp_rec(const struct bench_mp_cache *c,
+                size_t i, size_t *len)
+{
+	*len = c->off[i + 1] - c->off[i];
+	return c->blob + c->off[i];
+}
+
+/* field lookups alone: reader_init + every top-level key */
+static void bench_mp_lookup(const struct bench_mp_cache *c)
+{
+	struct McPkgMpReader r;
+	const char *sp;
+	size_t i, len, slen, bad = 0;
+	uint64_t t0, t1;
+	int k, found;
+
+	t0 = bench_now_ns();
+	for (i = 0; i < c->n; i++) {
+		const unsigned char *p = bench_mp_rec(c, i, &len);
+
+		if (mcpkg_mp_reader_init(&r, p, len)) {
+			bad++;
+			continue;
+		}
+		for (k = 2; k <= 19; k++)
+			(void)mcpkg_mp_get_str_borrow(&r, k, &sp, &slen, &found);
+		mcpkg_mp_reader_destroy(&r);
+	}
+	t1 = bench_now_ns();
+	bench_report("mp/meta", "reader+18 lookups", c->n, c->n, t1 - t0);
+	if (bad)
+		printf("%-12s n=%zu: %zu reader errors\n", "mp/meta", c->n, bad);
+}
+
+static void bench_mp_unpack(const struct bench_mp_cache *c)
+{
+	struct McPkgCache *m;
+	size_t i, len, bad = 0;
+	uint64_t t0, t1;
+
+	t0 = bench_now_ns();
+	for (i = 0; i < c->n; i++) {
+		const unsigned char *p = bench_mp_rec(c, i, &len);
+
+		if (mcpkg_mp_pkg_meta_unpack(p, len, &m)) {
+			bad++;
+			continue;
+		}
+		mcpkg_mp_pkg_meta_free(m);
+	}
+	t1 = bench_now_ns();
+	bench_report("mp/meta", "unpack+free", c->n, c->n, t1 - t0);
+	if (bad)
+		printf("%-12s n=%zu: %zu unpack errors\n", "mp/meta", c->n, bad);
+}
+
+static void bench_mp_unpack_arena(const struct bench_mp_cache *c)
+{
+	McPkgArena *a = mcpkg_arena_new(0, 0);
+	struct McPkgCache *m;
+	size_t i, len, bad = 0;
+	uint64_t t0, t1;
+
+	if (!a) {
+		printf("%-12s n=%zu: setup failed\n", "mp/meta", c->n);
+		return;
+	}
+
+	t0 = bench_now_ns();
+	for (i = 0; i < c->n; i++) {
+		const unsigned char *p = bench_mp_rec(c, i, &len);
+
+		if (i % BENCH_MP_PAGE == 0)
+			mcpkg_arena_reset(a);
+		if (mcpkg_mp_pkg_meta_unpack_arena(p, len, a, &m))
+			bad++;
+	}
+	t1 = bench_now_ns();
+	bench_report("mp/meta", "unpack arena", c->n, c->n, t1 - t0);
+	if (bad)
+		printf("%-12s n=%zu: %zu unpack errors\n", "mp/meta", c->n, bad);
+	mcpkg_arena_free(a);
+}
+
+/* read-only path: borrowed view, then the strings a listing shows */
+static void bench_mp_view(const struct bench_mp_cache *c)
+{
+	struct McPkgCacheView v;
+	size_t i, len, bad = 0, sum = 0;
+	uint64_t t0, t1;
+
+	t0 = bench_now_ns();
+	for (i = 0; i < c->n; i++) {
+		const unsigned char *p = bench_mp_rec(c, i, &len);
+
+		if (mcpkg_mp_pkg_meta_view(p, len, &v)) {
+			bad++;
+			continue;
+		}
+		sum += v.id.len + v.version.len + v.title.len;
+	}
+	t1 = bench_now_ns();
+	bench_report("mp/meta", "view", c->n, c->n, t1 - t0);
+	if (bad || !sum)
+		printf("%-12s n=%zu: %zu view errors\n", "mp/meta", c->n, bad);
+}
+
+static inline void run_bench_mp(void)
+{
+	static const size_t sizes[] = { 1000, 100000 };
+	size_t max = bench_max_n((size_t) -1);
+	struct bench_mp_cache c;
+	size_t i;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if (sizes[i] > max)
+			continue;
+		if (bench_mp_cache_build(&c, sizes[i])) {
+			printf("%-12s n=%zu: setup failed\n", "mp/meta",
+			       sizes[i]);
+			continue;
+		}
+		bench_mp_pack(sizes[i]);
+		bench_mp_lookup(&c);
+		bench_mp_unpack(&c);
+		bench_mp_unpack_arena(&c);
+		bench_mp_view(&c);
+		bench_mp_cache_free(&c);
+	}
+}
+
+#endif /* BENCH_MP_H */
@@ -0,0 +1,190 @@
+#ifndef BENCH_MPGEN_H
+#define BENCH_MPGEN_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_alloc.h>
+#include <container/mcpkg_list.h>
+#include <container/mcpkg_str_list.h>
+
+#include "bench_util.h"
+
+/*
+ * Support for the per-schema benches mpgen writes to mpgen/:
+ * random field values for the rand_mp_*_new generators, and timed rows
+ * that also report bytes and allocations per op.
+ */
+
+/* distinct random records per schema; ops cycle over them */
+#define BENCH_MPGEN_RECORDS  1024u
+#define BENCH_MPGEN_SEED     0x9E3779B97F4A7C15ull
+
+/* value of a random width in [0, bits], so every int encoding shows up */
+static inline uint64_t bench_rand_int(uint64_t *rs, unsigned bits)
+{
+	uint64_t v = bench_rand(rs);
+	unsigned w = (unsigned)(bench_rand(rs) % (bits + 1));
+
+	return w ? v >> (64 - w) : 0;
+}
+
+static inline void bench_rand_bytes(uint64_t *rs, uint8_t *dst, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = (uint8_t)(bench_rand(rs) >> 56);
+}
+
+/* element count: 1..3 for required lists, else 0..3 (0 = no list) */
+static inline size_t bench_rand_count(uint64_t *rs, int required)
+{
+	return required ? 1 + bench_rand(rs) % 3 : bench_rand(rs) % 4;
+}
+
+/* printable ASCII; mostly id-sized, one in eight description-sized */
+static inline size_t bench_rand_text(uint64_t *rs, char *buf, size_t cap)
+{
+	size_t i, n;
+
+	n = bench_rand(rs) % 8 ? bench_rand(rs) % 24 : bench_rand(rs) % 256;
+	if (n >= cap)
+		n = cap - 1;
+	for (i = 0; i < n; i++)
+		buf[i] = (char)(' ' + bench_rand(rs) % 95);
+	buf[n] = '\0';
+	return n;
+}
+
+/* optional strings stay NULL half the time; 0 or -1 (out of memory) */
+static inline int bench_rand_str(uint64_t *rs, int required, char **out)
+{
+	char buf[256];
+
+	*out = NULL;
+	if (!required && bench_rand(rs) & 1)
+		return 0;
+	bench_rand_text(rs, buf, sizeof(buf));
+	*out = mcpkg_strdup(buf);
+	return *out ? 0 : -1;
+}
+
+static inline int bench_rand_strlist(uint64_t *rs, int required,
+                                     struct McPkgStringList **out)
+{
+	size_t i, n = bench_rand_count(rs, required);
+	char buf[256];
+
+	*out = NULL;
+	if (!n)
+		return 0;
+	*out = mcpkg_stringlist_new(0, 0);
+	if (!*out)
+		return -1;
+	for (i = 0; i < n; i++) {
+		bench_rand_text(rs, buf, sizeof(buf));
+		if (mcpkg_stringlist_push(*out, buf))
+			return -1;
+	}
+	return 0;
+}
+
+/* list of n-byte arrays, as the generated decoders build it */
+static inline int bench_rand_binlist(uint64_t *rs, int required, size_t size,
+                                     struct McPkgList **out)
+{
+	size_t i, n = bench_rand_count(rs, required);
+	uint8_t buf[256];
+
+	*out = NULL;
+	if (size > sizeof(buf))
+		return -1;
+	if (!n)
+		return 0;
+	*out = mcpkg_list_new(size, NULL, 0, 0);
+	if (!*out)
+		return -1;
+	for (i = 0; i < n; i++) {
+		bench_rand_bytes(rs, buf, size);
+		if (mcpkg_list_push(*out, buf) != MCPKG_CONTAINER_OK)
+			return -1;
+	}
+	return 0;
+}
+
+/* ---------- allocation counting ---------- */
+
+static unsigned long long g_bench_mpgen_allocs;
+
+static void *bench_mpgen_alloc(void *ctx, size_t size)
+{
+	const McPkgAllocator *l = mcpkg_allocator_libc();
+
+	(void)ctx;
+	g_bench_mpgen_allocs++;
+	return l->alloc(l->ctx, size);
+}
+
+static void *bench_mpgen_realloc(void *ctx, void *p, size_t old_size,
+                                 size_t new_size)
+{
+	const McPkgAllocator *l = mcpkg_allocator_libc();
+
+	(void)ctx;
+	g_bench_mpgen_allocs++;
+	return l->realloc(l->ctx, p, old_size, new_size);
+}
+
+static void bench_mpgen_free(void *ctx, void *p, size_t size)
+{
+	const McPkgAllocator *l = mcpkg_allocator_libc();
+
+	(void)ctx;
+	l->free(l->ctx, p, size);
+}
+
+/* libc underneath, counting alloc/realloc calls; on = 0 restores libc */
+static inline void bench_mpgen_count_allocs(int on)
+{
+	static const McPkgAllocator counting = {
+		.alloc = bench_mpgen_alloc,
+		.realloc = bench_mpgen_realloc,
+		.free = bench_mpgen_free,
+	};
+
+	mcpkg_allocator_set_default(on ? &counting : NULL);
+}
+
+/* ---------- rows ---------- */
+
+struct bench_mpgen_row {
+	uint64_t		t0;
+	unsigned long long	allocs0;
+};
+
+static inline void bench_mpgen_begin(struct bench_mpgen_row *r)
+{
+	r->allocs0 = g_bench_mpgen_allocs;
+	r->t0 = bench_now_ns();
+}
+
+/* bench_report plus record bytes and library allocations per op */
+static inline void bench_mpgen_end(const struct bench_mpgen_row *r,
+                                   const char *group, const char *name,
+                                   size_t n, size_t ops, double bytes)
+{
+	uint64_t ns = bench_now_ns() - r->t0;
+	double per = ops ? (double)ns / (double)ops : 0.0;
+	double mops = ns ? (double)ops * 1000.0 / (double)ns : 0.0;
+	double allocs = ops ? (double)(g_bench_mpgen_allocs - r->allocs0) /
+	                (double)ops : 0.0;
+
+	/* wider group column: schema tags run to 18 chars */
+	printf("%-18s %-14s n=%-9zu %10.1f ns/op %10.2f Mops/s "
+	       "%8.1f B/op %6.2f allocs/op\n",
+	       group, name, n, per, mops, bytes, allocs);
+}
+
+#endif /* BENCH_MPGEN_H */
@@ -0,0 +1,106 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Tiny timing/report helpers for mcpkg_bench.
+ * MCPKG_BENCH_MAX caps the largest problem size (default: no cap).
+ */
+
+static inline uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline size_t bench_max_n(size_t dflt)
+{
+	const char *s = getenv("MCPKG_BENCH_MAX");
+	char *end = NULL;
+	unsigned long long v;
+
+	if (!s || !*s)
+		return dflt;
+	v = strtoull(s, &end, 10);
+	if (!end || *end || !v)
+		return dflt;
+	return (size_t)v;
+}
+
+/* xorshift64*; deterministic across runs */
+static inline uint64_t bench_rand(uint64_t *state)
+{
+	uint64_t x = *state;
+
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * Modrinth-style 8 char base62 project ids; index i maps to a distinct id
+ * (multiplication by a prime is a bijection mod 62^8).
+ */
+static inline void bench_pkg_id(size_t i, char out[9])
+{
+	static const char b62[] =
+	        "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+	const uint64_t m = 218340105584896ull; /* 62^8 */
+	uint64_t v = ((uint64_t)i * 2654435761ull) % m;
+	int k;
+
+	for (k = 7; k >= 0; k--) {
+		out[k] = b62[v % 62];
+		v /= 62;
+	}
+	out[8] = '\0';
+}
+
+/* n ids in one block: keys[i] points into the block. free(keys[0]), keys */
+static inline char **bench_pkg_ids_new(size_t first, size_t n)
+{
+	char **keys;
+	char *blk;
+	size_t i;
+
+	keys = malloc(n * sizeof(*keys));
+	blk = malloc(n * 9);
+	if (!keys || !blk) {
+		free(keys);
+		free(blk);
+		return NULL;
+	}
+	for (i = 0; i < n; i++) {
+		keys[i] = blk + i * 9;
+		bench_pkg_id(first + i, keys[i]);
+	}
+	return keys;
+}
+
+static inline void bench_pkg_ids_free(char **keys)
+{
+	if (!keys)
+		return;
+	free(keys[0]);
+	free(keys);
+}
+
+static inline void bench_report(const char *group, const char *name,
+                                size_t n, size_t ops, uint64_t ns)
+{
+	double per = ops ? (double)ns / (double)ops : 0.0;
+	double mops = ns ? (double)ops * 1000.0 / (double)ns : 0.0;
+
+	printf("%-12s %-22s n=%-9zu %10.1f ns/op %10.2f Mops/s\n",
+	       group, name, n, per, mops);
+}
+
+#endif /* BENCH_UTIL_H */
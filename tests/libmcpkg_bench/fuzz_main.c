@@ -0,0 +1,33 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <fs/mcpkg_fs_file.h>
+
+/*
+ * Replay driver for the mpgen fuzz entries when the compiler has no
+ * libFuzzer (-fsanitize=fuzzer is clang only): runs each file named on
+ * the command line, e.g. a saved corpus or a crash input, once.
+ */
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int main(int argc, char **argv)
+{
+	unsigned char *buf;
+	size_t len;
+	int i, ret = 0;
+
+	for (i = 1; i < argc; i++) {
+		buf = NULL;
+		len = 0;
+		if (mcpkg_fs_read_all(argv[i], &buf, &len) != MCPKG_FS_OK) {
+			fprintf(stderr, "%s: cannot read\n", argv[i]);
+			ret = 1;
+			continue;
+		}
+		LLVMFuzzerTestOneInput(buf, len);
+		free(buf);
+	}
+	return ret;
+}
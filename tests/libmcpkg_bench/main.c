@@ -0,0 +1,35 @@
+#include <stdio.h>
+
+#include "bench_chash.h"
+#include "bench_hash.h"
+#include "bench_list.h"
+#include "bench_map.h"
+#include "bench_mp.h"
+#include "bench_cache.h"
+#include "mpgen/bench_mpgen_run.h"
+
+#include <container/mcpkg_alloc.h>
+
+int main(int argc, char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	run_bench_hash();
+	run_bench_map();
+	run_bench_list();
+	run_bench_chash();
+	run_bench_mp();
+	run_bench_cache();
+	run_bench_mpgen();
+
+	if (mcpkg_mem_stats_enabled()) {
+		char *dbg = mcpkg_mem_stats_debug_str();
+
+		if (dbg)
+			printf("%s", dbg);
+		mcpkg_free(dbg);
+	}
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * AUTOGENERATED by mpgen — DO NOT EDIT BY HAND.
+ * Source schema: schemas/ledger/ledger_attestation.yaml
+ */
+
+#ifndef BENCH_MP_LEDGER_ATTESTATION_H
+#define BENCH_MP_LEDGER_ATTESTATION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_alloc.h>
+#include <container/mcpkg_arena.h>
+#include <mp/mcpkg_mp_ledger_attestation.h>
+
+#include "bench_mpgen.h"
+
+/* random ledger.attestation: required fields always, optional ones half the time */
+static struct McPkgAttestation *rand_mp_ledger_attestation_new(uint64_t *rs)
+{
+	struct McPkgAttestation *p = mcpkg_mp_ledger_attestation_new();
+
+	if (!p)
+		return NULL;
+	if (bench_rand_str(rs, 1, &p->pkg_id))
+		goto fail;
+	if (bench_rand_str(rs, 1, &p->version))
+		goto fail;
+	bench_rand_bytes(rs, p->manifest_sha256, 32);
+	bench_rand_bytes(rs, p->signer_pub, 32);
+	bench_rand_bytes(rs, p->signature, 64);
+	p->ts_ms = (int64_t)bench_rand_int(rs, 64);
+	return p;
+
+fail:
+	mcpkg_mp_ledger_attestation_free(p);
+	return NULL;
+}
+
+/* pack/unpack throughput over n random records, ops calls per row */
+static void bench_mp_ledger_attestation(size_t n, size_t ops)
+{
+	struct McPkgAttestation **recs, *p;
+	struct bench_mpgen_row row;
+	McPkgArena *a;
+	uint64_t rs = BENCH_MPGEN_SEED;
+	size_t i, k, len, *lens, bytes = 0, bad = 0;
+	void **bufs, *buf;
+	double avg;
+
+	recs = calloc(n, sizeof(*recs));
+	bufs = calloc(n, sizeof(*bufs));
+	lens = calloc(n, sizeof(*lens));
+	a = mcpkg_arena_new(0, 0);
+	for (i = 0; recs && bufs && lens && i < n; i++) {
+		recs[i] = rand_mp_ledger_attestation_new(&rs);
+		if (!recs[i] ||
+		    mcpkg_mp_ledger_attestation_pack(recs[i], &bufs[i], &lens[i]))
+			break;
+		bytes += lens[i];
+	}
+	if (!n || !a || i < n) {
+		printf("%-12s n=%zu: setup failed\n", "ledger.attestation", n);
+		goto out;
+	}
+	avg = (double)bytes / (double)n;
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		if (mcpkg_mp_ledger_attestation_pack(recs[i % n], &buf, &len)) {
+			bad++;
+			continue;
+		}
+		mcpkg_free(buf);
+	}
+	bench_mpgen_end(&row, "ledger.attestation", "pack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (mcpkg_mp_ledger_attestation_unpack(bufs[k], lens[k], &p)) {
+			bad++;
+			continue;
+		}
+		mcpkg_mp_ledger_attestation_free(p);
+	}
+	bench_mpgen_end(&row, "ledger.attestation", "unpack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (k == 0)
+			mcpkg_arena_reset(a);
+		if (mcpkg_mp_ledger_attestation_unpack_arena(bufs[k], lens[k], a, &p))
+			bad++;
+	}
+	bench_mpgen_end(&row, "ledger.attestation", "unpack arena", n, ops, avg);
+	if (bad)
+		printf("%-12s n=%zu: %zu errors\n", "ledger.attestation", n, bad);
+
+out:
+	for (i = 0; recs && i < n; i++)
+		mcpkg_mp_ledger_attestation_free(recs[i]);
+	for (i = 0; bufs && i < n; i++)
+		mcpkg_free(bufs[i]);
+	free(recs);
+	free(bufs);
+	free(lens);
+	mcpkg_arena_free(a);
+}
+
+#endif /* BENCH_MP_LEDGER_ATTESTATION_H */
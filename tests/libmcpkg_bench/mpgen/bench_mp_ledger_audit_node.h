@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * AUTOGENERATED by mpgen — DO NOT EDIT BY HAND.
+ * Source schema: schemas/ledger/ledger_audit_node.yaml
+ */
+
+#ifndef BENCH_MP_LEDGER_AUDIT_NODE_H
+#define BENCH_MP_LEDGER_AUDIT_NODE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_alloc.h>
+#include <container/mcpkg_arena.h>
+#include <mp/mcpkg_mp_ledger_audit_node.h>
+
+#include "bench_mpgen.h"
+
+/* random ledger.audit_node: required fields always, optional ones half the time */
+static struct McPkgAuditNode *rand_mp_ledger_audit_node_new(uint64_t *rs)
+{
+	struct McPkgAuditNode *p = mcpkg_mp_ledger_audit_node_new();
+
+	if (!p)
+		return NULL;
+	bench_rand_bytes(rs, p->sibling, 32);
+	p->is_right = (uint32_t)bench_rand_int(rs, 32);
+	return p;
+}
+
+/* pack/unpack throughput over n random records, ops calls per row */
+static void bench_mp_ledger_audit_node(size_t n, size_t ops)
+{
+	struct McPkgAuditNode **recs, *p;
+	struct bench_mpgen_row row;
+	McPkgArena *a;
+	uint64_t rs = BENCH_MPGEN_SEED;
+	size_t i, k, len, *lens, bytes = 0, bad = 0;
+	void **bufs, *buf;
+	double avg;
+
+	recs = calloc(n, sizeof(*recs));
+	bufs = calloc(n, sizeof(*bufs));
+	lens = calloc(n, sizeof(*lens));
+	a = mcpkg_arena_new(0, 0);
+	for (i = 0; recs && bufs && lens && i < n; i++) {
+		recs[i] = rand_mp_ledger_audit_node_new(&rs);
+		if (!recs[i] ||
+		    mcpkg_mp_ledger_audit_node_pack(recs[i], &bufs[i], &lens[i]))
+			break;
+		bytes += lens[i];
+	}
+	if (!n || !a || i < n) {
+		printf("%-12s n=%zu: setup failed\n", "ledger.audit_node", n);
+		goto out;
+	}
+	avg = (double)bytes / (double)n;
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		if (mcpkg_mp_ledger_audit_node_pack(recs[i % n], &buf, &len)) {
+			bad++;
+			continue;
+		}
+		mcpkg_free(buf);
+	}
+	bench_mpgen_end(&row, "ledger.audit_node", "pack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (mcpkg_mp_ledger_audit_node_unpack(bufs[k], lens[k], &p)) {
+			bad++;
+			continue;
+		}
+		mcpkg_mp_ledger_audit_node_free(p);
+	}
+	bench_mpgen_end(&row, "ledger.audit_node", "unpack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (k == 0)
+			mcpkg_arena_reset(a);
+		if (mcpkg_mp_ledger_audit_node_unpack_arena(bufs[k], lens[k], a, &p))
+			bad++;
+	}
+	bench_mpgen_end(&row, "ledger.audit_node", "unpack arena", n, ops, avg);
+	if (bad)
+		printf("%-12s n=%zu: %zu errors\n", "ledger.audit_node", n, bad);
+
+out:
+	for (i = 0; recs && i < n; i++)
+		mcpkg_mp_ledger_audit_node_free(recs[i]);
+	for (i = 0; bufs && i < n; i++)
+		mcpkg_free(bufs[i]);
+	free(recs);
+	free(bufs);
+	free(lens);
+	mcpkg_arena_free(a);
+}
+
+#endif /* BENCH_MP_LEDGER_AUDIT_NODE_H */
@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * AUTOGENERATED by mpgen — DO NOT EDIT BY HAND.
+ * Source schema: schemas/ledger/ledger_audit_path.yaml
+ */
+
+#ifndef BENCH_MP_LEDGER_AUDIT_PATH_H
+#define BENCH_MP_LEDGER_AUDIT_PATH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_alloc.h>
+#include <container/mcpkg_arena.h>
+#include <mp/mcpkg_mp_ledger_audit_path.h>
+
+#include "bench_mpgen.h"
+#include "bench_mp_ledger_audit_node.h"
+
+/* random ledger.audit_path: required fields always, optional ones half the time */
+static struct McPkgAuditPath *rand_mp_ledger_audit_path_new(uint64_t *rs)
+{
+	struct McPkgAuditPath *p = mcpkg_mp_ledger_audit_path_new();
+	size_t i, n;
+
+	if (!p)
+		return NULL;
+	n = bench_rand_count(rs, 0);
+	if (n) {
+		p->nodes = mcpkg_list_new(sizeof(struct McPkgAuditNode *),
+		                  NULL, 0, 0);
+		if (!p->nodes)
+			goto fail;
+	}
+	for (i = 0; i < n; i++) {
+		struct McPkgAuditNode *e = rand_mp_ledger_audit_node_new(rs);
+
+		if (!e || mcpkg_list_push(p->nodes, &e) !=
+		    MCPKG_CONTAINER_OK) {
+			mcpkg_mp_ledger_audit_node_free(e);
+			goto fail;
+		}
+	}
+	return p;
+
+fail:
+	mcpkg_mp_ledger_audit_path_free(p);
+	return NULL;
+}
+
+/* pack/unpack throughput over n random records, ops calls per row */
+static void bench_mp_ledger_audit_path(size_t n, size_t ops)
+{
+	struct McPkgAuditPath **recs, *p;
+	struct bench_mpgen_row row;
+	McPkgArena *a;
+	uint64_t rs = BENCH_MPGEN_SEED;
+	size_t i, k, len, *lens, bytes = 0, bad = 0;
+	void **bufs, *buf;
+	double avg;
+
+	recs = calloc(n, sizeof(*recs));
+	bufs = calloc(n, sizeof(*bufs));
+	lens = calloc(n, sizeof(*lens));
+	a = mcpkg_arena_new(0, 0);
+	for (i = 0; recs && bufs && lens && i < n; i++) {
+		recs[i] = rand_mp_ledger_audit_path_new(&rs);
+		if (!recs[i] ||
+		    mcpkg_mp_ledger_audit_path_pack(recs[i], &bufs[i], &lens[i]))
+			break;
+		bytes += lens[i];
+	}
+	if (!n || !a || i < n) {
+		printf("%-12s n=%zu: setup failed\n", "ledger.audit_path", n);
+		goto out;
+	}
+	avg = (double)bytes / (double)n;
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		if (mcpkg_mp_ledger_audit_path_pack(recs[i % n], &buf, &len)) {
+			bad++;
+			continue;
+		}
+		mcpkg_free(buf);
+	}
+	bench_mpgen_end(&row, "ledger.audit_path", "pack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (mcpkg_mp_ledger_audit_path_unpack(bufs[k], lens[k], &p)) {
+			bad++;
+			continue;
+		}
+		mcpkg_mp_ledger_audit_path_free(p);
+	}
+	bench_mpgen_end(&row, "ledger.audit_path", "unpack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (k == 0)
+			mcpkg_arena_reset(a);
+		if (mcpkg_mp_ledger_audit_path_unpack_arena(bufs[k], lens[k], a, &p))
+			bad++;
+	}
+	bench_mpgen_end(&row, "ledger.audit_path", "unpack arena", n, ops, avg);
+	if (bad)
+		printf("%-12s n=%zu: %zu errors\n", "ledger.audit_path", n, bad);
+
+out:
+	for (i = 0; recs && i < n; i++)
+		mcpkg_mp_ledger_audit_path_free(recs[i]);
+	for (i = 0; bufs && i < n; i++)
+		mcpkg_free(bufs[i]);
+	free(recs);
+	free(bufs);
+	free(lens);
+	mcpkg_arena_free(a);
+}
+
+#endif /* BENCH_MP_LEDGER_AUDIT_PATH_H */
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * AUTOGENERATED by mpgen — DO NOT EDIT BY HAND.
+ * Source schema: schemas/ledger/ledger_devproof.yaml
+ */
+
+#ifndef BENCH_MP_LEDGER_DEVPROOF_H
+#define BENCH_MP_LEDGER_DEVPROOF_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_alloc.h>
+#include <container/mcpkg_arena.h>
+#include <mp/mcpkg_mp_ledger_devproof.h>
+
+#include "bench_mpgen.h"
+
+/* random ledger.devproof: required fields always, optional ones half the time */
+static struct McPkgDevProof *rand_mp_ledger_devproof_new(uint64_t *rs)
+{
+	struct McPkgDevProof *p = mcpkg_mp_ledger_devproof_new();
+
+	if (!p)
+		return NULL;
+	p->kind = (uint32_t)bench_rand_int(rs, 32);
+	if (bench_rand_str(rs, 0, &p->proof_data1))
+		goto fail;
+	if (bench_rand_str(rs, 0, &p->proof_data2))
+		goto fail;
+	bench_rand_bytes(rs, p->proof_sig, 64);
+	return p;
+
+fail:
+	mcpkg_mp_ledger_devproof_free(p);
+	return NULL;
+}
+
+/* pack/unpack throughput over n random records, ops calls per row */
+static void bench_mp_ledger_devproof(size_t n, size_t ops)
+{
+	struct McPkgDevProof **recs, *p;
+	struct bench_mpgen_row row;
+	McPkgArena *a;
+	uint64_t rs = BENCH_MPGEN_SEED;
+	size_t i, k, len, *lens, bytes = 0, bad = 0;
+	void **bufs, *buf;
+	double avg;
+
+	recs = calloc(n, sizeof(*recs));
+	bufs = calloc(n, sizeof(*bufs));
+	lens = calloc(n, sizeof(*lens));
+	a = mcpkg_arena_new(0, 0);
+	for (i = 0; recs && bufs && lens && i < n; i++) {
+		recs[i] = rand_mp_ledger_devproof_new(&rs);
+		if (!recs[i] ||
+		    mcpkg_mp_ledger_devproof_pack(recs[i], &bufs[i], &lens[i]))
+			break;
+		bytes += lens[i];
+	}
+	if (!n || !a || i < n) {
+		printf("%-12s n=%zu: setup failed\n", "ledger.devproof", n);
+		goto out;
+	}
+	avg = (double)bytes / (double)n;
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		if (mcpkg_mp_ledger_devproof_pack(recs[i % n], &buf, &len)) {
+			bad++;
+			continue;
+		}
+		mcpkg_free(buf);
+	}
+	bench_mpgen_end(&row, "ledger.devproof", "pack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (mcpkg_mp_ledger_devproof_unpack(bufs[k], lens[k], &p)) {
+			bad++;
+			continue;
+		}
+		mcpkg_mp_ledger_devproof_free(p);
+	}
+	bench_mpgen_end(&row, "ledger.devproof", "unpack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (k == 0)
+			mcpkg_arena_reset(a);
+		if (mcpkg_mp_ledger_devproof_unpack_arena(bufs[k], lens[k], a, &p))
+			bad++;
+	}
+	bench_mpgen_end(&row, "ledger.devproof", "unpack arena", n, ops, avg);
+	if (bad)
+		printf("%-12s n=%zu: %zu errors\n", "ledger.devproof", n, bad);
+
+out:
+	for (i = 0; recs && i < n; i++)
+		mcpkg_mp_ledger_devproof_free(recs[i]);
+	for (i = 0; bufs && i < n; i++)
+		mcpkg_free(bufs[i]);
+	free(recs);
+	free(bufs);
+	free(lens);
+	mcpkg_arena_free(a);
+}
+
+#endif /* BENCH_MP_LEDGER_DEVPROOF_H */
@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * AUTOGENERATED by mpgen — DO NOT EDIT BY HAND.
+ * Source schema: schemas/pkg/pkg_meta.yaml
+ */
+
+#ifndef BENCH_MP_PKG_META_H
+#define BENCH_MP_PKG_META_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <container/mcpkg_alloc.h>
+#include <container/mcpkg_arena.h>
+#include <mp/mcpkg_mp_pkg_meta.h>
+
+#include "bench_mpgen.h"
+#include "bench_mp_pkg_depends.h"
+#include "bench_mp_pkg_file.h"
+#include "bench_mp_pkg_origin.h"
+
+/* random pkg.meta: required fields always, optional ones half the time */
+static struct McPkgCache *rand_mp_pkg_meta_new(uint64_t *rs)
+{
+	struct McPkgCache *p = mcpkg_mp_pkg_meta_new();
+	size_t i, n;
+
+	if (!p)
+		return NULL;
+	if (bench_rand_str(rs, 1, &p->id))
+		goto fail;
+	if (bench_rand_str(rs, 0, &p->slug))
+		goto fail;
+	if (bench_rand_str(rs, 1, &p->version))
+		goto fail;
+	if (bench_rand_str(rs, 0, &p->title))
+		goto fail;
+	if (bench_rand_str(rs, 0, &p->description))
+		goto fail;
+	if (bench_rand_str(rs, 0, &p->license_id))
+		goto fail;
+	if (bench_rand_str(rs, 0, &p->home_page))
+		goto fail;
+	if (bench_rand_str(rs, 0, &p->source_repo))
+		goto fail;
+	if (bench_rand_strlist(rs, 1, &p->loaders))
+		goto fail;
+	if (bench_rand_strlist(rs, 0, &p->sections))
+		goto fail;
+	if (bench_rand_strlist(rs, 0, &p->configs))
+		goto fail;
+	n = bench_rand_count(rs, 0);
+	if (n) {
+		p->depends = mcpkg_list_new(sizeof(struct McPkgDepends *),
+		                  NULL, 0, 0);
+		if (!p->depends)
+			goto fail;
+	}
+	for (i = 0; i < n; i++) {
+		struct McPkgDepends *e = rand_mp_pkg_depends_new(rs);
+
+		if (!e || mcpkg_list_push(p->depends, &e) !=
+		    MCPKG_CONTAINER_OK) {
+			mcpkg_mp_pkg_depends_free(e);
+			goto fail;
+		}
+	}
+	p->file = rand_mp_pkg_file_new(rs);
+	if (!p->file)
+		goto fail;
+	p->client = (int32_t)(uint32_t)bench_rand_int(rs, 32);
+	p->server = (int32_t)(uint32_t)bench_rand_int(rs, 32);
+	if (bench_rand(rs) & 1) {
+		p->origin = rand_mp_pkg_origin_new(rs);
+		if (!p->origin)
+			goto fail;
+	}
+	p->flags = (uint32_t)bench_rand_int(rs, 32);
+	p->schema = (uint32_t)bench_rand_int(rs, 32);
+	return p;
+
+fail:
+	mcpkg_mp_pkg_meta_free(p);
+	return NULL;
+}
+
+/* pack/unpack throughput over n random records, ops calls per row */
+static void bench_mp_pkg_meta(size_t n, size_t ops)
+{
+	struct McPkgCache **recs, *p;
+	struct McPkgCacheView v;
+	struct bench_mpgen_row row;
+	McPkgArena *a;
+	uint64_t rs = BENCH_MPGEN_SEED;
+	size_t i, k, len, *lens, bytes = 0, bad = 0;
+	void **bufs, *buf;
+	double avg;
+
+	recs = calloc(n, sizeof(*recs));
+	bufs = calloc(n, sizeof(*bufs));
+	lens = calloc(n, sizeof(*lens));
+	a = mcpkg_arena_new(0, 0);
+	for (i = 0; recs && bufs && lens && i < n; i++) {
+		recs[i] = rand_mp_pkg_meta_new(&rs);
+		if (!recs[i] ||
+		    mcpkg_mp_pkg_meta_pack(recs[i], &bufs[i], &lens[i]))
+			break;
+		bytes += lens[i];
+	}
+	if (!n || !a || i < n) {
+		printf("%-12s n=%zu: setup failed\n", "pkg.meta", n);
+		goto out;
+	}
+	avg = (double)bytes / (double)n;
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		if (mcpkg_mp_pkg_meta_pack(recs[i % n], &buf, &len)) {
+			bad++;
+			continue;
+		}
+		mcpkg_free(buf);
+	}
+	bench_mpgen_end(&row, "pkg.meta", "pack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (mcpkg_mp_pkg_meta_unpack(bufs[k], lens[k], &p)) {
+			bad++;
+			continue;
+		}
+		mcpkg_mp_pkg_meta_free(p);
+	}
+	bench_mpgen_end(&row, "pkg.meta", "unpack+free", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (k == 0)
+			mcpkg_arena_reset(a);
+		if (mcpkg_mp_pkg_meta_unpack_arena(bufs[k], lens[k], a, &p))
+			bad++;
+	}
+	bench_mpgen_end(&row, "pkg.meta", "unpack arena", n, ops, avg);
+
+	bench_mpgen_begin(&row);
+	for (i = 0; i < ops; i++) {
+		k = i % n;
+		if (mcpkg_mp_pkg_meta_view(bufs[k], lens[k], &v))
+			bad++;
+	}
+	bench_mpgen_end(&row, "pkg.meta", "view", n, ops, avg);
+	if (bad)
+		printf("%-12s n=%zu: %zu errors\n", "pkg.meta", n, bad);
+
+out:
+	for (i = 0; recs && i < n; i++)
+		mcpkg_mp_pkg_meta_free(recs[i]);
+	for (i = 0; bufs && i < n; i++)
+		mcpkg_free(bufs[i]);
+	free(recs);
+	free(bufs);
+	free(lens);
+	mcpkg_arena_free(a);
+}
+
+#endif /* BENCH_MP_PKG_META_H */
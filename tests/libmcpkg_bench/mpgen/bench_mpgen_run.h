@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * AUTOGENERATED by mpgen — DO NOT EDIT BY HAND.
+ * One bench per schema; see bench_mp_<schema>.h.
+ */
+
+#ifndef BENCH_MPGEN_RUN_H
+#define BENCH_MPGEN_RUN_H
+
+#include "bench_mpgen.h"
+#include "bench_mp_ledger_attestation.h"
+#include "bench_mp_ledger_audit_node.h"
+#include "bench_mp_ledger_audit_path.h"
+#include "bench_mp_ledger_block.h"
+#include "bench_mp_ledger_consistency.h"
+#include "bench_mp_ledger_delegate.h"
+#include "bench_mp_ledger_devlink.h"
+#include "bench_mp_ledger_devproof.h"
+#include "bench_mp_ledger_devsig.h"
+#include "bench_mp_ledger_hash32.h"
+#include "bench_mp_ledger_revoke.h"
+#include "bench_mp_ledger_reward.h"
+#include "bench_mp_ledger_sth.h"
+#include "bench_mp_ledger_tx.h"
+#include "bench_mp_pkg_depends.h"
+#include "bench_mp_pkg_digest.h"
+#include "bench_mp_pkg_file.h"
+#include "bench_mp_pkg_meta.h"
+#include "bench_mp_pkg_origin.h"
+
+static inline void run_bench_mpgen(void)
+{
+	size_t ops = bench_max_n(100000);
+	size_t n = ops < BENCH_MPGEN_RECORDS ? ops : BENCH_MPGEN_RECORDS;
+
+	bench_mpgen_count_allocs(1);
+	bench_mp_ledger_attestation(n, ops);
+	bench_mp_ledger_audit_node(n, ops);
+	bench_mp_ledger_audit_path(n, ops);
+	bench_mp_ledger_block(n, ops);
+	bench_mp_ledger_consistency(n, ops);
+	bench_mp_ledger_delegate(n, ops);
+	bench_mp_ledger_devlink(n, ops);
+	bench_mp_ledger_devproof(n, ops);
+	bench_mp_ledger_devsig(n, ops);
+	bench_mp_ledger_hash32(n, ops);
+	bench_mp_ledger_revoke(n, ops);
+	bench_mp_ledger_reward(n, ops);
+	bench_mp_ledger_sth(n, ops);
+	bench_mp_ledger_tx(n, ops);
+	bench_mp_pkg_depends(n, ops);
+	bench_mp_pkg_digest(n, ops);
+	bench_mp_pkg_file(n, ops);
+	bench_mp_pkg_meta(n, ops);
+	bench_mp_pkg_origin(n, ops);
+	bench_mpgen_count_allocs(0);
+}
+
+#endif /* BENCH_MPGEN_RUN_H */
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * AUTOGENERATED by mpgen — DO NOT EDIT BY HAND.
+ * Source schema: schemas/ledger/ledger_attestation.yaml
+ */
+
+/*
+ * libFuzzer entry for the ledger.attestation decoders. The heap and arena
+ * decoders must agree on every input, and an accepted record must
+ * pack to packed_size bytes, the same from either copy.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <container/mcpkg_alloc.h>
+#include <container/mcpkg_arena.h>
+#include <mp/mcpkg_mp_util.h>
+#include <mp/mcpkg_mp_ledger_attestation.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/* pack p; aborts unless it succeeds with exactly packed_size bytes */
+static void *fuzz_pack(const struct McPkgAttestation *p, size_t *len)
+{
+	void *buf = NULL;
+	int ret;
+
+	ret = mcpkg_mp_ledger_attestation_pack(p, &buf, len);
+	if (ret == MCPKG_MP_ERR_NO_MEMORY)
+		return NULL;
+	if (ret != MCPKG_MP_NO_ERROR || *len != mcpkg_mp_ledger_attestation_packed_size(p))
+		abort();
+	return buf;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct McPkgAttestation *p = NULL, *q = NULL;
+	McPkgArena *a;
+	void *bp, *bq;
+	size_t lp = 0, lq = 0;
+	int ret, ret_a;
+
+	a = mcpkg_arena_new(0, 0);
+	if (!a)
+		return 0;
+	ret = mcpkg_mp_ledger_attestation_unpack(data, size, &p);
+	ret_a = mcpkg_mp_ledger_attestation_unpack_arena(data, size, a, &q);
+	if (ret == MCPKG_MP_ERR_NO_MEMORY || ret_a == MCPKG_MP_ERR_NO_MEMORY)
+		goto out;
+	if ((ret == MCPKG_MP_NO_ERROR) != (ret_a == MCPKG_MP_NO_ERROR))
+		abort();
+	if (ret != MCPKG_MP_NO_ERROR)
+		goto out;
+
+	bp = fuzz_pack(p, &lp);
+	bq = fuzz_pack(q, &lq);
+	if (bp && bq && (lp != lq || memcmp(bp, bq, lp)))
+		abort();
+	mcpkg_free(bp);
+	mcpkg_free(bq);
+
+out:
+	mcpkg_mp_ledger_attestation_free(p);
+	mcpkg_arena_free(a);
+	return 0;
+}
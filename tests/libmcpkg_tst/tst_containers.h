@@ -3,6 +3,8 @@
 
 #include <string.h>
 #include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -12,6 +14,11 @@
 #include <container/mcpkg_str_list.h>
 #include <container/mcpkg_hash.h>
 #include <container/mcpkg_map.h>
+#include <container/mcpkg_chash.h>
+#include <container/mcpkg_hash_frozen.h>
+#include <container/mcpkg_arena.h>
+#include <container/mcpkg_alloc.h>
+#include <threads/mcpkg_thread.h>
 
 
 /* ----- list ----- */
@@ -48,6 +55,121 @@ static void test_list_basic(void)
 	mcpkg_list_free(lst);
 }
 
+/* inline elements spill to the heap without losing contents */
+static void test_list_inline(void)
+{
+	McPkgList *lst = mcpkg_list_new_inline(sizeof(int), NULL, 4, 0, 0);
+	int v, out, bad = 0;
+
+	CHECK(lst != NULL, "list_new_inline");
+	CHECK_EQ_SZ("inline capacity", mcpkg_list_capacity(lst), 4);
+
+	for (v = 0; v < 4; v++)
+		CHECK_OKC("push inline", mcpkg_list_push(lst, &v));
+	CHECK_EQ_SZ("still inline", mcpkg_list_capacity(lst), 4);
+
+	for (v = 4; v < 100; v++)
+		if (mcpkg_list_push(lst, &v) != MCPKG_CONTAINER_OK)
+			bad++;
+	CHECK_EQ_INT("push past inline", bad, 0);
+	CHECK(mcpkg_list_capacity(lst) >= 100, "grown to heap");
+
+	for (v = 0; v < 100; v++)
+		if (mcpkg_list_at(lst, (size_t)v, &out) != MCPKG_CONTAINER_OK ||
+		    out != v)
+			bad++;
+	CHECK_EQ_INT("contents kept", bad, 0);
+	v = 42;
+	CHECK_EQ_INT("index_of", mcpkg_list_index_of(lst, &v), 42);
+
+	mcpkg_list_free(lst);
+}
+
+struct tst_dep {
+	char id[16];
+	int  rank;		/* not part of identity */
+};
+
+static int tst_dep_eq(const void *a, const void *b, void *ctx)
+{
+	(void)ctx;
+	return strcmp(((const struct tst_dep *)a)->id,
+	              ((const struct tst_dep *)b)->id);
+}
+
+static const void *tst_dep_key(const void *e, size_t *len, void *ctx)
+{
+	const struct tst_dep *d = (const struct tst_dep *)e;
+
+	(void)ctx;
+	*len = strlen(d->id);
+	return d->id;
+}
+
+/* indexed index_of agrees with a plain scan through edits */
+static void test_list_indexed(void)
+{
+	McPkgListOps ops = { .equals = tst_dep_eq };
+	McPkgList *ix = mcpkg_list_new(sizeof(int), NULL, 0, 0);
+	McPkgList *ref = mcpkg_list_new(sizeof(int), NULL, 0, 0);
+	McPkgList *deps;
+	struct tst_dep d;
+	int v, i, bad = 0;
+
+	CHECK(ix && ref, "lists created");
+	CHECK_OKC("set indexed", mcpkg_list_set_indexed(ix, 1));
+
+	for (i = 0; i < 4000; i++) {
+		v = (i * 7919) % 1500;	/* plenty of duplicates */
+		mcpkg_list_push(ix, &v);
+		mcpkg_list_push(ref, &v);
+		if (i % 97 == 0) {
+			mcpkg_list_add(ix, (size_t)i / 2, &i);
+			mcpkg_list_add(ref, (size_t)i / 2, &i);
+		}
+		if (i % 89 == 0) {
+			mcpkg_list_remove_at(ix, (size_t)i / 3);
+			mcpkg_list_remove_at(ref, (size_t)i / 3);
+		}
+		if (i % 50 == 0) {
+			v = i % 1600;
+			if (mcpkg_list_index_of(ix, &v) !=
+			    mcpkg_list_index_of(ref, &v))
+				bad++;
+		}
+	}
+	for (v = 0; v < 4100; v++)
+		if (mcpkg_list_index_of(ix, &v) != mcpkg_list_index_of(ref, &v))
+			bad++;
+	CHECK_EQ_INT("indexed == scan", bad, 0);
+
+	mcpkg_list_free(ix);
+	mcpkg_list_free(ref);
+
+	/* custom equality needs a matching key */
+	deps = mcpkg_list_new(sizeof(d), &ops, 0, 0);
+	CHECK(mcpkg_list_set_indexed(deps, 1) == MCPKG_CONTAINER_ERR_INVALID,
+	      "equals without key");
+	mcpkg_list_free(deps);
+
+	ops.key = tst_dep_key;
+	deps = mcpkg_list_new(sizeof(d), &ops, 0, 0);
+	CHECK_OKC("key indexed", mcpkg_list_set_indexed(deps, 1));
+	for (i = 0; i < 100; i++) {
+		memset(&d, 0, sizeof(d));
+		snprintf(d.id, sizeof(d.id), "dep-%d", i % 60);
+		d.rank = i;
+		if (mcpkg_list_index_of(deps, &d) < 0)
+			mcpkg_list_push(deps, &d);
+	}
+	CHECK_EQ_SZ("dedup by id", mcpkg_list_size(deps), 60);
+	memset(&d, 0, sizeof(d));
+	strcpy(d.id, "dep-42");
+	d.rank = -1;
+	CHECK_EQ_INT("lookup ignores rank", mcpkg_list_index_of(deps, &d), 42);
+	mcpkg_list_free(deps);
+}
+
 /* ----- string list ----- */
 
 static void test_strlist_basic(void)
@@ -80,11 +202,125 @@ static void test_strlist_basic(void)
 	CHECK_OKC("Pop Str", mcpkg_stringlist_pop(sl, &taken));
 	CHECK(taken && strcmp(taken, "beta") == 0, "taken='%s'",
 	      taken ? taken : "(null)");
-	free(taken);
+	mcpkg_free(taken);
 
 	mcpkg_stringlist_free(sl);
 }
 
+/* packed lists behave like the strdup'd ones */
+static void test_strlist_packed(void)
+{
+	McPkgStringList *pk = mcpkg_stringlist_new_packed(0, 0);
+	McPkgStringList *ref = mcpkg_stringlist_new(0, 0);
+	unsigned long long seed = 99;
+	char buf[96], *taken = NULL;
+	const char *a, *b;
+	size_t i, n, at;
+	int r, bad = 0;
+
+	CHECK(pk && ref, "stringlists created");
+
+	CHECK_OKC("push_n", mcpkg_stringlist_push_n(pk, "fabricXX", 6));
+	CHECK_OKC("push", mcpkg_stringlist_push(pk, "quilt"));
+	CHECK_OKC("add front", mcpkg_stringlist_add(pk, 0, "forge"));
+	CHECK(mcpkg_stringlist_push_n(pk, "a\0b", 3) ==
+	      MCPKG_CONTAINER_ERR_INVALID, "push_n rejects NUL");
+	CHECK(strcmp(mcpkg_stringlist_at(pk, 1), "fabric") == 0, "push_n copy");
+	CHECK_EQ_INT("index_of", mcpkg_stringlist_index_of(pk, "quilt"), 2);
+	CHECK_OKC("remove middle", mcpkg_stringlist_remove_at(pk, 1));
+	CHECK(strcmp(mcpkg_stringlist_first(pk), "forge") == 0 &&
+	      strcmp(mcpkg_stringlist_last(pk), "quilt") == 0, "after remove");
+	CHECK_OKC("pop", mcpkg_stringlist_pop(pk, &taken));
+	CHECK(taken && strcmp(taken, "quilt") == 0, "pop copy");
+	mcpkg_free(taken);
+	CHECK_OKC("remove all", mcpkg_stringlist_remove_all(pk));
+
+	/* random edits against a reference; long strings leave inline text */
+	for (i = 0; i < 3000; i++) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		n = mcpkg_stringlist_size(ref);
+		snprintf(buf, sizeof(buf), "%0*llu", (int)((seed >> 20) % 80),
+		         (seed >> 33) % 1000);
+		switch ((seed >> 60) % 4) {
+		case 0:
+			at = n ? (size_t)(seed >> 40) % n : 0;
+			if (n && (mcpkg_stringlist_remove_at(pk, at) !=
+			          mcpkg_stringlist_remove_at(ref, at)))
+				bad++;
+			break;
+		case 1:
+			at = (size_t)(seed >> 40) % (n + 1);
+			if (mcpkg_stringlist_add(pk, at, buf) !=
+			    mcpkg_stringlist_add(ref, at, buf))
+				bad++;
+			break;
+		default:
+			if (mcpkg_stringlist_push(pk, buf) !=
+			    mcpkg_stringlist_push(ref, buf))
+				bad++;
+		}
+		if (i % 500 == 499) {
+			r = (int)((seed >> 8) % 20);
+			mcpkg_stringlist_resize(pk, (size_t)r);
+			mcpkg_stringlist_resize(ref, (size_t)r);
+		}
+	}
+	CHECK_EQ_INT("same op results", bad, 0);
+	CHECK_EQ_SZ("same size", mcpkg_stringlist_size(pk),
+	            mcpkg_stringlist_size(ref));
+	for (i = 0; i < mcpkg_stringlist_size(ref); i++) {
+		a = mcpkg_stringlist_at(pk, i);
+		b = mcpkg_stringlist_at(ref, i);
+		if (!a || !b || strcmp(a, b) != 0)
+			bad++;
+	}
+	CHECK_EQ_INT("same contents", bad, 0);
+
+	mcpkg_stringlist_free(pk);
+	mcpkg_stringlist_free(ref);
+}
+
+static void test_strlist_indexed(void)
+{
+	McPkgStringList *sls[2];
+	char buf[32];
+	int b, i, bad = 0;
+
+	sls[0] = mcpkg_stringlist_new(0, 0);
+	sls[1] = mcpkg_stringlist_new_packed(0, 0);
+	for (b = 0; b < 2; b++) {
+		McPkgStringList *sl = sls[b];
+
+		CHECK_OKC("strlist indexed", mcpkg_stringlist_set_indexed(sl, 1));
+		for (i = 0; i < 3000; i++) {
+			snprintf(buf, sizeof(buf), "mod-%d", (i * 31) % 1000);
+			if (mcpkg_stringlist_index_of(sl, buf) < 0)
+				mcpkg_stringlist_push(sl, buf);
+		}
+		CHECK_EQ_SZ("dedup", mcpkg_stringlist_size(sl), 1000);
+		CHECK_EQ_INT("first pushed", mcpkg_stringlist_index_of(sl,
+		                "mod-31"), 1);
+
+		/* removal shifts positions; the index follows */
+		CHECK_OKC("remove 0", mcpkg_stringlist_remove_at(sl, 0));
+		CHECK_EQ_INT("shifted", mcpkg_stringlist_index_of(sl,
+		                "mod-31"), 0);
+		CHECK_EQ_INT("gone", mcpkg_stringlist_index_of(sl, "mod-0"),
+		             -1);
+		CHECK_OKC("add front", mcpkg_stringlist_add(sl, 0, "mod-62"));
+		CHECK_EQ_INT("first of duplicates", mcpkg_stringlist_index_of(sl,
+		                "mod-62"), 0);
+		for (i = 0; i < 1000; i++) {
+			const char *s = mcpkg_stringlist_at(sl, (size_t)i);
+
+			if (mcpkg_stringlist_index_of(sl, s) > i)
+				bad++;
+		}
+		CHECK_EQ_INT("all reachable", bad, 0);
+		mcpkg_stringlist_free(sl);
+	}
+}
+
 /* ----- hash ----- */
 
 static void test_hash_basic(void)
@@ -130,6 +366,365 @@ static void test_hash_basic(void)
 	mcpkg_hash_free(h);
 }
 
+/* grow through several rehashes, punch holes, refill */
+static void test_hash_many(void)
+{
+	McPkgHash *h = mcpkg_hash_new(sizeof(int), NULL, 0, 0);
+	char key[32];
+	int i, out, bad = 0, count = 0;
+	size_t it;
+	const char *k;
+
+	CHECK(h != NULL, "hash_new ok");
+
+	for (i = 0; i < 5000; i++) {
+		snprintf(key, sizeof(key), "pkg-%d", i);
+		if (mcpkg_hash_set(h, key, &i) != MCPKG_CONTAINER_OK)
+			bad++;
+	}
+	CHECK_EQ_INT("5000 inserts", bad, 0);
+	CHECK_EQ_SZ("size 5000", mcpkg_hash_size(h), 5000);
+
+	for (i = 0; i < 5000; i += 2) {
+		snprintf(key, sizeof(key), "pkg-%d", i);
+		if (mcpkg_hash_remove(h, key) != MCPKG_CONTAINER_OK)
+			bad++;
+	}
+	CHECK_EQ_INT("remove evens", bad, 0);
+	CHECK_EQ_SZ("size 2500", mcpkg_hash_size(h), 2500);
+
+	for (i = 0; i < 5000; i++) {
+		snprintf(key, sizeof(key), "pkg-%d", i);
+		if (mcpkg_hash_contains(h, key) != (i & 1))
+			bad++;
+		if ((i & 1) && (mcpkg_hash_get(h, key, &out) !=
+		                MCPKG_CONTAINER_OK || out != i))
+			bad++;
+	}
+	CHECK_EQ_INT("odds kept, evens gone", bad, 0);
+
+	for (i = 0; i < 5000; i += 2) {
+		snprintf(key, sizeof(key), "pkg-%d", i);
+		if (mcpkg_hash_set(h, key, &i) != MCPKG_CONTAINER_OK)
+			bad++;
+	}
+	CHECK_EQ_INT("refill evens", bad, 0);
+
+	CHECK_OKC("iter begin", mcpkg_hash_iter_begin(h, &it));
+	while (mcpkg_hash_iter_next(h, &it, &k, NULL))
+		count++;
+	CHECK_EQ_INT("iterate 5000", count, 5000);
+
+	mcpkg_hash_free(h);
+}
+
+/* switching hash functions keeps every entry reachable */
+/*
+ * One shared home group for many keys (set_h with a fixed H1), then
+ * growth with ordinary keys: rehash must keep every accepted entry
+ * within the probe bound lookups use.
+ */
+static void test_hash_probe_bound(void)
+{
+	McPkgHash *h = mcpkg_hash_new(sizeof(int), NULL, 0, 0);
+	char key[32];
+	int i, out, same = 0, plain = 0, bad = 0;
+	MCPKG_CONTAINER_ERROR ret = MCPKG_CONTAINER_OK;
+
+	CHECK(h != NULL, "hash_new ok");
+
+	for (i = 0; i < 4096 && ret == MCPKG_CONTAINER_OK; i++) {
+		snprintf(key, sizeof(key), "same-%d", i);
+		ret = mcpkg_hash_set_h(h, key, strlen(key),
+		                       (uint64_t)(i & 0x7F), &i);
+		same += ret == MCPKG_CONTAINER_OK;
+	}
+	CHECK(ret == MCPKG_CONTAINER_ERR_LIMIT, "long chain refused");
+	CHECK(same > 0 && same < 4096, "chain accepted up to the bound");
+
+	/* growth is refused once the chain no longer fits, never lossy */
+	for (ret = MCPKG_CONTAINER_OK; plain < 20000; plain++) {
+		snprintf(key, sizeof(key), "pkg-%d", plain);
+		ret = mcpkg_hash_set(h, key, &plain);
+		if (ret != MCPKG_CONTAINER_OK)
+			break;
+	}
+	CHECK(ret == MCPKG_CONTAINER_OK || ret == MCPKG_CONTAINER_ERR_LIMIT,
+	      "crowded rehash reports LIMIT");
+	CHECK_EQ_SZ("size after growth", mcpkg_hash_size(h),
+	            (size_t)(same + plain));
+
+	for (i = 0; i < same; i++) {
+		snprintf(key, sizeof(key), "same-%d", i);
+		if (mcpkg_hash_get_h(h, key, strlen(key),
+		                     (uint64_t)(i & 0x7F), &out) !=
+		    MCPKG_CONTAINER_OK || out != i)
+			bad++;
+	}
+	for (i = 0; i < plain; i++) {
+		snprintf(key, sizeof(key), "pkg-%d", i);
+		if (mcpkg_hash_get(h, key, &out) != MCPKG_CONTAINER_OK ||
+		    out != i)
+			bad++;
+	}
+	CHECK_EQ_INT("every entry reachable", bad, 0);
+
+	mcpkg_hash_free(h);
+}
+
+static void test_hash_fn_switch(void)
+{
+	static const MCPKG_HASH_FN fns[] = {
+		MCPKG_HASH_FN_WYHASH, MCPKG_HASH_FN_SIPHASH13,
+		MCPKG_HASH_FN_SIPHASH24
+	};
+	McPkgHash *h = mcpkg_hash_new(sizeof(int), NULL, 0, 0);
+	char key[64];
+	size_t f;
+	int i, out, bad = 0;
+
+	CHECK(h != NULL, "hash_new ok");
+	CHECK(mcpkg_hash_set_hash_fn(h, (MCPKG_HASH_FN)99) ==
+	      MCPKG_CONTAINER_ERR_INVALID, "unknown hash fn rejected");
+
+	for (i = 0; i < 1000; i++) {
+		/* mix of short, 16..48 and >48 byte keys */
+		snprintf(key, sizeof(key), "%.*s%d", i % 40,
+		         "modrinth-project-id-padding-padding-xyz", i);
+		if (mcpkg_hash_set(h, key, &i) != MCPKG_CONTAINER_OK)
+			bad++;
+	}
+
+	for (f = 0; f < sizeof(fns) / sizeof(fns[0]); f++) {
+		CHECK_OKC("set hash fn", mcpkg_hash_set_hash_fn(h, fns[f]));
+		for (i = 0; i < 1000; i++) {
+			snprintf(key, sizeof(key), "%.*s%d", i % 40,
+			         "modrinth-project-id-padding-padding-xyz", i);
+			if (mcpkg_hash_get(h, key, &out) != MCPKG_CONTAINER_OK ||
+			    out != i)
+				bad++;
+		}
+		CHECK(!mcpkg_hash_contains(h, "missing"), "miss after switch");
+	}
+	CHECK_EQ_INT("entries survive fn switches", bad, 0);
+	CHECK_EQ_SZ("size 1000", mcpkg_hash_size(h), 1000);
+
+	mcpkg_hash_free(h);
+}
+
+/* borrowed (ptr,len) keys and prehashed lookups */
+static void test_hash_n_variants(void)
+{
+	/* one buffer, several keys: like strings borrowed from msgpack */
+	static const char buf[] = "sodiumlithiumfabric-api";
+	McPkgHash *h = mcpkg_hash_new(sizeof(int), NULL, 0, 0);
+	uint64_t hv;
+	int v, out = 0;
+
+	CHECK(h != NULL, "hash_new ok");
+
+	v = 1;
+	CHECK_OKC("set_n sodium", mcpkg_hash_set_n(h, buf, 6, &v));
+	v = 2;
+	CHECK_OKC("set_n lithium", mcpkg_hash_set_n(h, buf + 6, 7, &v));
+	CHECK(mcpkg_hash_set_n(h, "a\0b", 3, &v) ==
+	      MCPKG_CONTAINER_ERR_INVALID, "embedded NUL rejected");
+
+	CHECK_OKC("get cstr", mcpkg_hash_get(h, "lithium", &out));
+	CHECK_EQ_INT("lithium == 2", out, 2);
+	CHECK_OKC("get_n", mcpkg_hash_get_n(h, buf, 6, &out));
+	CHECK_EQ_INT("sodium == 1", out, 1);
+	CHECK(mcpkg_hash_contains_n(h, buf, 3) == 0, "prefix is a miss");
+	CHECK(mcpkg_hash_contains_n(h, buf + 13, 10) == 0, "n miss");
+
+	hv = mcpkg_hash_key_hash(h, buf + 13, 10);
+	CHECK(mcpkg_hash_contains_h(h, buf + 13, 10, hv) == 0, "h miss");
+	v = 3;
+	CHECK_OKC("set_h", mcpkg_hash_set_h(h, buf + 13, 10, hv, &v));
+	CHECK_OKC("get_h", mcpkg_hash_get_h(h, buf + 13, 10, hv, &out));
+	CHECK_EQ_INT("fabric-api == 3", out, 3);
+	CHECK(mcpkg_hash_contains(h, "fabric-api"), "cstr sees set_h key");
+	CHECK_EQ_SZ("size 3", mcpkg_hash_size(h), 3);
+
+	mcpkg_hash_free(h);
+}
+
+static void tst_noop_dtor(void *val, void *ctx)
+{
+	(void)val;
+	(void)ctx;
+}
+
+/* freeze → view round trip, plus rejection of damaged images */
+static void test_hash_frozen(void)
+{
+	McPkgHash *h = mcpkg_hash_new(sizeof(int), NULL, 0, 0);
+	McPkgFrozenHash *fh = NULL;
+	unsigned char *img = NULL, *bad_img;
+	void *buf = NULL;
+	size_t len = 0, it = 0, seen = 0;
+	const char *k;
+	const int *vp;
+	char key[64];
+	int i, out, bad = 0;
+
+	CHECK(h != NULL, "hash_new ok");
+	CHECK_OKC("hash fn", mcpkg_hash_set_hash_fn(h, MCPKG_HASH_FN_WYHASH));
+	for (i = 0; i < 3000; i++) {
+		snprintf(key, sizeof(key), "%.*s%d", i % 40,
+		         "modrinth-project-id-padding-padding-xyz", i);
+		mcpkg_hash_set(h, key, &i);
+	}
+
+	CHECK_OKC("freeze", mcpkg_hash_freeze(h, &buf, &len));
+	img = buf;
+	mcpkg_hash_free(h);    /* the image stands alone */
+
+	CHECK(mcpkg_frozen_hash_open(img, len, sizeof(short), &fh) ==
+	      MCPKG_CONTAINER_ERR_INVALID, "value size mismatch rejected");
+	CHECK_OKC("open", mcpkg_frozen_hash_open(img, len, sizeof(int), &fh));
+	CHECK_EQ_SZ("frozen size", mcpkg_frozen_hash_size(fh), 3000);
+	for (i = 0; i < 3000; i++) {
+		snprintf(key, sizeof(key), "%.*s%d", i % 40,
+		         "modrinth-project-id-padding-padding-xyz", i);
+		if (mcpkg_frozen_hash_get(fh, key, &out) != MCPKG_CONTAINER_OK ||
+		    out != i)
+			bad++;
+	}
+	CHECK_EQ_INT("frozen lookups", bad, 0);
+	CHECK(!mcpkg_frozen_hash_contains(fh, "missing"), "frozen miss");
+	CHECK(!mcpkg_frozen_hash_contains_n(fh, "40", 1), "prefix miss");
+	vp = mcpkg_frozen_hash_get_ptr(fh, "40", 2);
+	CHECK(vp && *vp == 40, "zero-copy value");
+
+	while (mcpkg_frozen_hash_iter_next(fh, &it, &k, &out))
+		if (mcpkg_frozen_hash_get(fh, k, &i) == MCPKG_CONTAINER_OK &&
+		    i == out)
+			seen++;
+	CHECK_EQ_SZ("iter visits all", seen, 3000);
+	mcpkg_frozen_hash_close(fh);
+	fh = NULL;
+
+	CHECK(mcpkg_frozen_hash_open(img, len - 8, sizeof(int), &fh) ==
+	      MCPKG_CONTAINER_ERR_INVALID, "truncated image rejected");
+	bad_img = malloc(len);
+	CHECK(bad_img != NULL, "alloc copy");
+	if (bad_img) {
+		memcpy(bad_img, img, len);
+		bad_img[0] ^= 0xFF;
+		CHECK(mcpkg_frozen_hash_open(bad_img, len, sizeof(int), &fh) ==
+		      MCPKG_CONTAINER_ERR_INVALID, "bad magic rejected");
+		free(bad_img);
+	}
+	mcpkg_free(img);
+
+	/* hooks mean values own memory: not freezable */
+	{
+		McPkgHashOps ops = { 0 };
+
+		ops.value_dtor = tst_noop_dtor;
+		h = mcpkg_hash_new(sizeof(int), &ops, 0, 0);
+		CHECK(mcpkg_hash_freeze(h, &buf, &len) ==
+		      MCPKG_CONTAINER_ERR_INVALID, "hooked map rejected");
+		mcpkg_hash_free(h);
+	}
+}
+
+/* ----- concurrent hash ----- */
+
+struct tst_chash_job {
+	McPkgCHash *ch;
+	int base;
+	int bad;
+};
+
+/* own range: insert, read back, drop odd keys; probe the others */
+static int tst_chash_worker(void *arg)
+{
+	struct tst_chash_job *j = arg;
+	char key[32];
+	int i, out;
+
+	for (i = 0; i < 2000; i++) {
+		snprintf(key, sizeof(key), "pkg-%d", j->base + i);
+		if (mcpkg_chash_set(j->ch, key, &i) != MCPKG_CONTAINER_OK)
+			j->bad++;
+	}
+	for (i = 0; i < 2000; i++) {
+		snprintf(key, sizeof(key), "pkg-%d", j->base + i);
+		if (mcpkg_chash_get(j->ch, key, &out) != MCPKG_CONTAINER_OK ||
+		    out != i)
+			j->bad++;
+		if ((i & 1) && mcpkg_chash_remove(j->ch, key) !=
+		    MCPKG_CONTAINER_OK)
+			j->bad++;
+		snprintf(key, sizeof(key), "pkg-%d", (j->base + 7919 * i) %
+		         8000);
+		(void)mcpkg_chash_contains(j->ch, key);
+	}
+	return 0;
+}
+
+static void test_chash(void)
+{
+	struct tst_chash_job jobs[4];
+	struct McPkgThread *th[4];
+	McPkgCHash *ch = mcpkg_chash_new(sizeof(int), NULL, 5, 0, 0);
+	McPkgHash *snap;
+	size_t it;
+	const char *k;
+	int i, v, out = 0, bad = 0;
+
+	CHECK(ch != NULL, "chash_new ok");
+	CHECK_EQ_INT("shards round up", (int)mcpkg_chash_shards(ch), 8);
+	CHECK(mcpkg_chash_new(sizeof(int), NULL, MCPKG_CHASH_MAX_SHARDS + 1,
+	                      0, 0) == NULL, "too many shards rejected");
+
+	v = 1;
+	CHECK_OKC("set", mcpkg_chash_set(ch, "sodium", &v));
+	CHECK_OKC("get", mcpkg_chash_get(ch, "sodium", &out));
+	CHECK_EQ_INT("sodium == 1", out, 1);
+	CHECK_OKC("get_n", mcpkg_chash_get_n(ch, "sodium-extra", 6, &out));
+	CHECK(mcpkg_chash_set_hash_fn(ch, MCPKG_HASH_FN_WYHASH) ==
+	      MCPKG_CONTAINER_ERR_INVALID, "hash fn fixed once filled");
+	CHECK_OKC("pop", mcpkg_chash_pop(ch, "sodium", &out));
+	CHECK(mcpkg_chash_get(ch, "sodium", &out) ==
+	      MCPKG_CONTAINER_ERR_NOT_FOUND, "popped");
+	CHECK_OKC("hash fn on empty",
+	          mcpkg_chash_set_hash_fn(ch, MCPKG_HASH_FN_WYHASH));
+
+	for (i = 0; i < 4; i++) {
+		jobs[i].ch = ch;
+		jobs[i].base = i * 2000;
+		jobs[i].bad = 0;
+		th[i] = mcpkg_thread_create(tst_chash_worker, &jobs[i]);
+		CHECK(th[i] != NULL, "thread create");
+	}
+	for (i = 0; i < 4; i++) {
+		if (th[i])
+			mcpkg_thread_join(th[i]);
+		bad += jobs[i].bad;
+	}
+	CHECK_EQ_INT("concurrent ops", bad, 0);
+	CHECK_EQ_SZ("even keys left", mcpkg_chash_size(ch), 4000);
+
+	snap = mcpkg_chash_snapshot(ch);
+	CHECK(snap != NULL, "snapshot");
+	CHECK_EQ_SZ("snapshot size", mcpkg_hash_size(snap), 4000);
+	bad = 0;
+	mcpkg_hash_iter_begin(snap, &it);
+	while (mcpkg_hash_iter_next(snap, &it, &k, &v))
+		if (mcpkg_chash_get(ch, k, &out) != MCPKG_CONTAINER_OK ||
+		    out != v || (v & 1))
+			bad++;
+	CHECK_EQ_INT("snapshot matches", bad, 0);
+	CHECK(mcpkg_hash_contains(snap, "pkg-2"), "snapshot lookup");
+	mcpkg_hash_free(snap);
+
+	CHECK_OKC("remove_all", mcpkg_chash_remove_all(ch));
+	CHECK_EQ_SZ("empty", mcpkg_chash_size(ch), 0);
+	mcpkg_chash_free(ch);
+}
 
 /* ----- map (ordered) ----- */
 
@@ -207,6 +802,699 @@ static void test_map_basic(void)
 }
 
 
+static void test_map_n_variants(void)
+{
+	static const char buf[] = "k2k10k1";
+	McPkgMap *m = mcpkg_map_new(sizeof(int), NULL, 0, 0);
+	const char *k;
+	int v, out = 0;
+
+	CHECK(m != NULL, "map_new ok");
+
+	v = 2;
+	CHECK_OKC("map set_n k2", mcpkg_map_set_n(m, buf, 2, &v));
+	v = 10;
+	CHECK_OKC("map set_n k10", mcpkg_map_set_n(m, buf + 2, 3, &v));
+	v = 1;
+	CHECK_OKC("map set_n k1", mcpkg_map_set_n(m, buf + 5, 2, &v));
+
+	CHECK_OKC("map get_n k2", mcpkg_map_get_n(m, buf, 2, &out));
+	CHECK_EQ_INT("k2 == 2", out, 2);
+	CHECK(mcpkg_map_contains_n(m, buf + 2, 2), "k1 via k10 prefix");
+	CHECK(!mcpkg_map_contains_n(m, "k", 1), "k miss");
+	CHECK(mcpkg_map_contains(m, "k10"), "cstr sees set_n key");
+
+	/* strcmp order: k1 < k10 < k2 */
+	CHECK_OKC("map first", mcpkg_map_first(m, &k, &out));
+	CHECK(strcmp(k, "k1") == 0, "first is k1");
+	CHECK_OKC("map last", mcpkg_map_last(m, &k, &out));
+	CHECK(strcmp(k, "k2") == 0, "last is k2");
+
+	mcpkg_map_free(m);
+}
+
+/* B+-tree must agree with the RB tree through splits and merges */
+static void test_map_btree(void)
+{
+	McPkgMap *rb = mcpkg_map_new(sizeof(int), NULL, 0, 0);
+	McPkgMap *bt = mcpkg_map_new(sizeof(int), NULL, 0, 0);
+	unsigned long long seed = 12345;
+	const char *ka, *kb;
+	void *ia, *ib;
+	char key[48];
+	int i, va, vb, bad = 0, ra, rb_;
+
+	CHECK(rb && bt, "maps created");
+	CHECK_OKC("btree backend", mcpkg_map_set_backend(bt, MCPKG_MAP_BTREE));
+
+	for (i = 0; i < 30000; i++) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		/* long shared prefixes exercise the tie path past 8 bytes */
+		snprintf(key, sizeof(key), "%s%llu",
+		         (seed >> 60) & 1 ? "fabric:mod-" : "q",
+		         (seed >> 33) % 20000);
+		if ((seed >> 40) % 3 == 0) {
+			ra = mcpkg_map_remove(rb, key);
+			rb_ = mcpkg_map_remove(bt, key);
+		} else {
+			ra = mcpkg_map_set(rb, key, &i);
+			rb_ = mcpkg_map_set(bt, key, &i);
+		}
+		if (ra != rb_)
+			bad++;
+	}
+	CHECK_EQ_INT("same op results", bad, 0);
+	CHECK_EQ_SZ("same size", mcpkg_map_size(bt), mcpkg_map_size(rb));
+
+	mcpkg_map_iter_begin(rb, &ia);
+	mcpkg_map_iter_begin(bt, &ib);
+	for (;;) {
+		ra = mcpkg_map_iter_next(rb, &ia, &ka, &va);
+		rb_ = mcpkg_map_iter_next(bt, &ib, &kb, &vb);
+		if (ra != rb_) {
+			bad++;
+			break;
+		}
+		if (!ra)
+			break;
+		if (strcmp(ka, kb) != 0 || va != vb)
+			bad++;
+	}
+	CHECK_EQ_INT("same ordered contents", bad, 0);
+
+	for (i = 0; i < 2000; i++) {
+		snprintf(key, sizeof(key), "%s%d", (i & 1) ? "fabric:mod-" : "q",
+		         i * 7);
+		mcpkg_map_iter_seek(rb, &ia, key);
+		mcpkg_map_iter_seek(bt, &ib, key);
+		ra = mcpkg_map_iter_next(rb, &ia, &ka, NULL);
+		rb_ = mcpkg_map_iter_next(bt, &ib, &kb, NULL);
+		if (ra != rb_ || (ra && strcmp(ka, kb) != 0))
+			bad++;
+	}
+	CHECK_EQ_INT("same lower bounds", bad, 0);
+
+	CHECK_OKC("bt first", mcpkg_map_first(bt, &kb, NULL));
+	CHECK_OKC("rb first", mcpkg_map_first(rb, &ka, NULL));
+	CHECK(strcmp(ka, kb) == 0, "same first");
+	CHECK_OKC("bt last", mcpkg_map_last(bt, &kb, NULL));
+	CHECK_OKC("rb last", mcpkg_map_last(rb, &ka, NULL));
+	CHECK(strcmp(ka, kb) == 0, "same last");
+
+	/* drain completely: merges all the way back to a single leaf */
+	mcpkg_map_iter_begin(rb, &ia);
+	while (mcpkg_map_iter_next(rb, &ia, &ka, NULL))
+		if (mcpkg_map_remove(bt, ka) != MCPKG_CONTAINER_OK)
+			bad++;
+	CHECK_EQ_INT("drain btree", bad, 0);
+	CHECK_EQ_SZ("btree empty", mcpkg_map_size(bt), 0);
+	CHECK(mcpkg_map_first(bt, &kb, NULL) == MCPKG_CONTAINER_ERR_RANGE,
+	      "empty btree has no first");
+
+	mcpkg_map_free(rb);
+	mcpkg_map_free(bt);
+}
+
+/* ----- shared key storage ----- */
+
+/* three sorted groups of n keys: fabric:00000.., forge:.., quilt:.. */
+static char **map_bulk_keys(size_t n)
+{
+	static const char *const pre[] = { "fabric:", "forge:", "quilt:" };
+	char **keys = calloc(3 * n, sizeof(*keys));
+	char buf[32];
+	size_t i;
+
+	if (!keys)
+		return NULL;
+	for (i = 0; i < 3 * n; i++) {
+		snprintf(buf, sizeof(buf), "%s%05zu", pre[i / n], i % n);
+		keys[i] = strdup(buf);
+	}
+	return keys;
+}
+
+static void test_map_bulk(void)
+{
+	const size_t n = 3000;
+	McPkgMap *maps[2], *m;
+	char **keys = map_bulk_keys(n);
+	const char *k, *ka, *kb, *bad_keys[3] = { "a", "c", "b" };
+	int *vals = malloc(3 * n * sizeof(*vals));
+	void *it, *ia, *ib;
+	size_t i, cnt, removed;
+	int v, va, vb, b, bad = 0;
+
+	CHECK(keys && vals, "bulk inputs");
+	for (i = 0; i < 3 * n; i++)
+		vals[i] = (int)i;
+
+	for (b = 0; b < 2; b++) {
+		m = maps[b] = mcpkg_map_new(sizeof(int), NULL, 0, 0);
+		if (b)
+			CHECK_OKC("btree backend",
+			          mcpkg_map_set_backend(m, MCPKG_MAP_BTREE));
+
+		CHECK_OKC("bulk load", mcpkg_map_bulk_load(m,
+		                (const char *const *)keys, vals, 3 * n));
+		CHECK_EQ_SZ("bulk size", mcpkg_map_size(m), 3 * n);
+		CHECK(mcpkg_map_bulk_load(m, bad_keys, vals, 1) ==
+		      MCPKG_CONTAINER_ERR_INVALID, "bulk into non-empty");
+
+		cnt = 0;
+		mcpkg_map_iter_begin(m, &it);
+		while (mcpkg_map_iter_next(m, &it, &k, &v))
+			if (strcmp(k, keys[cnt]) != 0 || v != (int)cnt++)
+				bad++;
+		CHECK_EQ_INT("bulk order", bad, 0);
+		CHECK_EQ_SZ("bulk scan count", cnt, 3 * n);
+		CHECK_OKC("bulk get", mcpkg_map_get(m, "forge:01234", &v));
+		CHECK_EQ_INT("bulk value", v, (int)(n + 1234));
+
+		cnt = 0;
+		mcpkg_map_iter_prefix(m, &it, "forge:");
+		while (mcpkg_map_iter_next_prefix(m, &it, "forge:", &k, NULL))
+			if (strncmp(k, "forge:", 6) == 0)
+				cnt++;
+		CHECK_EQ_SZ("prefix forge:", cnt, n);
+		cnt = 0;
+		mcpkg_map_iter_prefix(m, &it, "fabric:001");
+		while (mcpkg_map_iter_next_prefix(m, &it, "fabric:001", &k,
+		                                  NULL))
+			cnt++;
+		CHECK_EQ_SZ("prefix fabric:001", cnt, 100);
+		mcpkg_map_iter_prefix(m, &it, "neoforge:");
+		CHECK(!mcpkg_map_iter_next_prefix(m, &it, "neoforge:", &k,
+		                                  NULL), "prefix miss");
+
+		CHECK_OKC("range", mcpkg_map_remove_range(m, "fabric:00100",
+		                "fabric:00200", &removed));
+		CHECK_EQ_SZ("range removed", removed, 100);
+		CHECK(mcpkg_map_contains(m, "fabric:00099") &&
+		      !mcpkg_map_contains(m, "fabric:00100") &&
+		      !mcpkg_map_contains(m, "fabric:00199") &&
+		      mcpkg_map_contains(m, "fabric:00200"), "range bounds");
+		CHECK_OKC("range open lo",
+		          mcpkg_map_remove_range(m, NULL, "forge:", &removed));
+		CHECK_EQ_SZ("open lo removed", removed, n - 100);
+		CHECK_OKC("range open hi",
+		          mcpkg_map_remove_range(m, "quilt:00500", NULL,
+		                                 &removed));
+		CHECK_EQ_SZ("open hi removed", removed, n - 500);
+		CHECK_OKC("range empty",
+		          mcpkg_map_remove_range(m, "z", "a", &removed));
+		CHECK_EQ_SZ("inverted range", removed, 0);
+		CHECK_EQ_SZ("size after ranges", mcpkg_map_size(m), n + 500);
+
+		/* the tree stays fully usable after bulk ops */
+		for (i = 0; i < 3 * n; i += 7)
+			mcpkg_map_set(m, keys[i], &vals[i]);
+		for (i = 0; i < 3 * n; i += 5)
+			mcpkg_map_remove(m, keys[i]);
+	}
+
+	CHECK_EQ_SZ("same size", mcpkg_map_size(maps[1]),
+	            mcpkg_map_size(maps[0]));
+	mcpkg_map_iter_begin(maps[0], &ia);
+	mcpkg_map_iter_begin(maps[1], &ib);
+	for (;;) {
+		va = mcpkg_map_iter_next(maps[0], &ia, &ka, &v);
+		vb = mcpkg_map_iter_next(maps[1], &ib, &kb, &v);
+		if (va != vb || (va && strcmp(ka, kb) != 0)) {
+			bad++;
+			break;
+		}
+		if (!va)
+			break;
+	}
+	CHECK_EQ_INT("backends agree after bulk ops", bad, 0);
+
+	/* drain via one open range; unsorted input leaves the map empty */
+	for (b = 0; b < 2; b++) {
+		m = maps[b];
+		CHECK_OKC("drain", mcpkg_map_remove_range(m, NULL, NULL, NULL));
+		CHECK_EQ_SZ("drained", mcpkg_map_size(m), 0);
+		CHECK(mcpkg_map_bulk_load(m, bad_keys, vals, 3) ==
+		      MCPKG_CONTAINER_ERR_INVALID, "bulk unsorted");
+		CHECK_EQ_SZ("still empty", mcpkg_map_size(m), 0);
+		CHECK_OKC("reload", mcpkg_map_bulk_load(m,
+		                (const char *const *)keys, vals, 3 * n));
+		mcpkg_map_free(m);
+	}
+
+	m = mcpkg_map_new(sizeof(int), NULL, 10, 0);
+	CHECK(mcpkg_map_bulk_load(m, (const char *const *)keys, vals, 11) ==
+	      MCPKG_CONTAINER_ERR_LIMIT, "bulk over max_pairs");
+	mcpkg_map_free(m);
+
+	/* ranges over a tree that never had a root */
+	m = mcpkg_map_new(sizeof(int), NULL, 0, 0);
+	CHECK_OKC("btree backend", mcpkg_map_set_backend(m, MCPKG_MAP_BTREE));
+	removed = 1;
+	CHECK_OKC("empty range open lo",
+	          mcpkg_map_remove_range(m, NULL, "z", &removed));
+	CHECK_EQ_SZ("empty open lo removed", removed, 0);
+	removed = 1;
+	CHECK_OKC("empty range", mcpkg_map_remove_range(m, "a", "z", &removed));
+	CHECK_EQ_SZ("empty range removed", removed, 0);
+	mcpkg_map_free(m);
+
+	for (i = 0; keys && i < 3 * n; i++)
+		free(keys[i]);
+	free(keys);
+	free(vals);
+}
+
+static void test_str_intern(void)
+{
+	McPkgStrIntern *in = mcpkg_str_intern_new(0, 0);
+	const char *a, *b, *c;
+	char buf[8];
+
+	CHECK(in != NULL, "intern_new ok");
+
+	a = mcpkg_str_intern_add(in, "fabric-api");
+	snprintf(buf, sizeof(buf), "%s", "sodium");
+	b = mcpkg_str_intern_add(in, buf);
+	c = mcpkg_str_intern_add(in, "fabric-api");
+	CHECK(a && b && a == c, "equal strings share a pointer");
+	CHECK(b != buf && strcmp(b, "sodium") == 0, "intern copies");
+	CHECK(mcpkg_str_intern_find(in, "sodium") == b, "find hit");
+	CHECK(mcpkg_str_intern_find(in, "lithium") == NULL, "find miss");
+	CHECK(mcpkg_str_intern_addn(in, "sodium-x", 6) == b, "addn prefix");
+	CHECK_EQ_SZ("2 distinct", mcpkg_str_intern_size(in), 2);
+
+	mcpkg_str_intern_free(in);
+}
+
+static void test_arena(void)
+{
+	McPkgArena *a = mcpkg_arena_new(256, 0);
+	McPkgArenaMark m;
+	McPkgStringList *sl;
+	McPkgList *lst;
+	size_t reserved;
+	char *s, *g;
+	int *v, i;
+
+	CHECK(a != NULL, "arena_new ok");
+
+	s = mcpkg_arena_strdup(a, "fabric");
+	v = mcpkg_arena_calloc(a, 4, sizeof(int));
+	CHECK(s && strcmp(s, "fabric") == 0, "strdup");
+	CHECK(v && v[3] == 0, "calloc zeroes");
+	CHECK(((size_t)v % _Alignof(max_align_t)) == 0, "alloc aligned");
+
+	/* the newest block grows in place */
+	g = mcpkg_arena_alloc(a, 16);
+	CHECK(mcpkg_arena_realloc(a, g, 16, 64) == g, "realloc in place");
+	g = mcpkg_arena_realloc(a, s, 7, 32);
+	CHECK(g && g != s && strcmp(g, "fabric") == 0, "realloc copies");
+
+	/* rewind drops later chunks, including a big private one */
+	m = mcpkg_arena_mark(a);
+	reserved = mcpkg_arena_reserved(a);
+	CHECK(mcpkg_arena_alloc(a, 4096) != NULL, "big alloc");
+	for (i = 0; i < 20; i++)
+		CHECK(mcpkg_arena_strndup(a, "quilt-loader", 5) != NULL,
+		      "strndup");
+	CHECK(mcpkg_arena_reserved(a) > reserved, "grew");
+	mcpkg_arena_rewind(a, &m);
+	CHECK_EQ_SZ("rewind reserved", mcpkg_arena_reserved(a), reserved);
+	CHECK(strcmp(s, "fabric") == 0, "older data kept");
+
+	/* arena-backed containers; free is a no-op */
+	lst = mcpkg_list_new_arena(a, sizeof(int), NULL, 0, 0);
+	sl = mcpkg_stringlist_new_arena(a, 0, 0);
+	CHECK(lst && sl, "arena containers");
+	for (i = 0; lst && sl && i < 100; i++) {
+		CHECK_OKC("list push", mcpkg_list_push(lst, &i));
+		CHECK_OKC("sl push", mcpkg_stringlist_push(sl,
+		          i % 2 ? "neoforge" : "fabric"));
+	}
+	CHECK_EQ_SZ("list size", mcpkg_list_size(lst), 100);
+	CHECK(mcpkg_stringlist_at(sl, 99) &&
+	      strcmp(mcpkg_stringlist_at(sl, 99), "neoforge") == 0, "sl at");
+	CHECK_EQ_INT("sl index_of", mcpkg_stringlist_index_of(sl, "fabric"), 0);
+	mcpkg_stringlist_free(sl);
+	mcpkg_list_free(lst);
+	CHECK(mcpkg_list_new_arena(NULL, sizeof(int), NULL, 0, 0) == NULL,
+	      "NULL arena");
+
+	mcpkg_arena_reset(a);
+	CHECK_EQ_SZ("reset used", mcpkg_arena_used(a), 0);
+	CHECK_EQ_SZ("reset keeps a chunk", mcpkg_arena_reserved(a) > 0, 1);
+	mcpkg_arena_free(a);
+
+	a = mcpkg_arena_new(0, 1024);
+	CHECK(a && mcpkg_arena_alloc(a, 4096) == NULL, "max_bytes");
+	mcpkg_arena_free(a);
+}
+
+/* ----- allocator hooks ----- */
+
+/*
+ * Counting allocator: prefixes every block with its size so sized
+ * frees/reallocs can be cross-checked, and fails once over budget.
+ */
+struct tst_counting {
+	long			live;       /* blocks outstanding */
+	size_t			bytes;      /* bytes outstanding */
+	size_t			budget;     /* 0 = unlimited */
+	int			bad_size;   /* wrong size passed to free/realloc */
+};
+
+typedef union {
+	max_align_t		align;
+	size_t			size;
+} tst_counting_hdr;
+
+static void *tst_counting_alloc(void *ctx, size_t size)
+{
+	struct tst_counting *c = ctx;
+	tst_counting_hdr *h;
+
+	if (c->budget && c->bytes + size > c->budget)
+		return NULL;
+	h = malloc(sizeof(*h) + size);
+	if (!h)
+		return NULL;
+	h->size = size;
+	c->live++;
+	c->bytes += size;
+	return h + 1;
+}
+
+static void *tst_counting_realloc(void *ctx, void *p, size_t old_size,
+                                  size_t new_size)
+{
+	struct tst_counting *c = ctx;
+	tst_counting_hdr *h = (tst_counting_hdr *)p - 1, *n;
+	size_t had = h->size;
+
+	if (old_size && old_size != had)
+		c->bad_size++;
+	if (c->budget && new_size > had &&
+	    c->bytes + (new_size - had) > c->budget)
+		return NULL;
+	n = realloc(h, sizeof(*n) + new_size);
+	if (!n)
+		return NULL;
+	n->size = new_size;
+	c->bytes = c->bytes - had + new_size;
+	return n + 1;
+}
+
+static void tst_counting_free(void *ctx, void *p, size_t size)
+{
+	struct tst_counting *c = ctx;
+	tst_counting_hdr *h = (tst_counting_hdr *)p - 1;
+
+	if (size && size != h->size)
+		c->bad_size++;
+	c->live--;
+	c->bytes -= h->size;
+	free(h);
+}
+
+static void test_allocator(void)
+{
+	struct tst_counting cnt = { 0 };
+	const McPkgAllocator ca = {
+		.alloc = tst_counting_alloc,
+		.realloc = tst_counting_realloc,
+		.free = tst_counting_free,
+		.ctx = &cnt,
+	};
+	McPkgStringList *sl;
+	McPkgList *lst;
+	McPkgHash *h;
+	McPkgMap *m;
+	McPkgArena *a;
+	McPkgCHash *ch;
+	char key[64], *s;
+	int i, v, bad;
+
+	/* list + both string list layouts */
+	lst = mcpkg_list_new_alloc(&ca, sizeof(int), NULL, 0, 0);
+	CHECK(lst != NULL, "list_new_alloc ok");
+	for (i = 0; lst && i < 1000; i++)
+		mcpkg_list_push(lst, &i);
+	CHECK_EQ_SZ("alloc list size", mcpkg_list_size(lst), 1000);
+	CHECK(cnt.live > 0, "list uses allocator");
+	mcpkg_list_free(lst);
+	CHECK_EQ_INT("list balanced", (int)cnt.live, 0);
+
+	for (i = 0; i < 2; i++) {
+		sl = i ? mcpkg_stringlist_new_packed_alloc(&ca, 0, 0)
+		     : mcpkg_stringlist_new_alloc(&ca, 0, 0);
+		CHECK(sl != NULL, "stringlist_new_alloc ok");
+		for (v = 0; sl && v < 300; v++) {
+			snprintf(key, sizeof(key), "mod-%d", v);
+			mcpkg_stringlist_push(sl, key);
+		}
+		CHECK_OKC("sl pop", mcpkg_stringlist_pop(sl, &s));
+		CHECK(s && strcmp(s, "mod-299") == 0, "popped string");
+		/* popped strings come from the list's allocator */
+		mcpkg_allocator_free(&ca, s, 0);
+		mcpkg_stringlist_free(sl);
+		CHECK_EQ_INT("stringlist balanced", (int)cnt.live, 0);
+	}
+
+	/* hash in every key mode */
+	for (i = MCPKG_CONTAINER_KEYS_OWNED; i <= MCPKG_CONTAINER_KEYS_ARENA;
+	     i++) {
+		h = mcpkg_hash_new_alloc(&ca, sizeof(int), NULL, 0, 0);
+		CHECK(h != NULL, "hash_new_alloc ok");
+		mcpkg_hash_set_key_mode(h, (MCPKG_CONTAINER_KEYS)i, NULL);
+		bad = 0;
+		for (v = 0; h && v < 500; v++) {
+			snprintf(key, sizeof(key), "%s-%d", (v & 1) ?
+			         "a-key-that-does-not-fit-inline" : "k", v);
+			if (mcpkg_hash_set(h, key, &v) != MCPKG_CONTAINER_OK)
+				bad++;
+		}
+		for (v = 0; h && v < 500; v += 2) {
+			snprintf(key, sizeof(key), "k-%d", v);
+			if (mcpkg_hash_remove(h, key) != MCPKG_CONTAINER_OK)
+				bad++;
+		}
+		CHECK_EQ_INT("alloc hash ops", bad, 0);
+		mcpkg_hash_free(h);
+		CHECK_EQ_INT("hash balanced", (int)cnt.live, 0);
+	}
+
+	/* map on both backends */
+	for (i = 0; i < 2; i++) {
+		m = mcpkg_map_new_alloc(&ca, sizeof(int), NULL, 0, 0);
+		CHECK(m != NULL, "map_new_alloc ok");
+		mcpkg_map_set_backend(m, i ? MCPKG_MAP_BTREE : MCPKG_MAP_RBTREE);
+		bad = 0;
+		for (v = 0; m && v < 500; v++) {
+			snprintf(key, sizeof(key), "%04d", (v * 37) % 500);
+			if (mcpkg_map_set(m, key, &v) != MCPKG_CONTAINER_OK)
+				bad++;
+		}
+		for (v = 0; m && v < 500; v += 3) {
+			snprintf(key, sizeof(key), "%04d", v);
+			if (mcpkg_map_remove(m, key) != MCPKG_CONTAINER_OK)
+				bad++;
+		}
+		CHECK_EQ_INT("alloc map ops", bad, 0);
+		mcpkg_map_free(m);
+		CHECK_EQ_INT("map balanced", (int)cnt.live, 0);
+	}
+
+	/* arena chunks come from the allocator */
+	a = mcpkg_arena_new_alloc(&ca, 256, 0);
+	CHECK(a != NULL, "arena_new_alloc ok");
+	for (v = 0; a && v < 50; v++)
+		mcpkg_arena_alloc(a, 100);
+	CHECK(cnt.live > 2, "arena chunks counted");
+	mcpkg_arena_free(a);
+	CHECK_EQ_INT("arena balanced", (int)cnt.live, 0);
+
+	/* budget exhaustion surfaces as NO_MEM */
+	cnt.budget = 4096;
+	lst = mcpkg_list_new_alloc(&ca, sizeof(int), NULL, 0, 0);
+	CHECK(lst != NULL, "budget list ok");
+	v = MCPKG_CONTAINER_OK;
+	for (i = 0; lst && i < 10000 && v == MCPKG_CONTAINER_OK; i++)
+		v = mcpkg_list_push(lst, &i);
+	CHECK_EQ_INT("budget NO_MEM", v, MCPKG_CONTAINER_ERR_NO_MEM);
+	mcpkg_list_free(lst);
+	cnt.budget = 0;
+	CHECK_EQ_INT("budget balanced", (int)cnt.live, 0);
+
+	/* process-wide default */
+	mcpkg_allocator_set_default(&ca);
+	CHECK(mcpkg_allocator_default() == &ca, "default set");
+	s = mcpkg_strdup("sodium");
+	ch = mcpkg_chash_new(sizeof(int), NULL, 0, 0, 0);
+	CHECK(s && ch && cnt.live > 1, "default used");
+	mcpkg_chash_free(ch);
+	mcpkg_free(s);
+	mcpkg_allocator_set_default(NULL);
+	CHECK(mcpkg_allocator_default() == mcpkg_allocator_libc(),
+	      "default restored");
+	CHECK_EQ_INT("default balanced", (int)cnt.live, 0);
+	CHECK_EQ_INT("sized frees match", cnt.bad_size, 0);
+	CHECK(mcpkg_allocator_calloc(NULL, SIZE_MAX, 2) == NULL,
+	      "calloc overflow");
+}
+
+static void test_mem_stats(void)
+{
+	McPkgMemStats before, mid, after;
+	McPkgList *lst;
+	char *dbg;
+	int i;
+
+	CHECK(strcmp(mcpkg_mem_module_name(MCPKG_MEM_CONTAINER),
+	             "container") == 0, "module name");
+	CHECK(strcmp(mcpkg_mem_module_name(MCPKG_MEM_MODULE_COUNT),
+	             "unknown") == 0, "module name out of range");
+
+	mcpkg_mem_stats_get(MCPKG_MEM_CONTAINER, &before);
+	lst = mcpkg_list_new(sizeof(int), NULL, 0, 0);
+	for (i = 0; lst && i < 4096; i++)
+		mcpkg_list_push(lst, &i);
+	mcpkg_mem_stats_get(MCPKG_MEM_CONTAINER, &mid);
+	mcpkg_list_free(lst);
+	mcpkg_mem_stats_get(MCPKG_MEM_CONTAINER, &after);
+
+	if (mcpkg_mem_stats_enabled()) {
+		CHECK(mid.live_bytes >= before.live_bytes + 4096 * sizeof(int),
+		      "list bytes charged to container");
+		CHECK(mid.allocs > before.allocs, "allocs counted");
+		CHECK_EQ_SZ("live back after free", after.live_bytes,
+		            before.live_bytes);
+		CHECK(after.peak_bytes >= mid.live_bytes, "peak kept");
+		CHECK_EQ_SZ("frees balance",
+		            after.frees - before.frees,
+		            after.allocs - before.allocs);
+
+		mcpkg_mem_stats_reset_peak();
+		mcpkg_mem_stats_get(MCPKG_MEM_TOTAL, &after);
+		CHECK_EQ_SZ("reset_peak", after.peak_bytes, after.live_bytes);
+	} else {
+		CHECK(mid.allocs == 0 && mid.live_bytes == 0, "stats off");
+	}
+
+	dbg = mcpkg_mem_stats_debug_str();
+	CHECK(dbg && strstr(dbg, "container") && strstr(dbg, "total"),
+	      "debug_str");
+	mcpkg_free(dbg);
+}
+
+/* same workload through every key mode */
+static void test_hash_key_modes(void)
+{
+	static const char *long_key =
+	        "a-key-that-is-much-longer-than-the-inline-limit";
+	McPkgStrIntern *in = mcpkg_str_intern_new(0, 0);
+	MCPKG_CONTAINER_KEYS mode;
+	McPkgHash *h;
+	char key[64];
+	int i, out, bad;
+
+	CHECK(in != NULL, "intern_new ok");
+
+	for (mode = MCPKG_CONTAINER_KEYS_OWNED;
+	     mode <= MCPKG_CONTAINER_KEYS_INTERNED; mode++) {
+		h = mcpkg_hash_new(sizeof(int), NULL, 0, 0);
+		CHECK(h != NULL, "hash_new ok");
+		CHECK_OKC("set key mode",
+		          mcpkg_hash_set_key_mode(h, mode, in));
+
+		bad = 0;
+		for (i = 0; i < 600; i++) {
+			snprintf(key, sizeof(key), "%s-%d",
+			         (i & 1) ? long_key : "k", i);
+			if (mcpkg_hash_set(h, key, &i) != MCPKG_CONTAINER_OK)
+				bad++;
+		}
+		for (i = 0; i < 600; i += 3) {
+			snprintf(key, sizeof(key), "%s-%d",
+			         (i & 1) ? long_key : "k", i);
+			if (mcpkg_hash_remove(h, key) != MCPKG_CONTAINER_OK)
+				bad++;
+		}
+		for (i = 0; i < 600; i++) {
+			snprintf(key, sizeof(key), "%s-%d",
+			         (i & 1) ? long_key : "k", i);
+			if (mcpkg_hash_contains(h, key) != (i % 3 != 0))
+				bad++;
+			if (i % 3 && (mcpkg_hash_get(h, key, &out) !=
+			              MCPKG_CONTAINER_OK || out != i))
+				bad++;
+		}
+		CHECK_EQ_INT("key mode roundtrip", bad, 0);
+		CHECK_EQ_SZ("key mode size", mcpkg_hash_size(h), 400);
+
+		i = 1;
+		CHECK(mcpkg_hash_set_key_mode(h, mode, in) ==
+		      MCPKG_CONTAINER_ERR_INVALID, "mode locked when non-empty");
+		CHECK_OKC("remove_all", mcpkg_hash_remove_all(h));
+		CHECK_OKC("reuse after clear", mcpkg_hash_set(h, "k", &i));
+		mcpkg_hash_free(h);
+	}
+
+	mcpkg_str_intern_free(in);
+}
+
+static void test_map_key_modes(void)
+{
+	McPkgStrIntern *in = mcpkg_str_intern_new(0, 0);
+	McPkgMap *m;
+	char key[128];
+	const char *k, *prev;
+	void *it;
+	int i, v, bad;
+
+	CHECK(in != NULL, "intern_new ok");
+
+	/* every key mode on both backends */
+	for (i = 0; i < 6; i++) {
+		MCPKG_CONTAINER_KEYS mode = (MCPKG_CONTAINER_KEYS)(i % 3);
+
+		m = mcpkg_map_new(sizeof(int), NULL, 0, 0);
+		CHECK(m != NULL, "map_new ok");
+		CHECK_OKC("map backend", mcpkg_map_set_backend(m,
+		          i < 3 ? MCPKG_MAP_RBTREE : MCPKG_MAP_BTREE));
+		CHECK_OKC("map key mode", mcpkg_map_set_key_mode(m, mode, in));
+
+		bad = 0;
+		for (v = 0; v < 200; v++) {
+			/* every 7th key is too long to sit inline */
+			snprintf(key, sizeof(key), "%03d%s", v, (v % 7) ? "" :
+			         "-padding-padding-padding-padding-padding-padding");
+			if (mcpkg_map_set(m, key, &v) != MCPKG_CONTAINER_OK)
+				bad++;
+		}
+		for (v = 0; v < 200; v += 2) {
+			snprintf(key, sizeof(key), "%03d%s", v, (v % 7) ? "" :
+			         "-padding-padding-padding-padding-padding-padding");
+			if (mcpkg_map_remove(m, key) != MCPKG_CONTAINER_OK)
+				bad++;
+		}
+		CHECK_EQ_INT("map key mode set/remove", bad, 0);
+		CHECK_EQ_SZ("map key mode size", mcpkg_map_size(m), 100);
+
+		prev = NULL;
+		mcpkg_map_iter_begin(m, &it);
+		while (mcpkg_map_iter_next(m, &it, &k, &v)) {
+			if ((prev && strcmp(prev, k) >= 0) || !(v & 1))
+				bad++;
+			prev = k;
+		}
+		CHECK_EQ_INT("map key mode order", bad, 0);
+		mcpkg_map_free(m);
+	}
+
+	mcpkg_str_intern_free(in);
+}
+
 /* ----- entry point for this header ----- */
 
 static inline void run_tst_containers(void)
@@ -215,9 +1503,28 @@ static inline void run_tst_containers(void)
 
 	tst_info("containers: starting...");
 	test_list_basic();
+	test_list_inline();
 	test_strlist_basic();
+	test_list_indexed();
+	test_strlist_packed();
+	test_strlist_indexed();
 	test_hash_basic();
+	test_hash_many();
+	test_hash_probe_bound();
+	test_hash_fn_switch();
+	test_hash_n_variants();
+	test_hash_frozen();
+	test_chash();
 	test_map_basic();
+	test_map_n_variants();
+	test_map_btree();
+	test_map_bulk();
+	test_str_intern();
+	test_arena();
+	test_allocator();
+	test_mem_stats();
+	test_hash_key_modes();
+	test_map_key_modes();
 
 	if (g_tst_fails == before)
 		(void)TST_WRITE(TST_OUT_FD, "containers: OK\n", 15);
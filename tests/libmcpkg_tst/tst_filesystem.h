@@ -14,9 +14,18 @@
 #include "fs/mcpkg_fs_util.h"
 #include "fs/mcpkg_fs_file.h"
 #include "fs/mcpkg_fs_dir.h"
+#include "fs/mcpkg_fs_zstd.h"
+#include "fs/mcpkg_cache_file.h"
+#include "mp/mcpkg_mp_util.h"
+#include "mp/mcpkg_mp_pkg_digest.h"
+#include "mp/mcpkg_mp_pkg_file.h"
+#include "mp/mcpkg_mp_pkg_meta.h"
+#include "threads/mcpkg_thread_pool.h"
 
 #ifdef _WIN32
 #  include <windows.h>
+#else
+#  include <unistd.h>
 #endif
 
 /* ----- tiny tmp helpers ----- */
@@ -134,6 +143,17 @@ static void test_dirs_and_files(void)
 	buf = NULL;
 	sz = 0;
 
+	{
+		McPkgFsMap map;
+
+		CHECK_OKFS("map_ro", mcpkg_fs_map_ro(f1, &map));
+		CHECK_EQ_SZ("mapped size 8", map.size, 8);
+		CHECK(map.data && memcmp(map.data, "hello fs", 8) == 0,
+		      "mapped content");
+		mcpkg_fs_unmap(&map);
+		CHECK(map.data == NULL, "unmapped");
+	}
+
 	f2 = join2(sub, "copy.txt");
 	CHECK_OKFS("cp_file", mcpkg_fs_cp_file(f1, f2, 1));
 	CHECK_OKFS("read copy", mcpkg_fs_read_all(f2, &buf, &sz));
@@ -215,6 +235,135 @@ static void test_cp_dir_rm_r(void)
 }
 #endif
 
+/* ----- streaming zstd ----- */
+
+#define TST_ZS_LEN  (3u * 1024u * 1024u + 17u)
+
+/* compressible but not trivial: text-like runs with a counter */
+static unsigned char *zs_data(void)
+{
+	unsigned char *p = malloc(TST_ZS_LEN);
+	size_t i;
+
+	for (i = 0; p && i < TST_ZS_LEN; i++)
+		p[i] = (unsigned char)("mcpkg-stream "[i % 13] + (i >> 12) % 7);
+	return p;
+}
+
+struct zs_cmp {
+	const unsigned char *want;
+	size_t               pos;
+	size_t               bad;
+};
+
+static MCPKG_FS_ERROR zs_sink(void *ctx, const void *buf, size_t len)
+{
+	struct zs_cmp *c = ctx;
+
+	if (c->pos + len > TST_ZS_LEN || memcmp(c->want + c->pos, buf, len))
+		c->bad++;
+	c->pos += len;
+	return MCPKG_FS_OK;
+}
+
+static MCPKG_FS_ERROR zs_src(void *ctx, void *buf, size_t cap, size_t *got)
+{
+	struct zs_cmp *c = ctx;
+	size_t n = TST_ZS_LEN - c->pos;
+
+	/* short reads on purpose */
+	if (n > cap / 3)
+		n = cap / 3;
+	memcpy(buf, c->want + c->pos, n);
+	c->pos += n;
+	*got = n;
+	return MCPKG_FS_OK;
+}
+
+static void test_zstd_stream(void)
+{
+	char *root = tmp_root_make();
+	char *f = root ? join2(root, "s.zst") : NULL;
+	char *g = root ? join2(root, "cut.zst") : NULL;
+	unsigned char *data = zs_data(), *buf = NULL, small[777];
+	McPkgFsZstdOpts opts = { 3, 2, NULL };
+	McPkgFsZstdWriter *w = NULL;
+	McPkgFsZstdReader *r = NULL;
+	struct zs_cmp c = { data, 0, 0 };
+	size_t off, n, got, sz = 0, bad = 0;
+	MCPKG_FS_ERROR ret;
+
+	CHECK(root && f && g && data, "zstd stream setup");
+	if (!root || !f || !g || !data)
+		goto out;
+
+	/* odd-sized pushes, two workers if libzstd has them */
+	CHECK_OKFS("zw open", mcpkg_fs_zstd_writer_open(f, &opts, &w));
+	for (off = 0; w && off < TST_ZS_LEN; off += n) {
+		n = TST_ZS_LEN - off < 40009u ? TST_ZS_LEN - off : 40009u;
+		bad += mcpkg_fs_zstd_writer_write(w, data + off, n) !=
+		       MCPKG_FS_OK;
+	}
+	CHECK_EQ_SZ("zw writes", bad, 0);
+	CHECK_OKFS("zw finish", mcpkg_fs_zstd_writer_finish(w));
+	mcpkg_fs_zstd_writer_free(w);
+
+	/* the one-shot reader takes it as a normal zstd file */
+	CHECK_OKFS("read_zstd", mcpkg_fs_read_zstd(f, &buf, &sz));
+	CHECK(sz == TST_ZS_LEN && buf && !memcmp(buf, data, sz),
+	      "stream file reads one-shot");
+	free(buf);
+	buf = NULL;
+
+	/* pull back through a small buffer */
+	CHECK_OKFS("zr open", mcpkg_fs_zstd_reader_open(f, NULL, &r));
+	for (off = 0; r; off += got) {
+		if (mcpkg_fs_zstd_reader_read(r, small, sizeof(small), &got) ||
+		    !got)
+			break;
+		bad += off + got > TST_ZS_LEN || memcmp(data + off, small, got);
+	}
+	CHECK(off == TST_ZS_LEN && !bad, "reader content (%zu bytes)", off);
+	mcpkg_fs_zstd_reader_free(r);
+	r = NULL;
+
+	/* callbacks both ways, one-shot writer on the other side */
+	CHECK_OKFS("write_zstd_cb", mcpkg_fs_write_zstd_cb(g, NULL, zs_src,
+	                &c));
+	c.pos = 0;
+	CHECK_OKFS("read_zstd_cb", mcpkg_fs_read_zstd_cb(g, NULL, zs_sink,
+	                &c));
+	CHECK(c.pos == TST_ZS_LEN && !c.bad, "callback roundtrip");
+	CHECK_OKFS("write_zstd", mcpkg_fs_write_zstd(g, data, 1000, 1));
+	c.pos = 0;
+	CHECK_OKFS("read_zstd_cb one-shot", mcpkg_fs_read_zstd_cb(g, NULL,
+	                zs_sink, &c));
+	CHECK(c.pos == 1000 && !c.bad, "one-shot file streams");
+
+	/* a cut frame is an error, not a short success */
+	CHECK_OKFS("read s.zst", mcpkg_fs_read_all(f, &buf, &sz));
+	CHECK_OKFS("write cut", mcpkg_fs_write_all(g, buf, sz / 2, 1));
+	free(buf);
+	buf = NULL;
+	c.pos = 0;
+	ret = mcpkg_fs_read_zstd_cb(g, NULL, zs_sink, &c);
+	CHECK(ret == MCPKG_FS_ERR_IO, "truncated stream rejected");
+
+	/* an unfinished writer leaves no file */
+	CHECK_OKFS("rm cut", mcpkg_fs_unlink(g));
+	CHECK_OKFS("zw open 2", mcpkg_fs_zstd_writer_open(g, NULL, &w));
+	(void)mcpkg_fs_zstd_writer_write(w, data, 100);
+	mcpkg_fs_zstd_writer_free(w);
+	CHECK(mcpkg_fs_file_exists(g) == 0, "unfinished stream discarded");
+
+	CHECK_OKFS("rm_r zstd root", mcpkg_fs_rm_r(root));
+out:
+	free(data);
+	free(g);
+	free(f);
+	free(root);
+}
+
 /* ----- NEW: explicit /tmp/tmp-test scenario ----- */
 
 #ifndef _WIN32
@@ -406,6 +555,329 @@ static void test_std_paths(void)
 }
 
 
+/* ----- indexed cache file ----- */
+
+#ifndef _WIN32
+#define TST_CACHE_N  300u
+
+/* one record shape for every cache entry; keys are swapped in per record */
+static struct McPkgCache *cache_meta_new(void)
+{
+	struct McPkgCache *m = mcpkg_mp_pkg_meta_new();
+	struct McPkgDigest *d = mcpkg_mp_pkg_digest_new();
+	int ok;
+
+	if (!m || !d) {
+		mcpkg_mp_pkg_meta_free(m);
+		mcpkg_mp_pkg_digest_free(d);
+		return NULL;
+	}
+	m->id = mcpkg_strdup("com.example:coolmod");
+	m->slug = mcpkg_strdup("coolmod");
+	m->version = mcpkg_strdup("1.2.3");
+	m->title = mcpkg_strdup("Cool Mod");
+	m->description = mcpkg_strdup("Adds cool blocks and a cooler biome");
+	m->license_id = mcpkg_strdup("MIT");
+	m->home_page = mcpkg_strdup("https://example.invalid");
+	m->loaders = mcpkg_stringlist_new(0, 0);
+	m->file = mcpkg_mp_pkg_file_new();
+	d->algo = 2;
+	d->hex = mcpkg_strdup("0123456789abcdef");
+	ok = m->id && m->slug && m->version && m->title && m->description &&
+	     m->license_id && m->home_page && m->loaders && m->file && d->hex &&
+	     !mcpkg_stringlist_push(m->loaders, "fabric") &&
+	     !mcpkg_stringlist_push(m->loaders, "quilt");
+	if (ok) {
+		m->file->url = mcpkg_strdup("https://example.invalid/mod.jar");
+		m->file->file_name = mcpkg_strdup("mod.jar");
+		m->file->size = 1234567u;
+		m->file->digests = mcpkg_list_new(sizeof(d), NULL, 0, 0);
+		ok = m->file->url && m->file->file_name && m->file->digests &&
+		     mcpkg_list_push(m->file->digests, &d) == MCPKG_CONTAINER_OK;
+	}
+	if (!ok) {
+		mcpkg_mp_pkg_digest_free(d);
+		mcpkg_mp_pkg_meta_free(m);
+		return NULL;
+	}
+	m->client = 1;
+	m->server = 1;
+	return m;
+}
+
+/*
+ * Keys of record i: ids out of file order. Returns slug, or NULL for
+ * every 10th record, which is written without one.
+ */
+static char *cache_keys(size_t i, char *id, char *slug, size_t cap)
+{
+	snprintf(id, cap, "mod-%03zu", (i * 7u) % TST_CACHE_N);
+	snprintf(slug, cap, "slug-%zu", i);
+	return (i % 10) ? slug : NULL;
+}
+
+static MCPKG_FS_ERROR cache_get(const McPkgCacheFile *cf,
+                                MCPKG_CACHE_KEY kind, const char *key,
+                                McPkgCacheBlock *b, struct McPkgCacheView *v)
+{
+	MCPKG_FS_ERROR ret;
+	const void *rec;
+	size_t len;
+
+	ret = mcpkg_cache_file_get(cf, kind, key, strlen(key), b, &rec, &len);
+	if (ret)
+		return ret;
+	return mcpkg_mp_pkg_meta_view(rec, len, v) ? MCPKG_FS_ERR_FORMAT
+	       : MCPKG_FS_OK;
+}
+
+/* whole-file decode: same records in file order for any job count */
+static void test_cache_load(const McPkgCacheFile *cf)
+{
+	static const unsigned jobs[] = { 1, 3, 16 };
+	struct McPkgThreadPoolCfg pcfg = { 3, 16 };
+	struct McPkgThreadPool *pool = NULL;
+	McPkgCacheLoad ld;
+	char id[32], slug[32], *sl;
+	size_t i, k, bad = 0;
+
+	CHECK_OK_THREADS("pool", mcpkg_thread_pool_new(&pcfg, &pool));
+	for (k = 0; k < sizeof(jobs) / sizeof(jobs[0]); k++) {
+		CHECK_OKFS("load", mcpkg_cache_file_load(cf, k ? pool : NULL,
+		                jobs[k], &ld));
+		CHECK_EQ_SZ("loaded all", ld.n, TST_CACHE_N);
+		for (i = 0; i < ld.n; i++) {
+			sl = cache_keys(i, id, slug, sizeof(id));
+			bad += !ld.recs[i] || strcmp(ld.recs[i]->id, id) ||
+			       (sl ? !ld.recs[i]->slug ||
+			        strcmp(ld.recs[i]->slug, sl) :
+			        ld.recs[i]->slug != NULL);
+		}
+		mcpkg_cache_load_free(&ld);
+	}
+	CHECK_EQ_SZ("file order for every job count", bad, 0);
+	mcpkg_thread_pool_free(pool);
+}
+
+/* cf's records rewritten one per block, plain and against a dict */
+static size_t cache_rewrite(const McPkgCacheFile *cf, const char *path,
+                            const McPkgZstdDict *d)
+{
+	McPkgCacheWriter *w = NULL;
+	McPkgCacheBlock b;
+	unsigned char *img = NULL;
+	const void *rec;
+	size_t k, pos, len, sz = 0, bad = 0;
+
+	memset(&b, 0, sizeof(b));
+	CHECK_OKFS("rewrite open", mcpkg_cache_writer_open(path, 1, 3, &w));
+	if (w && d)
+		CHECK_OKFS("set dict", mcpkg_cache_writer_set_dict(w, d));
+	for (k = 0; w && k < mcpkg_cache_file_blocks(cf); k++) {
+		bad += mcpkg_cache_file_read_block(cf, k, &b) != MCPKG_FS_OK;
+		pos = 0;
+		while (mcpkg_cache_block_next(&b, &pos, &rec, &len))
+			bad += mcpkg_cache_writer_add_packed(w, rec, len) !=
+			       MCPKG_FS_OK;
+	}
+	CHECK_EQ_SZ("rewrite records", bad, 0);
+	if (d)
+		CHECK(mcpkg_cache_writer_set_dict(w, d) == MCPKG_FS_ERR_RANGE,
+		      "dict fixed once blocks exist");
+	CHECK_OKFS("rewrite finish", mcpkg_cache_writer_finish(w));
+	mcpkg_cache_writer_free(w);
+	mcpkg_cache_block_free(&b);
+
+	if (mcpkg_fs_read_all(path, &img, &sz) != MCPKG_FS_OK)
+		sz = 0;
+	free(img);
+	return sz;
+}
+
+/* trained dictionary: embedded, found by id, and worth its bytes */
+static void test_cache_dict(const McPkgCacheFile *cf, const char *path)
+{
+	McPkgZstdDict *d = NULL;
+	McPkgCacheFile *cd = NULL;
+	McPkgCacheBlock b;
+	struct McPkgCacheView v;
+	unsigned char *out = NULL;
+	char id[32], slug[32], zpath[64];
+	size_t i, plain, with, len = 0, bad = 0;
+	const void *rec;
+
+	CHECK_OKFS("train", mcpkg_cache_file_train_dict(cf, 4096, 3, &d));
+	if (!d)
+		return;
+	CHECK(mcpkg_fs_zstd_dict_id(d) != 0, "dict id");
+
+	plain = cache_rewrite(cf, path, NULL);
+	with = cache_rewrite(cf, path, d);
+	CHECK(with && with < plain, "dict shrinks one-record blocks");
+
+	CHECK_OKFS("open dict cache", mcpkg_cache_file_open(path, &cd));
+	CHECK(mcpkg_cache_file_dict_id(cd) == mcpkg_fs_zstd_dict_id(d) &&
+	      mcpkg_cache_file_blocks(cd) == TST_CACHE_N, "dict cache header");
+	memset(&b, 0, sizeof(b));
+	for (i = 0; cd && i < TST_CACHE_N; i += 7) {
+		cache_keys(i, id, slug, sizeof(id));
+		bad += cache_get(cd, MCPKG_CACHE_KEY_ID, id, &b, &v) ||
+		       !mcpkg_mp_str_eq(&v.id, id);
+	}
+	CHECK_EQ_SZ("dict lookups", bad, 0);
+
+	/* single-file helpers: needs the same dict back */
+	snprintf(zpath, sizeof(zpath), "%s.zst", path);
+	CHECK_OKFS("get one", mcpkg_cache_file_get(cd, MCPKG_CACHE_KEY_SLUG,
+	                "slug-5", 6, &b, &rec, &len));
+	CHECK_OKFS("write zstd dict", mcpkg_fs_write_zstd_dict(zpath, rec, len,
+	                d));
+	CHECK_OKFS("read zstd dict", mcpkg_fs_read_zstd_dict(zpath, d, &out,
+	                &i));
+	CHECK(out && i == len && !memcmp(out, rec, len), "dict frame roundtrip");
+	free(out);
+	out = NULL;
+	CHECK(mcpkg_fs_read_zstd(zpath, &out, &i) != MCPKG_FS_OK && !out,
+	      "dict frame needs its dict");
+	unlink(zpath);
+
+	mcpkg_cache_block_free(&b);
+	mcpkg_cache_file_close(cd);
+	mcpkg_fs_zstd_dict_free(d);
+}
+
+static void test_cache_file(void)
+{
+	char path[] = "/tmp/mcpkg_rt_cache.XXXXXX", tmp[sizeof(path) + 4];
+	struct McPkgCache *m = cache_meta_new(), *out = NULL;
+	struct McPkgCacheView v;
+	McPkgCacheWriter *w = NULL;
+	McPkgCacheFile *cf = NULL;
+	McPkgCacheBlock b;
+	McPkgCacheLoc loc;
+	char id[32], slug[32], *sl, *m_id, *m_slug;
+	unsigned char *img = NULL;
+	const void *rec;
+	void *buf = NULL;
+	size_t i, k, len = 0, buf_len = 0, pos, seen = 0, bad = 0, sz = 0;
+	int fd = mkstemp(path);
+
+	CHECK(m && fd >= 0, "cache file setup");
+	if (!m || fd < 0) {
+		mcpkg_mp_pkg_meta_free(m);
+		return;
+	}
+	close(fd);
+	memset(&b, 0, sizeof(b));
+
+	/* 64 records per block: five frames, the last one short */
+	CHECK_OKFS("writer open", mcpkg_cache_writer_open(path, 64, 3, &w));
+	m_id = m->id;
+	m_slug = m->slug;
+	for (i = 0; w && i < TST_CACHE_N; i++) {
+		m->slug = cache_keys(i, id, slug, sizeof(id));
+		m->id = id;
+		if (i != 5) {
+			bad += mcpkg_cache_writer_add(w, m) != MCPKG_FS_OK;
+			continue;
+		}
+		/* one record takes the already-packed path */
+		bad += mcpkg_mp_pkg_meta_pack(m, &buf, &buf_len) !=
+		       MCPKG_MP_NO_ERROR || mcpkg_cache_writer_add_packed(w, buf,
+		                buf_len) != MCPKG_FS_OK;
+	}
+	m->id = m_id;
+	m->slug = m_slug;
+	CHECK_EQ_SZ("records added", bad, 0);
+	CHECK_OKFS("writer finish", mcpkg_cache_writer_finish(w));
+	mcpkg_cache_writer_free(w);
+
+	CHECK_OKFS("open", mcpkg_cache_file_open(path, &cf));
+	CHECK_EQ_SZ("records", mcpkg_cache_file_records(cf), TST_CACHE_N);
+	CHECK_EQ_SZ("blocks", mcpkg_cache_file_blocks(cf), 5);
+
+	/* point lookups by id and slug */
+	for (i = 0; cf && i < TST_CACHE_N; i += 13) {
+		sl = cache_keys(i, id, slug, sizeof(id));
+		bad += cache_get(cf, MCPKG_CACHE_KEY_ID, id, &b, &v) ||
+		       !mcpkg_mp_str_eq(&v.id, id);
+		if (sl)
+			bad += cache_get(cf, MCPKG_CACHE_KEY_SLUG, slug, &b,
+			                 &v) || !mcpkg_mp_str_eq(&v.slug, slug);
+	}
+	CHECK_EQ_SZ("lookups", bad, 0);
+
+	CHECK_OKFS("find last", mcpkg_cache_file_find(cf, MCPKG_CACHE_KEY_ID,
+	                "mod-293", 7, &loc));
+	CHECK(loc.block == 4 && loc.rec == TST_CACHE_N - 1, "last location");
+	CHECK(mcpkg_cache_file_find(cf, MCPKG_CACHE_KEY_ID, "mod-29", 6, &loc)
+	      == MCPKG_FS_ERR_NOT_FOUND, "prefix is no match");
+	CHECK(mcpkg_cache_file_find(cf, MCPKG_CACHE_KEY_SLUG, "slug-10", 7,
+	                            &loc) == MCPKG_FS_ERR_NOT_FOUND,
+	      "record without slug is not indexed");
+	CHECK(mcpkg_cache_file_find(cf, MCPKG_CACHE_KEY_ID, "zzz", 3, &loc)
+	      == MCPKG_FS_ERR_NOT_FOUND, "missing id");
+
+	/* the packed-path record decodes to the source */
+	CHECK_OKFS("get packed one", mcpkg_cache_file_get(cf,
+	                MCPKG_CACHE_KEY_SLUG, "slug-5", 6, &b, &rec, &len));
+	CHECK_OK_PACK("unpack", mcpkg_mp_pkg_meta_unpack(rec, len, &out));
+	CHECK(len == buf_len && !memcmp(rec, buf, len), "packed bytes kept");
+	CHECK(out && !strcmp(out->title, m->title) &&
+	      mcpkg_stringlist_size(out->loaders) == 2 &&
+	      !strcmp(out->file->url, m->file->url), "record fields");
+
+	/* scan every block in file order */
+	for (k = 0; k < mcpkg_cache_file_blocks(cf); k++) {
+		if (mcpkg_cache_file_read_block(cf, k, &b) || b.first != seen) {
+			bad++;
+			continue;
+		}
+		pos = 0;
+		while (mcpkg_cache_block_next(&b, &pos, &rec, &len)) {
+			cache_keys(seen++, id, slug, sizeof(id));
+			bad += mcpkg_mp_pkg_meta_view(rec, len, &v) ||
+			       !mcpkg_mp_str_eq(&v.id, id);
+		}
+		bad += pos != b.len;
+	}
+	CHECK_EQ_SZ("scan saw every record", seen, TST_CACHE_N);
+	CHECK_EQ_SZ("scan in file order", bad, 0);
+	mcpkg_cache_block_free(&b);
+
+	test_cache_load(cf);
+	snprintf(tmp, sizeof(tmp), "%s.d", path);
+	test_cache_dict(cf, tmp);
+	unlink(tmp);
+	mcpkg_cache_file_close(cf);
+	cf = NULL;
+
+	/* damaged images fail to open */
+	CHECK_OKFS("read image", mcpkg_fs_read_all(path, &img, &sz));
+	CHECK(img && mcpkg_cache_file_open_mem(img, sz - 8, &cf) ==
+	      MCPKG_FS_ERR_FORMAT, "truncated image");
+	if (img)
+		img[0] ^= 1;
+	CHECK(img && mcpkg_cache_file_open_mem(img, sz, &cf) ==
+	      MCPKG_FS_ERR_FORMAT && !cf, "bad magic");
+	free(img);
+
+	/* a writer freed before finish leaves nothing behind */
+	unlink(path);
+	CHECK_OKFS("writer open 2", mcpkg_cache_writer_open(path, 0, 0, &w));
+	CHECK_OKFS("add", mcpkg_cache_writer_add(w, m));
+	mcpkg_cache_writer_free(w);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	CHECK(access(path, F_OK) != 0 && access(tmp, F_OK) != 0,
+	      "unfinished cache discarded");
+
+	mcpkg_mp_pkg_meta_free(out);
+	mcpkg_mp_pkg_meta_free(m);
+	mcpkg_free(buf);
+}
+#endif
+
+
 /* ----- entry point ----- */
 
 static inline void run_tst_filesystem(void)
@@ -415,9 +887,11 @@ static inline void run_tst_filesystem(void)
 	tst_info("filesystem: starting...");
 	test_join_and_config();
 	test_dirs_and_files();
+	test_zstd_stream();
 #ifndef _WIN32
 	test_cp_dir_rm_r();
 	test_explicit_tmp_scenario();
+	test_cache_file();
 #endif
 	if (g_tst_fails == before)
 		(void)TST_WRITE(TST_OUT_FD, "filesystem: OK\n", 16);
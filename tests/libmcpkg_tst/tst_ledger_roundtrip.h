@@ -16,6 +16,7 @@
 #include <mp/mcpkg_mp_ledger_devproof.h>
 #include <mp/mcpkg_mp_ledger_devlink.h>
 #include <mp/mcpkg_mp_ledger_block.h>
+#include <mp/mcpkg_mp_ledger_consistency.h>
 
 
 /* ---------- tiny helpers ---------- */
@@ -79,8 +80,8 @@ static struct McPkgDevProof *mk_devproof(void)
 		return NULL;
 
 	p->kind = 3u; /* SIG */
-	p->proof_data1 = strdup("sig-type");
-	p->proof_data2 = strdup("sig-body");
+	p->proof_data1 = mcpkg_strdup("sig-type");
+	p->proof_data2 = mcpkg_strdup("sig-body");
 	fill_bin64(p->proof_sig, 0xCC);
 	return p;
 }
@@ -93,8 +94,8 @@ static struct McPkgDevLink *mk_devlink(void)
 	if (!l)
 		return NULL;
 
-	l->provider = strdup("modrinth");
-	l->project_id = strdup("P123");
+	l->provider = mcpkg_strdup("modrinth");
+	l->project_id = mcpkg_strdup("P123");
 	fill_bin32(l->dev_pub, 0x77);
 	l->proof = mk_devproof();
 	l->ts_ms = 1712345678;
@@ -142,7 +143,7 @@ static void rt_sth(void)
 
 	mcpkg_mp_ledger_sth_free(in);
 	mcpkg_mp_ledger_sth_free(out);
-	free(buf);
+	mcpkg_free(buf);
 }
 
 static void rt_tx(void)
@@ -168,7 +169,7 @@ static void rt_tx(void)
 
 	mcpkg_mp_ledger_tx_free(in);
 	mcpkg_mp_ledger_tx_free(out);
-	free(buf);
+	mcpkg_free(buf);
 }
 
 static void rt_devlink(void)
@@ -183,6 +184,8 @@ static void rt_devlink(void)
 	              mcpkg_mp_ledger_devlink_pack(in, &buf, &len));
 	CHECK_NONNULL("buf", buf);
 	CHECK_EQ_SZ("len > 0", len > 0 ? 1 : 0, 1);
+	CHECK_EQ_SZ("devlink packed_size",
+	            mcpkg_mp_ledger_devlink_packed_size(in), len);
 
 	CHECK_OK_PACK("unpack devlink",
 	              mcpkg_mp_ledger_devlink_unpack(buf, len, &out));
@@ -202,7 +205,7 @@ static void rt_devlink(void)
 
 	mcpkg_mp_ledger_devlink_free(in);
 	mcpkg_mp_ledger_devlink_free(out);
-	free(buf);
+	mcpkg_free(buf);
 }
 
 static void rt_block(void)
@@ -217,6 +220,8 @@ static void rt_block(void)
 	              mcpkg_mp_ledger_block_pack(in, &buf, &len));
 	CHECK_NONNULL("buf", buf);
 	CHECK_EQ_SZ("len > 0", len > 0 ? 1 : 0, 1);
+	CHECK_EQ_SZ("block packed_size",
+	            mcpkg_mp_ledger_block_packed_size(in), len);
 
 	CHECK_OK_PACK("unpack block",
 	              mcpkg_mp_ledger_block_unpack(buf, len, &out));
@@ -239,7 +244,49 @@ static void rt_block(void)
 
 	mcpkg_mp_ledger_block_free(in);
 	mcpkg_mp_ledger_block_free(out);
-	free(buf);
+	mcpkg_free(buf);
+}
+
+/* list<bin[32]>: elements are stored inline, not as pointers */
+static void rt_consistency(void)
+{
+	struct McPkgConsistencyProof *in, *out = NULL;
+	unsigned char node[32];
+	const void *a, *b;
+	void *buf = NULL;
+	size_t len = 0, i;
+
+	in = mcpkg_mp_ledger_consistency_new();
+	CHECK_NONNULL("rt_consistency in", in);
+	if (!in)
+		return;
+	in->nodes = mcpkg_list_new(32, NULL, 0, 0);
+	CHECK_NONNULL("nodes", in->nodes);
+	for (i = 0; in->nodes && i < 3; i++) {
+		fill_bin32(node, (unsigned char)(0x40 + i * 0x20));
+		CHECK_EQ_INT("push node", mcpkg_list_push(in->nodes, node),
+		             MCPKG_CONTAINER_OK);
+	}
+
+	CHECK_OK_PACK("pack consistency",
+	              mcpkg_mp_ledger_consistency_pack(in, &buf, &len));
+	CHECK_EQ_SZ("packed_size", len,
+	            mcpkg_mp_ledger_consistency_packed_size(in));
+	CHECK_OK_PACK("unpack consistency",
+	              mcpkg_mp_ledger_consistency_unpack(buf, len, &out));
+	CHECK_NONNULL("out nodes", out ? out->nodes : NULL);
+	if (out && out->nodes) {
+		CHECK_EQ_SZ("node count", mcpkg_list_size(out->nodes), 3);
+		for (i = 0; i < 3; i++) {
+			a = mcpkg_list_at_cptr(in->nodes, i);
+			b = mcpkg_list_at_cptr(out->nodes, i);
+			CHECK_MEMEQ("node", b, a, 32);
+		}
+	}
+
+	mcpkg_mp_ledger_consistency_free(in);
+	mcpkg_mp_ledger_consistency_free(out);
+	mcpkg_free(buf);
 }
 
 /* ---------- entry point ---------- */
@@ -261,6 +308,10 @@ static inline void run_tst_ledger_roundtrip(void)
 	TST_BLOCK("ledger block", {
 		rt_block();
 	});
+
+	TST_BLOCK("ledger consistency", {
+		rt_consistency();
+	});
 }
 
 #endif /* TST_LEDGER_ROUNDTRIP_H */
@@ -65,7 +65,7 @@ static void test_providers_message_pack(void)
 	if (q.owns_base_url && q.base_url)
 		free((void *)q.base_url);
 
-	free(buf);
+	mcpkg_free(buf);
 }
 
 static void test_loaders(void)
@@ -125,7 +125,7 @@ static void test_loaders_message_pack(void)
 	if (q.owns_base_url && q.base_url)
 		free((void *)q.base_url);
 
-	free(buf);
+	mcpkg_free(buf);
 }
 
 static void test_versions(void)
@@ -194,7 +194,7 @@ static void test_versions_message_pack(void)
 	if (out.versions)
 		mcpkg_stringlist_free(out.versions);
 
-	free(buf);
+	mcpkg_free(buf);
 }
 
 static void test_mc(void)
@@ -232,7 +232,7 @@ static void test_mc(void)
 	CHECK_OK_MC("pack_current_provider",
 	            mcpkg_mc_pack_current_provider(mc, &buf, &len));
 	CHECK(buf && len > 0, "provider current packed");
-	free(buf);
+	mcpkg_free(buf);
 	buf = NULL;
 	len = 0;
 
@@ -240,7 +240,7 @@ static void test_mc(void)
 	CHECK_OK_MC("pack_current_loader",
 	            mcpkg_mc_pack_current_loader(mc, &buf, &len));
 	CHECK(buf && len > 0, "loader current packed");
-	free(buf);
+	mcpkg_free(buf);
 	buf = NULL;
 	len = 0;
 
@@ -255,7 +255,7 @@ static void test_mc(void)
 
 	CHECK(mc->current_version != NULL, "current family set from unpack");
 
-	free(buf);
+	mcpkg_free(buf);
 	buf = NULL;
 	len = 0;
 
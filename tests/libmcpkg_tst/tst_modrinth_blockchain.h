@@ -176,7 +176,7 @@ static void test_modrinth_end_to_end(void)
 			char *dbg = mcpkg_mp_pkg_meta_debug_str(p);
 			if (dbg) {
 				tst_info("pkg[%zu] %s", i, dbg);
-				free(dbg);
+				mcpkg_free(dbg);
 			}
 		}
 
@@ -108,7 +108,212 @@ static void test_pack(void)
 	// cleanup
 	mcpkg_mp_reader_destroy(&r);
 	if (sl) mcpkg_stringlist_free(sl);
-	free(buf);
+	mcpkg_free(buf);
+}
+
+/* reader key index: duplicates, keys past the dense range, negatives */
+static void test_pack_key_index(void)
+{
+	static const int keys[] = { 5, 5, 31, 40, -3 };
+	struct McPkgMpWriter w;
+	struct McPkgMpReader r;
+	void *buf = NULL;
+	size_t len = 0, i;
+	int64_t v = 0;
+	int found = 0;
+
+	CHECK_OK_PACK("writer_init", mcpkg_mp_writer_init(&w));
+	CHECK_OK_PACK("map_begin", mcpkg_mp_map_begin(&w, 2 + 5));
+	CHECK_OK_PACK("write_header",
+	              mcpkg_mp_write_header(&w, TPK_TAG, TPK_VER));
+	for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+		CHECK_OK_PACK("kv_i32",
+		              mcpkg_mp_kv_i32(&w, keys[i], (int32_t)i + 1));
+	CHECK_OK_PACK("writer_finish", mcpkg_mp_writer_finish(&w, &buf, &len));
+	mcpkg_mp_writer_destroy(&w);
+
+	CHECK_OK_PACK("reader_init", mcpkg_mp_reader_init(&r, buf, len));
+	CHECK_OK_PACK("get 5", mcpkg_mp_get_i64(&r, 5, &v, &found));
+	CHECK(found && v == 1, "first duplicate wins");
+	CHECK_OK_PACK("get 31", mcpkg_mp_get_i64(&r, 31, &v, &found));
+	CHECK(found && v == 3, "last dense key");
+	CHECK_OK_PACK("get 40", mcpkg_mp_get_i64(&r, 40, &v, &found));
+	CHECK(found && v == 4, "key past dense range");
+	CHECK_OK_PACK("get -3", mcpkg_mp_get_i64(&r, -3, &v, &found));
+	CHECK(found && v == 5, "negative key");
+	CHECK_OK_PACK("get 6", mcpkg_mp_get_i64(&r, 6, &v, &found));
+	CHECK(!found, "absent dense key");
+	CHECK_OK_PACK("get 99", mcpkg_mp_get_i64(&r, 99, &v, &found));
+	CHECK(!found, "absent sparse key");
+
+	mcpkg_mp_reader_destroy(&r);
+	mcpkg_free(buf);
+}
+
+/* raw cursor over hand-written bytes: every value class once */
+static void test_pack_cursor(void)
+{
+	static const unsigned char b[] = {
+		0x87,                                   /* map, 7 pairs */
+		0xa1, 'k', 0x01,                        /* str key */
+		0x02, 0xd0, 0x85,                       /* int8 -123 */
+		0x03, 0xce, 0xff, 0xff, 0xff, 0xff,     /* u32 max */
+		0x04, 0xc0,                             /* nil */
+		0x05, 0xc4, 0x02, 0xab, 0xcd,           /* bin8 */
+		0x06, 0x92, 0x81, 0x01, 0xcb,           /* [{1: f64}, "hi"] */
+		0, 0, 0, 0, 0, 0, 0, 0, 0xa2, 'h', 'i',
+		0xd3, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		0xa3, 'x', 'y', 'z',                    /* int64 -1 key */
+	};
+	struct McPkgMpCur c;
+	const void *bp;
+	const char *sp;
+	size_t n = 0, len = 0;
+	int32_t i32 = 0;
+	uint32_t u32 = 0;
+	int key = 0;
+
+	mcpkg_mp_cur_init(&c, b, sizeof(b));
+	CHECK_OK_PACK("cur_map", mcpkg_mp_cur_map(&c, &n));
+	CHECK_EQ_SZ("pairs", n, 7);
+
+	CHECK_OK_PACK("str key", mcpkg_mp_cur_key(&c, &key));
+	CHECK_EQ_INT("str key reads -1", key, -1);
+	CHECK_OK_PACK("skip 1", mcpkg_mp_cur_skip(&c));
+
+	CHECK_OK_PACK("key 2", mcpkg_mp_cur_key(&c, &key));
+	CHECK_EQ_INT("key 2", key, 2);
+	CHECK_OK_PACK("i32", mcpkg_mp_cur_i32(&c, &i32));
+	CHECK_EQ_I32("int8", i32, -123);
+
+	CHECK_OK_PACK("key 3", mcpkg_mp_cur_key(&c, &key));
+	CHECK_OK_PACK("u32", mcpkg_mp_cur_u32(&c, &u32));
+	CHECK_EQ_U32("u32 max", u32, 0xffffffffu);
+
+	CHECK_OK_PACK("key 4", mcpkg_mp_cur_key(&c, &key));
+	CHECK(mcpkg_mp_cur_nil(&c), "nil consumed");
+	CHECK(!mcpkg_mp_cur_nil(&c), "next is not nil");
+
+	CHECK_OK_PACK("key 5", mcpkg_mp_cur_key(&c, &key));
+	CHECK_OK_PACK("bin", mcpkg_mp_cur_bin(&c, &bp, &len));
+	CHECK(len == 2 && !memcmp(bp, "\xab\xcd", 2), "bin payload");
+
+	CHECK_OK_PACK("key 6", mcpkg_mp_cur_key(&c, &key));
+	CHECK_OK_PACK("skip nested", mcpkg_mp_cur_skip(&c));
+
+	CHECK_OK_PACK("key -1", mcpkg_mp_cur_key(&c, &key));
+	CHECK_EQ_INT("int64 key", key, -1);
+	CHECK_OK_PACK("str", mcpkg_mp_cur_str(&c, &sp, &len));
+	CHECK(len == 3 && !memcmp(sp, "xyz", 3), "str payload");
+	CHECK(c.p == c.end, "all consumed");
+
+	/* type and range errors */
+	mcpkg_mp_cur_init(&c, b + 5, 2);
+	CHECK(mcpkg_mp_cur_u32(&c, &u32) == MCPKG_MP_ERR_PARSE, "neg as u32");
+	mcpkg_mp_cur_init(&c, b + 8, 5);
+	CHECK(mcpkg_mp_cur_i32(&c, &i32) == MCPKG_MP_ERR_PARSE, "u32 max as i32");
+	mcpkg_mp_cur_init(&c, b + 16, 4);
+	CHECK(mcpkg_mp_cur_str(&c, &sp, &len) == MCPKG_MP_ERR_PARSE, "bin as str");
+	mcpkg_mp_cur_init(&c, b + 16, 3);
+	CHECK(mcpkg_mp_cur_bin(&c, &bp, &len) == MCPKG_MP_ERR_PARSE, "short bin");
+	mcpkg_mp_cur_init(&c, b, sizeof(b) - 1);
+	CHECK(mcpkg_mp_cur_skip(&c) == MCPKG_MP_ERR_PARSE, "short map");
+	mcpkg_mp_cur_init(&c, "\xc1", 1);
+	CHECK(mcpkg_mp_cur_skip(&c) == MCPKG_MP_ERR_PARSE, "reserved byte");
+	mcpkg_mp_cur_init(&c, "\xdd\xff\xff\xff\xff", 5);
+	CHECK(mcpkg_mp_cur_array(&c, &n) == MCPKG_MP_ERR_PARSE,
+	      "count past the buffer");
+}
+
+/* one small record: header + TPK_K_NUM */
+static int tpk_write_num(struct McPkgMpWriter *w, int32_t v)
+{
+	int ret = mcpkg_mp_map_begin(w, 3);
+
+	if (!ret)
+		ret = mcpkg_mp_write_header(w, TPK_TAG, TPK_VER);
+	if (!ret)
+		ret = mcpkg_mp_kv_i32(w, TPK_K_NUM, v);
+	return ret;
+}
+
+static int64_t tpk_read_num(const void *buf, size_t len)
+{
+	struct McPkgMpReader r;
+	int64_t v = -1;
+	int found = 0;
+
+	if (mcpkg_mp_reader_init(&r, buf, len))
+		return -1;
+	if (mcpkg_mp_get_i64(&r, TPK_K_NUM, &v, &found) || !found)
+		v = -1;
+	mcpkg_mp_reader_destroy(&r);
+	return v;
+}
+
+/* finish hands the buffer over; reset/append keep one buffer going */
+static void test_pack_writer_reuse(void)
+{
+	struct McPkgMpWriter w;
+	const void *dp;
+	void *a = NULL, *b = NULL, *own;
+	size_t alen = 0, blen = 0, off[4], i, len;
+
+	CHECK_OK_PACK("writer_init", mcpkg_mp_writer_init(&w));
+	CHECK_OK_PACK("rec 1", tpk_write_num(&w, 1));
+	dp = mcpkg_mp_writer_data(&w, &len);
+	CHECK_OK_PACK("finish 1", mcpkg_mp_writer_finish(&w, &a, &alen));
+	CHECK(a == dp && alen == len, "finish hands over, no copy");
+	CHECK_EQ_SZ("empty after finish", mcpkg_mp_writer_len(&w), 0);
+	CHECK_OK_PACK("rec 2", tpk_write_num(&w, 2));
+	CHECK_OK_PACK("finish 2", mcpkg_mp_writer_finish(&w, &b, &blen));
+	CHECK(a != b, "fresh buffer after finish");
+	CHECK(tpk_read_num(a, alen) == 1 && tpk_read_num(b, blen) == 2,
+	      "both records intact");
+	mcpkg_free(a);
+	mcpkg_free(b);
+	a = b = NULL;
+
+	/* reset: same memory, next record from offset 0 */
+	CHECK_OK_PACK("rec 3", tpk_write_num(&w, 3));
+	dp = mcpkg_mp_writer_data(&w, &len);
+	mcpkg_mp_writer_reset(&w);
+	CHECK_EQ_SZ("empty after reset", mcpkg_mp_writer_len(&w), 0);
+	CHECK_OK_PACK("rec 4", tpk_write_num(&w, 4));
+	CHECK(mcpkg_mp_writer_data(&w, &len) == dp, "buffer reused");
+	CHECK(tpk_read_num(dp, len) == 4, "record after reset");
+
+	/* finish with nothing written still gives a freeable block */
+	mcpkg_mp_writer_reset(&w);
+	CHECK_OK_PACK("finish empty", mcpkg_mp_writer_finish(&w, &a, &alen));
+	CHECK(a != NULL && alen == 0, "empty finish");
+	mcpkg_free(a);
+	mcpkg_mp_writer_destroy(&w);
+
+	/* append after a caller-owned prefix, records back to back */
+	own = mcpkg_malloc(4);
+	CHECK(own != NULL, "prefix alloc");
+	if (!own)
+		return;
+	memcpy(own, "HDR!", 4);
+	CHECK_OK_PACK("init_append",
+	              mcpkg_mp_writer_init_append(&w, NULL, own, 4, 4));
+	for (i = 0; i < 3; i++) {
+		off[i] = mcpkg_mp_writer_len(&w);
+		CHECK_OK_PACK("append rec", tpk_write_num(&w, (int32_t)i + 10));
+	}
+	off[3] = mcpkg_mp_writer_len(&w);
+	CHECK_OK_PACK("finish append", mcpkg_mp_writer_finish(&w, &a, &alen));
+	mcpkg_mp_writer_destroy(&w);
+	CHECK(alen == off[3] && off[0] == 4, "append offsets");
+	CHECK(a && !memcmp(a, "HDR!", 4), "prefix kept");
+	for (i = 0; a && i < 3; i++)
+		CHECK(tpk_read_num((char *)a + off[i], off[i + 1] - off[i]) ==
+		      (int64_t)i + 10, "appended record");
+	mcpkg_free(a);
+
+	CHECK(mcpkg_mp_writer_init_append(&w, NULL, NULL, 1, 0) ==
+	      MCPKG_MP_ERR_INVALID_ARG, "len past cap");
 }
 
 static inline void run_tst_pack(void)
@@ -118,6 +323,9 @@ static inline void run_tst_pack(void)
 	tst_info("mcpkg message pack's tests: starting...");
 
 	test_pack();
+	test_pack_key_index();
+	test_pack_cursor();
+	test_pack_writer_reuse();
 
 	if (g_tst_fails == before)
 		(void)TST_WRITE(TST_OUT_FD,
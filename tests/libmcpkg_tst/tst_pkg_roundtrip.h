@@ -8,6 +8,7 @@
 
 #include <tst_macros.h>
 #include <mp/mcpkg_mp_util.h>
+#include <container/mcpkg_arena.h>
 
 /* generated model headers */
 #include <mp/mcpkg_mp_pkg_digest.h>
@@ -202,7 +203,7 @@ static struct McPkgDigest *mk_digest(const char *hex, uint32_t algo)
 		return NULL;
 
 	d->algo = algo;
-	d->hex = strdup(hex);
+	d->hex = mcpkg_strdup(hex);
 	CHECK_NONNULL("mk_digest hex dup", d->hex);
 	return d;
 }
@@ -234,8 +235,8 @@ static struct McPkgFile *mk_file_typical(void)
 	if (!f)
 		return NULL;
 
-	f->url = strdup("https://example.invalid/mod.jar");
-	f->file_name = strdup("mod.jar");
+	f->url = mcpkg_strdup("https://example.invalid/mod.jar");
+	f->file_name = mcpkg_strdup("mod.jar");
 	f->size = 1234567ULL;
 	f->digests = mk_digest_list_2();
 	CHECK(f->url && f->file_name && f->digests, "mk_file fields");
@@ -250,8 +251,8 @@ static struct McPkgDepends *mk_dep(const char *id, const char *vr,
 	CHECK_NONNULL("mk_dep alloc", d);
 	if (!d)
 		return NULL;
-	d->id = strdup(id);
-	d->version_range = strdup(vr);
+	d->id = mcpkg_strdup(id);
+	d->version_range = mcpkg_strdup(vr);
 	d->kind = kind;
 	d->side = side;
 	CHECK(d->id && d->version_range, "mk_dep strings");
@@ -284,10 +285,10 @@ static struct McPkgOrigin *mk_origin(void)
 	CHECK_NONNULL("mk_origin alloc", o);
 	if (!o)
 		return NULL;
-	o->provider = strdup("modrinth");
-	o->project_id = strdup("P1234");
-	o->version_id = strdup("V5678");
-	o->source_url = strdup("https://modrinth.example/P1234/V5678");
+	o->provider = mcpkg_strdup("modrinth");
+	o->project_id = mcpkg_strdup("P1234");
+	o->version_id = mcpkg_strdup("V5678");
+	o->source_url = mcpkg_strdup("https://modrinth.example/P1234/V5678");
 	CHECK(o->provider && o->project_id && o->source_url, "mk_origin str");
 	return o;
 }
@@ -314,14 +315,14 @@ static struct McPkgCache *mk_meta_maximal(void)
 	if (!m)
 		return NULL;
 
-	m->id = strdup("com.example:coolmod");
-	m->slug = strdup("coolmod");
-	m->version = strdup("1.2.3");
-	m->title = strdup("Cool Mod");
-	m->description = strdup("Cool mod desc");
-	m->license_id = strdup("MIT");
-	m->home_page = strdup("https://example.invalid");
-	m->source_repo = strdup("https://git.example/coolmod");
+	m->id = mcpkg_strdup("com.example:coolmod");
+	m->slug = mcpkg_strdup("coolmod");
+	m->version = mcpkg_strdup("1.2.3");
+	m->title = mcpkg_strdup("Cool Mod");
+	m->description = mcpkg_strdup("Cool mod desc");
+	m->license_id = mcpkg_strdup("MIT");
+	m->home_page = mcpkg_strdup("https://example.invalid");
+	m->source_repo = mcpkg_strdup("https://git.example/coolmod");
 
 	m->loaders = mk_strlist3("fabric", "quilt", "neoforge");
 	m->sections = mk_strlist3("gameplay", "worldgen", "");
@@ -359,7 +360,7 @@ static void rt_digest(void)
 
 	mcpkg_mp_pkg_digest_free(in);
 	mcpkg_mp_pkg_digest_free(out);
-	free(buf);
+	mcpkg_free(buf);
 }
 
 static void rt_file(void)
@@ -381,7 +382,7 @@ static void rt_file(void)
 
 	mcpkg_mp_pkg_file_free(in);
 	mcpkg_mp_pkg_file_free(out);
-	free(buf);
+	mcpkg_free(buf);
 }
 
 static void rt_meta(void)
@@ -403,7 +404,361 @@ static void rt_meta(void)
 
 	mcpkg_mp_pkg_meta_free(in);
 	mcpkg_mp_pkg_meta_free(out);
-	free(buf);
+	mcpkg_free(buf);
+}
+
+/* whole graph in one arena; a failed unpack leaves nothing behind */
+static void rt_meta_arena(void)
+{
+	McPkgArena *a = mcpkg_arena_new(0, 0);
+	struct McPkgCache *in = NULL, *out = NULL;
+	struct McPkgFile *bad = NULL, *fout = NULL;
+	void *buf = NULL, *fbuf = NULL;
+	size_t len = 0, flen = 0, used;
+	int i;
+
+	in = mk_meta_maximal();
+	bad = mcpkg_mp_pkg_file_new();
+	CHECK(a && in && bad, "rt_meta_arena setup");
+
+	CHECK_OK_PACK("pack meta", mcpkg_mp_pkg_meta_pack(in, &buf, &len));
+	CHECK_OK_PACK("pack file", mcpkg_mp_pkg_file_pack(bad, &fbuf, &flen));
+
+	for (i = 0; i < 3; i++) {
+		CHECK_OK_PACK("unpack meta (arena)",
+		              mcpkg_mp_pkg_meta_unpack_arena(buf, len, a, &out));
+		CHECK(eq_meta(in, out), "arena meta equal");
+	}
+	CHECK_EQ_SZ("one chunk", mcpkg_arena_reserved(a) <=
+	            MCPKG_ARENA_DEFAULT_CHUNK + 64, 1);
+
+	used = mcpkg_arena_used(a);
+	CHECK(mcpkg_mp_pkg_file_unpack_arena(fbuf, flen, a, &fout) !=
+	      MCPKG_MP_NO_ERROR, "arena unpack fails (required)");
+	CHECK_EQ_SZ("failed unpack rewound", mcpkg_arena_used(a), used);
+	CHECK(eq_meta(in, out), "earlier graph intact");
+
+	/* one reset releases every record */
+	mcpkg_arena_reset(a);
+	CHECK_EQ_SZ("reset", mcpkg_arena_used(a), 0);
+
+	mcpkg_mp_pkg_meta_free(in);
+	mcpkg_mp_pkg_file_free(bad);
+	mcpkg_arena_free(a);
+	mcpkg_free(buf);
+	mcpkg_free(fbuf);
+}
+
+/*
+ * Hand-built version 1 record: fields out of order, nested structs
+ * embedded as bin, unknown keys carrying nested containers, a repeated
+ * id (first wins) and a negative i32.
+ */
+static void rt_meta_stream(void)
+{
+	struct McPkgFile *f = mk_file_typical();
+	struct McPkgDepends *d = mk_dep("dep:x", ">=1", 1, 0);
+	struct McPkgStringList *ld = mk_strlist3("fabric", "quilt", "forge");
+	struct McPkgCache *out = NULL;
+	struct McPkgDepends *dout = NULL;
+	struct McPkgMpWriter w;
+	void *fbuf = NULL, *dbuf = NULL, *buf = NULL;
+	size_t flen = 0, dlen = 0, len = 0;
+
+	CHECK_OK_PACK("pack file", mcpkg_mp_pkg_file_pack(f, &fbuf, &flen));
+	CHECK_OK_PACK("pack dep", mcpkg_mp_pkg_depends_pack(d, &dbuf, &dlen));
+	CHECK_OK_PACK("writer_init", mcpkg_mp_writer_init(&w));
+	CHECK_OK_PACK("map_begin", mcpkg_mp_map_begin(&w, 10));
+	CHECK_OK_PACK("kv file", mcpkg_mp_kv_bin(&w, 14, fbuf, (uint32_t)flen));
+	CHECK_OK_PACK("kv depends", mcpkg_mp_kv_array_begin(&w, 13, 1));
+	CHECK_OK_PACK("  elt", mcpkg_mp_write_bin(&w, dbuf, (uint32_t)dlen));
+	CHECK_OK_PACK("kv client", mcpkg_mp_kv_i32(&w, 15, -1));
+	CHECK_OK_PACK("kv unknown map", mcpkg_mp_kv_map_begin(&w, 40, 1));
+	CHECK_OK_PACK("  key", mcpkg_mp_kv_array_begin(&w, 1, 2));
+	CHECK_OK_PACK("  elt", mcpkg_mp_write_bin(&w, "xy", 2));
+	CHECK_OK_PACK("  elt", mcpkg_mp_write_bin(&w, "z", 1));
+	CHECK_OK_PACK("kv id", mcpkg_mp_kv_str(&w, 2, "first"));
+	CHECK_OK_PACK("header", mcpkg_mp_write_header(&w, "pkg.meta", 1));
+	CHECK_OK_PACK("kv version", mcpkg_mp_kv_str(&w, 4, "1.0"));
+	CHECK_OK_PACK("kv loaders", mcpkg_mp_kv_strlist(&w, 10, ld));
+	CHECK_OK_PACK("kv id again", mcpkg_mp_kv_str(&w, 2, "second"));
+	CHECK_OK_PACK("finish", mcpkg_mp_writer_finish(&w, &buf, &len));
+	mcpkg_mp_writer_destroy(&w);
+
+	CHECK_OK_PACK("unpack", mcpkg_mp_pkg_meta_unpack(buf, len, &out));
+	if (out) {
+		CHECK_STR("first id wins", out->id, "first");
+		CHECK_STR("version", out->version, "1.0");
+		CHECK_EQ_I32("negative client", out->client, -1);
+		CHECK(eq_stringlist(ld, out->loaders), "loaders");
+		CHECK(eq_file(f, out->file), "nested file");
+		CHECK(!out->slug && !out->origin, "absent optionals");
+		CHECK(out->depends && mcpkg_list_size(out->depends) == 1 &&
+		      mcpkg_list_at(out->depends, 0, &dout) == MCPKG_CONTAINER_OK &&
+		      eq_depends(d, dout), "bin-embedded list element");
+	}
+
+	{
+		struct McPkgCacheView v;
+		struct McPkgFileView fv;
+		struct McPkgDependsView dv;
+		struct McPkgMpCur c;
+
+		CHECK_OK_PACK("view", mcpkg_mp_pkg_meta_view(buf, len, &v));
+		CHECK(mcpkg_mp_str_eq(&v.id, "first"), "view: first id wins");
+		mcpkg_mp_cur_init(&c, v.file.p, v.file.len);
+		CHECK_OK_PACK("view bin file",
+		              mcpkg_mp_pkg_file_view_cur(&c, &fv));
+		CHECK(mcpkg_mp_str_eq(&fv.file_name, f->file_name),
+		      "view: bin-embedded file");
+		mcpkg_mp_cur_init(&c, v.depends.p, v.depends.len);
+		CHECK_OK_PACK("view bin dep",
+		              mcpkg_mp_pkg_depends_view_cur(&c, &dv));
+		CHECK(mcpkg_mp_str_eq(&dv.id, "dep:x"), "view: bin-embedded dep");
+	}
+
+	mcpkg_mp_pkg_meta_free(out);
+	mcpkg_mp_pkg_depends_free(d);
+	mcpkg_mp_pkg_file_free(f);
+	mcpkg_stringlist_free(ld);
+	mcpkg_free(fbuf);
+	mcpkg_free(dbuf);
+	mcpkg_free(buf);
+}
+
+/* current records carry nested structs as inline maps, not bin */
+static void rt_meta_inline(void)
+{
+	struct McPkgCache *in = mk_meta_maximal();
+	struct McPkgFile *fout = NULL;
+	struct McPkgMpCur c;
+	void *buf = NULL;
+	size_t len = 0, n = 0, i;
+	int key = -1, maps = 0;
+
+	CHECK_OK_PACK("pack meta", mcpkg_mp_pkg_meta_pack(in, &buf, &len));
+	mcpkg_mp_cur_init(&c, buf, len);
+	CHECK_OK_PACK("root map", mcpkg_mp_cur_map(&c, &n));
+	for (i = 0; i < n; i++) {
+		CHECK_OK_PACK("key", mcpkg_mp_cur_key(&c, &key));
+		if (key == 1) {
+			int64_t ver = 0;
+
+			CHECK_OK_PACK("version", mcpkg_mp_cur_i64(&c, &ver));
+			CHECK_EQ_I64("record version", ver, MCPKG_MP_MP_PKG_META_VER);
+		} else if (key == 14) {
+			CHECK(!mcpkg_mp_cur_is_bin(&c), "file not bin-embedded");
+			CHECK_OK_PACK("file unpack_cur",
+			              mcpkg_mp_pkg_file_unpack_cur(&c, NULL, &fout));
+			CHECK(fout && eq_file(in->file, fout), "inline file");
+			maps++;
+		} else {
+			CHECK_OK_PACK("skip", mcpkg_mp_cur_skip(&c));
+		}
+	}
+	CHECK_EQ_INT("file seen once", maps, 1);
+	CHECK(c.p == c.end, "record consumed");
+
+	mcpkg_mp_pkg_file_free(fout);
+	mcpkg_mp_pkg_meta_free(in);
+	mcpkg_free(buf);
+}
+
+/* packed_size matches the growing writer's bytes; pack_into fills them */
+static void rt_meta_size_one(const struct McPkgCache *m, const char *what)
+{
+	unsigned char stack[512];
+	struct McPkgMpWriter w;
+	const void *ref;
+	void *big = NULL;
+	size_t rlen = 0, need, len = 0;
+
+	CHECK_OK_PACK("writer_init", mcpkg_mp_writer_init(&w));
+	CHECK_OK_PACK("pack_append", mcpkg_mp_pkg_meta_pack_append(m, &w));
+	ref = mcpkg_mp_writer_data(&w, &rlen);
+
+	need = mcpkg_mp_pkg_meta_packed_size(m);
+	CHECK(need == rlen, what);
+
+	CHECK(mcpkg_mp_pkg_meta_pack_into(m, NULL, 0, &len) ==
+	      MCPKG_MP_ERR_NO_MEMORY && len == need, "size probe");
+	if (need <= sizeof(stack)) {
+		CHECK_OK_PACK("pack_into stack",
+		              mcpkg_mp_pkg_meta_pack_into(m, stack, need, &len));
+		CHECK(len == need && !memcmp(stack, ref, need), "stack bytes");
+		CHECK(mcpkg_mp_pkg_meta_pack_into(m, stack, need - 1, &len) ==
+		      MCPKG_MP_ERR_NO_MEMORY && len == need, "one byte short");
+	} else {
+		big = mcpkg_malloc(need);
+		CHECK_OK_PACK("pack_into heap",
+		              mcpkg_mp_pkg_meta_pack_into(m, big, need, &len));
+		CHECK(big && len == need && !memcmp(big, ref, need),
+		      "heap bytes");
+	}
+
+	mcpkg_free(big);
+	mcpkg_mp_writer_destroy(&w);
+}
+
+static void rt_meta_size(void)
+{
+	struct McPkgCache *m = mk_meta_maximal();
+	struct McPkgCache *e = mcpkg_mp_pkg_meta_new();
+	char *longs;
+
+	CHECK(m && e, "rt_meta_size setup");
+	if (!m || !e)
+		goto out;
+
+	rt_meta_size_one(m, "maximal meta size");
+	rt_meta_size_one(e, "empty meta size");
+
+	/* every int and str width the encoder picks */
+	m->client = -40000;
+	m->server = -100;
+	m->flags = 0xffffffffu;
+	m->schema = 200u;
+	m->file->size = 1ull << 40;
+	mcpkg_free(m->title);
+	m->title = longs = mcpkg_malloc(70000 + 1);
+	CHECK_NONNULL("long title", longs);
+	if (!longs)
+		goto out;
+	memset(longs, 'x', 70000);
+	longs[70000] = '\0';
+	rt_meta_size_one(m, "str32 title size");
+	longs[300] = '\0';
+	rt_meta_size_one(m, "str16 title size");
+	longs[40] = '\0';
+	rt_meta_size_one(m, "str8 title size");
+
+	CHECK_EQ_SZ("NULL record", mcpkg_mp_pkg_meta_packed_size(NULL), 0);
+out:
+	mcpkg_mp_pkg_meta_free(e);
+	mcpkg_mp_pkg_meta_free(m);
+}
+
+/* view: strings and spans borrowed from the packed record, no allocation */
+static void rt_meta_view(void)
+{
+	struct McPkgCache *in = mk_meta_maximal();
+	struct McPkgCacheView v;
+	struct McPkgFileView fv;
+	struct McPkgDigestView gv;
+	struct McPkgDependsView dv;
+	struct McPkgOriginView ov;
+	struct McPkgDepends *d = NULL;
+	struct McPkgMpCur c;
+	McPkgMemStats st0, st1;
+	const char *sp;
+	void *buf = NULL;
+	size_t len = 0, i, n;
+	int ok = 1;
+
+	CHECK_OK_PACK("pack meta", mcpkg_mp_pkg_meta_pack(in, &buf, &len));
+	mcpkg_mem_stats_get(MCPKG_MEM_TOTAL, &st0);
+	CHECK_OK_PACK("view meta", mcpkg_mp_pkg_meta_view(buf, len, &v));
+	mcpkg_mem_stats_get(MCPKG_MEM_TOTAL, &st1);
+	CHECK_EQ_U64("no allocations", st1.allocs - st0.allocs, 0);
+
+	CHECK(mcpkg_mp_str_eq(&v.id, in->id), "id");
+	CHECK(mcpkg_mp_str_eq(&v.version, in->version), "version");
+	CHECK(mcpkg_mp_str_eq(&v.source_repo, in->source_repo), "source_repo");
+	CHECK(v.client == in->client && v.schema == in->schema, "scalars");
+
+	CHECK_EQ_SZ("loaders n", v.loaders.n, 3);
+	mcpkg_mp_cur_init(&c, v.loaders.p, v.loaders.len);
+	for (i = 0; i < v.loaders.n; i++) {
+		ok &= mcpkg_mp_cur_str(&c, &sp, &n) == MCPKG_MP_NO_ERROR &&
+		      n == strlen(mcpkg_stringlist_at(in->loaders, i)) &&
+		      !memcmp(sp, mcpkg_stringlist_at(in->loaders, i), n);
+	}
+	CHECK(ok && c.p == c.end, "loaders elements");
+
+	mcpkg_mp_cur_init(&c, v.file.p, v.file.len);
+	CHECK_OK_PACK("file view", mcpkg_mp_pkg_file_view_cur(&c, &fv));
+	CHECK(mcpkg_mp_str_eq(&fv.url, in->file->url) &&
+	      fv.size == in->file->size, "file fields");
+	CHECK_EQ_SZ("digests n", fv.digests.n, 2);
+	mcpkg_mp_cur_init(&c, fv.digests.p, fv.digests.len);
+	CHECK_OK_PACK("digest view", mcpkg_mp_pkg_digest_view_cur(&c, &gv));
+	CHECK(gv.hex.p && gv.hex.len > 0, "digest hex");
+
+	mcpkg_mp_cur_init(&c, v.depends.p, v.depends.len);
+	for (i = 0; i < v.depends.n; i++) {
+		CHECK_OK_PACK("dep view", mcpkg_mp_pkg_depends_view_cur(&c, &dv));
+		CHECK(mcpkg_list_at(in->depends, i, &d) == MCPKG_CONTAINER_OK &&
+		      mcpkg_mp_str_eq(&dv.id, d->id) && dv.side == d->side,
+		      "dep fields");
+	}
+
+	mcpkg_mp_cur_init(&c, v.origin.p, v.origin.len);
+	CHECK_OK_PACK("origin view", mcpkg_mp_pkg_origin_view_cur(&c, &ov));
+	CHECK(mcpkg_mp_str_eq(&ov.project_id, in->origin->project_id),
+	      "origin");
+
+	/* absent optionals and the usual validation */
+	mcpkg_free(in->slug);
+	in->slug = NULL;
+	mcpkg_mp_pkg_origin_free(in->origin);
+	in->origin = NULL;
+	mcpkg_free(buf);
+	buf = NULL;
+	CHECK_OK_PACK("repack", mcpkg_mp_pkg_meta_pack(in, &buf, &len));
+	CHECK_OK_PACK("view again", mcpkg_mp_pkg_meta_view(buf, len, &v));
+	CHECK(!v.slug.p && mcpkg_mp_str_eq(&v.slug, NULL) && !v.origin.p,
+	      "absent optionals");
+	for (n = 1, i = 0; n < len; n++)
+		i += mcpkg_mp_pkg_meta_view(buf, n, &v) == MCPKG_MP_NO_ERROR;
+	CHECK_EQ_SZ("truncated views rejected", i, 0);
+
+	mcpkg_mp_pkg_meta_free(in);
+	mcpkg_free(buf);
+}
+
+/* a key repeated past any small counter still keeps its first value */
+#define RT_REPEATS  300u
+
+static void rt_meta_repeats(void)
+{
+	static const unsigned char dup[] = { 0x02, 0xa3, 'd', 'u', 'p' };
+	struct McPkgCache *in = mk_meta_maximal(), *out = NULL;
+	struct McPkgCacheView v;
+	struct McPkgMpCur c;
+	unsigned char *rec = NULL, *p;
+	void *buf = NULL;
+	size_t len = 0, n = 0, body, i;
+
+	CHECK_OK_PACK("pack meta", mcpkg_mp_pkg_meta_pack(in, &buf, &len));
+	mcpkg_mp_cur_init(&c, buf, len);
+	CHECK_OK_PACK("root map", mcpkg_mp_cur_map(&c, &n));
+
+	/* same entries under a map16 header, then RT_REPEATS more ids */
+	body = (size_t)(c.end - c.p);
+	rec = malloc(3 + body + RT_REPEATS * sizeof(dup));
+	CHECK_NONNULL("repeats buf", rec);
+	if (!rec)
+		goto out;
+	p = rec;
+	*p++ = 0xde;
+	*p++ = (unsigned char)((n + RT_REPEATS) >> 8);
+	*p++ = (unsigned char)(n + RT_REPEATS);
+	memcpy(p, c.p, body);
+	p += body;
+	for (i = 0; i < RT_REPEATS; i++, p += sizeof(dup))
+		memcpy(p, dup, sizeof(dup));
+	len = (size_t)(p - rec);
+
+	CHECK_OK_PACK("unpack repeats", mcpkg_mp_pkg_meta_unpack(rec, len, &out));
+	CHECK(out && eq_str(out->id, in->id), "first id wins");
+	mcpkg_mp_pkg_meta_free(out);
+	CHECK_OK_PACK("view repeats", mcpkg_mp_pkg_meta_view(rec, len, &v));
+	CHECK(mcpkg_mp_str_eq(&v.id, in->id), "first id wins (view)");
+
+out:
+	free(rec);
+	mcpkg_mp_pkg_meta_free(in);
+	mcpkg_free(buf);
 }
 
 /* ---------- negative cases ---------- */
@@ -432,11 +787,40 @@ static void neg_missing_required_in_file(void)
 
 	mcpkg_mp_pkg_file_free(in);
 	mcpkg_mp_pkg_file_free(out);
-	free(buf);
+	mcpkg_free(buf);
 }
 
 /* ---------- entry point ---------- */
 
+/* every proper prefix of a valid record is rejected, heap and arena */
+static void neg_meta_truncated(void)
+{
+	struct McPkgCache *in = mk_meta_maximal(), *out = NULL;
+	McPkgArena *a = mcpkg_arena_new(0, 0);
+	void *buf = NULL;
+	size_t len = 0, n, bad = 0;
+
+	CHECK(in && a, "neg_meta_truncated setup");
+	CHECK_OK_PACK("pack meta", mcpkg_mp_pkg_meta_pack(in, &buf, &len));
+
+	for (n = 1; n < len; n++) {
+		out = NULL;
+		if (mcpkg_mp_pkg_meta_unpack(buf, n, &out) == MCPKG_MP_NO_ERROR) {
+			mcpkg_mp_pkg_meta_free(out);
+			bad++;
+		}
+		if (mcpkg_mp_pkg_meta_unpack_arena(buf, n, a, &out) ==
+		    MCPKG_MP_NO_ERROR)
+			bad++;
+	}
+	CHECK_EQ_SZ("truncated records rejected", bad, 0);
+	CHECK_EQ_SZ("arena rewound", mcpkg_arena_used(a), 0);
+
+	mcpkg_mp_pkg_meta_free(in);
+	mcpkg_arena_free(a);
+	mcpkg_free(buf);
+}
+
 static inline void run_tst_pkg_roundtrip(void)
 {
 	TST_BLOCK("pkg digest", {
@@ -451,9 +835,37 @@ static inline void run_tst_pkg_roundtrip(void)
 		rt_meta();
 	});
 
+	TST_BLOCK("pkg meta (arena)", {
+		rt_meta_arena();
+	});
+
+	TST_BLOCK("pkg meta (version 1 layout)", {
+		rt_meta_stream();
+	});
+
+	TST_BLOCK("pkg meta (inline nested)", {
+		rt_meta_inline();
+	});
+
+	TST_BLOCK("pkg meta (exact size, pack_into)", {
+		rt_meta_size();
+	});
+
+	TST_BLOCK("pkg meta (borrowed view)", {
+		rt_meta_view();
+	});
+
+	TST_BLOCK("pkg meta (repeated keys)", {
+		rt_meta_repeats();
+	});
+
 	TST_BLOCK("pkg negative: missing required in file", {
 		neg_missing_required_in_file();
 	});
+
+	TST_BLOCK("pkg negative: truncated meta", {
+		neg_meta_truncated();
+	});
 }
 
 #endif /* TST_PKG_ROUNDTRIP_H */
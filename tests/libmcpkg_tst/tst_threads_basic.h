@@ -181,6 +181,51 @@ static void test_thread_id_and_name(void)
 	}
 }
 
+/* thread-local slot: per-thread values, dtor on thread exit */
+static struct McPkgTls *g_tls_key;
+static volatile int g_tls_dtors;
+
+static void tls_dtor(void *v)
+{
+	(void)v;
+	g_tls_dtors++;          /* threads are joined one at a time */
+}
+
+static int worker_tls(void *arg)
+{
+	int *own = (int *)arg;
+
+	if (mcpkg_tls_get(g_tls_key) != NULL)
+		return 1;
+	if (mcpkg_tls_set(g_tls_key, own) != MCPKG_THREAD_NO_ERROR)
+		return 1;
+	*own = mcpkg_tls_get(g_tls_key) == own;
+	return 0;
+}
+
+static void test_tls(void)
+{
+	struct McPkgThread *t;
+	int mine = 0, theirs = 0;
+
+	g_tls_key = mcpkg_tls_new(tls_dtor);
+	CHECK_NONNULL("tls new", g_tls_key);
+	if (!g_tls_key)
+		return;
+	CHECK_OK_THREADS("tls set", mcpkg_tls_set(g_tls_key, &mine));
+
+	t = mcpkg_thread_create(worker_tls, &theirs);
+	CHECK_NONNULL("tls thread", t);
+	CHECK_OK_THREADS("tls join", mcpkg_thread_join(t));
+	CHECK(theirs == 1, "thread saw only its own value");
+	CHECK(mcpkg_tls_get(g_tls_key) == &mine, "caller value kept");
+	CHECK_EQ_INT("dtor ran at thread exit", g_tls_dtors, 1);
+
+	CHECK_OK_THREADS("tls clear", mcpkg_tls_set(g_tls_key, NULL));
+	mcpkg_tls_free(g_tls_key);
+	g_tls_key = NULL;
+}
+
 /* ---------- runner ---------- */
 
 static inline void run_threads_basic(void)
@@ -194,6 +239,7 @@ static inline void run_threads_basic(void)
 	test_cond_timedwait_timeout();
 	test_many_threads_increment();
 	test_thread_id_and_name();
+	test_tls();
 
 	if (g_tst_fails == before)
 		(void)TST_WRITE(TST_OUT_FD, "mcpkg threads tests: OK\n", 26);